@@ -0,0 +1,423 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+
+#include "access-log-binary.h"
+
+namespace cartesi {
+
+static constexpr char ACCESS_LOG_BINARY_MAGIC[] = {'C', 'M', 'A', 'L'};
+
+/// \brief Maximum number of sibling hashes in an access, one per level of the tree above a word
+static constexpr uint64_t ACCESS_LOG_BINARY_MAX_SIBLINGS = 64;
+
+/// \brief Record tags
+enum access_log_binary_tag : uint8_t {
+    ACCESS_LOG_BINARY_TAG_END = 0,
+    ACCESS_LOG_BINARY_TAG_ACCESS = 1,
+    ACCESS_LOG_BINARY_TAG_BRACKET = 2,
+};
+
+/// \brief Flags in the header, describing the log type
+enum access_log_binary_type_flags : uint8_t {
+    ACCESS_LOG_BINARY_TYPE_PROOFS = 1,
+    ACCESS_LOG_BINARY_TYPE_ANNOTATIONS = 2,
+    ACCESS_LOG_BINARY_TYPE_LARGE_DATA = 4,
+};
+
+/// \brief Flags in each access record, telling which optional fields follow
+enum access_log_binary_access_flags : uint8_t {
+    ACCESS_LOG_BINARY_ACCESS_READ = 1,
+    ACCESS_LOG_BINARY_ACCESS_WRITTEN = 2,
+    ACCESS_LOG_BINARY_ACCESS_WRITTEN_HASH = 4,
+    ACCESS_LOG_BINARY_ACCESS_SIBLING_HASHES = 8,
+};
+
+size_t access_log_binary_writer::hash_hasher::operator()(const hash_type &hash) const {
+    size_t h = 0;
+    memcpy(&h, hash.data(), sizeof(h));
+    return h;
+}
+
+access_log_binary_writer::access_log_binary_writer(std::ostream &out, const access_log::type &log_type) :
+    m_out{out},
+    m_log_type{log_type} {
+    m_out.write(ACCESS_LOG_BINARY_MAGIC, sizeof(ACCESS_LOG_BINARY_MAGIC));
+    write_byte(ACCESS_LOG_BINARY_VERSION);
+    uint8_t flags = 0;
+    if (log_type.has_proofs()) {
+        flags |= ACCESS_LOG_BINARY_TYPE_PROOFS;
+    }
+    if (log_type.has_annotations()) {
+        flags |= ACCESS_LOG_BINARY_TYPE_ANNOTATIONS;
+    }
+    if (log_type.has_large_data()) {
+        flags |= ACCESS_LOG_BINARY_TYPE_LARGE_DATA;
+    }
+    write_byte(flags);
+}
+
+void access_log_binary_writer::write_access(const access &a, const std::string &note) {
+    if (m_finished) {
+        throw std::logic_error{"access log already finished"};
+    }
+    write_byte(ACCESS_LOG_BINARY_TAG_ACCESS);
+    write_byte(static_cast<uint8_t>(a.get_type()));
+    write_byte(static_cast<uint8_t>(a.get_log2_size()));
+    write_uint64(a.get_address());
+    uint8_t flags = 0;
+    if (a.get_read().has_value()) {
+        flags |= ACCESS_LOG_BINARY_ACCESS_READ;
+    }
+    if (a.get_written().has_value()) {
+        flags |= ACCESS_LOG_BINARY_ACCESS_WRITTEN;
+    }
+    if (a.get_written_hash().has_value()) {
+        flags |= ACCESS_LOG_BINARY_ACCESS_WRITTEN_HASH;
+    }
+    if (a.get_sibling_hashes().has_value()) {
+        flags |= ACCESS_LOG_BINARY_ACCESS_SIBLING_HASHES;
+    }
+    write_byte(flags);
+    write_hash(a.get_read_hash());
+    // NOLINTBEGIN(bugprone-unchecked-optional-access)
+    if (a.get_read().has_value()) {
+        write_data(a.get_read().value());
+    }
+    if (a.get_written().has_value()) {
+        write_data(a.get_written().value());
+    }
+    if (a.get_written_hash().has_value()) {
+        write_hash(a.get_written_hash().value());
+    }
+    if (a.get_sibling_hashes().has_value()) {
+        const auto &sibling_hashes = a.get_sibling_hashes().value();
+        write_varint(sibling_hashes.size());
+        for (const auto &hash : sibling_hashes) {
+            write_hash(hash);
+        }
+    }
+    // NOLINTEND(bugprone-unchecked-optional-access)
+    if (m_log_type.has_annotations()) {
+        write_string(note);
+    }
+}
+
+void access_log_binary_writer::write_bracket(const bracket_note &b) {
+    if (m_finished) {
+        throw std::logic_error{"access log already finished"};
+    }
+    write_byte(ACCESS_LOG_BINARY_TAG_BRACKET);
+    write_byte(static_cast<uint8_t>(b.type));
+    write_varint(b.where);
+    write_string(b.text);
+}
+
+void access_log_binary_writer::finish(void) {
+    if (m_finished) {
+        throw std::logic_error{"access log already finished"};
+    }
+    write_byte(ACCESS_LOG_BINARY_TAG_END);
+    m_finished = true;
+    m_out.flush();
+    if (!m_out) {
+        throw std::runtime_error{"error writing access log"};
+    }
+}
+
+void access_log_binary_writer::write_byte(uint8_t b) {
+    m_out.put(static_cast<char>(b));
+}
+
+void access_log_binary_writer::write_uint64(uint64_t value) {
+    // Little-endian, whatever the host byte order
+    unsigned char bytes[sizeof(value)];
+    for (unsigned i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    write_bytes(bytes, sizeof(bytes));
+}
+
+void access_log_binary_writer::write_varint(uint64_t value) {
+    while (value >= 0x80) {
+        write_byte(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    write_byte(static_cast<uint8_t>(value));
+}
+
+void access_log_binary_writer::write_bytes(const unsigned char *data, size_t length) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    m_out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(length));
+}
+
+void access_log_binary_writer::write_data(const access_data &data) {
+    write_varint(data.size());
+    write_bytes(data.data(), data.size());
+}
+
+void access_log_binary_writer::write_string(const std::string &s) {
+    write_varint(s.size());
+    m_out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+// A hash is either 0 followed by the hash itself, which then enters the table, or its 1-based index in the table
+void access_log_binary_writer::write_hash(const hash_type &hash) {
+    auto [it, inserted] = m_hash_table.try_emplace(hash, m_hash_table.size());
+    if (inserted) {
+        write_varint(0);
+        write_bytes(hash.data(), hash.size());
+    } else {
+        write_varint(it->second + 1);
+    }
+}
+
+access_log_binary_reader::access_log_binary_reader(std::istream &in) : m_in{in} {
+    char magic[sizeof(ACCESS_LOG_BINARY_MAGIC)]{};
+    m_in.read(magic, sizeof(magic));
+    if (!m_in || memcmp(magic, ACCESS_LOG_BINARY_MAGIC, sizeof(magic)) != 0) {
+        throw std::invalid_argument{"not a binary access log"};
+    }
+    const uint8_t version = read_byte();
+    if (version != ACCESS_LOG_BINARY_VERSION) {
+        throw std::invalid_argument{"unsupported binary access log version " + std::to_string(version)};
+    }
+    const uint8_t flags = read_byte();
+    m_log_type = access_log::type{(flags & ACCESS_LOG_BINARY_TYPE_PROOFS) != 0,
+        (flags & ACCESS_LOG_BINARY_TYPE_ANNOTATIONS) != 0, (flags & ACCESS_LOG_BINARY_TYPE_LARGE_DATA) != 0};
+}
+
+access_log_binary_reader::record access_log_binary_reader::read_next(void) {
+    if (m_finished) {
+        return record::end;
+    }
+    switch (read_byte()) {
+        case ACCESS_LOG_BINARY_TAG_END:
+            m_finished = true;
+            return record::end;
+        case ACCESS_LOG_BINARY_TAG_ACCESS: {
+            access a;
+            const uint8_t type = read_byte();
+            if (type > static_cast<uint8_t>(access_type::write)) {
+                throw std::invalid_argument{"invalid access type in binary access log"};
+            }
+            a.set_type(static_cast<access_type>(type));
+            a.set_log2_size(read_byte());
+            a.set_address(read_uint64());
+            const uint8_t flags = read_byte();
+            read_hash(a.get_read_hash());
+            if ((flags & ACCESS_LOG_BINARY_ACCESS_READ) != 0) {
+                const std::string data = read_string();
+                a.set_read(access_data(data.begin(), data.end()));
+            }
+            if ((flags & ACCESS_LOG_BINARY_ACCESS_WRITTEN) != 0) {
+                const std::string data = read_string();
+                a.set_written(access_data(data.begin(), data.end()));
+            }
+            if ((flags & ACCESS_LOG_BINARY_ACCESS_WRITTEN_HASH) != 0) {
+                hash_type hash{};
+                read_hash(hash);
+                a.set_written_hash(hash);
+            }
+            if ((flags & ACCESS_LOG_BINARY_ACCESS_SIBLING_HASHES) != 0) {
+                const uint64_t count = read_varint();
+                if (count > ACCESS_LOG_BINARY_MAX_SIBLINGS) {
+                    throw std::invalid_argument{"too many sibling hashes in binary access log"};
+                }
+                access::sibling_hashes_type sibling_hashes(count);
+                for (auto &hash : sibling_hashes) {
+                    read_hash(hash);
+                }
+                a.get_sibling_hashes() = std::move(sibling_hashes);
+            }
+            m_note = m_log_type.has_annotations() ? read_string() : std::string{};
+            m_access = std::move(a);
+            return record::access;
+        }
+        case ACCESS_LOG_BINARY_TAG_BRACKET: {
+            const uint8_t type = read_byte();
+            if (type > static_cast<uint8_t>(bracket_type::end)) {
+                throw std::invalid_argument{"invalid bracket type in binary access log"};
+            }
+            m_bracket.type = static_cast<bracket_type>(type);
+            m_bracket.where = read_varint();
+            m_bracket.text = read_string();
+            return record::bracket;
+        }
+        default:
+            throw std::invalid_argument{"invalid record in binary access log"};
+    }
+}
+
+uint8_t access_log_binary_reader::read_byte(void) {
+    const auto c = m_in.get();
+    if (c == std::istream::traits_type::eof()) {
+        throw std::invalid_argument{"truncated binary access log"};
+    }
+    return static_cast<uint8_t>(c);
+}
+
+uint64_t access_log_binary_reader::read_uint64(void) {
+    unsigned char bytes[sizeof(uint64_t)];
+    read_bytes(bytes, sizeof(bytes));
+    // Little-endian, whatever the host byte order
+    uint64_t value = 0;
+    for (unsigned i = 0; i < sizeof(bytes); ++i) {
+        value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+uint64_t access_log_binary_reader::read_varint(void) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const uint8_t b = read_byte();
+        value |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::invalid_argument{"invalid varint in binary access log"};
+}
+
+void access_log_binary_reader::read_bytes(unsigned char *data, size_t length) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    m_in.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(length));
+    if (static_cast<size_t>(m_in.gcount()) != length) {
+        throw std::invalid_argument{"truncated binary access log"};
+    }
+}
+
+std::string access_log_binary_reader::read_string(void) {
+    const uint64_t length = read_varint();
+    std::string s;
+    // Grow as the data arrives, so a corrupt length cannot exhaust memory
+    char chunk[4096];
+    for (uint64_t remaining = length; remaining > 0;) {
+        const auto n = static_cast<size_t>(std::min<uint64_t>(remaining, sizeof(chunk)));
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        read_bytes(reinterpret_cast<unsigned char *>(chunk), n);
+        s.append(chunk, n);
+        remaining -= n;
+    }
+    return s;
+}
+
+void access_log_binary_reader::read_hash(hash_type &hash) {
+    const uint64_t index = read_varint();
+    if (index == 0) {
+        read_bytes(hash.data(), hash.size());
+        m_hash_table.push_back(hash);
+    } else if (index <= m_hash_table.size()) {
+        hash = m_hash_table[index - 1];
+    } else {
+        throw std::invalid_argument{"invalid hash reference in binary access log"};
+    }
+}
+
+/// \brief Writes an entire access log to a stream
+static void write_access_log_binary(std::ostream &out, const access_log &log) {
+    access_log_binary_writer writer{out, log.get_log_type()};
+    const auto &accesses = log.get_accesses();
+    const auto &notes = log.get_notes();
+    const bool has_notes = log.get_log_type().has_annotations();
+    if (has_notes && notes.size() != accesses.size()) {
+        throw std::invalid_argument{"access log has mismatched accesses and notes"};
+    }
+    const std::string no_note;
+    for (size_t i = 0; i < accesses.size(); ++i) {
+        writer.write_access(accesses[i], has_notes ? notes[i] : no_note);
+    }
+    for (const auto &b : log.get_brackets()) {
+        writer.write_bracket(b);
+    }
+    writer.finish();
+}
+
+std::string encode_access_log_binary(const access_log &log) {
+    std::ostringstream out;
+    write_access_log_binary(out, log);
+    return std::move(out).str();
+}
+
+std::string encode_access_logs_binary(const std::vector<access_log> &logs) {
+    std::ostringstream out;
+    for (const auto &log : logs) {
+        write_access_log_binary(out, log);
+    }
+    return std::move(out).str();
+}
+
+/// \brief Read-only stream buffer over memory, so decoding needs no copy of the data
+class memory_streambuf final : public std::streambuf {
+public:
+    explicit memory_streambuf(std::string_view data) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+        char *begin = const_cast<char *>(data.data());
+        setg(begin, begin, begin + data.size());
+    }
+};
+
+/// \brief Reads an entire access log from a stream, up to its end record
+static access_log read_access_log_binary(std::istream &in) {
+    access_log_binary_reader reader{in};
+    std::vector<access> accesses;
+    std::vector<bracket_note> brackets;
+    std::vector<std::string> notes;
+    const bool has_notes = reader.get_log_type().has_annotations();
+    for (;;) {
+        switch (reader.read_next()) {
+            case access_log_binary_reader::record::access:
+                accesses.push_back(reader.get_access());
+                if (has_notes) {
+                    notes.push_back(reader.get_note());
+                }
+                break;
+            case access_log_binary_reader::record::bracket:
+                brackets.push_back(reader.get_bracket());
+                break;
+            case access_log_binary_reader::record::end:
+                return access_log{std::move(accesses), std::move(brackets), std::move(notes), reader.get_log_type()};
+        }
+    }
+}
+
+access_log decode_access_log_binary(std::string_view data) {
+    memory_streambuf buf{data};
+    std::istream in{&buf};
+    auto log = read_access_log_binary(in);
+    if (in.peek() != std::istream::traits_type::eof()) {
+        throw std::invalid_argument{"trailing data after binary access log"};
+    }
+    return log;
+}
+
+std::vector<access_log> decode_access_logs_binary(std::string_view data) {
+    memory_streambuf buf{data};
+    std::istream in{&buf};
+    std::vector<access_log> logs;
+    while (in.peek() != std::istream::traits_type::eof()) {
+        logs.push_back(read_access_log_binary(in));
+    }
+    return logs;
+}
+
+} // namespace cartesi
@@ -0,0 +1,180 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ACCESS_LOG_BINARY_H
+#define ACCESS_LOG_BINARY_H
+
+/// \file
+/// \brief Compact binary encoding of state access logs
+/// \details \{
+/// An encoded log starts with the 4-byte magic "CMAL", a version byte and a byte with the log type flags.
+/// A sequence of records follows, each starting with a tag byte, and the end record closes the log.
+/// Access records appear in log order, and bracket records name the access they point to.
+/// Every hash is written once in full and added to a table, and later occurrences refer to it by index.
+/// Accesses in the same log share most of their sibling hashes, so this makes logs much smaller.
+/// Integers are little-endian, and lengths and hash references are LEB128 varints.
+/// \}
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "access-log.h"
+#include "bracket-note.h"
+
+namespace cartesi {
+
+/// \brief Version of the binary access log encoding
+constexpr uint8_t ACCESS_LOG_BINARY_VERSION = 1;
+
+/// \brief Writes an access log in the binary encoding, one record at a time
+class access_log_binary_writer final {
+public:
+    using hash_type = access::hash_type;
+
+    /// \brief Writes the header of the log
+    /// \param out Stream that receives the encoded log
+    /// \param log_type Type of the log
+    access_log_binary_writer(std::ostream &out, const access_log::type &log_type);
+
+    access_log_binary_writer(const access_log_binary_writer &other) = delete;
+    access_log_binary_writer(access_log_binary_writer &&other) = delete;
+    access_log_binary_writer &operator=(const access_log_binary_writer &other) = delete;
+    access_log_binary_writer &operator=(access_log_binary_writer &&other) = delete;
+    ~access_log_binary_writer() = default;
+
+    /// \brief Writes the next access
+    /// \param a Access
+    /// \param note Annotation of the access, ignored unless the log type includes annotations
+    void write_access(const access &a, const std::string &note);
+
+    /// \brief Writes a bracket annotation
+    /// \param b Bracket, pointing to an access by its index in the log
+    void write_bracket(const bracket_note &b);
+
+    /// \brief Writes the end of the log
+    void finish(void);
+
+private:
+    void write_byte(uint8_t b);
+    void write_uint64(uint64_t value);
+    void write_varint(uint64_t value);
+    void write_bytes(const unsigned char *data, size_t length);
+    void write_data(const access_data &data);
+    void write_string(const std::string &s);
+    void write_hash(const hash_type &hash);
+
+    /// \brief Hashes a hash for the table, which needs no mixing since hashes are already uniform
+    struct hash_hasher {
+        size_t operator()(const hash_type &hash) const;
+    };
+
+    std::ostream &m_out;                                                ///< Stream receiving the log
+    access_log::type m_log_type;                                        ///< Type of the log
+    std::unordered_map<hash_type, uint64_t, hash_hasher> m_hash_table{}; ///< Index of each hash already written
+    bool m_finished{false};                                             ///< True after the end record
+};
+
+/// \brief Reads an access log in the binary encoding, one record at a time
+class access_log_binary_reader final {
+public:
+    using hash_type = access::hash_type;
+
+    /// \brief Kind of record read
+    enum class record {
+        access,  ///< An access, available from get_access() and get_note()
+        bracket, ///< A bracket annotation, available from get_bracket()
+        end      ///< The end of the log
+    };
+
+    /// \brief Reads the header of the log
+    /// \param in Stream holding the encoded log
+    explicit access_log_binary_reader(std::istream &in);
+
+    access_log_binary_reader(const access_log_binary_reader &other) = delete;
+    access_log_binary_reader(access_log_binary_reader &&other) = delete;
+    access_log_binary_reader &operator=(const access_log_binary_reader &other) = delete;
+    access_log_binary_reader &operator=(access_log_binary_reader &&other) = delete;
+    ~access_log_binary_reader() = default;
+
+    /// \brief Gets the type of the log
+    const access_log::type &get_log_type(void) const {
+        return m_log_type;
+    }
+
+    /// \brief Reads the next record
+    /// \returns Kind of record read
+    record read_next(void);
+
+    /// \brief Gets the access read by the last call to read_next()
+    const access &get_access(void) const {
+        return m_access;
+    }
+
+    /// \brief Gets the annotation of the access read by the last call to read_next()
+    const std::string &get_note(void) const {
+        return m_note;
+    }
+
+    /// \brief Gets the bracket read by the last call to read_next()
+    const bracket_note &get_bracket(void) const {
+        return m_bracket;
+    }
+
+private:
+    uint8_t read_byte(void);
+    uint64_t read_uint64(void);
+    uint64_t read_varint(void);
+    void read_bytes(unsigned char *data, size_t length);
+    std::string read_string(void);
+    void read_hash(hash_type &hash);
+
+    std::istream &m_in;                      ///< Stream holding the log
+    access_log::type m_log_type{false};      ///< Type of the log
+    std::vector<hash_type> m_hash_table{};   ///< Hashes read so far, in the order they were written
+    access m_access{};                       ///< Last access read
+    std::string m_note{};                    ///< Annotation of last access read
+    bracket_note m_bracket{};                ///< Last bracket read
+    bool m_finished{false};                  ///< True after the end record
+};
+
+/// \brief Encodes an entire access log
+/// \param log Access log
+/// \returns Encoded log
+std::string encode_access_log_binary(const access_log &log);
+
+/// \brief Decodes an entire access log
+/// \param data Encoded log
+/// \returns Access log
+access_log decode_access_log_binary(std::string_view data);
+
+/// \brief Encodes several access logs, one after the other
+/// \param logs Access logs
+/// \returns Encoded logs
+std::string encode_access_logs_binary(const std::vector<access_log> &logs);
+
+/// \brief Decodes several access logs encoded one after the other
+/// \param data Encoded logs
+/// \returns Access logs
+std::vector<access_log> decode_access_logs_binary(std::string_view data);
+
+} // namespace cartesi
+
+#endif
@@ -268,10 +268,36 @@ where options are:
         when omitted or defined as 0, the number of hardware threads is used if
         it can be identified or else a single thread is used.
 
+  --host-tlb=<key>:<value>[,<key>:<value>[,...]...]
+    enables a larger, set-associative TLB in the host that is consulted when
+    the shadow TLB misses, before walking the page tables.
+    the shadow TLB, and therefore the machine state, is not affected.
+
+    <key>:<value> is one of
+        size:<number>
+        ways:<number>
+
+        size (optional)
+        number of entries of each type (code, read, write), a power of 2
+        no larger than 2^20 (default: 4096).
+
+        ways (optional)
+        number of entries in each set, 1, 2, or 4 (default: 4).
+
   --htif-no-console-putchar
     suppress any console output during machine run,
     this includes anything written to machine's stdout or stderr.
 
+  --page-hash-cache-size=<number>
+    keep the hashes inside up to <number> recently proved pages, so proofs of
+    words in them, as logged by --log-uarch-step, only hash again the words
+    that changed since (default: 0, i.e., disabled).
+
+  --map-ram-image
+    map the RAM image privately instead of reading it in full when creating or
+    loading the machine, so its pages are only read from the file when first
+    accessed. the file must not be modified while the machine exists.
+
   --skip-root-hash-check
     skip merkle tree root hash check when loading a stored machine,
     assuming the stored machine files are not corrupt,
@@ -311,6 +337,11 @@ where options are:
     store machine to <directory>, where "%%h" is substituted by the
     state hash in the directory name.
 
+  --store-base=<directory>
+    when storing the machine, store only the pages that changed since the
+    machine previously stored in <directory>, which must stay in place for
+    as long as the stored delta is in use.
+
   --load=<directory>
     load machine previously stored in <directory>.
 
@@ -458,6 +489,10 @@ local uarch
 local rollup_advance
 local rollup_inspect
 local concurrency_update_merkle_tree = 0
+local host_tlb_size = 0
+local host_tlb_ways = 0
+local page_hash_cache_size = 0
+local map_ram_image = false
 local skip_root_hash_check = false
 local skip_version_check = false
 local htif_no_console_putchar = false
@@ -477,6 +512,7 @@ local log_uarch_step = false
 local auto_uarch_reset = false
 local log_uarch_reset = false
 local store_dir
+local store_base_dir
 local load_dir
 local cmdline_opts_finished = false
 local store_config = false
@@ -828,6 +864,19 @@ local options = {
             return true
         end,
     },
+    {
+        "^(%-%-host%-tlb%=(.+))$",
+        function(all, opts)
+            if not opts then return false end
+            local t = util.parse_options(opts, {
+                size = true,
+                ways = true,
+            })
+            host_tlb_size = assert(util.parse_number(t.size or "4096"), "invalid size number in " .. all)
+            host_tlb_ways = assert(util.parse_number(t.ways or "4"), "invalid ways number in " .. all)
+            return true
+        end,
+    },
     {
         "^%-%-htif%-no%-console%-putchar$",
         function(all)
@@ -836,6 +885,22 @@ local options = {
             return true
         end,
     },
+    {
+        "^(%-%-page%-hash%-cache%-size%=(.*))$",
+        function(all, n)
+            if not n then return false end
+            page_hash_cache_size = assert(util.parse_number(n), "invalid option " .. all)
+            return true
+        end,
+    },
+    {
+        "^%-%-map%-ram%-image$",
+        function(all)
+            if not all then return false end
+            map_ram_image = true
+            return true
+        end,
+    },
     {
         "^%-%-skip%-root%-hash%-check$",
         function(all)
@@ -980,6 +1045,14 @@ local options = {
             return true
         end,
     },
+    {
+        "^%-%-store%-base%=(.*)$",
+        function(o)
+            if not o or #o < 1 then return false end
+            store_base_dir = o
+            return true
+        end,
+    },
     {
         "^%-%-remote%-address%=(.*)$",
         function(o)
@@ -1440,6 +1513,12 @@ local runtime = {
     htif = {
         no_console_putchar = htif_no_console_putchar,
     },
+    host_tlb = {
+        size = host_tlb_size,
+        ways = host_tlb_ways,
+    },
+    page_hash_cache_size = page_hash_cache_size,
+    map_ram_image = map_ram_image,
     skip_root_hash_check = skip_root_hash_check,
     skip_version_check = skip_version_check,
 }
@@ -1764,12 +1843,16 @@ local function save_rollup_inspect_state_report(machine, config, inspect)
     f:close()
 end
 
-local function store_machine(machine, config, dir)
+local function store_machine(machine, config, dir, base_dir)
     assert(not config.htif.console_getchar, "hashes are meaningless in interactive mode")
     stderr("Storing machine: please wait\n")
     local h = util.hexhash(machine:get_root_hash())
     local name = instantiate_filename(dir, { h = h })
-    machine:store(name)
+    if base_dir then
+        machine:store_delta(name, base_dir)
+    else
+        machine:store(name)
+    end
 end
 
 local function dump_pmas(machine)
@@ -1798,7 +1881,6 @@ if store_config == stderr then store_machine_config(config, stderr) end
 if rollup_advance or rollup_inspect then
     check_rollup_htif_config(config.htif)
     assert(config.rollup, "rollup device must be present")
-    assert(remote_address, "rollup requires --remote-address for snapshot/rollback")
     check_rollup_memory_range_config(config.rollup.tx_buffer, "tx-buffer")
     check_rollup_memory_range_config(config.rollup.rx_buffer, "rx-buffer")
     check_rollup_memory_range_config(config.rollup.input_metadata, "input-metadata")
@@ -1957,7 +2039,7 @@ if final_hash then
     print_root_hash(machine, stderr_unsilenceable)
 end
 dump_value_proofs(machine, final_proof, config.htif.console_getchar)
-if store_dir then store_machine(machine, config, store_dir) end
+if store_dir then store_machine(machine, config, store_dir, store_base_dir) end
 if assert_rolling_template then
     local cmd, reason = get_yield(machine)
     if not (cmd == cartesi.machine.HTIF_YIELD_MANUAL and reason == cartesi.machine.HTIF_YIELD_REASON_RX_ACCEPTED) then
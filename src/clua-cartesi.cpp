@@ -84,9 +84,17 @@ static int cartesi_mod_keccak(lua_State *L) {
     }
 }
 
+/// \brief This is the cartesi.compact_delta() function implementation.
+/// \param L Lua state.
+static int cartesi_mod_compact_delta(lua_State *L) {
+    TRY_EXECUTE(cm_compact_delta(luaL_checkstring(L, 1), luaL_checkstring(L, 2), err_msg));
+    return 0;
+}
+
 /// \brief Contents of the cartesi module table.
 static const auto cartesi_mod = cartesi::clua_make_luaL_Reg_array({
     {"keccak", cartesi_mod_keccak},
+    {"compact_delta", cartesi_mod_compact_delta},
 });
 
 extern "C" {
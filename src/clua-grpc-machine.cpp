@@ -130,6 +130,25 @@ static int grpc_machine_class_verify_uarch_step_state_transition(lua_State *L) {
     return 1;
 }
 
+/// \brief This is the machine.verify_uarch_step_state_transitions()
+/// static method implementation.
+static int grpc_machine_class_verify_uarch_step_state_transitions(lua_State *L) {
+    const int stubidx = lua_upvalueindex(1);
+    const int ctxidx = lua_upvalueindex(2);
+    lua_settop(L, 4);
+    auto &managed_grpc_stub = clua_check<clua_managed_cm_ptr<cm_grpc_machine_stub>>(L, stubidx, ctxidx);
+    auto &transitions = clua_push_to(L, clua_uarch_step_transitions{}, ctxidx);
+    clua_check_uarch_step_transitions(L, 1, 2, 3, transitions, ctxidx);
+    auto &managed_runtime_config = clua_push_to(L,
+        clua_managed_cm_ptr<cm_machine_runtime_config>(clua_opt_cm_machine_runtime_config(L, 4, {}, ctxidx)), ctxidx);
+    TRY_EXECUTE(cm_grpc_verify_uarch_step_state_transitions(managed_grpc_stub.get(), transitions.root_hashes_before.data(),
+        transitions.logs.data(), transitions.root_hashes_after.data(), transitions.logs.size(),
+        managed_runtime_config.get(), true, transitions.log_err_msgs.data(), err_msg));
+    managed_runtime_config.reset();
+    clua_push_uarch_step_transition_results(L, transitions);
+    return 1;
+}
+
 /// \brief This is the machine.get_x_address() method implementation.
 static int grpc_machine_class_get_x_address(lua_State *L) {
     auto &managed_grpc_stub =
@@ -166,6 +185,7 @@ static const auto grpc_machine_static_methods = cartesi::clua_make_luaL_Reg_arra
     {"get_default_config", grpc_machine_class_get_default_config},
     {"verify_uarch_step_log", grpc_machine_class_verify_uarch_step_log},
     {"verify_uarch_step_state_transition", grpc_machine_class_verify_uarch_step_state_transition},
+    {"verify_uarch_step_state_transitions", grpc_machine_class_verify_uarch_step_state_transitions},
     {"verify_uarch_reset_log", grpc_machine_class_verify_uarch_reset_log},
     {"verify_uarch_reset_state_transition", grpc_machine_class_verify_uarch_reset_state_transition},
     {"get_x_address", grpc_machine_class_get_x_address},
@@ -286,6 +306,8 @@ int clua_grpc_machine_init(lua_State *L, int ctxidx) {
     clua_createnewtype<clua_managed_cm_ptr<const cm_machine_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_machine_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_access_log>>(L, ctxidx);
+    clua_createnewtype<clua_managed_cm_ptr<cm_access_log_array>>(L, ctxidx);
+    clua_createnewtype<clua_managed_cm_ptr<cm_checkpoint_array>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_machine_runtime_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_merkle_tree_proof>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<char>>(L, ctxidx);
@@ -293,6 +315,7 @@ int clua_grpc_machine_init(lua_State *L, int ctxidx) {
     clua_createnewtype<clua_managed_cm_ptr<cm_memory_range_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<const cm_semantic_version>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_grpc_machine_stub>>(L, ctxidx);
+    clua_createnewtype<clua_uarch_step_transitions>(L, ctxidx);
     return 1;
 }
 
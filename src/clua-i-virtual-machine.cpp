@@ -330,6 +330,37 @@ static int machine_obj_index_run(lua_State *L) {
     return 1;
 }
 
+/// \brief This is the machine:run_with_checkpoints() method implementation.
+/// \param L Lua state.
+static int machine_obj_index_run_with_checkpoints(lua_State *L) {
+    auto &m = clua_check<clua_managed_cm_ptr<cm_machine>>(L, 1);
+    auto &managed_checkpoints = clua_push_to(L, clua_managed_cm_ptr<cm_checkpoint_array>(nullptr));
+    TRY_EXECUTE(cm_machine_run_with_checkpoints(m.get(), luaL_checkinteger(L, 2), luaL_checkinteger(L, 3),
+        &managed_checkpoints.get(), err_msg));
+    lua_createtable(L, static_cast<int>(managed_checkpoints.get()->count), 0);
+    for (size_t i = 0; i < managed_checkpoints.get()->count; ++i) {
+        const auto &checkpoint = managed_checkpoints.get()->entry[i];
+        lua_createtable(L, 0, 2);
+        clua_setintegerfield(L, checkpoint.mcycle, "mcycle", -1);
+        clua_push_cm_hash(L, &checkpoint.root_hash);
+        lua_setfield(L, -2, "root_hash");
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i) + 1);
+    }
+    managed_checkpoints.reset();
+    return 1;
+}
+
+/// \brief This is the machine:transaction() method implementation.
+/// \param L Lua state.
+static int machine_obj_index_transaction(lua_State *L) {
+    auto &m = clua_check<clua_managed_cm_ptr<cm_machine>>(L, 1);
+    auto &managed_results = clua_push_to(L, clua_managed_cm_ptr<char>(nullptr));
+    TRY_EXECUTE(cm_transaction(m.get(), luaL_checkstring(L, 2), &managed_results.get(), err_msg));
+    lua_pushstring(L, managed_results.get());
+    managed_results.reset();
+    return 1;
+}
+
 /// \brief This is the machine:read_uarch_halt_flag() method implementation.
 /// \param L Lua state.
 static int machine_obj_index_read_uarch_halt_flag(lua_State *L) {
@@ -400,6 +431,22 @@ static int machine_obj_index_log_uarch_step(lua_State *L) {
     return 1;
 }
 
+/// \brief This is the machine:log_uarch_steps() method implementation.
+/// \param L Lua state.
+static int machine_obj_index_log_uarch_steps(lua_State *L) {
+    auto &m = clua_check<clua_managed_cm_ptr<cm_machine>>(L, 1);
+    auto &managed_logs = clua_push_to(L, clua_managed_cm_ptr<cm_access_log_array>(nullptr));
+    TRY_EXECUTE(cm_log_uarch_steps(m.get(), luaL_checkinteger(L, 2), clua_check_cm_log_type(L, 3), true,
+        &managed_logs.get(), err_msg));
+    lua_createtable(L, static_cast<int>(managed_logs.get()->count), 0);
+    for (size_t i = 0; i < managed_logs.get()->count; ++i) {
+        clua_push_cm_access_log(L, managed_logs.get()->entry[i]);
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i) + 1);
+    }
+    managed_logs.reset();
+    return 1;
+}
+
 /// \brief This is the machine:store() method implementation.
 /// \param L Lua state.
 static int machine_obj_index_store(lua_State *L) {
@@ -408,6 +455,14 @@ static int machine_obj_index_store(lua_State *L) {
     return 0;
 }
 
+/// \brief This is the machine:store_delta() method implementation.
+/// \param L Lua state.
+static int machine_obj_index_store_delta(lua_State *L) {
+    auto &m = clua_check<clua_managed_cm_ptr<cm_machine>>(L, 1);
+    TRY_EXECUTE(cm_store_delta(m.get(), luaL_checkstring(L, 2), luaL_checkstring(L, 3), err_msg));
+    return 0;
+}
+
 /// \brief This is the machine:verify_dirty_page_maps() method implementation.
 /// \param L Lua state.
 static int machine_obj_index_verify_dirty_page_maps(lua_State *L) {
@@ -541,6 +596,14 @@ static int machine_obj_index_rollback(lua_State *L) {
     return 0;
 }
 
+/// \brief This is the machine:commit() method implementation.
+/// \param L Lua state.
+static int machine_obj_index_commit(lua_State *L) {
+    auto &m = clua_check<clua_managed_cm_ptr<cm_machine>>(L, 1);
+    TRY_EXECUTE(cm_commit(m.get(), err_msg));
+    return 0;
+}
+
 /// \brief Contents of the machine object metatable __index table.
 static const auto machine_obj_index = cartesi::clua_make_luaL_Reg_array({
     {"get_proof", machine_obj_index_get_proof},
@@ -603,9 +666,13 @@ static const auto machine_obj_index = cartesi::clua_make_luaL_Reg_array({
     {"read_x", machine_obj_index_read_x},
     {"read_f", machine_obj_index_read_f},
     {"run", machine_obj_index_run},
+    {"run_with_checkpoints", machine_obj_index_run_with_checkpoints},
+    {"transaction", machine_obj_index_transaction},
     {"run_uarch", machine_obj_index_run_uarch},
     {"log_uarch_step", machine_obj_index_log_uarch_step},
+    {"log_uarch_steps", machine_obj_index_log_uarch_steps},
     {"store", machine_obj_index_store},
+    {"store_delta", machine_obj_index_store_delta},
     {"verify_dirty_page_maps", machine_obj_index_verify_dirty_page_maps},
     {"verify_merkle_tree", machine_obj_index_verify_merkle_tree},
     {"write_clint_mtimecmp", machine_obj_index_write_clint_mtimecmp},
@@ -654,6 +721,7 @@ static const auto machine_obj_index = cartesi::clua_make_luaL_Reg_array({
     {"destroy", machine_obj_index_destroy},
     {"snapshot", machine_obj_index_snapshot},
     {"rollback", machine_obj_index_rollback},
+    {"commit", machine_obj_index_commit},
     {"read_uarch_halt_flag", machine_obj_index_read_uarch_halt_flag},
     {"set_uarch_halt_flag", machine_obj_index_set_uarch_halt_flag},
     {"get_memory_ranges", machine_obj_index_get_memory_ranges},
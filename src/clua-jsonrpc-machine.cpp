@@ -130,6 +130,25 @@ static int jsonrpc_machine_class_verify_uarch_reset_state_transition(lua_State *
     return 1;
 }
 
+/// \brief This is the machine.verify_uarch_step_state_transitions()
+/// static method implementation.
+static int jsonrpc_machine_class_verify_uarch_step_state_transitions(lua_State *L) {
+    const int stubidx = lua_upvalueindex(1);
+    const int ctxidx = lua_upvalueindex(2);
+    lua_settop(L, 4);
+    auto &managed_jsonrpc_mg_mgr = clua_check<clua_managed_cm_ptr<cm_jsonrpc_mg_mgr>>(L, stubidx, ctxidx);
+    auto &transitions = clua_push_to(L, clua_uarch_step_transitions{}, ctxidx);
+    clua_check_uarch_step_transitions(L, 1, 2, 3, transitions, ctxidx);
+    auto &managed_runtime_config = clua_push_to(L,
+        clua_managed_cm_ptr<cm_machine_runtime_config>(clua_opt_cm_machine_runtime_config(L, 4, {}, ctxidx)), ctxidx);
+    TRY_EXECUTE(cm_jsonrpc_verify_uarch_step_state_transitions(managed_jsonrpc_mg_mgr.get(), transitions.root_hashes_before.data(),
+        transitions.logs.data(), transitions.root_hashes_after.data(), transitions.logs.size(),
+        managed_runtime_config.get(), true, transitions.log_err_msgs.data(), err_msg));
+    managed_runtime_config.reset();
+    clua_push_uarch_step_transition_results(L, transitions);
+    return 1;
+}
+
 /// \brief This is the machine.get_x_address() method implementation.
 static int jsonrpc_machine_class_get_x_address(lua_State *L) {
     auto &managed_jsonrpc_mg_mgr =
@@ -177,6 +196,7 @@ static const auto jsonrpc_machine_static_methods = cartesi::clua_make_luaL_Reg_a
     {"get_default_config", jsonrpc_machine_class_get_default_config},
     {"verify_uarch_step_log", jsonrpc_machine_class_verify_uarch_step_log},
     {"verify_uarch_step_state_transition", jsonrpc_machine_class_verify_uarch_step_state_transition},
+    {"verify_uarch_step_state_transitions", jsonrpc_machine_class_verify_uarch_step_state_transitions},
     {"verify_uarch_reset_log", jsonrpc_machine_class_verify_uarch_reset_log},
     {"verify_uarch_reset_state_transition", jsonrpc_machine_class_verify_uarch_reset_state_transition},
     {"get_x_address", jsonrpc_machine_class_get_x_address},
@@ -257,6 +277,14 @@ static int jsonrpc_server_class_shutdown(lua_State *L) {
     return 1;
 }
 
+/// \brief This is the set_keep_alive method implementation.
+static int jsonrpc_server_class_set_keep_alive(lua_State *L) {
+    auto &managed_jsonrpc_mg_mgr =
+        clua_check<clua_managed_cm_ptr<cm_jsonrpc_mg_mgr>>(L, lua_upvalueindex(1), lua_upvalueindex(2));
+    TRY_EXECUTE(cm_jsonrpc_set_keep_alive(managed_jsonrpc_mg_mgr.get(), lua_toboolean(L, 1), err_msg));
+    return 0;
+}
+
 /// \brief This is the fork method implementation.
 static int jsonrpc_server_class_fork(lua_State *L) {
     auto &managed_jsonrpc_mg_mgr =
@@ -274,6 +302,7 @@ static const auto jsonrpc_server_static_methods = cartesi::clua_make_luaL_Reg_ar
     {"get_version", jsonrpc_server_class_get_version},
     {"shutdown", jsonrpc_server_class_shutdown},
     {"fork", jsonrpc_server_class_fork},
+    {"set_keep_alive", jsonrpc_server_class_set_keep_alive},
 });
 
 /// \brief This is the jsonrpc.stub() method implementation.
@@ -309,6 +338,8 @@ int clua_jsonrpc_machine_init(lua_State *L, int ctxidx) {
     clua_createnewtype<clua_managed_cm_ptr<const cm_machine_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_machine_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_access_log>>(L, ctxidx);
+    clua_createnewtype<clua_managed_cm_ptr<cm_access_log_array>>(L, ctxidx);
+    clua_createnewtype<clua_managed_cm_ptr<cm_checkpoint_array>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_machine_runtime_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_merkle_tree_proof>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<char>>(L, ctxidx);
@@ -316,6 +347,7 @@ int clua_jsonrpc_machine_init(lua_State *L, int ctxidx) {
     clua_createnewtype<clua_managed_cm_ptr<cm_memory_range_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<const cm_semantic_version>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_jsonrpc_mg_mgr>>(L, ctxidx);
+    clua_createnewtype<clua_uarch_step_transitions>(L, ctxidx);
     return 1;
 }
 
@@ -69,6 +69,18 @@ void cm_delete(cm_access_log *ptr) {
     cm_delete_access_log(ptr);
 }
 
+/// \brief Deleter for C api access log array
+template <>
+void cm_delete(cm_access_log_array *ptr) {
+    cm_delete_access_log_array(ptr);
+}
+
+/// \brief Deleter for C api checkpoint array
+template <>
+void cm_delete(cm_checkpoint_array *ptr) {
+    cm_delete_checkpoint_array(ptr);
+}
+
 /// \brief Deleter for C api merkle tree proof
 template <>
 void cm_delete(cm_merkle_tree_proof *ptr) {
@@ -509,6 +521,59 @@ cm_access_log *clua_check_cm_access_log(lua_State *L, int tabidx, int ctxidx) {
     return log;
 }
 
+clua_uarch_step_transitions::~clua_uarch_step_transitions() {
+    for (auto *log : logs) {
+        cm_delete_access_log(log);
+    }
+    for (const auto *err_msg : log_err_msgs) {
+        cm_delete_cstring(err_msg);
+    }
+}
+
+void clua_check_uarch_step_transitions(lua_State *L, int beforeidx, int logsidx, int afteridx,
+    clua_uarch_step_transitions &transitions, int ctxidx) {
+    beforeidx = lua_absindex(L, beforeidx);
+    logsidx = lua_absindex(L, logsidx);
+    afteridx = lua_absindex(L, afteridx);
+    ctxidx = lua_absindex(L, ctxidx);
+    luaL_checktype(L, beforeidx, LUA_TTABLE);
+    luaL_checktype(L, logsidx, LUA_TTABLE);
+    luaL_checktype(L, afteridx, LUA_TTABLE);
+    const auto count = static_cast<size_t>(luaL_len(L, logsidx));
+    if (static_cast<size_t>(luaL_len(L, beforeidx)) != count || static_cast<size_t>(luaL_len(L, afteridx)) != count) {
+        luaL_error(L, "number of root hashes does not match number of logs");
+    }
+    transitions.root_hashes_before.resize(count);
+    transitions.root_hashes_after.resize(count);
+    transitions.logs.reserve(count);
+    for (size_t i = 1; i <= count; ++i) {
+        lua_geti(L, beforeidx, static_cast<lua_Integer>(i));
+        clua_check_cm_hash(L, -1, &transitions.root_hashes_before[i - 1]);
+        lua_pop(L, 1);
+        lua_geti(L, afteridx, static_cast<lua_Integer>(i));
+        clua_check_cm_hash(L, -1, &transitions.root_hashes_after[i - 1]);
+        lua_pop(L, 1);
+        lua_geti(L, logsidx, static_cast<lua_Integer>(i));
+        auto &managed_log =
+            clua_push_to(L, clua_managed_cm_ptr<cm_access_log>(clua_check_cm_access_log(L, -1, ctxidx)), ctxidx);
+        transitions.logs.push_back(managed_log.release());
+        lua_pop(L, 2);
+    }
+    transitions.log_err_msgs.resize(count, nullptr);
+}
+
+void clua_push_uarch_step_transition_results(lua_State *L, const clua_uarch_step_transitions &transitions) {
+    lua_createtable(L, static_cast<int>(transitions.log_err_msgs.size()), 0);
+    for (size_t i = 0; i < transitions.log_err_msgs.size(); ++i) {
+        if (transitions.log_err_msgs[i] != nullptr) {
+            lua_pushstring(L, transitions.log_err_msgs[i]);
+        } else {
+            lua_pushboolean(L, true);
+        }
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+}
+
 void clua_check_cm_hash(lua_State *L, int idx, cm_hash *c_hash) {
     if (lua_isstring(L, idx)) {
         size_t len = 0;
@@ -970,6 +1035,7 @@ void clua_push_cm_machine_config(lua_State *L, const cm_machine_config *c) {
 static void push_cm_concurrency_runtime_config(lua_State *L, const cm_concurrency_runtime_config *c) {
     lua_newtable(L);
     clua_setintegerfield(L, c->update_merkle_tree, "update_merkle_tree", -1);
+    clua_setintegerfield(L, c->verify_uarch_step, "verify_uarch_step", -1);
 }
 
 void clua_push_cm_machine_runtime_config(lua_State *L, const cm_machine_runtime_config *r) {
@@ -1281,6 +1347,7 @@ static void check_cm_concurrency_runtime_config(lua_State *L, int tabidx, cm_con
         return;
     }
     c->update_merkle_tree = opt_uint_field(L, -1, "update_merkle_tree");
+    c->verify_uarch_step = opt_uint_field(L, -1, "verify_uarch_step");
     lua_pop(L, 1);
 }
 
@@ -1296,6 +1363,19 @@ static void check_cm_htif_runtime_config(lua_State *L, int tabidx, cm_htif_runti
     lua_pop(L, 1);
 }
 
+/// \brief Loads C api host TLB runtime config from Lua
+/// \param L Lua state
+/// \param tabidx Runtime config stack index
+/// \param c C api host TLB runtime config structure to receive results
+static void check_cm_host_tlb_runtime_config(lua_State *L, int tabidx, cm_host_tlb_runtime_config *c) {
+    if (!opt_table_field(L, tabidx, "host_tlb")) {
+        return;
+    }
+    c->size = opt_uint_field(L, -1, "size");
+    c->ways = opt_uint_field(L, -1, "ways");
+    lua_pop(L, 1);
+}
+
 cm_machine_runtime_config *clua_check_cm_machine_runtime_config(lua_State *L, int tabidx, int ctxidx) {
     luaL_checktype(L, tabidx, LUA_TTABLE);
     auto &managed =
@@ -1303,6 +1383,9 @@ cm_machine_runtime_config *clua_check_cm_machine_runtime_config(lua_State *L, in
     cm_machine_runtime_config *config = managed.get();
     check_cm_concurrency_runtime_config(L, tabidx, &config->concurrency);
     check_cm_htif_runtime_config(L, tabidx, &config->htif);
+    check_cm_host_tlb_runtime_config(L, tabidx, &config->host_tlb);
+    config->page_hash_cache_size = opt_uint_field(L, tabidx, "page_hash_cache_size");
+    config->map_ram_image = opt_boolean_field(L, tabidx, "map_ram_image");
     config->skip_root_hash_check = opt_boolean_field(L, tabidx, "skip_root_hash_check");
     config->skip_version_check = opt_boolean_field(L, tabidx, "skip_version_check");
     managed.release();
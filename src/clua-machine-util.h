@@ -84,6 +84,14 @@ void cm_delete(cm_dtb_config *p);
 template <>
 void cm_delete(cm_access_log *ptr);
 
+/// \brief Deleter for C api access log array
+template <>
+void cm_delete(cm_access_log_array *ptr);
+
+/// \brief Deleter for C api checkpoint array
+template <>
+void cm_delete(cm_checkpoint_array *ptr);
+
 /// \brief Deleter for C api merkle tree proof
 template <>
 void cm_delete(cm_merkle_tree_proof *p);
@@ -227,6 +235,37 @@ cm_merkle_tree_proof *clua_check_cm_merkle_tree_proof(lua_State *L, int tabidx);
 /// \returns The access log. Must be delete by the user with cm_delete_access_log
 cm_access_log *clua_check_cm_access_log(lua_State *L, int tabidx, int ctxidx = lua_upvalueindex(1));
 
+/// \brief State transitions loaded from Lua to be verified together, owning their C api objects
+struct clua_uarch_step_transitions {
+    std::vector<cm_hash> root_hashes_before;
+    std::vector<cm_access_log *> logs;
+    std::vector<cm_hash> root_hashes_after;
+    std::vector<char *> log_err_msgs; ///< Receives the reason each transition is invalid, or NULL
+
+    clua_uarch_step_transitions() = default;
+    clua_uarch_step_transitions(clua_uarch_step_transitions &&other) = default;
+    clua_uarch_step_transitions(const clua_uarch_step_transitions &other) = delete;
+    clua_uarch_step_transitions &operator=(const clua_uarch_step_transitions &other) = delete;
+    clua_uarch_step_transitions &operator=(clua_uarch_step_transitions &&other) = delete;
+    ~clua_uarch_step_transitions();
+};
+
+/// \brief Loads state transitions from three Lua arrays of the same length
+/// \param L Lua state
+/// \param beforeidx Index in stack of the array of root hashes before each step
+/// \param logsidx Index in stack of the array of step access logs
+/// \param afteridx Index in stack of the array of root hashes after each step
+/// \param transitions Receives the state transitions
+/// \param ctxidx Index of clua context
+void clua_check_uarch_step_transitions(lua_State *L, int beforeidx, int logsidx, int afteridx,
+    clua_uarch_step_transitions &transitions, int ctxidx = lua_upvalueindex(1));
+
+/// \brief Pushes the results of verifying state transitions to the Lua stack
+/// \param L Lua state
+/// \param transitions Verified state transitions
+/// \details Pushes an array with true for each valid transition, and the reason it is not valid for the others.
+void clua_push_uarch_step_transition_results(lua_State *L, const clua_uarch_step_transitions &transitions);
+
 /// \brief Loads a cm_machine_config object from a Lua table
 /// \param L Lua state
 /// \param tabidx Index of table in Lua stack
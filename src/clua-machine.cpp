@@ -65,6 +65,21 @@ static int machine_class_index_verify_uarch_step_state_transition(lua_State *L)
     managed_runtime_config.reset();
     return 1;
 }
+/// \brief This is the machine.verify_uarch_step_state_transitions() method implementation.
+static int machine_class_index_verify_uarch_step_state_transitions(lua_State *L) {
+    lua_settop(L, 4);
+    auto &transitions = clua_push_to(L, clua_uarch_step_transitions{});
+    clua_check_uarch_step_transitions(L, 1, 2, 3, transitions);
+    auto &managed_runtime_config =
+        clua_push_to(L, clua_managed_cm_ptr<cm_machine_runtime_config>(clua_check_cm_machine_runtime_config(L, 4)));
+    TRY_EXECUTE(cm_verify_uarch_step_state_transitions(transitions.root_hashes_before.data(),
+        transitions.logs.data(), transitions.root_hashes_after.data(), transitions.logs.size(),
+        managed_runtime_config.get(), true, transitions.log_err_msgs.data(), err_msg));
+    managed_runtime_config.reset();
+    clua_push_uarch_step_transition_results(L, transitions);
+    return 1;
+}
+
 /// \brief This is the machine.verify_uarch_reset_log() method implementation.
 static int machine_class_index_verify_uarch_reset_log(lua_State *L) {
     lua_settop(L, 2);
@@ -137,6 +152,7 @@ static const auto machine_class_index = cartesi::clua_make_luaL_Reg_array({
     {"get_default_config", machine_class_index_get_default_config},
     {"verify_uarch_step_log", machine_class_index_verify_uarch_step_log},
     {"verify_uarch_step_state_transition", machine_class_index_verify_uarch_step_state_transition},
+    {"verify_uarch_step_state_transitions", machine_class_index_verify_uarch_step_state_transitions},
     {"verify_uarch_reset_log", machine_class_index_verify_uarch_reset_log},
     {"verify_uarch_reset_state_transition", machine_class_index_verify_uarch_reset_state_transition},
     {"get_x_address", machine_class_index_get_x_address},
@@ -176,12 +192,15 @@ int clua_machine_init(lua_State *L, int ctxidx) {
     clua_createnewtype<clua_managed_cm_ptr<const cm_machine_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_machine_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_access_log>>(L, ctxidx);
+    clua_createnewtype<clua_managed_cm_ptr<cm_access_log_array>>(L, ctxidx);
+    clua_createnewtype<clua_managed_cm_ptr<cm_checkpoint_array>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_machine_runtime_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_merkle_tree_proof>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<char>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<unsigned char>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_memory_range_config>>(L, ctxidx);
     clua_createnewtype<clua_managed_cm_ptr<cm_memory_range_descr_array>>(L, ctxidx);
+    clua_createnewtype<clua_uarch_step_transitions>(L, ctxidx);
     if (!clua_typeexists<machine_class>(L, ctxidx)) {
         clua_createtype<machine_class>(L, "cartesi machine class", ctxidx);
         clua_setmethods<machine_class>(L, machine_class_index.data(), 0, ctxidx);
@@ -0,0 +1,146 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CONCAT_HASH_CACHE_H
+#define CONCAT_HASH_CACHE_H
+
+/// \file
+/// \brief Thread-safe memo of hashes of concatenated hash pairs
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "i-hasher.h"
+#include "merkle-tree-proof.h"
+
+namespace cartesi {
+
+/// \brief Thread-safe memo of hashes of concatenated hash pairs
+/// \details \{
+/// Proofs of accesses to nearby addresses, or of the same address before and
+/// after a write, climb the tree through the same nodes. When many such proofs are
+/// verified together, each node hash along the shared paths is computed once and
+/// then looked up. The memo is split into shards, each with its own mutex, so
+/// threads verifying different proofs rarely wait on each other. Each shard holds
+/// a bounded number of entries, and starts over when full, so memory use does not
+/// grow with the number of proofs verified.
+/// \}
+/// \tparam HASHER_TYPE Hasher class
+template <typename HASHER_TYPE>
+class concat_hash_cache final {
+public:
+    using hasher_type = HASHER_TYPE;
+    using hash_type = typename hasher_type::hash_type;
+
+    /// \brief Number of independently locked shards
+    static constexpr int shard_count = 64;
+
+    /// \brief Maximum number of entries in each shard (64Ki entries in all)
+    static constexpr size_t max_shard_size = 1024;
+
+    concat_hash_cache() = default;
+    ~concat_hash_cache() = default;
+    concat_hash_cache(const concat_hash_cache &) = delete;
+    concat_hash_cache &operator=(const concat_hash_cache &) = delete;
+    concat_hash_cache(concat_hash_cache &&) = delete;
+    concat_hash_cache &operator=(concat_hash_cache &&) = delete;
+
+    /// \brief Computes the hash of concatenated hashes, or looks it up if it was computed before
+    /// \param h Hasher object to use on a miss
+    /// \param left Left hash to concatenate
+    /// \param right Right hash to concatenate
+    /// \param result Receives the hash of the concatenation
+    void get_concat_hash(hasher_type &h, const hash_type &left, const hash_type &right, hash_type &result) {
+        const key_type key{left, right};
+        auto &shard = m_shards[key_hash{}(key) % shard_count];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.hashes.find(key);
+            if (it != shard.hashes.end()) {
+                result = it->second;
+                return;
+            }
+        }
+        // Hash outside the lock. Two threads may race to compute the same entry, but both get the same value.
+        cartesi::get_concat_hash(h, left, right, result);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.hashes.size() >= max_shard_size) {
+            shard.hashes.clear();
+        }
+        shard.hashes.emplace(key, result);
+    }
+
+    /// \brief Computes the root hash a proof would have with a new target hash, using the memo
+    /// \tparam ADDRESS_TYPE Address type of proof
+    /// \param h Hasher object to use on misses
+    /// \param proof Proof whose sibling hashes are used
+    /// \param new_target_hash Hash of target node
+    /// \return Root hash
+    /// \details Gives the same result as merkle_tree_proof::bubble_up().
+    template <typename ADDRESS_TYPE>
+    hash_type bubble_up(hasher_type &h, const merkle_tree_proof<hash_type, ADDRESS_TYPE> &proof,
+        const hash_type &new_target_hash) {
+        hash_type hash = new_target_hash;
+        for (int log2_size = proof.get_log2_target_size(); log2_size < proof.get_log2_root_size(); ++log2_size) {
+            const int bit = (proof.get_target_address() & (static_cast<ADDRESS_TYPE>(1) << log2_size)) != 0;
+            if (bit) {
+                get_concat_hash(h, proof.get_sibling_hash(log2_size), hash, hash);
+            } else {
+                get_concat_hash(h, hash, proof.get_sibling_hash(log2_size), hash);
+            }
+        }
+        return hash;
+    }
+
+    /// \brief Verifies a proof, using the memo
+    /// \tparam ADDRESS_TYPE Address type of proof
+    /// \param h Hasher object to use on misses
+    /// \param proof Proof to verify
+    /// \return True if the target hash bubbles up to the root hash
+    template <typename ADDRESS_TYPE>
+    bool verify(hasher_type &h, const merkle_tree_proof<hash_type, ADDRESS_TYPE> &proof) {
+        return bubble_up(h, proof, proof.get_target_hash()) == proof.get_root_hash();
+    }
+
+private:
+    using key_type = std::array<hash_type, 2>;
+
+    /// \brief Hashes are already uniformly distributed, so any of their bytes make a good key hash
+    struct key_hash {
+        size_t operator()(const key_type &key) const {
+            uint64_t left = 0;
+            uint64_t right = 0;
+            memcpy(&left, key[0].data(), sizeof(left));
+            memcpy(&right, key[1].data(), sizeof(right));
+            return static_cast<size_t>(left ^ (right * UINT64_C(0x9e3779b97f4a7c15)));
+        }
+    };
+
+    struct shard_type {
+        std::mutex mutex;
+        std::unordered_map<key_type, hash_type, key_hash> hashes;
+    };
+
+    std::array<shard_type, shard_count> m_shards;
+};
+
+} // namespace cartesi
+
+#endif
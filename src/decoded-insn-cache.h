@@ -0,0 +1,93 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef DECODED_INSN_CACHE_H
+#define DECODED_INSN_CACHE_H
+
+/// \file
+/// \brief Decoded instruction cache.
+/// \details \{
+/// The interpreter remembers, for each 2-byte aligned instruction slot of recently executed pages of code,
+/// the handler the instruction in that slot was decoded to, so hot code skips the instruction decoder.
+///
+/// Every slot is tagged with the raw instruction bits it was decoded from,
+/// and the interpreter only uses a slot when its tag matches the bits it has just fetched.
+/// The handler is a function of the instruction bits alone, so a slot can never go stale:
+/// writes to code pages, FENCE.I, SFENCE.VMA, or even two host pages sharing the same slots,
+/// can only cause misses, never a change in behavior.
+/// This is what keeps the interpreter bit-for-bit identical with and without the cache,
+/// without having to track writes to code pages.
+///
+/// The cache is host-only state and is not part of the machine state Merkle tree.
+/// \}
+
+#include <cstdint>
+#include <memory>
+
+#include "pma-constants.h"
+
+namespace cartesi {
+
+/// \brief Decoded instruction cache constants.
+enum DECODED_INSN_CACHE_constants : uint64_t {
+    DECODED_INSN_CACHE_PAGES_LOG2 = 8,                               ///< log<sub>2</sub> of number of pages
+    DECODED_INSN_CACHE_PAGES = UINT64_C(1) << DECODED_INSN_CACHE_PAGES_LOG2, ///< Number of pages in the cache
+    DECODED_INSN_CACHE_SLOTS_PER_PAGE = PMA_PAGE_SIZE / sizeof(uint16_t), ///< Instruction slots in each page
+};
+
+/// \brief Decoded instruction slot.
+struct decoded_insn_slot final {
+    uint32_t insn;    ///< Raw instruction bits the slot was decoded from (tag)
+    uint32_t handler; ///< Handler the instruction was decoded to (interpreted by the interpreter)
+};
+
+/// \brief Decoded instruction cache.
+/// \details Pages of slots are direct-mapped by the host address of the code page.
+/// Zero-filled slots are valid: the interpreter guarantees that instruction 0 decodes to handler 0.
+class decoded_insn_cache final {
+    std::unique_ptr<decoded_insn_slot[]> m_slots; ///< Slots for all pages
+
+public:
+    /// \brief Constructor
+    decoded_insn_cache(void) :
+        m_slots(std::make_unique<decoded_insn_slot[]>(DECODED_INSN_CACHE_PAGES * DECODED_INSN_CACHE_SLOTS_PER_PAGE)) {
+        ;
+    }
+
+    /// \brief No copy constructor
+    decoded_insn_cache(const decoded_insn_cache &) = delete;
+    /// \brief No copy assignment
+    decoded_insn_cache &operator=(const decoded_insn_cache &) = delete;
+    /// \brief No move constructor
+    decoded_insn_cache(decoded_insn_cache &&) = delete;
+    /// \brief No move assignment
+    decoded_insn_cache &operator=(decoded_insn_cache &&) = delete;
+    /// \brief Default destructor
+    ~decoded_insn_cache() = default;
+
+    /// \brief Returns the slots for a page of code.
+    /// \param hpage Pointer to start of the page in host memory.
+    /// \returns Pointer to the first of DECODED_INSN_CACHE_SLOTS_PER_PAGE slots.
+    decoded_insn_slot *get_page_slots(const unsigned char *hpage) {
+        const auto page_index = (reinterpret_cast<uintptr_t>(hpage) >> PMA_PAGE_SIZE_LOG2) &
+            (DECODED_INSN_CACHE_PAGES - 1);
+        return m_slots.get() + page_index * DECODED_INSN_CACHE_SLOTS_PER_PAGE;
+    }
+};
+
+} // namespace cartesi
+
+#endif
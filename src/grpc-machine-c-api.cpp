@@ -154,6 +154,25 @@ int cm_grpc_verify_uarch_step_state_transition(const cm_grpc_machine_stub *stub,
     return cm_result_failure(err_msg);
 }
 
+int cm_grpc_verify_uarch_step_state_transitions(const cm_grpc_machine_stub *stub, const cm_hash *root_hashes_before,
+    const cm_access_log *const *logs, const cm_hash *root_hashes_after, size_t count,
+    const cm_machine_runtime_config *runtime_config, bool one_based, char **log_err_msgs, char **err_msg) try {
+    if (log_err_msgs == nullptr && count > 0) {
+        throw std::invalid_argument("invalid log error messages output");
+    }
+    const auto *cpp_stub = convert_from_c(stub);
+    const auto cpp_root_hashes_before = convert_from_c(root_hashes_before, count);
+    const auto cpp_logs = convert_from_c(logs, count);
+    const auto cpp_root_hashes_after = convert_from_c(root_hashes_after, count);
+    const cartesi::machine_runtime_config cpp_runtime = convert_from_c(runtime_config);
+    convert_to_c(cartesi::grpc_virtual_machine::verify_uarch_step_state_transitions(*cpp_stub, cpp_root_hashes_before,
+                     cpp_logs, cpp_root_hashes_after, cpp_runtime, one_based),
+        log_err_msgs);
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
 int cm_grpc_verify_uarch_reset_log(const cm_grpc_machine_stub *stub, const cm_access_log *log,
     const cm_machine_runtime_config *runtime_config, bool one_based, char **err_msg) try {
     const auto *cpp_stub = convert_from_c(stub);
@@ -145,6 +145,26 @@ CM_API int cm_grpc_verify_uarch_step_state_transition(const cm_grpc_machine_stub
     const cm_access_log *log, const cm_hash *root_hash_after, const cm_machine_runtime_config *runtime_config,
     bool one_based, char **err_msg);
 
+/// \brief Checks the validity of many independent state transitions
+/// \param stub Cartesi grpc machine stub. Must be pointer to valid object
+/// \param root_hashes_before Array with the state hash before each step
+/// \param logs Array with the step state access logs
+/// \param root_hashes_after Array with the state hash after each step
+/// \param count Number of entries in each array
+/// \param runtime_config Machine runtime configuration. Must be pointer to valid object
+/// \param one_based Use 1-based indices when reporting errors
+/// \param log_err_msgs Array of count entries. Each receives NULL if its state transition is valid,
+/// or the reason it is not, which must be deleted by the function caller using cm_delete_cstring
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successfull function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring
+/// \returns 0 if all state transitions were checked, valid or not, non zero code for error
+/// \details The gRPC protocol has no batch call, so each transition is sent in its own request.
+CM_API int cm_grpc_verify_uarch_step_state_transitions(const cm_grpc_machine_stub *stub,
+    const cm_hash *root_hashes_before, const cm_access_log *const *logs, const cm_hash *root_hashes_after,
+    size_t count, const cm_machine_runtime_config *runtime_config, bool one_based, char **log_err_msgs,
+    char **err_msg);
+
 /// \brief Gets the address of a general-purpose register from remote cartesi server
 /// \param stub Cartesi grpc machine stub. Must be pointer to valid object
 /// \param i Register index. Between 0 and X_REG_COUNT-1, inclusive.
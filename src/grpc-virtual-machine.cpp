@@ -20,6 +20,7 @@
 
 #include "grpc-config.h"
 #include "grpc-virtual-machine.h"
+#include "machine-transaction.h"
 #include "protobuf-util.h"
 
 using grpc::ClientContext;
@@ -336,6 +337,34 @@ void grpc_virtual_machine::verify_uarch_step_state_transition(const grpc_machine
     check_status(stub->get_stub()->VerifyUarchStepStateTransition(&context, request, &response));
 }
 
+std::vector<std::string> grpc_virtual_machine::verify_uarch_step_state_transitions(const grpc_machine_stub_ptr &stub,
+    const std::vector<hash_type> &root_hashes_before, const std::vector<access_log> &logs,
+    const std::vector<hash_type> &root_hashes_after, const machine_runtime_config &r, bool one_based) {
+    if (root_hashes_before.size() != logs.size() || root_hashes_after.size() != logs.size()) {
+        throw std::invalid_argument{"number of root hashes does not match number of logs"};
+    }
+    // The protocol has no batch call, so send one request per transition
+    std::vector<std::string> errors(logs.size());
+    for (size_t i = 0; i < logs.size(); ++i) {
+        VerifyUarchStepStateTransitionRequest request;
+        Void response;
+        ClientContext context;
+        set_proto_hash(root_hashes_before[i], request.mutable_root_hash_before());
+        set_proto_access_log(logs[i], request.mutable_log());
+        set_proto_hash(root_hashes_after[i], request.mutable_root_hash_after());
+        set_proto_machine_runtime_config(r, request.mutable_runtime());
+        request.set_one_based(one_based);
+        const auto status = stub->get_stub()->VerifyUarchStepStateTransition(&context, request, &response);
+        // The server reports failed verifications as aborted, anything else is a failure of the request itself
+        if (status.error_code() == StatusCode::ABORTED && !status.error_message().empty()) {
+            errors[i] = status.error_message();
+        } else {
+            check_status(status);
+        }
+    }
+    return errors;
+}
+
 interpreter_break_reason grpc_virtual_machine::do_run(uint64_t mcycle_end) {
     RunRequest request;
     request.set_limit(mcycle_end);
@@ -354,6 +383,41 @@ interpreter_break_reason grpc_virtual_machine::do_run(uint64_t mcycle_end) {
     }
 }
 
+std::vector<std::pair<uint64_t, grpc_virtual_machine::hash_type>> grpc_virtual_machine::do_run_with_checkpoints(
+    uint64_t mcycle_end, uint64_t period) {
+    // The protocol has no call to run with checkpoints, so each segment and root hash is a request of its own
+    if (period == 0) {
+        throw std::invalid_argument{"checkpoint period cannot be zero"};
+    }
+    uint64_t mcycle = do_read_mcycle();
+    if (mcycle > mcycle_end) {
+        throw std::invalid_argument{"mcycle is past"};
+    }
+    std::vector<std::pair<uint64_t, hash_type>> checkpoints;
+    hash_type hash;
+    do_get_root_hash(hash);
+    checkpoints.emplace_back(mcycle, hash);
+    uint64_t next_checkpoint = mcycle;
+    while (mcycle < mcycle_end) {
+        next_checkpoint = (UINT64_MAX - next_checkpoint > period) ? next_checkpoint + period : UINT64_MAX;
+        const auto reason = do_run(std::min(next_checkpoint, mcycle_end));
+        const uint64_t previous_mcycle = std::exchange(mcycle, do_read_mcycle());
+        if (mcycle != previous_mcycle) {
+            do_get_root_hash(hash);
+            checkpoints.emplace_back(mcycle, hash);
+        }
+        if (reason != interpreter_break_reason::reached_target_mcycle) {
+            break;
+        }
+    }
+    return checkpoints;
+}
+
+std::string grpc_virtual_machine::do_transaction(const std::string &operations) {
+    // The gRPC protocol has no compound request, so each operation is a request of its own
+    return run_transaction(static_cast<i_virtual_machine &>(*this), nlohmann::json::parse(operations)).dump();
+}
+
 void grpc_virtual_machine::do_store(const std::string &dir) {
     StoreRequest request;
     request.set_directory(dir);
@@ -362,6 +426,12 @@ void grpc_virtual_machine::do_store(const std::string &dir) {
     check_status(m_stub->get_stub()->Store(&context, request, &response));
 }
 
+void grpc_virtual_machine::do_store_delta(const std::string &dir, const std::string &base_dir) {
+    (void) dir;
+    (void) base_dir;
+    throw std::runtime_error("store_delta is not supported by the gRPC protocol");
+}
+
 uint64_t grpc_virtual_machine::do_read_csr(csr r) const {
     ReadCsrRequest request;
     static_assert(cartesi::machine::num_csr == Csr_ARRAYSIZE);
@@ -833,6 +903,20 @@ machine_merkle_tree::proof_type grpc_virtual_machine::do_get_proof(uint64_t addr
     return get_proto_merkle_tree_proof(response.proof());
 }
 
+machine_merkle_tree::multiproof_type grpc_virtual_machine::do_get_multiproof(const std::vector<uint64_t> &addresses,
+    int log2_size) const {
+    // The gRPC protocol has no multiproofs, so assemble one from the proof of each node
+    std::vector<uint64_t> sorted{addresses};
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    std::vector<machine_merkle_tree::proof_type> proofs;
+    proofs.reserve(sorted.size());
+    for (const uint64_t address : sorted) {
+        proofs.push_back(do_get_proof(address, log2_size));
+    }
+    return machine_merkle_tree::multiproof_type::from_proofs(proofs);
+}
+
 void grpc_virtual_machine::do_replace_memory_range(const memory_range_config &new_range) {
     ReplaceMemoryRangeRequest request;
     MemoryRangeConfig *range = request.mutable_config();
@@ -857,6 +941,19 @@ access_log grpc_virtual_machine::do_log_uarch_step(const access_log::type &log_t
     return get_proto_access_log(response.log());
 }
 
+std::vector<access_log> grpc_virtual_machine::do_log_uarch_steps(uint64_t count, const access_log::type &log_type,
+    bool one_based) {
+    // The protocol has no call to log several steps at once, so the steps are logged one request at a time
+    std::vector<access_log> logs;
+    for (uint64_t i = 0; i < count; ++i) {
+        logs.push_back(do_log_uarch_step(log_type, one_based));
+        if (i + 1 < count && do_read_uarch_halt_flag()) {
+            break;
+        }
+    }
+    return logs;
+}
+
 void grpc_virtual_machine::do_destroy() {
     const Void request;
     Void response;
@@ -868,18 +965,18 @@ void grpc_virtual_machine::do_snapshot() {
     const Void request;
     Void response;
     ClientContext context;
-    m_stub->prepare_checkin();
     check_status(m_stub->get_stub()->Snapshot(&context, request, &response));
-    m_stub->wait_checkin_and_reconnect();
 }
 
 void grpc_virtual_machine::do_rollback() {
     const Void request;
     Void response;
     ClientContext context;
-    m_stub->prepare_checkin();
     check_status(m_stub->get_stub()->Rollback(&context, request, &response));
-    m_stub->wait_checkin_and_reconnect();
+}
+
+void grpc_virtual_machine::do_commit() {
+    throw std::runtime_error("commit is not supported by the gRPC protocol");
 }
 
 bool grpc_virtual_machine::do_verify_dirty_page_maps(void) const {
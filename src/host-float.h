@@ -0,0 +1,215 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST_FLOAT_H
+#define HOST_FLOAT_H
+
+/// \file
+/// \brief Floating-point operations that use the host FPU when it gives the same results as soft-float.
+/// \details \{
+/// The host FPU is used only for round-to-nearest-even operations on operands and results
+/// that are neither zero nor close to the overflow and underflow thresholds.
+/// In this range, the host result is the correctly rounded IEEE 754 result, and the only exception
+/// flag that can be raised is the inexact flag.
+/// Instead of reading host exception flags, which compilers are free to reorder around,
+/// the inexact flag is computed from the exact rounding error of each operation.
+/// Everything else falls back to soft-float.
+///
+/// No subnormal value is ever an operand, a result, or an intermediate value of the rounding error
+/// computations, so results do not change when the host flushes subnormals to zero (FTZ/DAZ).
+/// The host rounding mode is checked before each operation, in case the embedding program changed it.
+/// \}
+
+#include <cfenv>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "compiler-defines.h"
+#include "riscv-constants.h"
+#include "soft-float.h"
+
+// Expressions must be evaluated in the precision of their types, as they are with SSE2 or AArch64,
+// otherwise the host may round twice
+#if !defined(NO_HOST_FPU) && defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define HOST_FPU 1
+#endif
+
+namespace cartesi {
+
+/// \class i_hfloat
+/// \brief Interface for floating-point operations that try the host FPU before soft-float.
+/// \tparam FLOAT Host floating-point type.
+/// \tparam SFLOAT Soft-float interface for the same format.
+template <typename FLOAT, typename SFLOAT>
+struct i_hfloat {
+    using F_UINT = typename SFLOAT::F_UINT;
+
+    static_assert(sizeof(FLOAT) == sizeof(F_UINT), "incompatible host float size");
+    static_assert(std::numeric_limits<FLOAT>::is_iec559, "host float is not IEEE 754");
+    static_assert(std::numeric_limits<FLOAT>::digits == SFLOAT::MANT_SIZE + 1, "incompatible host float mantissa");
+
+    /// \brief Addition operation.
+    static F_UINT add(F_UINT a, F_UINT b, FRM_modes rm, uint32_t *pfflags) {
+        if (likely(rm == FRM_RNE && host_rounds_to_nearest())) {
+            const FLOAT x = to_float(a);
+            const FLOAT y = to_float(b);
+            if (likely(in_exact_range(x) && in_exact_range(y))) {
+                // The sum, and its rounding error (TwoSum), are multiples of the smallest ulp of the operands,
+                // so they are either zero or far from the subnormal range
+                const FLOAT s = x + y;
+                const FLOAT yy = s - x;
+                const FLOAT e = (x - (s - yy)) + (y - yy);
+                if (e != 0) {
+                    *pfflags |= FFLAGS_NX_MASK;
+                }
+                return to_uint(s);
+            }
+        }
+        return SFLOAT::add(a, b, rm, pfflags);
+    }
+
+    /// \brief Multiplication operation.
+    static F_UINT mul(F_UINT a, F_UINT b, FRM_modes rm, uint32_t *pfflags) {
+        if (likely(rm == FRM_RNE && host_rounds_to_nearest())) {
+            const FLOAT x = to_float(a);
+            const FLOAT y = to_float(b);
+            const FLOAT p = x * y;
+            if (likely(in_exact_range(x) && in_exact_range(y) && in_exact_range(p))) {
+                if (!is_exact_product(x, y, p)) {
+                    *pfflags |= FFLAGS_NX_MASK;
+                }
+                return to_uint(p);
+            }
+        }
+        return SFLOAT::mul(a, b, rm, pfflags);
+    }
+
+    /// \brief Division operation.
+    static F_UINT div(F_UINT a, F_UINT b, FRM_modes rm, uint32_t *pfflags) {
+        if (likely(rm == FRM_RNE && host_rounds_to_nearest())) {
+            const FLOAT x = to_float(a);
+            const FLOAT y = to_float(b);
+            if (likely(in_exact_range(x) && in_exact_range(y))) {
+                const FLOAT q = x / y;
+                if (likely(in_exact_range(q))) {
+                    if (!is_exact_product(q, y, x)) {
+                        *pfflags |= FFLAGS_NX_MASK;
+                    }
+                    return to_uint(q);
+                }
+            }
+        }
+        return SFLOAT::div(a, b, rm, pfflags);
+    }
+
+    /// \brief Square root operation.
+    static F_UINT sqrt(F_UINT a, FRM_modes rm, uint32_t *pfflags) {
+        if (likely(rm == FRM_RNE && host_rounds_to_nearest())) {
+            const FLOAT x = to_float(a);
+            // Also rules out negative operands
+            if (likely(x >= MIN_EXACT && x <= MAX_EXACT)) {
+                const FLOAT r = std::sqrt(x);
+                if (!is_exact_product(r, r, x)) {
+                    *pfflags |= FFLAGS_NX_MASK;
+                }
+                return to_uint(r);
+            }
+        }
+        return SFLOAT::sqrt(a, rm, pfflags);
+    }
+
+private:
+    static constexpr int DIGITS = std::numeric_limits<FLOAT>::digits;
+
+    static constexpr FLOAT TWO_POW_DIGITS = static_cast<FLOAT>(UINT64_C(1) << DIGITS);
+
+    /// \brief Smallest magnitude for which rounding errors of products and quotients never underflow
+    static constexpr FLOAT MIN_EXACT = std::numeric_limits<FLOAT>::min() * TWO_POW_DIGITS * TWO_POW_DIGITS;
+
+    /// \brief Largest magnitude for which intermediate values of the rounding error computations never overflow
+    static constexpr FLOAT MAX_EXACT = std::numeric_limits<FLOAT>::max() / TWO_POW_DIGITS;
+
+    /// \brief Checks if the host FPU is rounding to nearest-even
+    static bool host_rounds_to_nearest() {
+        return std::fegetround() == FE_TONEAREST;
+    }
+
+    static FLOAT to_float(F_UINT a) {
+        FLOAT x{};
+        memcpy(&x, &a, sizeof(x));
+        return x;
+    }
+
+    static F_UINT to_uint(FLOAT x) {
+        F_UINT a{};
+        memcpy(&a, &x, sizeof(a));
+        return a;
+    }
+
+    /// \brief Checks if a value is within the range where the host FPU can be used for products and quotients
+    /// \details This rules out zeros, infinities and NaNs.
+    static bool in_exact_range(FLOAT x) {
+        const FLOAT m = std::fabs(x);
+        return m >= MIN_EXACT && m <= MAX_EXACT;
+    }
+
+    /// \brief Checks if the exact product of x and y is z, when all are within the exact range
+    /// \details z must be within a factor of 2 from the rounded product of x and y.
+    static bool is_exact_product(FLOAT x, FLOAT y, FLOAT z) {
+        if constexpr (std::is_same_v<FLOAT, float>) {
+            // The product of two floats is exact in double precision
+            return static_cast<double>(x) * static_cast<double>(y) == static_cast<double>(z);
+        } else {
+#ifdef FP_FAST_FMA
+            return std::fma(x, y, -z) == 0;
+#else
+            // The product x * y is exactly ph + pl (Dekker's product)
+            FLOAT xh{};
+            FLOAT xl{};
+            FLOAT yh{};
+            FLOAT yl{};
+            split(x, xh, xl);
+            split(y, yh, yl);
+            const FLOAT ph = x * y;
+            const FLOAT e1 = xh * yh - ph;
+            const FLOAT e2 = e1 + xh * yl;
+            const FLOAT e3 = e2 + xl * yh;
+            const FLOAT pl = e3 + xl * yl;
+            // The subtraction is exact because z and ph are within a factor of 2 from each other
+            return z - ph == pl;
+#endif
+        }
+    }
+
+    /// \brief Splits a value into two halves with at most DIGITS/2 significant bits each (Veltkamp's split)
+    static void split(FLOAT x, FLOAT &h, FLOAT &l) {
+        const FLOAT c = x * static_cast<FLOAT>((UINT64_C(1) << ((DIGITS + 1) / 2)) + 1);
+        const FLOAT d = c - x;
+        h = c - d;
+        l = x - h;
+    }
+};
+
+using i_hfloat32 = i_hfloat<float, i_sfloat32>;  // Interface for single-precision floating-point
+using i_hfloat64 = i_hfloat<double, i_sfloat64>; // Interface for double-precision floating-point
+
+} // namespace cartesi
+
+#endif
@@ -0,0 +1,224 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST_TLB_H
+#define HOST_TLB_H
+
+/// \file
+/// \brief Host TLB.
+/// \details \{
+/// The shadow TLB is a direct-mapped table with PMA_TLB_SIZE entries per type.
+/// Its layout is part of the machine state, so it cannot grow without changing every proof.
+/// Guests with working sets larger than it covers keep evicting its entries,
+/// and each miss pays for a full page table walk.
+///
+/// The host TLB is a larger, set-associative cache of virtual to physical page translations
+/// that sits behind the shadow TLB. On a shadow TLB miss, the interpreter looks the page up
+/// in the host TLB before walking the page tables, and installs the result into the shadow TLB
+/// exactly as it would after a walk. The contents of the shadow TLB are therefore unchanged.
+///
+/// A hit must be indistinguishable from a walk, or the interpreter would diverge from the microarchitecture,
+/// which always walks. Each entry therefore keeps the page table entries its walk read, with the values they
+/// had once the walk set their accessed and dirty bits. The entry is only used while all of them still hold
+/// those values, and while satp, the effective privilege, and the mstatus bits the walk depends on are the
+/// same. A walk in these conditions would give the same translation without writing to any page table entry.
+/// Hits are thus exact no matter when entries are inserted or dropped, and the host TLB does not need to be
+/// flushed on SFENCE.VMA or between runs.
+///
+/// Entries point into host memory to read page table entries cheaply, so they are dropped when memory ranges
+/// are replaced.
+///
+/// The host TLB is host-only state and is not part of the machine state Merkle tree.
+/// \}
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "pma-constants.h"
+#include "shadow-tlb.h"
+#include "translate-virtual-address.h"
+
+namespace cartesi {
+
+/// \brief Host TLB constants.
+enum HOST_TLB_constants : uint64_t {
+    HOST_TLB_WAYS_MAX = 4,                  ///< Maximum number of ways in each set
+    HOST_TLB_SIZE_MAX = UINT64_C(1) << 20, ///< Maximum number of entries of each type
+};
+
+/// \brief Host TLB entry.
+struct host_tlb_entry final {
+    uint64_t vaddr_page;                                      ///< Target virtual address of page start
+    uint64_t paddr_page;                                      ///< Target physical address of page start
+    int levels;                                               ///< Number of page table entries read by the walk
+    std::array<const uint64_t *, PAGE_TABLE_LEVELS_MAX> hpte; ///< Host address of each page table entry
+    std::array<uint64_t, PAGE_TABLE_LEVELS_MAX> pte;          ///< Value of each page table entry after the walk
+};
+
+/// \brief Machine state that page table walks depend on, other than the page table entries themselves.
+struct host_tlb_context final {
+    uint64_t satp; ///< Value of satp
+    uint64_t mode; ///< Effective privilege, ORed with the mstatus bits that affect the walk
+
+    bool operator==(const host_tlb_context &other) const {
+        return satp == other.satp && mode == other.mode;
+    }
+    bool operator!=(const host_tlb_context &other) const {
+        return !(*this == other);
+    }
+};
+
+/// \brief Host TLB state.
+/// \details Each entry type has its own table of sets, and the entries in each set are kept in
+/// most recently used order, so the least recently used entry is the one replaced.
+class host_tlb_state final {
+    std::unique_ptr<host_tlb_entry[]> m_entries; ///< Entries of all types, one table after the other
+    uint64_t m_size{0};                          ///< Number of entries of each type, or 0 when disabled
+    uint64_t m_ways{0};                          ///< Number of entries in each set
+    uint64_t m_set_mask{0};                      ///< Mask selecting the set from a virtual page number
+    std::array<host_tlb_context, 3> m_contexts{}; ///< Context of the entries of each type
+
+    template <TLB_entry_type ETYPE>
+    host_tlb_entry *get_set(uint64_t vaddr) {
+        const uint64_t set = (vaddr >> PMA_PAGE_SIZE_LOG2) & m_set_mask;
+        return m_entries.get() + ETYPE * m_size + set * m_ways;
+    }
+
+public:
+    /// \brief Constructor
+    host_tlb_state(void) = default;
+
+    /// \brief No copy constructor
+    host_tlb_state(const host_tlb_state &) = delete;
+    /// \brief No copy assignment
+    host_tlb_state &operator=(const host_tlb_state &) = delete;
+    /// \brief No move constructor
+    host_tlb_state(host_tlb_state &&) = delete;
+    /// \brief No move assignment
+    host_tlb_state &operator=(host_tlb_state &&) = delete;
+    /// \brief Default destructor
+    ~host_tlb_state() = default;
+
+    /// \brief Sets the geometry of the host TLB and flushes it.
+    /// \param size Number of entries of each type, or 0 to disable the host TLB.
+    /// \param ways Number of entries in each set (1, 2, or 4).
+    void configure(uint64_t size, uint64_t ways) {
+        if (size == 0) {
+            m_entries.reset();
+            m_size = m_ways = m_set_mask = 0;
+            return;
+        }
+        if (ways != 1 && ways != 2 && ways != HOST_TLB_WAYS_MAX) {
+            throw std::invalid_argument{"host TLB ways must be 1, 2, or 4"};
+        }
+        if ((size & (size - 1)) != 0 || size < ways || size > HOST_TLB_SIZE_MAX) {
+            throw std::invalid_argument{"host TLB size must be a power of 2 between ways and 2^20"};
+        }
+        m_entries = std::make_unique<host_tlb_entry[]>(3 * size);
+        m_size = size;
+        m_ways = ways;
+        m_set_mask = size / ways - 1;
+        flush();
+    }
+
+    /// \brief Tells if the host TLB is enabled.
+    bool is_enabled(void) const {
+        return m_size != 0;
+    }
+
+    /// \brief Looks up the physical page of a virtual address.
+    /// \tparam ETYPE TLB entry type.
+    /// \param context Current context of page table walks for the type.
+    /// \param vaddr Target virtual address.
+    /// \param ppaddr Receives the target physical address on a hit.
+    /// \returns True on hit, false otherwise.
+    /// \details Entries of the type are dropped when the context changes.
+    template <TLB_entry_type ETYPE>
+    bool translate(const host_tlb_context &context, uint64_t vaddr, uint64_t *ppaddr) {
+        if (m_contexts[ETYPE] != context) {
+            flush<ETYPE>();
+            m_contexts[ETYPE] = context;
+            return false;
+        }
+        const uint64_t vaddr_page = vaddr & ~PAGE_OFFSET_MASK;
+        host_tlb_entry *set = get_set<ETYPE>(vaddr);
+        for (uint64_t way = 0; way < m_ways; ++way) {
+            if (set[way].vaddr_page == vaddr_page) {
+                const host_tlb_entry &entry = set[way];
+                // The page tables changed since the walk, so walk again
+                for (int i = 0; i < entry.levels; ++i) {
+                    if (*entry.hpte[i] != entry.pte[i]) {
+                        return false;
+                    }
+                }
+                const host_tlb_entry hit = entry;
+                // Move the entry to the front of the set
+                for (; way > 0; --way) {
+                    set[way] = set[way - 1];
+                }
+                set[0] = hit;
+                *ppaddr = hit.paddr_page | (vaddr & PAGE_OFFSET_MASK);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// \brief Inserts a translation, replacing the least recently used entry in its set.
+    /// \tparam ETYPE TLB entry type.
+    /// \param context Current context of page table walks for the type.
+    /// \param entry Entry to insert, with the page table entries read by the walk.
+    template <TLB_entry_type ETYPE>
+    void insert(const host_tlb_context &context, const host_tlb_entry &entry) {
+        if (m_contexts[ETYPE] != context) {
+            flush<ETYPE>();
+            m_contexts[ETYPE] = context;
+        }
+        host_tlb_entry *set = get_set<ETYPE>(entry.vaddr_page);
+        // Reuse the entry for the same page if there is one, so a page is never cached twice
+        uint64_t way = 0;
+        while (way < m_ways - 1 && set[way].vaddr_page != entry.vaddr_page) {
+            ++way;
+        }
+        for (; way > 0; --way) {
+            set[way] = set[way - 1];
+        }
+        set[0] = entry;
+    }
+
+    /// \brief Invalidates all entries of a type.
+    /// \tparam ETYPE TLB entry type.
+    template <TLB_entry_type ETYPE>
+    void flush(void) {
+        host_tlb_entry *entries = m_entries.get() + ETYPE * m_size;
+        for (uint64_t i = 0; i < m_size; ++i) {
+            entries[i].vaddr_page = TLB_INVALID_PAGE;
+        }
+    }
+
+    /// \brief Invalidates all entries of all types.
+    void flush(void) {
+        flush<TLB_CODE>();
+        flush<TLB_READ>();
+        flush<TLB_WRITE>();
+    }
+};
+
+} // namespace cartesi
+
+#endif
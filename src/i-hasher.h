@@ -61,6 +61,17 @@ public:
     void end(hash_type &hash) {
         return derived().do_end(hash);
     }
+
+    /// \brief Hashes a batch of equally sized messages in one go
+    /// \param data Pointer to the messages, stored back to back
+    /// \param length Length of each message
+    /// \param count Number of messages
+    /// \param hashes Receives the hash of each message, in order
+    /// \details Equivalent to calling begin(), add_data() and end() on each message,
+    /// but lets the hasher process several messages in parallel.
+    void hash_batch(const unsigned char *data, size_t length, size_t count, hash_type *hashes) {
+        return derived().do_hash_batch(data, length, count, hashes);
+    }
 };
 
 template <typename DERIVED>
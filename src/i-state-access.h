@@ -26,11 +26,13 @@
 #include "machine-statistics.h"
 #include "meta.h"
 #include "shadow-tlb.h"
+#include "translate-virtual-address.h"
 
 namespace cartesi {
 
 // Forward declarations
 enum class bracket_type;
+struct decoded_insn_slot;
 
 /// \class i_state_access
 /// \brief Interface for machine state access.
@@ -710,6 +712,26 @@ public:
         return derived().template do_replace_tlb_entry<ETYPE>(vaddr, paddr, pma);
     }
 
+    /// \brief Try to translate a virtual address to a physical address through the host TLB.
+    /// \tparam ETYPE TLB entry type.
+    /// \param vaddr Target virtual address.
+    /// \param ppaddr Pointer to physical address receiving value.
+    /// \returns True if successful (host TLB hit), false otherwise.
+    template <TLB_entry_type ETYPE>
+    bool translate_vaddr_via_host_tlb(uint64_t vaddr, uint64_t *ppaddr) {
+        return derived().template do_translate_vaddr_via_host_tlb<ETYPE>(vaddr, ppaddr);
+    }
+
+    /// \brief Inserts the translation found by a page table walk into the host TLB.
+    /// \tparam ETYPE TLB entry type.
+    /// \param vaddr Target virtual address.
+    /// \param paddr Target physical address.
+    /// \param walk Page table entries read by the walk.
+    template <TLB_entry_type ETYPE>
+    void insert_host_tlb_entry(uint64_t vaddr, uint64_t paddr, const page_table_walk &walk) {
+        derived().template do_insert_host_tlb_entry<ETYPE>(vaddr, paddr, walk);
+    }
+
     /// \brief Invalidates all TLB entries of a type.
     /// \tparam ETYPE TLB entry type to flush.
     template <TLB_entry_type ETYPE>
@@ -724,6 +746,13 @@ public:
         derived().template flush_tlb_type<TLB_WRITE>();
     }
 
+    /// \brief Returns the decoded instruction cache slots for a page of code.
+    /// \param hpage Pointer to start of the page in host memory.
+    /// \returns Pointer to the slots, or nullptr if the accessor does not cache decoded instructions.
+    decoded_insn_slot *get_decoded_insn_slots(const unsigned char *hpage) {
+        return derived().do_get_decoded_insn_slots(hpage);
+    }
+
     /// \brief Invalidates TLB entries for a specific virtual address.
     /// \param vaddr Target virtual address.
     void flush_tlb_vaddr(uint64_t vaddr) {
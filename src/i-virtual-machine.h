@@ -56,21 +56,50 @@ public:
         return do_run(mcycle_end);
     }
 
+    /// \brief Runs the machine until mcycle reaches mcycle_end, the machine halts or yields, obtaining the root hash
+    /// at periodic checkpoints.
+    std::vector<std::pair<uint64_t, hash_type>> run_with_checkpoints(uint64_t mcycle_end, uint64_t period) {
+        return do_run_with_checkpoints(mcycle_end, period);
+    }
+
+    /// \brief Runs a sequence of operations on the machine, all in a single request to remote machines
+    /// \param operations JSON array with the operations (see machine-transaction.h)
+    /// \returns JSON array with the result of each operation
+    std::string transaction(const std::string &operations) {
+        return do_transaction(operations);
+    }
+
     /// \brief Serialize entire state to directory
     void store(const std::string &dir) {
         do_store(dir);
     }
 
+    /// \brief Serialize only the pages that changed since a previously stored machine to directory
+    void store_delta(const std::string &dir, const std::string &base_dir) {
+        do_store_delta(dir, base_dir);
+    }
+
     /// \brief Runs the machine for one micro cycle logging all accesses to the state.
     access_log log_uarch_step(const access_log::type &log_type, bool one_based = false) {
         return do_log_uarch_step(log_type, one_based);
     }
 
+    /// \brief Runs the machine for several micro cycles logging all accesses to the state in each.
+    std::vector<access_log> log_uarch_steps(uint64_t count, const access_log::type &log_type,
+        bool one_based = false) {
+        return do_log_uarch_steps(count, log_type, one_based);
+    }
+
     /// \brief Obtains the proof for a node in the Merkle tree.
     machine_merkle_tree::proof_type get_proof(uint64_t address, int log2_size) const {
         return do_get_proof(address, log2_size);
     }
 
+    /// \brief Obtains a single proof for several nodes of the same size in the Merkle tree.
+    machine_merkle_tree::multiproof_type get_multiproof(const std::vector<uint64_t> &addresses, int log2_size) const {
+        return do_get_multiproof(addresses, log2_size);
+    }
+
     /// \brief Obtains the root hash of the Merkle tree.
     void get_root_hash(hash_type &hash) const {
         do_get_root_hash(hash);
@@ -166,6 +195,11 @@ public:
         do_rollback();
     }
 
+    /// \brief commit
+    void commit(void) {
+        do_commit();
+    }
+
     /// \brief Reads the pc register
     uint64_t read_pc(void) const {
         return do_read_pc();
@@ -647,9 +681,17 @@ public:
 
 private:
     virtual interpreter_break_reason do_run(uint64_t mcycle_end) = 0;
+    virtual std::vector<std::pair<uint64_t, hash_type>> do_run_with_checkpoints(uint64_t mcycle_end,
+        uint64_t period) = 0;
+    virtual std::string do_transaction(const std::string &operations) = 0;
     virtual void do_store(const std::string &dir) = 0;
+    virtual void do_store_delta(const std::string &dir, const std::string &base_dir) = 0;
     virtual access_log do_log_uarch_step(const access_log::type &log_type, bool one_based = false) = 0;
+    virtual std::vector<access_log> do_log_uarch_steps(uint64_t count, const access_log::type &log_type,
+        bool one_based = false) = 0;
     virtual machine_merkle_tree::proof_type do_get_proof(uint64_t address, int log2_size) const = 0;
+    virtual machine_merkle_tree::multiproof_type do_get_multiproof(const std::vector<uint64_t> &addresses,
+        int log2_size) const = 0;
     virtual void do_get_root_hash(hash_type &hash) const = 0;
     virtual bool do_verify_merkle_tree(void) const = 0;
     virtual uint64_t do_read_csr(csr r) const = 0;
@@ -750,6 +792,7 @@ private:
     virtual void do_snapshot() = 0;
     virtual void do_destroy() = 0;
     virtual void do_rollback() = 0;
+    virtual void do_commit() = 0;
     virtual uint64_t do_read_uarch_x(int i) const = 0;
     virtual void do_write_uarch_x(int i, uint64_t val) = 0;
     virtual uint64_t do_read_uarch_pc(void) const = 0;
@@ -20,6 +20,7 @@
 #else
 #include "state-access.h"
 #endif
+#include <array>
 #include <cinttypes>
 #include <cstdint>
 #include <utility>
@@ -91,6 +92,10 @@
 ///   https://gcc.gnu.org/onlinedocs/gcc-7.3.0/gcc/Arrays-and-pointers-implementation.html#Arrays-and-pointers-implementation
 /// \}
 
+#include "decoded-insn-cache.h"
+#ifndef MICROARCHITECTURE
+#include "host-float.h"
+#endif
 #include "interpret.h"
 #include "meta.h"
 #include "riscv-constants.h"
@@ -102,6 +107,15 @@
 
 namespace cartesi {
 
+// The microarchitecture always uses soft-float, which keeps its state transitions simple to verify
+#ifdef HOST_FPU
+using i_float32 = i_hfloat32;
+using i_float64 = i_hfloat64;
+#else
+using i_float32 = i_sfloat32;
+using i_float64 = i_sfloat64;
+#endif
+
 #ifdef DUMP_REGS
 static const std::array<const char *, X_REG_COUNT> reg_name{"zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "s0",
     "s1", "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11",
@@ -536,7 +550,7 @@ static inline void set_rtc_interrupt(STATE_ACCESS &a, uint64_t mcycle) {
 
 /// \brief Obtains the funct3 and opcode fields an instruction.
 /// \param insn Instruction.
-static inline uint32_t insn_get_funct3_00000_opcode(uint32_t insn) {
+static constexpr uint32_t insn_get_funct3_00000_opcode(uint32_t insn) {
     return insn & 0b111000001111111;
 }
 
@@ -661,7 +675,7 @@ static inline uint32_t insn_get_rs3(uint32_t insn) {
 
 /// \brief Obtains the compressed instruction funct3 and opcode fields an instruction.
 /// \param insn Instruction.
-static inline uint32_t insn_get_c_funct3(uint32_t insn) {
+static constexpr uint32_t insn_get_c_funct3(uint32_t insn) {
     return insn & 0b1110000000000011;
 }
 
@@ -796,6 +810,40 @@ static FORCE_INLINE int32_t insn_get_C_SWSP_imm(uint32_t insn) {
     return static_cast<int32_t>(((insn >> (9 - 2)) & 0x3c) | ((insn >> (7 - 6)) & 0xc0));
 }
 
+#ifdef MICROARCHITECTURE
+// The microarchitecture only ever uses the shadow TLB, so its runs match the canonical layout
+constexpr bool use_host_tlb = false;
+#else
+constexpr bool use_host_tlb = true;
+#endif
+
+/// \brief Translates a virtual address after a TLB miss, trying the host TLB before walking the page tables.
+/// \tparam ETYPE TLB entry type the translation is for.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param ppaddr Pointer to physical address.
+/// \param vaddr Virtual address.
+/// \param xwr_shift Encodes the access mode by the shift to the XWR triad.
+/// \returns True if succeeded, false otherwise.
+template <TLB_entry_type ETYPE, typename STATE_ACCESS>
+static FORCE_INLINE bool translate_virtual_address_after_tlb_miss(STATE_ACCESS &a, uint64_t *ppaddr, uint64_t vaddr,
+    int xwr_shift) {
+    if constexpr (use_host_tlb) {
+        if (a.template translate_vaddr_via_host_tlb<ETYPE>(vaddr, ppaddr)) {
+            INC_COUNTER(a.get_statistics(), host_tlb_hit);
+            return true;
+        }
+        INC_COUNTER(a.get_statistics(), host_tlb_miss);
+        page_table_walk walk;
+        if (unlikely(!translate_virtual_address(a, ppaddr, vaddr, xwr_shift, &walk))) {
+            return false;
+        }
+        a.template insert_host_tlb_entry<ETYPE>(vaddr, *ppaddr, walk);
+        return true;
+    }
+    return translate_virtual_address(a, ppaddr, vaddr, xwr_shift);
+}
+
 /// \brief Read an aligned word from virtual memory (slow path that goes through virtual address translation).
 /// \tparam T uint8_t, uint16_t, uint32_t, or uint64_t.
 /// \tparam STATE_ACCESS Class of machine state accessor object.
@@ -823,7 +871,7 @@ static NO_INLINE std::pair<bool, uint64_t> read_virtual_memory_slow(STATE_ACCESS
     }
     // Deal with aligned accesses
     uint64_t paddr{};
-    if (unlikely(!translate_virtual_address(a, &paddr, vaddr, PTE_XWR_R_SHIFT))) {
+    if (unlikely(!translate_virtual_address_after_tlb_miss<TLB_READ>(a, &paddr, vaddr, PTE_XWR_R_SHIFT))) {
         pc = raise_exception(a, pc, RAISE_STORE_EXCEPTIONS ? MCAUSE_STORE_AMO_PAGE_FAULT : MCAUSE_LOAD_PAGE_FAULT,
             vaddr);
         return {false, pc};
@@ -899,7 +947,7 @@ static NO_INLINE std::pair<execute_status, uint64_t> write_virtual_memory_slow(S
     }
     // Deal with aligned accesses
     uint64_t paddr{};
-    if (unlikely(!translate_virtual_address(a, &paddr, vaddr, PTE_XWR_W_SHIFT))) {
+    if (unlikely(!translate_virtual_address_after_tlb_miss<TLB_WRITE>(a, &paddr, vaddr, PTE_XWR_W_SHIFT))) {
         pc = raise_exception(a, pc, MCAUSE_STORE_AMO_PAGE_FAULT, vaddr);
         return {execute_status::failure, pc};
     }
@@ -3773,7 +3821,7 @@ static FORCE_INLINE execute_status execute_FADD_S(STATE_ACCESS &a, uint64_t &pc,
     dump_insn(a, pc, insn, "fadd.s");
     return execute_float_binary_op_rm<uint32_t>(a, pc, insn,
         [](uint32_t s1, uint32_t s2, uint32_t rm, uint32_t *fflags) -> uint32_t {
-            return i_sfloat32::add(s1, s2, static_cast<FRM_modes>(rm), fflags);
+            return i_float32::add(s1, s2, static_cast<FRM_modes>(rm), fflags);
         });
 }
 
@@ -3782,7 +3830,7 @@ static FORCE_INLINE execute_status execute_FADD_D(STATE_ACCESS &a, uint64_t &pc,
     dump_insn(a, pc, insn, "fadd.d");
     return execute_float_binary_op_rm<uint64_t>(a, pc, insn,
         [](uint64_t s1, uint64_t s2, uint32_t rm, uint32_t *fflags) -> uint64_t {
-            return i_sfloat64::add(s1, s2, static_cast<FRM_modes>(rm), fflags);
+            return i_float64::add(s1, s2, static_cast<FRM_modes>(rm), fflags);
         });
 }
 
@@ -3791,7 +3839,7 @@ static FORCE_INLINE execute_status execute_FSUB_S(STATE_ACCESS &a, uint64_t &pc,
     dump_insn(a, pc, insn, "fsub.s");
     return execute_float_binary_op_rm<uint32_t>(a, pc, insn,
         [](uint32_t s1, uint32_t s2, uint32_t rm, uint32_t *fflags) -> uint32_t {
-            return i_sfloat32::add(s1, s2 ^ i_sfloat32::SIGN_MASK, static_cast<FRM_modes>(rm), fflags);
+            return i_float32::add(s1, s2 ^ i_sfloat32::SIGN_MASK, static_cast<FRM_modes>(rm), fflags);
         });
 }
 
@@ -3800,7 +3848,7 @@ static FORCE_INLINE execute_status execute_FSUB_D(STATE_ACCESS &a, uint64_t &pc,
     dump_insn(a, pc, insn, "fsub.d");
     return execute_float_binary_op_rm<uint64_t>(a, pc, insn,
         [](uint64_t s1, uint64_t s2, uint32_t rm, uint32_t *fflags) -> uint64_t {
-            return i_sfloat64::add(s1, s2 ^ i_sfloat64::SIGN_MASK, static_cast<FRM_modes>(rm), fflags);
+            return i_float64::add(s1, s2 ^ i_sfloat64::SIGN_MASK, static_cast<FRM_modes>(rm), fflags);
         });
 }
 
@@ -3809,7 +3857,7 @@ static FORCE_INLINE execute_status execute_FMUL_S(STATE_ACCESS &a, uint64_t &pc,
     dump_insn(a, pc, insn, "fmul.s");
     return execute_float_binary_op_rm<uint32_t>(a, pc, insn,
         [](uint32_t s1, uint32_t s2, uint32_t rm, uint32_t *fflags) -> uint32_t {
-            return i_sfloat32::mul(s1, s2, static_cast<FRM_modes>(rm), fflags);
+            return i_float32::mul(s1, s2, static_cast<FRM_modes>(rm), fflags);
         });
 }
 
@@ -3818,7 +3866,7 @@ static FORCE_INLINE execute_status execute_FMUL_D(STATE_ACCESS &a, uint64_t &pc,
     dump_insn(a, pc, insn, "fmul.d");
     return execute_float_binary_op_rm<uint64_t>(a, pc, insn,
         [](uint64_t s1, uint64_t s2, uint32_t rm, uint32_t *fflags) -> uint64_t {
-            return i_sfloat64::mul(s1, s2, static_cast<FRM_modes>(rm), fflags);
+            return i_float64::mul(s1, s2, static_cast<FRM_modes>(rm), fflags);
         });
 }
 
@@ -3827,7 +3875,7 @@ static FORCE_INLINE execute_status execute_FDIV_S(STATE_ACCESS &a, uint64_t &pc,
     dump_insn(a, pc, insn, "fdiv.s");
     return execute_float_binary_op_rm<uint32_t>(a, pc, insn,
         [](uint32_t s1, uint32_t s2, uint32_t rm, uint32_t *fflags) -> uint32_t {
-            return i_sfloat32::div(s1, s2, static_cast<FRM_modes>(rm), fflags);
+            return i_float32::div(s1, s2, static_cast<FRM_modes>(rm), fflags);
         });
 }
 
@@ -3836,7 +3884,7 @@ static FORCE_INLINE execute_status execute_FDIV_D(STATE_ACCESS &a, uint64_t &pc,
     dump_insn(a, pc, insn, "fdiv.d");
     return execute_float_binary_op_rm<uint64_t>(a, pc, insn,
         [](uint64_t s1, uint64_t s2, uint32_t rm, uint32_t *fflags) -> uint64_t {
-            return i_sfloat64::div(s1, s2, static_cast<FRM_modes>(rm), fflags);
+            return i_float64::div(s1, s2, static_cast<FRM_modes>(rm), fflags);
         });
 }
 
@@ -4109,7 +4157,7 @@ template <typename STATE_ACCESS>
 static FORCE_INLINE execute_status execute_FSQRT_S(STATE_ACCESS &a, uint64_t &pc, uint32_t insn) {
     dump_insn(a, pc, insn, "fsqrt.s");
     return execute_float_unary_op_rm<uint32_t>(a, pc, insn, [](uint32_t s1, uint32_t rm, uint32_t *fflags) -> uint32_t {
-        return i_sfloat32::sqrt(s1, static_cast<FRM_modes>(rm), fflags);
+        return i_float32::sqrt(s1, static_cast<FRM_modes>(rm), fflags);
     });
 }
 
@@ -4117,7 +4165,7 @@ template <typename STATE_ACCESS>
 static FORCE_INLINE execute_status execute_FSQRT_D(STATE_ACCESS &a, uint64_t &pc, uint32_t insn) {
     dump_insn(a, pc, insn, "fsqrt.d");
     return execute_float_unary_op_rm<uint64_t>(a, pc, insn, [](uint64_t s1, uint32_t rm, uint32_t *fflags) -> uint64_t {
-        return i_sfloat64::sqrt(s1, static_cast<FRM_modes>(rm), fflags);
+        return i_float64::sqrt(s1, static_cast<FRM_modes>(rm), fflags);
     });
 }
 
@@ -5103,6 +5151,7 @@ static FORCE_INLINE execute_status execute_C_SDSP(STATE_ACCESS &a, uint64_t &pc,
     return execute_C_S<uint64_t>(a, pc, mcycle, rs2, 0x2, imm);
 }
 
+#ifndef THREADED_DISPATCH
 /// \brief Decodes and executes an instruction.
 /// \tparam STATE_ACCESS Class of machine state accessor object.
 /// \param a Machine state accessor object.
@@ -5386,6 +5435,687 @@ static FORCE_INLINE execute_status execute_insn(STATE_ACCESS &a, uint64_t &pc, u
         }
     }
 }
+#endif // THREADED_DISPATCH
+
+/// \brief Instruction handlers, as resolved by the instruction decoder.
+/// \details Each handler corresponds to one of the execute_&lt;FOO&gt; functions called by execute_insn.
+///  Compressed instruction handlers come first, so instruction 0 (an illegal compressed instruction
+///  handled by execute_C_ADDI4SPN) decodes to handler 0, as required by the decoded instruction cache.
+enum class insn_handler : uint32_t {
+    // Compressed instructions
+    C_ADDI4SPN,
+    C_LW,
+    C_LD,
+    C_SW,
+    C_SD,
+    C_Q1_SET0,
+    C_ADDIW,
+    C_LI,
+    C_Q1_SET1,
+    C_Q1_SET2,
+    C_J,
+    C_BEQZ,
+    C_BNEZ,
+    C_SLLI,
+    C_LWSP,
+    C_LDSP,
+    C_Q2_SET0,
+    C_SWSP,
+    C_SDSP,
+    C_FLD,
+    C_FSD,
+    C_FLDSP,
+    C_FSDSP,
+    C_ILLEGAL,
+    // Uncompressed instructions
+    LB,
+    LH,
+    LW,
+    LD,
+    LBU,
+    LHU,
+    LWU,
+    SB,
+    SH,
+    SW,
+    SD,
+    FENCE,
+    FENCE_I,
+    ADDI,
+    SLLI,
+    SLTI,
+    SLTIU,
+    XORI,
+    ORI,
+    ANDI,
+    ADDIW,
+    SLLIW,
+    SLLW,
+    DIVW,
+    REMW,
+    REMUW,
+    BEQ,
+    BNE,
+    BLT,
+    BGE,
+    BLTU,
+    BGEU,
+    JALR,
+    CSRRW,
+    CSRRS,
+    CSRRC,
+    CSRRWI,
+    CSRRSI,
+    CSRRCI,
+    AUIPC,
+    LUI,
+    JAL,
+    SRLI_SRAI,
+    SRLIW_SRAIW,
+    AMO_W,
+    AMO_D,
+    ADD_MUL_SUB,
+    SLL_MULH,
+    SLT_MULHSU,
+    SLTU_MULHU,
+    XOR_DIV,
+    SRL_DIVU_SRA,
+    OR_REM,
+    AND_REMU,
+    ADDW_MULW_SUBW,
+    SRLW_DIVUW_SRAW,
+    PRIVILEGED,
+    FSW,
+    FSD,
+    FLW,
+    FLD,
+    FMADD,
+    FMSUB,
+    FNMSUB,
+    FNMADD,
+    FD,
+    ILLEGAL,
+    COUNT ///< Number of handlers (not a handler)
+};
+
+/// \brief Decodes an instruction into its handler, without executing it.
+/// \param insn Instruction.
+/// \return Handler that execute_decoded_insn will use to execute the instruction.
+/// \details This mirrors the decoding performed by execute_insn.
+static constexpr insn_handler decode_insn(uint32_t insn) {
+    // Is compressed instruction
+    if ((insn & 3) != 3) {
+        switch (static_cast<insn_c_funct3>(insn_get_c_funct3(insn))) {
+            case insn_c_funct3::C_ADDI4SPN:
+                return insn_handler::C_ADDI4SPN;
+            case insn_c_funct3::C_LW:
+                return insn_handler::C_LW;
+            case insn_c_funct3::C_LD:
+                return insn_handler::C_LD;
+            case insn_c_funct3::C_SW:
+                return insn_handler::C_SW;
+            case insn_c_funct3::C_SD:
+                return insn_handler::C_SD;
+            case insn_c_funct3::C_Q1_SET0:
+                return insn_handler::C_Q1_SET0;
+            case insn_c_funct3::C_ADDIW:
+                return insn_handler::C_ADDIW;
+            case insn_c_funct3::C_LI:
+                return insn_handler::C_LI;
+            case insn_c_funct3::C_Q1_SET1:
+                return insn_handler::C_Q1_SET1;
+            case insn_c_funct3::C_Q1_SET2:
+                return insn_handler::C_Q1_SET2;
+            case insn_c_funct3::C_J:
+                return insn_handler::C_J;
+            case insn_c_funct3::C_BEQZ:
+                return insn_handler::C_BEQZ;
+            case insn_c_funct3::C_BNEZ:
+                return insn_handler::C_BNEZ;
+            case insn_c_funct3::C_SLLI:
+                return insn_handler::C_SLLI;
+            case insn_c_funct3::C_LWSP:
+                return insn_handler::C_LWSP;
+            case insn_c_funct3::C_LDSP:
+                return insn_handler::C_LDSP;
+            case insn_c_funct3::C_Q2_SET0:
+                return insn_handler::C_Q2_SET0;
+            case insn_c_funct3::C_SWSP:
+                return insn_handler::C_SWSP;
+            case insn_c_funct3::C_SDSP:
+                return insn_handler::C_SDSP;
+            case insn_c_funct3::C_FLD:
+                return insn_handler::C_FLD;
+            case insn_c_funct3::C_FSD:
+                return insn_handler::C_FSD;
+            case insn_c_funct3::C_FLDSP:
+                return insn_handler::C_FLDSP;
+            case insn_c_funct3::C_FSDSP:
+                return insn_handler::C_FSDSP;
+            default:
+                return insn_handler::C_ILLEGAL;
+        }
+    }
+    switch (static_cast<insn_funct3_00000_opcode>(insn_get_funct3_00000_opcode(insn))) {
+        case insn_funct3_00000_opcode::LB:
+            return insn_handler::LB;
+        case insn_funct3_00000_opcode::LH:
+            return insn_handler::LH;
+        case insn_funct3_00000_opcode::LW:
+            return insn_handler::LW;
+        case insn_funct3_00000_opcode::LD:
+            return insn_handler::LD;
+        case insn_funct3_00000_opcode::LBU:
+            return insn_handler::LBU;
+        case insn_funct3_00000_opcode::LHU:
+            return insn_handler::LHU;
+        case insn_funct3_00000_opcode::LWU:
+            return insn_handler::LWU;
+        case insn_funct3_00000_opcode::SB:
+            return insn_handler::SB;
+        case insn_funct3_00000_opcode::SH:
+            return insn_handler::SH;
+        case insn_funct3_00000_opcode::SW:
+            return insn_handler::SW;
+        case insn_funct3_00000_opcode::SD:
+            return insn_handler::SD;
+        case insn_funct3_00000_opcode::FENCE:
+            return insn_handler::FENCE;
+        case insn_funct3_00000_opcode::FENCE_I:
+            return insn_handler::FENCE_I;
+        case insn_funct3_00000_opcode::ADDI:
+            return insn_handler::ADDI;
+        case insn_funct3_00000_opcode::SLLI:
+            return insn_handler::SLLI;
+        case insn_funct3_00000_opcode::SLTI:
+            return insn_handler::SLTI;
+        case insn_funct3_00000_opcode::SLTIU:
+            return insn_handler::SLTIU;
+        case insn_funct3_00000_opcode::XORI:
+            return insn_handler::XORI;
+        case insn_funct3_00000_opcode::ORI:
+            return insn_handler::ORI;
+        case insn_funct3_00000_opcode::ANDI:
+            return insn_handler::ANDI;
+        case insn_funct3_00000_opcode::ADDIW:
+            return insn_handler::ADDIW;
+        case insn_funct3_00000_opcode::SLLIW:
+            return insn_handler::SLLIW;
+        case insn_funct3_00000_opcode::SLLW:
+            return insn_handler::SLLW;
+        case insn_funct3_00000_opcode::DIVW:
+            return insn_handler::DIVW;
+        case insn_funct3_00000_opcode::REMW:
+            return insn_handler::REMW;
+        case insn_funct3_00000_opcode::REMUW:
+            return insn_handler::REMUW;
+        case insn_funct3_00000_opcode::BEQ:
+            return insn_handler::BEQ;
+        case insn_funct3_00000_opcode::BNE:
+            return insn_handler::BNE;
+        case insn_funct3_00000_opcode::BLT:
+            return insn_handler::BLT;
+        case insn_funct3_00000_opcode::BGE:
+            return insn_handler::BGE;
+        case insn_funct3_00000_opcode::BLTU:
+            return insn_handler::BLTU;
+        case insn_funct3_00000_opcode::BGEU:
+            return insn_handler::BGEU;
+        case insn_funct3_00000_opcode::JALR:
+            return insn_handler::JALR;
+        case insn_funct3_00000_opcode::CSRRW:
+            return insn_handler::CSRRW;
+        case insn_funct3_00000_opcode::CSRRS:
+            return insn_handler::CSRRS;
+        case insn_funct3_00000_opcode::CSRRC:
+            return insn_handler::CSRRC;
+        case insn_funct3_00000_opcode::CSRRWI:
+            return insn_handler::CSRRWI;
+        case insn_funct3_00000_opcode::CSRRSI:
+            return insn_handler::CSRRSI;
+        case insn_funct3_00000_opcode::CSRRCI:
+            return insn_handler::CSRRCI;
+        case insn_funct3_00000_opcode::AUIPC_000:
+        case insn_funct3_00000_opcode::AUIPC_001:
+        case insn_funct3_00000_opcode::AUIPC_010:
+        case insn_funct3_00000_opcode::AUIPC_011:
+        case insn_funct3_00000_opcode::AUIPC_100:
+        case insn_funct3_00000_opcode::AUIPC_101:
+        case insn_funct3_00000_opcode::AUIPC_110:
+        case insn_funct3_00000_opcode::AUIPC_111:
+            return insn_handler::AUIPC;
+        case insn_funct3_00000_opcode::LUI_000:
+        case insn_funct3_00000_opcode::LUI_001:
+        case insn_funct3_00000_opcode::LUI_010:
+        case insn_funct3_00000_opcode::LUI_011:
+        case insn_funct3_00000_opcode::LUI_100:
+        case insn_funct3_00000_opcode::LUI_101:
+        case insn_funct3_00000_opcode::LUI_110:
+        case insn_funct3_00000_opcode::LUI_111:
+            return insn_handler::LUI;
+        case insn_funct3_00000_opcode::JAL_000:
+        case insn_funct3_00000_opcode::JAL_001:
+        case insn_funct3_00000_opcode::JAL_010:
+        case insn_funct3_00000_opcode::JAL_011:
+        case insn_funct3_00000_opcode::JAL_100:
+        case insn_funct3_00000_opcode::JAL_101:
+        case insn_funct3_00000_opcode::JAL_110:
+        case insn_funct3_00000_opcode::JAL_111:
+            return insn_handler::JAL;
+        case insn_funct3_00000_opcode::SRLI_SRAI:
+            return insn_handler::SRLI_SRAI;
+        case insn_funct3_00000_opcode::SRLIW_SRAIW:
+            return insn_handler::SRLIW_SRAIW;
+        case insn_funct3_00000_opcode::AMO_W:
+            return insn_handler::AMO_W;
+        case insn_funct3_00000_opcode::AMO_D:
+            return insn_handler::AMO_D;
+        case insn_funct3_00000_opcode::ADD_MUL_SUB:
+            return insn_handler::ADD_MUL_SUB;
+        case insn_funct3_00000_opcode::SLL_MULH:
+            return insn_handler::SLL_MULH;
+        case insn_funct3_00000_opcode::SLT_MULHSU:
+            return insn_handler::SLT_MULHSU;
+        case insn_funct3_00000_opcode::SLTU_MULHU:
+            return insn_handler::SLTU_MULHU;
+        case insn_funct3_00000_opcode::XOR_DIV:
+            return insn_handler::XOR_DIV;
+        case insn_funct3_00000_opcode::SRL_DIVU_SRA:
+            return insn_handler::SRL_DIVU_SRA;
+        case insn_funct3_00000_opcode::OR_REM:
+            return insn_handler::OR_REM;
+        case insn_funct3_00000_opcode::AND_REMU:
+            return insn_handler::AND_REMU;
+        case insn_funct3_00000_opcode::ADDW_MULW_SUBW:
+            return insn_handler::ADDW_MULW_SUBW;
+        case insn_funct3_00000_opcode::SRLW_DIVUW_SRAW:
+            return insn_handler::SRLW_DIVUW_SRAW;
+        case insn_funct3_00000_opcode::PRIVILEGED:
+            return insn_handler::PRIVILEGED;
+        case insn_funct3_00000_opcode::FSW:
+            return insn_handler::FSW;
+        case insn_funct3_00000_opcode::FSD:
+            return insn_handler::FSD;
+        case insn_funct3_00000_opcode::FLW:
+            return insn_handler::FLW;
+        case insn_funct3_00000_opcode::FLD:
+            return insn_handler::FLD;
+        case insn_funct3_00000_opcode::FMADD_RNE:
+        case insn_funct3_00000_opcode::FMADD_RTZ:
+        case insn_funct3_00000_opcode::FMADD_RDN:
+        case insn_funct3_00000_opcode::FMADD_RUP:
+        case insn_funct3_00000_opcode::FMADD_RMM:
+        case insn_funct3_00000_opcode::FMADD_DYN:
+            return insn_handler::FMADD;
+        case insn_funct3_00000_opcode::FMSUB_RNE:
+        case insn_funct3_00000_opcode::FMSUB_RTZ:
+        case insn_funct3_00000_opcode::FMSUB_RDN:
+        case insn_funct3_00000_opcode::FMSUB_RUP:
+        case insn_funct3_00000_opcode::FMSUB_RMM:
+        case insn_funct3_00000_opcode::FMSUB_DYN:
+            return insn_handler::FMSUB;
+        case insn_funct3_00000_opcode::FNMSUB_RNE:
+        case insn_funct3_00000_opcode::FNMSUB_RTZ:
+        case insn_funct3_00000_opcode::FNMSUB_RDN:
+        case insn_funct3_00000_opcode::FNMSUB_RUP:
+        case insn_funct3_00000_opcode::FNMSUB_RMM:
+        case insn_funct3_00000_opcode::FNMSUB_DYN:
+            return insn_handler::FNMSUB;
+        case insn_funct3_00000_opcode::FNMADD_RNE:
+        case insn_funct3_00000_opcode::FNMADD_RTZ:
+        case insn_funct3_00000_opcode::FNMADD_RDN:
+        case insn_funct3_00000_opcode::FNMADD_RUP:
+        case insn_funct3_00000_opcode::FNMADD_RMM:
+        case insn_funct3_00000_opcode::FNMADD_DYN:
+            return insn_handler::FNMADD;
+        case insn_funct3_00000_opcode::FD_000:
+        case insn_funct3_00000_opcode::FD_001:
+        case insn_funct3_00000_opcode::FD_010:
+        case insn_funct3_00000_opcode::FD_011:
+        case insn_funct3_00000_opcode::FD_100:
+        case insn_funct3_00000_opcode::FD_111:
+            return insn_handler::FD;
+        default:
+            return insn_handler::ILLEGAL;
+    }
+}
+
+/// \brief Executes an instruction that has already been decoded.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param pc Current pc.
+/// \param mcycle Current mcycle.
+/// \param insn Instruction, as fetched.
+/// \param handler Handler obtained from decode_insn(insn).
+/// \return execute_status::failure if an exception was raised, or
+///  execute_status::success otherwise.
+/// \details Has exactly the same effect as execute_insn(a, pc, mcycle, insn).
+template <typename STATE_ACCESS>
+static FORCE_INLINE execute_status execute_decoded_insn(STATE_ACCESS &a, uint64_t &pc, uint64_t &mcycle, uint32_t insn,
+    insn_handler handler) {
+    if (handler <= insn_handler::C_ILLEGAL) {
+        // The fetch may read 4 bytes as an optimization,
+        // but the compressed instruction uses only the 2 less significant bytes
+        insn = static_cast<uint16_t>(insn);
+    }
+    switch (handler) {
+        case insn_handler::C_ADDI4SPN:
+            return execute_C_ADDI4SPN(a, pc, insn);
+        case insn_handler::C_LW:
+            return execute_C_LW(a, pc, mcycle, insn);
+        case insn_handler::C_LD:
+            return execute_C_LD(a, pc, mcycle, insn);
+        case insn_handler::C_SW:
+            return execute_C_SW(a, pc, mcycle, insn);
+        case insn_handler::C_SD:
+            return execute_C_SD(a, pc, mcycle, insn);
+        case insn_handler::C_Q1_SET0:
+            return execute_C_Q1_SET0(a, pc, insn);
+        case insn_handler::C_ADDIW:
+            return execute_C_ADDIW(a, pc, insn);
+        case insn_handler::C_LI:
+            return execute_C_LI(a, pc, insn);
+        case insn_handler::C_Q1_SET1:
+            return execute_C_Q1_SET1(a, pc, insn);
+        case insn_handler::C_Q1_SET2:
+            return execute_C_Q1_SET2(a, pc, insn);
+        case insn_handler::C_J:
+            return execute_C_J(a, pc, insn);
+        case insn_handler::C_BEQZ:
+            return execute_C_BEQZ(a, pc, insn);
+        case insn_handler::C_BNEZ:
+            return execute_C_BNEZ(a, pc, insn);
+        case insn_handler::C_SLLI:
+            return execute_C_SLLI(a, pc, insn);
+        case insn_handler::C_LWSP:
+            return execute_C_LWSP(a, pc, mcycle, insn);
+        case insn_handler::C_LDSP:
+            return execute_C_LDSP(a, pc, mcycle, insn);
+        case insn_handler::C_Q2_SET0:
+            return execute_C_Q2_SET0(a, pc, insn);
+        case insn_handler::C_SWSP:
+            return execute_C_SWSP(a, pc, mcycle, insn);
+        case insn_handler::C_SDSP:
+            return execute_C_SDSP(a, pc, mcycle, insn);
+        case insn_handler::LB:
+            return execute_LB(a, pc, mcycle, insn);
+        case insn_handler::LH:
+            return execute_LH(a, pc, mcycle, insn);
+        case insn_handler::LW:
+            return execute_LW(a, pc, mcycle, insn);
+        case insn_handler::LD:
+            return execute_LD(a, pc, mcycle, insn);
+        case insn_handler::LBU:
+            return execute_LBU(a, pc, mcycle, insn);
+        case insn_handler::LHU:
+            return execute_LHU(a, pc, mcycle, insn);
+        case insn_handler::LWU:
+            return execute_LWU(a, pc, mcycle, insn);
+        case insn_handler::SB:
+            return execute_SB(a, pc, mcycle, insn);
+        case insn_handler::SH:
+            return execute_SH(a, pc, mcycle, insn);
+        case insn_handler::SW:
+            return execute_SW(a, pc, mcycle, insn);
+        case insn_handler::SD:
+            return execute_SD(a, pc, mcycle, insn);
+        case insn_handler::FENCE:
+            return execute_FENCE(a, pc, insn);
+        case insn_handler::FENCE_I:
+            return execute_FENCE_I(a, pc, insn);
+        case insn_handler::ADDI:
+            return execute_ADDI(a, pc, insn);
+        case insn_handler::SLLI:
+            return execute_SLLI(a, pc, insn);
+        case insn_handler::SLTI:
+            return execute_SLTI(a, pc, insn);
+        case insn_handler::SLTIU:
+            return execute_SLTIU(a, pc, insn);
+        case insn_handler::XORI:
+            return execute_XORI(a, pc, insn);
+        case insn_handler::ORI:
+            return execute_ORI(a, pc, insn);
+        case insn_handler::ANDI:
+            return execute_ANDI(a, pc, insn);
+        case insn_handler::ADDIW:
+            return execute_ADDIW(a, pc, insn);
+        case insn_handler::SLLIW:
+            return execute_SLLIW(a, pc, insn);
+        case insn_handler::SLLW:
+            return execute_SLLW(a, pc, insn);
+        case insn_handler::DIVW:
+            return execute_DIVW(a, pc, insn);
+        case insn_handler::REMW:
+            return execute_REMW(a, pc, insn);
+        case insn_handler::REMUW:
+            return execute_REMUW(a, pc, insn);
+        case insn_handler::BEQ:
+            return execute_BEQ(a, pc, insn);
+        case insn_handler::BNE:
+            return execute_BNE(a, pc, insn);
+        case insn_handler::BLT:
+            return execute_BLT(a, pc, insn);
+        case insn_handler::BGE:
+            return execute_BGE(a, pc, insn);
+        case insn_handler::BLTU:
+            return execute_BLTU(a, pc, insn);
+        case insn_handler::BGEU:
+            return execute_BGEU(a, pc, insn);
+        case insn_handler::JALR:
+            return execute_JALR(a, pc, insn);
+        case insn_handler::CSRRW:
+            return execute_CSRRW(a, pc, mcycle, insn);
+        case insn_handler::CSRRS:
+            return execute_CSRRS(a, pc, mcycle, insn);
+        case insn_handler::CSRRC:
+            return execute_CSRRC(a, pc, mcycle, insn);
+        case insn_handler::CSRRWI:
+            return execute_CSRRWI(a, pc, mcycle, insn);
+        case insn_handler::CSRRSI:
+            return execute_CSRRSI(a, pc, mcycle, insn);
+        case insn_handler::CSRRCI:
+            return execute_CSRRCI(a, pc, mcycle, insn);
+        case insn_handler::AUIPC:
+            return execute_AUIPC(a, pc, insn);
+        case insn_handler::LUI:
+            return execute_LUI(a, pc, insn);
+        case insn_handler::JAL:
+            return execute_JAL(a, pc, insn);
+        case insn_handler::SRLI_SRAI:
+            return execute_SRLI_SRAI(a, pc, insn);
+        case insn_handler::SRLIW_SRAIW:
+            return execute_SRLIW_SRAIW(a, pc, insn);
+        case insn_handler::AMO_W:
+            return execute_AMO_W(a, pc, mcycle, insn);
+        case insn_handler::AMO_D:
+            return execute_AMO_D(a, pc, mcycle, insn);
+        case insn_handler::ADD_MUL_SUB:
+            return execute_ADD_MUL_SUB(a, pc, insn);
+        case insn_handler::SLL_MULH:
+            return execute_SLL_MULH(a, pc, insn);
+        case insn_handler::SLT_MULHSU:
+            return execute_SLT_MULHSU(a, pc, insn);
+        case insn_handler::SLTU_MULHU:
+            return execute_SLTU_MULHU(a, pc, insn);
+        case insn_handler::XOR_DIV:
+            return execute_XOR_DIV(a, pc, insn);
+        case insn_handler::SRL_DIVU_SRA:
+            return execute_SRL_DIVU_SRA(a, pc, insn);
+        case insn_handler::OR_REM:
+            return execute_OR_REM(a, pc, insn);
+        case insn_handler::AND_REMU:
+            return execute_AND_REMU(a, pc, insn);
+        case insn_handler::ADDW_MULW_SUBW:
+            return execute_ADDW_MULW_SUBW(a, pc, insn);
+        case insn_handler::SRLW_DIVUW_SRAW:
+            return execute_SRLW_DIVUW_SRAW(a, pc, insn);
+        case insn_handler::PRIVILEGED:
+            return execute_privileged(a, pc, mcycle, insn);
+        default: {
+            // Here we are sure that the next instruction, at best, can only be a floating point instruction,
+            // or, at worst, an illegal instruction.
+            // If FS is OFF, attempts to read or write the float state will cause an illegal instruction exception.
+            if (unlikely((a.read_mstatus() & MSTATUS_FS_MASK) == MSTATUS_FS_OFF)) {
+                return raise_illegal_insn_exception(a, pc, insn);
+            }
+            switch (handler) {
+                case insn_handler::C_FLD:
+                    return execute_C_FLD(a, pc, mcycle, insn);
+                case insn_handler::C_FSD:
+                    return execute_C_FSD(a, pc, mcycle, insn);
+                case insn_handler::C_FLDSP:
+                    return execute_C_FLDSP(a, pc, mcycle, insn);
+                case insn_handler::C_FSDSP:
+                    return execute_C_FSDSP(a, pc, mcycle, insn);
+                case insn_handler::FSW:
+                    return execute_FSW(a, pc, mcycle, insn);
+                case insn_handler::FSD:
+                    return execute_FSD(a, pc, mcycle, insn);
+                case insn_handler::FLW:
+                    return execute_FLW(a, pc, mcycle, insn);
+                case insn_handler::FLD:
+                    return execute_FLD(a, pc, mcycle, insn);
+                case insn_handler::FMADD:
+                    return execute_FMADD(a, pc, insn);
+                case insn_handler::FMSUB:
+                    return execute_FMSUB(a, pc, insn);
+                case insn_handler::FNMSUB:
+                    return execute_FNMSUB(a, pc, insn);
+                case insn_handler::FNMADD:
+                    return execute_FNMADD(a, pc, insn);
+                case insn_handler::FD:
+                    return execute_FD(a, pc, insn);
+                default:
+                    return raise_illegal_insn_exception(a, pc, insn);
+            }
+        }
+    }
+}
+
+/// \brief Pointer to a function executing instructions decoded to a given handler.
+template <typename STATE_ACCESS>
+using insn_handler_function = execute_status (*)(STATE_ACCESS &a, uint64_t &pc, uint64_t &mcycle, uint32_t insn);
+
+/// \brief Executes an instruction decoded to a fixed handler.
+/// \details Instantiated once per handler to fill the handler function table.
+template <typename STATE_ACCESS, insn_handler HANDLER>
+static execute_status execute_insn_with_handler(STATE_ACCESS &a, uint64_t &pc, uint64_t &mcycle, uint32_t insn) {
+    return execute_decoded_insn(a, pc, mcycle, insn, HANDLER);
+}
+
+/// \brief Builds the table mapping each handler to the function that executes it.
+template <typename STATE_ACCESS, size_t... I>
+static constexpr auto make_insn_handler_functions(std::index_sequence<I...> /*unused*/) {
+    return std::array<insn_handler_function<STATE_ACCESS>, sizeof...(I)>{
+        {&execute_insn_with_handler<STATE_ACCESS, static_cast<insn_handler>(I)>...}};
+}
+
+/// \brief Table mapping each handler to the function that executes it.
+template <typename STATE_ACCESS>
+static constexpr auto insn_handler_functions =
+    make_insn_handler_functions<STATE_ACCESS>(std::make_index_sequence<to_underlying(insn_handler::COUNT)>{});
+
+#ifdef THREADED_DISPATCH
+/// \brief Threaded dispatch constants.
+enum INSN_DISPATCH_constants : uint32_t {
+    INSN_DISPATCH_KEY_COUNT = 1024, ///< Number of distinct dispatch keys
+};
+
+/// \brief Combines the opcode and funct3 fields of an instruction into its dispatch key.
+/// \param insn Instruction.
+/// \details Uncompressed instructions map to funct3:opcode, where opcode bits 1:0 are always 0b11.
+///  Compressed instructions map to funct3:00000:quadrant, where quadrant is never 0b11, so keys never collide.
+///  The remaining decoding, if any, is left to the handler the key maps to.
+static constexpr uint32_t insn_dispatch_key(uint32_t insn) {
+    if ((insn & 3) != 3) {
+        return ((insn >> 6) & 0b1110000000) | (insn & 0b11);
+    }
+    return ((insn >> 5) & 0b1110000000) | (insn & 0b1111111);
+}
+
+/// \brief Returns an instruction with a given dispatch key (the inverse of insn_dispatch_key).
+/// \param key Dispatch key.
+static constexpr uint32_t insn_dispatch_key_to_insn(uint32_t key) {
+    if ((key & 3) != 3) {
+        return ((key & 0b1110000000) << 6) | (key & 0b11);
+    }
+    return ((key & 0b1110000000) << 5) | (key & 0b1111111);
+}
+
+/// \brief Builds the table mapping each dispatch key to the handler of its instructions.
+/// \details The table is generated by the very same decode_insn used everywhere else.
+template <size_t... K>
+static constexpr auto make_insn_dispatch_handlers(std::index_sequence<K...> /*unused*/) {
+    return std::array<insn_handler, sizeof...(K)>{{decode_insn(insn_dispatch_key_to_insn(K))...}};
+}
+
+/// \brief Table mapping each dispatch key to the handler of its instructions.
+static constexpr auto insn_dispatch_handlers =
+    make_insn_dispatch_handlers(std::make_index_sequence<INSN_DISPATCH_KEY_COUNT>{});
+
+/// \brief Builds the table mapping each dispatch key to the function that executes its instructions.
+template <typename STATE_ACCESS, size_t... K>
+static constexpr auto make_insn_dispatch_functions(std::index_sequence<K...> /*unused*/) {
+    return std::array<insn_handler_function<STATE_ACCESS>, sizeof...(K)>{
+        {insn_handler_functions<STATE_ACCESS>[to_underlying(insn_dispatch_handlers[K])]...}};
+}
+
+/// \brief Table mapping each dispatch key to the function that executes its instructions.
+template <typename STATE_ACCESS>
+static constexpr auto insn_dispatch_functions =
+    make_insn_dispatch_functions<STATE_ACCESS>(std::make_index_sequence<INSN_DISPATCH_KEY_COUNT>{});
+
+/// \brief Decodes and executes an instruction with a single indirect jump.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param pc Current pc.
+/// \param insn Instruction.
+/// \return execute_status::failure if an exception was raised, or
+///  execute_status::success otherwise.
+/// \details Has exactly the same effect as the switch-based execute_insn, which it replaces in threaded builds.
+template <typename STATE_ACCESS>
+static FORCE_INLINE execute_status execute_insn(STATE_ACCESS &a, uint64_t &pc, uint64_t &mcycle, uint32_t insn) {
+    return insn_dispatch_functions<STATE_ACCESS>[insn_dispatch_key(insn)](a, pc, mcycle, insn);
+}
+#endif // THREADED_DISPATCH
+
+#ifdef MICROARCHITECTURE
+// The microarchitecture has neither the room nor the need for a decoded instruction cache
+constexpr bool use_decoded_insn_cache = false;
+#else
+constexpr bool use_decoded_insn_cache = true;
+#endif
+
+/// \brief Executes an instruction through the decoded instruction cache.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param pc Current pc.
+/// \param mcycle Current mcycle.
+/// \param insn Instruction, as fetched.
+/// \param slots Decoded instruction cache slots for the page containing pc.
+/// \return execute_status::failure if an exception was raised, or
+///  execute_status::success otherwise.
+/// \details The instruction is only decoded if the slot for pc was not decoded from the very same instruction bits.
+template <typename STATE_ACCESS>
+static FORCE_INLINE execute_status execute_insn_via_decoded_cache(STATE_ACCESS &a, uint64_t &pc, uint64_t &mcycle,
+    uint32_t insn, decoded_insn_slot *slots) {
+    decoded_insn_slot &slot = slots[(pc & PAGE_OFFSET_MASK) >> 1];
+    if (unlikely(slot.insn != insn)) {
+        INC_COUNTER(a.get_statistics(), dcache_miss);
+        slot.insn = insn;
+#ifdef THREADED_DISPATCH
+        slot.handler = to_underlying(insn_dispatch_handlers[insn_dispatch_key(insn)]);
+#else
+        slot.handler = to_underlying(decode_insn(insn));
+#endif
+    } else {
+        INC_COUNTER(a.get_statistics(), dcache_hit);
+    }
+    return insn_handler_functions<STATE_ACCESS>[slot.handler](a, pc, mcycle, insn);
+}
+
+// Zero-filled slots of the decoded instruction cache must be valid
+static_assert(to_underlying(insn_handler::C_ADDI4SPN) == 0, "instruction 0 must decode to handler 0");
 
 /// \brief Instruction fetch status code
 enum class fetch_status : int {
@@ -5406,7 +6136,7 @@ static FORCE_INLINE fetch_status fetch_translate_pc_slow(STATE_ACCESS &a, uint64
     unsigned char **phptr) {
     uint64_t paddr{};
     // Walk page table and obtain the physical address
-    if (unlikely(!translate_virtual_address(a, &paddr, vaddr, PTE_XWR_X_SHIFT))) {
+    if (unlikely(!translate_virtual_address_after_tlb_miss<TLB_CODE>(a, &paddr, vaddr, PTE_XWR_X_SHIFT))) {
         pc = raise_exception(a, pc, MCAUSE_FETCH_PAGE_FAULT, vaddr);
         return fetch_status::exception;
     }
@@ -5452,11 +6182,12 @@ static FORCE_INLINE fetch_status fetch_translate_pc(STATE_ACCESS &a, uint64_t &p
 /// \param insn Receives the instruction.
 /// \param fetch_vaddr_page Fetch virtual address translation page cache.
 /// \param fetch_vh_offset Fetch virtual address host pointer offset cache.
+/// \param fetch_slots Decoded instruction cache slots for the fetch page cache.
 /// \return Returns fetch_status::success if load succeeded, fetch_status::exception if it caused an exception.
 //          In that case, raise the exception.
 template <typename STATE_ACCESS>
 static FORCE_INLINE fetch_status fetch_insn(STATE_ACCESS &a, uint64_t &pc, uint32_t &insn, uint64_t &fetch_vaddr_page,
-    uint64_t &fetch_vh_offset) {
+    uint64_t &fetch_vh_offset, decoded_insn_slot *&fetch_slots) {
     unsigned char *hptr = nullptr;
     const uint64_t vaddr_page = pc & ~PAGE_OFFSET_MASK;
     // If pc is in the same page as the last pc fetch,
@@ -5471,6 +6202,9 @@ static FORCE_INLINE fetch_status fetch_insn(STATE_ACCESS &a, uint64_t &pc, uint3
         // Update fetch address translation cache
         fetch_vaddr_page = vaddr_page;
         fetch_vh_offset = cast_ptr_to_addr<uint64_t>(hptr) - pc;
+        if constexpr (use_decoded_insn_cache) {
+            fetch_slots = a.get_decoded_insn_slots(hptr - (pc & PAGE_OFFSET_MASK));
+        }
     }
     // The following code assumes pc is always 2-byte aligned, this is guaranteed by RISC-V spec.
     // If pc is pointing to the very last 2 bytes of a page, it's crossing a page boundary.
@@ -5487,6 +6221,9 @@ static FORCE_INLINE fetch_status fetch_insn(STATE_ACCESS &a, uint64_t &pc, uint3
             // Update fetch translation cache
             fetch_vaddr_page = vaddr & ~PAGE_OFFSET_MASK;
             fetch_vh_offset = cast_ptr_to_addr<uint64_t>(hptr) - vaddr;
+            if constexpr (use_decoded_insn_cache) {
+                fetch_slots = a.get_decoded_insn_slots(hptr);
+            }
             // Produce the final 4-byte instruction
             insn |= aliased_aligned_read<uint16_t>(hptr) << 16;
         }
@@ -5529,6 +6266,8 @@ NO_INLINE void interpret_loop(STATE_ACCESS &a, uint64_t mcycle_end, uint64_t mcy
     // Initialize fetch address translation cache invalidated
     uint64_t fetch_vaddr_page = PAGE_OFFSET_MASK;
     uint64_t fetch_vh_offset = 0;
+    // Decoded instruction cache slots for the fetch page
+    decoded_insn_slot *fetch_slots = nullptr;
 
     // The outer loop continues until there is an interruption that should be handled
     // externally, or mcycle reaches mcycle_end
@@ -5557,9 +6296,15 @@ NO_INLINE void interpret_loop(STATE_ACCESS &a, uint64_t mcycle_end, uint64_t mcy
             uint32_t insn = 0;
 
             // Try to fetch the next instruction
-            if (likely(fetch_insn(a, pc, insn, fetch_vaddr_page, fetch_vh_offset) == fetch_status::success)) {
-                // Try to execute it
-                const execute_status status = execute_insn(a, pc, mcycle, insn);
+            if (likely(fetch_insn(a, pc, insn, fetch_vaddr_page, fetch_vh_offset, fetch_slots) ==
+                    fetch_status::success)) {
+                // Try to execute it, skipping the decoder when the instruction has been decoded before
+                execute_status status{};
+                if constexpr (use_decoded_insn_cache) {
+                    status = execute_insn_via_decoded_cache(a, pc, mcycle, insn, fetch_slots);
+                } else {
+                    status = execute_insn(a, pc, mcycle, insn);
+                }
 
                 // When execute status is above success, we have to deal with special loop conditions,
                 // this is very unlikely to happen most of the time
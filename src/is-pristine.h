@@ -0,0 +1,61 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef IS_PRISTINE_H
+#define IS_PRISTINE_H
+
+/// \file
+/// \brief Fast check for memory filled with zeros
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cartesi {
+
+/// \brief Checks if a memory range is pristine, i.e., filled with zeros
+/// \param data Pointer to start of range
+/// \param length Length of range
+/// \returns True if all bytes in range are zero, false otherwise
+/// \details ORs together vectors of 64-bit words a block at a time,
+/// and stops at the first block that is not entirely zero.
+static inline bool is_pristine(const unsigned char *data, size_t length) {
+    using word_vector [[gnu::vector_size(2 * sizeof(uint64_t))]] = uint64_t;
+    constexpr size_t block_size = 16 * sizeof(word_vector);
+    size_t offset = 0;
+    for (; offset + block_size <= length; offset += block_size) {
+        word_vector bits{};
+#pragma GCC unroll 16
+        for (size_t i = 0; i < block_size; i += sizeof(word_vector)) {
+            word_vector words;
+            memcpy(&words, data + offset + i, sizeof(word_vector));
+            bits |= words;
+        }
+        if ((bits[0] | bits[1]) != 0) {
+            return false;
+        }
+    }
+    for (; offset < length; ++offset) {
+        if (data[offset] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace cartesi
+
+#endif
@@ -200,6 +200,23 @@ interpreter_break_reason interpreter_break_reason_from_name(const std::string &n
     return got->second;
 }
 
+static std::string interpreter_break_reason_name(interpreter_break_reason reason) {
+    using ibr = interpreter_break_reason;
+    switch (reason) {
+        case ibr::failed:
+            return "failed";
+        case ibr::halted:
+            return "halted";
+        case ibr::yielded_manually:
+            return "yielded_manually";
+        case ibr::yielded_automatically:
+            return "yielded_automatically";
+        case ibr::reached_target_mcycle:
+            return "reached_target_mcycle";
+    }
+    throw std::domain_error{"invalid interpreter break reason"};
+}
+
 uarch_interpreter_break_reason uarch_interpreter_break_reason_from_name(const std::string &name) {
     using uibr = uarch_interpreter_break_reason;
     if (name == "reached_target_cycle") {
@@ -211,6 +228,17 @@ uarch_interpreter_break_reason uarch_interpreter_break_reason_from_name(const st
     throw std::domain_error{"invalid uarch interpreter break reason"};
 }
 
+static std::string uarch_interpreter_break_reason_name(uarch_interpreter_break_reason reason) {
+    using uibr = uarch_interpreter_break_reason;
+    switch (reason) {
+        case uibr::uarch_halted:
+            return "uarch_halted";
+        case uibr::reached_target_cycle:
+            return "reached_target_cycle";
+    }
+    throw std::domain_error{"invalid uarch interpreter break reason"};
+}
+
 static std::string access_type_name(access_type at) {
     switch (at) {
         case access_type::read:
@@ -248,6 +276,20 @@ template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t
 template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key, std::string &value,
     const std::string &path);
 
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, nlohmann::json &value, const std::string &path) {
+    (void) path;
+    if (!contains(j, key)) {
+        return;
+    }
+    value = j[key];
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key, nlohmann::json &value,
+    const std::string &path);
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key, nlohmann::json &value,
+    const std::string &path);
+
 template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, bool &value, const std::string &path) {
     if (!contains(j, key)) {
@@ -405,6 +447,7 @@ void ju_get_opt_field(const nlohmann::json &j, const K &key, concurrency_runtime
         return;
     }
     ju_get_opt_field(j[key], "update_merkle_tree"s, value.update_merkle_tree, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "verify_uarch_step"s, value.verify_uarch_step, path + to_string(key) + "/");
 }
 
 template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
@@ -427,6 +470,22 @@ template void ju_get_opt_field<bool>(const nlohmann::json &j, const bool &key, h
 template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key, htif_runtime_config &value,
     const std::string &path);
 
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, host_tlb_runtime_config &value,
+    const std::string &path) {
+    if (!contains(j, key)) {
+        return;
+    }
+    ju_get_opt_field(j[key], "size"s, value.size, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "ways"s, value.ways, path + to_string(key) + "/");
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key, host_tlb_runtime_config &value,
+    const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    host_tlb_runtime_config &value, const std::string &path);
+
 template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, machine_runtime_config &value, const std::string &path) {
     if (!contains(j, key)) {
@@ -434,6 +493,9 @@ void ju_get_opt_field(const nlohmann::json &j, const K &key, machine_runtime_con
     }
     ju_get_field(j[key], "concurrency"s, value.concurrency, path + to_string(key) + "/");
     ju_get_field(j[key], "htif"s, value.htif, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "host_tlb"s, value.host_tlb, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "page_hash_cache_size"s, value.page_hash_cache_size, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "map_ram_image"s, value.map_ram_image, path + to_string(key) + "/");
     ju_get_opt_field(j[key], "skip_root_hash_check"s, value.skip_root_hash_check, path + to_string(key) + "/");
     ju_get_opt_field(j[key], "skip_version_check"s, value.skip_version_check, path + to_string(key) + "/");
 }
@@ -538,6 +600,126 @@ template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t
 template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
     not_default_constructible<machine_merkle_tree::proof_type> &value, const std::string &path);
 
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &path) {
+    value = {};
+    if (!contains(j, key)) {
+        return;
+    }
+    const auto &jk = j[key];
+    const auto new_path = path + to_string(key) + "/";
+    uint64_t log2_root_size = 0;
+    ju_get_field(jk, "log2_root_size"s, log2_root_size, new_path);
+    if (log2_root_size > INT_MAX) {
+        throw std::domain_error("field \""s + new_path + "log2_root_size\" is out of bounds");
+    }
+    uint64_t log2_target_size = 0;
+    ju_get_field(jk, "log2_target_size"s, log2_target_size, new_path);
+    if (log2_target_size > INT_MAX) {
+        throw std::domain_error("field \""s + new_path + "log2_target_size\" is out of bounds");
+    }
+    value.emplace(static_cast<int>(log2_root_size), static_cast<int>(log2_target_size));
+    auto &proof = value.value();
+    machine_merkle_tree::multiproof_type::hash_type root_hash;
+    ju_get_field(jk, "root_hash"s, root_hash, new_path);
+    proof.set_root_hash(root_hash);
+    if (!contains(jk, "targets")) {
+        throw std::invalid_argument("missing field \""s + new_path + "targets\""s);
+    }
+    const auto &ts = jk["targets"];
+    if (!ts.is_array()) {
+        throw std::invalid_argument("field \""s + new_path + "targets\" not an array"s);
+    }
+    for (uint64_t i = 0; i < ts.size(); ++i) {
+        const auto target_path = new_path + "targets/" + std::to_string(i) + "/";
+        machine_merkle_tree::multiproof_type::address_type address = 0;
+        ju_get_field(ts[i], "address"s, address, target_path);
+        machine_merkle_tree::multiproof_type::hash_type hash;
+        ju_get_field(ts[i], "hash"s, hash, target_path);
+        proof.add_target(address, hash);
+    }
+    std::vector<machine_merkle_tree::multiproof_type::hash_type> sibling_hashes;
+    ju_get_vector_like_field(jk, "sibling_hashes"s, sibling_hashes, new_path);
+    for (const auto &sibling_hash : sibling_hashes) {
+        proof.add_sibling_hash(sibling_hash);
+    }
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::vector<uint64_t> &value, const std::string &path) {
+    ju_get_opt_vector_like_field(j, key, value, path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key, std::vector<uint64_t> &value,
+    const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    std::vector<uint64_t> &value, const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::vector<std::string> &value,
+    const std::string &path) {
+    ju_get_opt_vector_like_field(j, key, value, path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    std::vector<std::string> &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    std::vector<std::string> &value, const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::vector<machine_merkle_tree::hash_type> &value,
+    const std::string &path) {
+    ju_get_opt_vector_like_field(j, key, value, path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    std::vector<machine_merkle_tree::hash_type> &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    std::vector<machine_merkle_tree::hash_type> &value, const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::pair<uint64_t, machine_merkle_tree::hash_type> &value,
+    const std::string &path) {
+    if (!contains(j, key)) {
+        return;
+    }
+    const auto &jk = j[key];
+    if (!jk.is_object()) {
+        throw std::invalid_argument("field \""s + path + to_string(key) + "\" not an object");
+    }
+    const auto new_path = path + to_string(key) + "/";
+    ju_get_field(jk, "mcycle"s, value.first, new_path);
+    ju_get_field(jk, "root_hash"s, value.second, new_path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    std::pair<uint64_t, machine_merkle_tree::hash_type> &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    std::pair<uint64_t, machine_merkle_tree::hash_type> &value, const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key,
+    std::vector<std::pair<uint64_t, machine_merkle_tree::hash_type>> &value, const std::string &path) {
+    ju_get_opt_vector_like_field(j, key, value, path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    std::vector<std::pair<uint64_t, machine_merkle_tree::hash_type>> &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    std::vector<std::pair<uint64_t, machine_merkle_tree::hash_type>> &value, const std::string &path);
+
 template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, access_type &value, const std::string &path) {
     if (!contains(j, key)) {
@@ -792,6 +974,18 @@ template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t
 template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
     not_default_constructible<access_log> &value, const std::string &path);
 
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::vector<access_log> &value,
+    const std::string &path) {
+    ju_get_opt_vector_like_field(j, key, value, path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key, std::vector<access_log> &value,
+    const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    std::vector<access_log> &value, const std::string &path);
+
 template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, processor_config &value, const std::string &path) {
     if (!contains(j, key)) {
@@ -1124,6 +1318,14 @@ void to_json(nlohmann::json &j, const machine::csr &csr) {
     j = csr_to_name(csr);
 }
 
+void to_json(nlohmann::json &j, const interpreter_break_reason &reason) {
+    j = interpreter_break_reason_name(reason);
+}
+
+void to_json(nlohmann::json &j, const uarch_interpreter_break_reason &reason) {
+    j = uarch_interpreter_break_reason_name(reason);
+}
+
 void to_json(nlohmann::json &j, const machine_merkle_tree::hash_type &h) {
     j = encode_base64(h);
 }
@@ -1134,6 +1336,19 @@ void to_json(nlohmann::json &j, const std::vector<machine_merkle_tree::hash_type
         [](const machine_merkle_tree::hash_type &h) -> nlohmann::json { return h; });
 }
 
+void to_json(nlohmann::json &j, const std::pair<uint64_t, machine_merkle_tree::hash_type> &c) {
+    j = nlohmann::json{{"mcycle", c.first}, {"root_hash", encode_base64(c.second)}};
+}
+
+void to_json(nlohmann::json &j, const std::vector<std::pair<uint64_t, machine_merkle_tree::hash_type>> &cs) {
+    j = nlohmann::json::array();
+    for (const auto &c : cs) {
+        nlohmann::json jc;
+        to_json(jc, c);
+        j.push_back(std::move(jc));
+    }
+}
+
 void to_json(nlohmann::json &j, const machine_merkle_tree::proof_type &p) {
     nlohmann::json s = nlohmann::json::array();
     for (int log2_size = p.get_log2_root_size() - 1; log2_size >= p.get_log2_target_size(); --log2_size) {
@@ -1144,6 +1359,19 @@ void to_json(nlohmann::json &j, const machine_merkle_tree::proof_type &p) {
         {"root_hash", encode_base64(p.get_root_hash())}, {"sibling_hashes", s}};
 }
 
+void to_json(nlohmann::json &j, const machine_merkle_tree::multiproof_type &p) {
+    nlohmann::json t = nlohmann::json::array();
+    for (const auto &target : p.get_targets()) {
+        t.push_back(nlohmann::json{{"address", target.address}, {"hash", encode_base64(target.hash)}});
+    }
+    nlohmann::json s = nlohmann::json::array();
+    for (const auto &sibling_hash : p.get_sibling_hashes()) {
+        s.push_back(encode_base64(sibling_hash));
+    }
+    j = nlohmann::json{{"log2_target_size", p.get_log2_target_size()}, {"log2_root_size", p.get_log2_root_size()},
+        {"root_hash", encode_base64(p.get_root_hash())}, {"targets", t}, {"sibling_hashes", s}};
+}
+
 void to_json(nlohmann::json &j, const access &a) {
     j = nlohmann::json{
         {"type", access_type_name(a.get_type())},
@@ -1319,6 +1547,7 @@ void to_json(nlohmann::json &j, const machine_config &config) {
 void to_json(nlohmann::json &j, const concurrency_runtime_config &config) {
     j = nlohmann::json{
         {"update_merkle_tree", config.update_merkle_tree},
+        {"verify_uarch_step", config.verify_uarch_step},
     };
 }
 
@@ -1328,10 +1557,20 @@ void to_json(nlohmann::json &j, const htif_runtime_config &config) {
     };
 }
 
+void to_json(nlohmann::json &j, const host_tlb_runtime_config &config) {
+    j = nlohmann::json{
+        {"size", config.size},
+        {"ways", config.ways},
+    };
+}
+
 void to_json(nlohmann::json &j, const machine_runtime_config &runtime) {
     j = nlohmann::json{
         {"concurrency", runtime.concurrency},
         {"htif", runtime.htif},
+        {"host_tlb", runtime.host_tlb},
+        {"page_hash_cache_size", runtime.page_hash_cache_size},
+        {"map_ram_image", runtime.map_ram_image},
         {"skip_root_hash_check", runtime.skip_root_hash_check},
         {"skip_version_check", runtime.skip_version_check},
     };
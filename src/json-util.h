@@ -80,6 +80,16 @@ inline bool contains(const nlohmann::json &j, const std::string &s) {
 template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, std::string &value, const std::string &path = "params/");
 
+/// \brief Attempts to load a JSON value of any type from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, nlohmann::json &value,
+    const std::string &path = "params/");
+
 /// \brief Attempts to load a bool from a field in a JSON object
 /// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
 /// \param j JSON object to load from
@@ -166,6 +176,16 @@ template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, htif_runtime_config &value,
     const std::string &path = "params/");
 
+/// \brief Attempts to load an host_tlb_runtime_config object from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, host_tlb_runtime_config &value,
+    const std::string &path = "params/");
+
 /// \brief Attempts to load an machine_runtime_config object from a field in a JSON object
 /// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
 /// \param j JSON object to load from
@@ -196,6 +216,66 @@ template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key,
     not_default_constructible<machine_merkle_tree::proof_type> &value, const std::string &path = "params/");
 
+/// \brief Attempts to load a Merkle tree multiproof object from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &path = "params/");
+
+/// \brief Attempts to load an array of addresses from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::vector<uint64_t> &value,
+    const std::string &path = "params/");
+
+/// \brief Attempts to load an array of strings from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::vector<std::string> &value,
+    const std::string &path = "params/");
+
+/// \brief Attempts to load an array of hashes from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::vector<machine_merkle_tree::hash_type> &value,
+    const std::string &path = "params/");
+
+/// \brief Attempts to load a checkpoint (mcycle and root hash) from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::pair<uint64_t, machine_merkle_tree::hash_type> &value,
+    const std::string &path = "params/");
+
+/// \brief Attempts to load an array of checkpoints from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key,
+    std::vector<std::pair<uint64_t, machine_merkle_tree::hash_type>> &value, const std::string &path = "params/");
+
 /// \brief Attempts to load an access_type name from a field in a JSON object
 /// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
 /// \param j JSON object to load from
@@ -261,6 +341,16 @@ template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, not_default_constructible<access_log> &optional,
     const std::string &path = "params/");
 
+/// \brief Attempts to load an array of state access logs from a field in a JSON object
+/// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
+/// \param j JSON object to load from
+/// \param key Key to load value from
+/// \param value Object to store value
+/// \param path Path to j
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, std::vector<access_log> &value,
+    const std::string &path = "params/");
+
 /// \brief Attempts to load a processor_config object from a field in a JSON object
 /// \tparam K Key type (explicit extern declarations for uint64_t and std::string are provided)
 /// \param j JSON object to load from
@@ -551,7 +641,10 @@ std::string encode_base64(const access_data &data);
 void to_json(nlohmann::json &j, const access_log::type &log_type);
 void to_json(nlohmann::json &j, const machine_merkle_tree::hash_type &h);
 void to_json(nlohmann::json &j, const std::vector<machine_merkle_tree::hash_type> &hs);
+void to_json(nlohmann::json &j, const std::pair<uint64_t, machine_merkle_tree::hash_type> &c);
+void to_json(nlohmann::json &j, const std::vector<std::pair<uint64_t, machine_merkle_tree::hash_type>> &cs);
 void to_json(nlohmann::json &j, const machine_merkle_tree::proof_type &p);
+void to_json(nlohmann::json &j, const machine_merkle_tree::multiproof_type &p);
 void to_json(nlohmann::json &j, const access &a);
 void to_json(nlohmann::json &j, const bracket_note &b);
 void to_json(nlohmann::json &j, const std::vector<bracket_note> &bs);
@@ -572,8 +665,11 @@ void to_json(nlohmann::json &j, const uarch_config &config);
 void to_json(nlohmann::json &j, const machine_config &config);
 void to_json(nlohmann::json &j, const concurrency_runtime_config &config);
 void to_json(nlohmann::json &j, const htif_runtime_config &config);
+void to_json(nlohmann::json &j, const host_tlb_runtime_config &config);
 void to_json(nlohmann::json &j, const machine_runtime_config &runtime);
 void to_json(nlohmann::json &j, const machine::csr &csr);
+void to_json(nlohmann::json &j, const interpreter_break_reason &reason);
+void to_json(nlohmann::json &j, const uarch_interpreter_break_reason &reason);
 void to_json(nlohmann::json &j, const machine_memory_range_descrs &mrds);
 
 // Extern template declarations
@@ -581,6 +677,10 @@ extern template void ju_get_opt_field(const nlohmann::json &j, const std::string
     const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, std::string &value,
     const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, nlohmann::json &value,
+    const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, nlohmann::json &value,
+    const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, bool &value,
     const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, bool &value,
@@ -615,6 +715,10 @@ extern template void ju_get_opt_field(const nlohmann::json &j, const bool &key,
     const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, htif_runtime_config &value,
     const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, host_tlb_runtime_config &value,
+    const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, host_tlb_runtime_config &value,
+    const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, machine_runtime_config &value,
     const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, machine_runtime_config &value,
@@ -627,6 +731,30 @@ extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &k
     not_default_constructible<machine_merkle_tree::proof_type> &value, const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key,
     not_default_constructible<machine_merkle_tree::proof_type> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, std::vector<uint64_t> &value,
+    const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, std::vector<uint64_t> &value,
+    const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, std::vector<std::string> &value,
+    const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key,
+    std::vector<std::string> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key,
+    std::vector<machine_merkle_tree::hash_type> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key,
+    std::vector<machine_merkle_tree::hash_type> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key,
+    std::pair<uint64_t, machine_merkle_tree::hash_type> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key,
+    std::pair<uint64_t, machine_merkle_tree::hash_type> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key,
+    std::vector<std::pair<uint64_t, machine_merkle_tree::hash_type>> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key,
+    std::vector<std::pair<uint64_t, machine_merkle_tree::hash_type>> &value, const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, access_type &value,
     const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, access_type &value,
@@ -657,6 +785,10 @@ extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &k
     not_default_constructible<access_log> &value, const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key,
     not_default_constructible<access_log> &value, const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, std::vector<access_log> &value,
+    const std::string &base = "params/");
+extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, std::vector<access_log> &value,
+    const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const uint64_t &key, processor_config &value,
     const std::string &base = "params/");
 extern template void ju_get_opt_field(const nlohmann::json &j, const std::string &key, processor_config &value,
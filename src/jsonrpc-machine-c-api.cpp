@@ -154,6 +154,25 @@ int cm_jsonrpc_verify_uarch_step_state_transition(const cm_jsonrpc_mg_mgr *mgr,
     return cm_result_failure(err_msg);
 }
 
+int cm_jsonrpc_verify_uarch_step_state_transitions(const cm_jsonrpc_mg_mgr *mgr, const cm_hash *root_hashes_before,
+    const cm_access_log *const *logs, const cm_hash *root_hashes_after, size_t count,
+    const cm_machine_runtime_config *runtime_config, bool one_based, char **log_err_msgs, char **err_msg) try {
+    if (log_err_msgs == nullptr && count > 0) {
+        throw std::invalid_argument("invalid log error messages output");
+    }
+    const auto *cpp_mgr = convert_from_c(mgr);
+    const auto cpp_root_hashes_before = convert_from_c(root_hashes_before, count);
+    const auto cpp_logs = convert_from_c(logs, count);
+    const auto cpp_root_hashes_after = convert_from_c(root_hashes_after, count);
+    const cartesi::machine_runtime_config cpp_runtime = convert_from_c(runtime_config);
+    convert_to_c(cartesi::jsonrpc_virtual_machine::verify_uarch_step_state_transitions(*cpp_mgr,
+                     cpp_root_hashes_before, cpp_logs, cpp_root_hashes_after, cpp_runtime, one_based),
+        log_err_msgs);
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
 int cm_jsonrpc_verify_uarch_reset_log(const cm_jsonrpc_mg_mgr *mgr, const cm_access_log *log,
     const cm_machine_runtime_config *runtime_config, bool one_based, char **err_msg) try {
     const auto *cpp_mgr = convert_from_c(mgr);
@@ -243,3 +262,11 @@ int cm_jsonrpc_shutdown(const cm_jsonrpc_mg_mgr *mgr, char **err_msg) try {
 } catch (...) {
     return cm_result_failure(err_msg);
 }
+
+int cm_jsonrpc_set_keep_alive(const cm_jsonrpc_mg_mgr *mgr, bool keep_alive, char **err_msg) try {
+    const auto *cpp_mgr = convert_from_c(mgr);
+    (*cpp_mgr)->set_keep_alive(keep_alive);
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
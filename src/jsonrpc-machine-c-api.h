@@ -143,6 +143,24 @@ CM_API int cm_jsonrpc_verify_uarch_step_state_transition(const cm_jsonrpc_mg_mgr
     const cm_access_log *log, const cm_hash *root_hash_after, const cm_machine_runtime_config *runtime_config,
     bool one_based, char **err_msg);
 
+/// \brief Checks the validity of many independent state transitions, in parallel on the server
+/// \param mgr Cartesi jsonrpc connection manager. Must be pointer to valid object
+/// \param root_hashes_before Array with the state hash before each step
+/// \param logs Array with the step state access logs
+/// \param root_hashes_after Array with the state hash after each step
+/// \param count Number of entries in each array
+/// \param runtime_config Runtime config to be used
+/// \param one_based Use 1-based indices when reporting errors
+/// \param log_err_msgs Array of count entries. Each receives NULL if its state transition is valid,
+/// or the reason it is not, which must be deleted by the function caller using cm_delete_cstring
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successfull function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring
+/// \returns 0 if all state transitions were checked, valid or not, non zero code for error
+CM_API int cm_jsonrpc_verify_uarch_step_state_transitions(const cm_jsonrpc_mg_mgr *mgr, const cm_hash *root_hashes_before,
+    const cm_access_log *const *logs, const cm_hash *root_hashes_after, size_t count,
+    const cm_machine_runtime_config *runtime_config, bool one_based, char **log_err_msgs, char **err_msg);
+
 /// \brief Forks the server
 /// \param mgr Cartesi jsonrpc connection manager. Must be pointer to valid object
 /// \param address Receives address of new server if function execution succeeds or NULL
@@ -212,6 +230,16 @@ CM_API int cm_jsonrpc_get_semantic_version(const cm_jsonrpc_mg_mgr *mgr, const c
 /// \returns 0 for successfull verification, non zero code for error
 CM_API int cm_jsonrpc_shutdown(const cm_jsonrpc_mg_mgr *mgr, char **err_msg);
 
+/// \brief Sets whether connections to the server are kept alive to serve later requests
+/// \param mgr Cartesi jsonrpc connection manager. Must be pointer to valid object
+/// \param keep_alive If false, each request is sent on a new connection. Otherwise, connections are reused.
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successfull function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring
+/// \details Keep-alive is enabled by default.
+/// \returns 0 for success, non zero code for error
+CM_API int cm_jsonrpc_set_keep_alive(const cm_jsonrpc_mg_mgr *mgr, bool keep_alive, char **err_msg);
+
 #ifdef __cplusplus
 }
 #endif
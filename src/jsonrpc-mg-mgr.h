@@ -28,6 +28,8 @@ class jsonrpc_mg_mgr final {
 
     boost::container::static_vector<std::string, 2> m_address{};
     struct mg_mgr m_mgr {}; // unecessary initialization to silince clang-tidy
+    bool m_keep_alive{true};
+    bool m_binary_requests{true};
 
 public:
     explicit jsonrpc_mg_mgr(std::string remote_address);
@@ -40,6 +42,16 @@ public:
     bool is_shutdown(void) const;
     struct mg_mgr &get_mgr(void);
     const struct mg_mgr &get_mgr(void) const;
+    /// \brief Checks if connections to the server are kept alive to serve later requests
+    bool is_keep_alive(void) const;
+    /// \brief Sets whether connections to the server are kept alive to serve later requests
+    /// \details Keep-alive is enabled by default. Disabling it closes the connections kept alive so far.
+    void set_keep_alive(bool keep_alive);
+    /// \brief Checks if requests may carry raw bytes after the JSON request
+    bool is_binary_requests(void) const;
+    /// \brief Sets whether requests may carry raw bytes after the JSON request
+    /// \details Enabled by default, and disabled once the server fails to parse such a request.
+    void set_binary_requests(bool binary_requests);
     const std::string &get_remote_address(void) const;
     const std::string &get_remote_parent_address(void) const;
     void snapshot(void);
@@ -0,0 +1,293 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef JSONRPC_PARAMS_H
+#define JSONRPC_PARAMS_H
+
+/// \file
+/// \brief Parsing of JSONRPC request params into typed arguments
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+#include "json-util.h"
+
+namespace cartesi {
+
+/// \brief Checks that a JSON object contains only fields with allowed keys
+/// \param j JSON object to test
+/// \param keys Set of allowed keys
+inline void jsonrpc_check_allowed_fields(const nlohmann::json &j, const std::unordered_set<std::string> &keys,
+    const std::string &base = "params/") {
+    for (const auto &[key, val] : j.items()) {
+        if (keys.find(key) == keys.end()) {
+            // NOLINTNEXTLINE(performance-inefficient-string-concatenation)
+            throw std::invalid_argument("unexpected field \"/"s + base + key + "\""s);
+        }
+    }
+}
+
+/// \brief Checks that a JSON object all fields with given keys
+/// \param j JSON object to test
+/// \param keys Set of mandatory keys
+inline void jsonrpc_check_mandatory_fields(const nlohmann::json &j, const std::unordered_set<std::string> &keys,
+    const std::string &base = "params/") {
+    for (const auto &key : keys) {
+        if (!j.contains(key)) {
+            // NOLINTNEXTLINE(performance-inefficient-string-concatenation)
+            throw std::invalid_argument("missing field \"/"s + base + key + "\""s);
+        }
+    }
+}
+
+/// \brief Checks that a JSONRPC request has no params, or empty params
+/// \param j JSONRPC request
+/// \param path Path to params, for error messages
+inline void jsonrpc_check_no_params(const nlohmann::json &j, const std::string &path = "params") {
+    if (j.contains("params") && !j["params"].empty()) {
+        throw std::invalid_argument("unexpected \""s + path + "\" field"s);
+    }
+}
+
+/// \brief Type trait to test if a type has been encapsulated in an optional_param
+/// \tparam T type to test
+/// \details This is the default case
+template <typename T>
+struct is_optional_param : std::false_type {};
+
+/// \brief Type trait to test if a type has been encapsulated in an optional_param
+/// \tparam T type to test
+/// \details This is the encapsulated case
+template <typename T>
+struct is_optional_param<optional_param<T>> : std::true_type {};
+
+/// \brief Shortcut to the type trait to test if a type has been encapsulated in an optional_param
+/// \tparam T type to test
+template <typename T>
+inline constexpr bool is_optional_param_v = is_optional_param<T>::value;
+
+/// \brief Counts the number of parameters that are mandatory (i.e., not wrapped in optional_param)
+/// \tparam ARGS Parameter pack to test
+/// \returns Number of parameters wrapped in optional_param
+template <typename... ARGS>
+constexpr size_t count_mandatory_params(void) {
+    return ((is_optional_param_v<ARGS> ? 0 : 1) + ... + 0);
+}
+
+/// \brief Returns index of the first parameter that is optional (i.e., wrapped in optional_param)
+/// \tparam ARGS Parameter pack to test
+/// \tparam I Parameter pack with indices of each parameter
+/// \returns Index of first parameter that is optional
+template <typename... ARGS, size_t... I>
+size_t first_optional_param(const std::tuple<ARGS...> &, std::index_sequence<I...>) {
+    if constexpr (sizeof...(ARGS) > 0) {
+        return std::min({(is_optional_param_v<ARGS> ? I + 1 : sizeof...(ARGS) + 1)...});
+    } else {
+        return sizeof...(ARGS) + 1;
+    }
+}
+
+/// \brief Returns index of the first parameter that is optional (i.e., wrapped in optional_param)
+/// \tparam ARGS Parameter pack to test
+/// \tparam I Parameter pack with indices of each parameter
+/// \returns Index of first parameter that is optional
+template <typename... ARGS, size_t... I>
+size_t last_mandatory_param(const std::tuple<ARGS...> &, std::index_sequence<I...>) {
+    if constexpr (sizeof...(ARGS) > 0) {
+        return std::max({(!is_optional_param_v<ARGS> ? I + 1 : 0)...});
+    } else {
+        return 0;
+    }
+}
+
+/// \brief Checks if an argument has a value
+/// \tparam T Type of argument
+/// \param t Argument
+/// \returns True if it has a value
+/// \details This is the default overload
+template <typename T>
+bool has_arg(const T &t) {
+    (void) t;
+    return true;
+}
+
+/// \brief Checks if an argument has a value
+/// \tparam T Type of argument
+/// \param t Argument
+/// \returns True if it has a value
+/// \details This is the overload for optional paramenters (i.e., wrapped in optional_param)
+template <typename T>
+bool has_arg(const optional_param<T> &t) {
+    return t.has_value();
+}
+
+/// \brief Finds the index of the first missing optional argument (i.e., wrapped in optional_param)
+/// \tparam ARGS Parameter pack with parameter types
+/// \tparam I Parameter pack with indices of each parameter
+/// \returns Index of first optional argument that is missing
+/// \details The function returns the index + 1, so that sizeof...(ARGS)+1 means no missing optional arguments
+template <typename... ARGS, size_t... I>
+size_t first_missing_optional_arg(const std::tuple<ARGS...> &tup, std::index_sequence<I...>) {
+    if constexpr (sizeof...(ARGS) > 0) {
+        return std::min({(!has_arg(std::get<I>(tup)) ? I + 1 : sizeof...(ARGS) + 1)...});
+    } else {
+        return 1;
+    }
+}
+
+/// \brief Finds the index of the last argument that is present
+/// \tparam ARGS Parameter pack with parameter types
+/// \tparam I Parameter pack with indices of each parameter
+/// \returns Index of last argument that is present
+/// \details The function returns the index + 1, so that 0 means no arguments are present
+template <typename... ARGS, size_t... I>
+size_t last_present_arg(const std::tuple<ARGS...> &tup, std::index_sequence<I...>) {
+    if constexpr (sizeof...(ARGS) > 0) {
+        return std::max({(has_arg(std::get<I>(tup)) ? I + 1 : 0)...});
+    } else {
+        return 0;
+    }
+}
+
+/// \brief Counts the number of arguments provided
+/// \tparam ARGS Parameter pack with parameter types
+/// \tparam I Parameter pack with indices of each parameter
+/// \param tup Tupple with all arguments
+/// \param i Index sequence
+/// \returns Number of arguments provided
+template <typename... ARGS, size_t... I>
+size_t count_args(const std::tuple<ARGS...> &tup, const std::index_sequence<I...> &i) {
+    // check first optional parameter happens after last mandatory parameter
+    auto fop = first_optional_param(tup, i);
+    auto lmp = last_mandatory_param(tup, i);
+    if (fop <= lmp) {
+        throw std::invalid_argument{"first optional parameter must come after last mandatory parameter"};
+    }
+    // make sure last present optional argument comes before first missing optional argument
+    auto fmoa = first_missing_optional_arg(tup, i);
+    auto lpa = last_present_arg(tup, i);
+    if (lpa >= fmoa) {
+        throw std::invalid_argument{"first missing optional argument must come after last present argument"};
+    }
+    return std::max(lmp, lpa);
+}
+
+/// \brief Counts the number of arguments provided
+/// \tparam ARGS Parameter pack with parameter types
+/// \param tup Tupple with all arguments
+/// \returns Number of arguments provided
+template <typename... ARGS>
+size_t count_args(const std::tuple<ARGS...> &tup) {
+    return count_args(tup, std::make_index_sequence<sizeof...(ARGS)>{});
+}
+
+/// \brief Parse arguments from an array
+/// \tparam ARGS Parameter pack with parameter types
+/// \tparam I Parameter pack with indices of each parameter
+/// \param j JSONRPC request params
+/// \param path Path to params, for error messages
+/// \returns tuple with arguments
+template <typename... ARGS, size_t... I>
+std::tuple<ARGS...> parse_array_args(const nlohmann::json &j, const std::string &path, std::index_sequence<I...>) {
+    std::tuple<ARGS...> tp;
+    (ju_get_field(j, static_cast<uint64_t>(I), std::get<I>(tp), path), ...);
+    return tp;
+}
+
+/// \brief Parse arguments from an array
+/// \tparam ARGS Parameter pack with parameter types
+/// \param j JSONRPC request params
+/// \param path Path to params, for error messages
+/// \returns tuple with arguments
+template <typename... ARGS>
+std::tuple<ARGS...> parse_array_args(const nlohmann::json &j, const std::string &path) {
+    return parse_array_args<ARGS...>(j, path, std::make_index_sequence<sizeof...(ARGS)>{});
+}
+
+/// \brief Parse arguments from an object
+/// \tparam ARGS Parameter pack with parameter types
+/// \tparam I Parameter pack with indices of each parameter
+/// \param j JSONRPC request params
+/// \param param_name Name of each parameter
+/// \param path Path to params, for error messages
+/// \returns tuple with arguments
+template <typename... ARGS, size_t... I>
+std::tuple<ARGS...> parse_object_args(const nlohmann::json &j, const char *(&param_name)[sizeof...(ARGS)],
+    const std::string &path, std::index_sequence<I...>) {
+    std::tuple<ARGS...> tp;
+    (ju_get_field(j, std::string(param_name[I]), std::get<I>(tp), path), ...);
+    return tp;
+}
+
+/// \brief Parse arguments from an object
+/// \tparam ARGS Parameter pack with parameter types
+/// \param j JSONRPC request params
+/// \param param_name Name of each parameter
+/// \param path Path to params, for error messages
+/// \returns tuple with arguments
+template <typename... ARGS>
+std::tuple<ARGS...> parse_object_args(const nlohmann::json &j, const char *(&param_name)[sizeof...(ARGS)],
+    const std::string &path) {
+    return parse_object_args<ARGS...>(j, param_name, path, std::make_index_sequence<sizeof...(ARGS)>{});
+}
+
+/// \brief Parse arguments from an object or array
+/// \tparam ARGS Parameter pack with parameter types
+/// \param j JSONRPC request, or any object with a params field
+/// \param param_name Name of each parameter
+/// \param path Path to params, for error messages
+/// \returns tuple with arguments
+template <typename... ARGS>
+std::tuple<ARGS...> parse_args(const nlohmann::json &j, const char *(&param_name)[sizeof...(ARGS)],
+    const std::string &path = "params") {
+    constexpr auto mandatory_params = count_mandatory_params<ARGS...>();
+    if (!j.contains("params")) {
+        if constexpr (mandatory_params == 0) {
+            return std::make_tuple(ARGS{}...);
+        }
+        throw std::invalid_argument("missing field \""s + path + "\""s);
+    }
+    const nlohmann::json &params = j["params"];
+    if (!params.is_object() && !params.is_array()) {
+        throw std::invalid_argument("\""s + path + "\" field not object or array"s);
+    }
+    const std::string base = path + "/"s;
+    if (params.is_object()) {
+        //??D This could be optimized so we don't construct these sets every call
+        jsonrpc_check_mandatory_fields(params,
+            std::unordered_set<std::string>{param_name, param_name + mandatory_params}, base);
+        jsonrpc_check_allowed_fields(params, std::unordered_set<std::string>{param_name, param_name + sizeof...(ARGS)},
+            base);
+        return parse_object_args<ARGS...>(params, param_name, base);
+    }
+    if (params.size() < mandatory_params) {
+        throw std::invalid_argument("not enough entries in \""s + path + "\" array"s);
+    }
+    if (params.size() > sizeof...(ARGS)) {
+        throw std::invalid_argument("too many entries in \""s + path + "\" array"s);
+    }
+    return parse_array_args<ARGS...>(params, base);
+}
+
+} // namespace cartesi
+
+#endif
@@ -20,6 +20,7 @@
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <exception>
 #include <iostream>
@@ -39,9 +40,12 @@
 
 #include <mongoose.h>
 
+#include "access-log-binary.h"
 #include "base64.h"
 #include "json-util.h"
 #include "jsonrpc-discover.h"
+#include "jsonrpc-params.h"
+#include "machine-transaction.h"
 #include "machine.h"
 #include "unique-c-ptr.h"
 
@@ -74,6 +78,9 @@ std::ostream &operator<<(std::ostream &out, log_prefix prefix) {
 
 using namespace std::string_literals;
 using json = nlohmann::json;
+using cartesi::count_args;
+using cartesi::jsonrpc_check_no_params;
+using cartesi::parse_args;
 
 /// \brief Server semantic version major
 static constexpr uint32_t server_version_major = 0;
@@ -287,251 +294,6 @@ static json jsonrpc_response_invalid_params(const json &j, const std::string &me
     return jsonrpc_response_error(j, jsonrpc_error_code::invalid_params, message);
 }
 
-/// \brief Checks that a JSON object contains only fields with allowed keys
-/// \param j JSON object to test
-/// \param keys Set of allowed keys
-static void jsonrpc_check_allowed_fields(const json &j, const std::unordered_set<std::string> &keys,
-    const std::string &base = "params/") {
-    for (const auto &[key, val] : j.items()) {
-        if (keys.find(key) == keys.end()) {
-            // NOLINTNEXTLINE(performance-inefficient-string-concatenation)
-            throw std::invalid_argument("unexpected field \"/"s + base + key + "\""s);
-        }
-    }
-}
-
-/// \brief Checks that a JSON object all fields with given keys
-/// \param j JSON object to test
-/// \param keys Set of mandatory keys
-static void jsonrpc_check_mandatory_fields(const json &j, const std::unordered_set<std::string> &keys,
-    const std::string &base = "params/") {
-    for (const auto &key : keys) {
-        if (!j.contains(key)) {
-            // NOLINTNEXTLINE(performance-inefficient-string-concatenation)
-            throw std::invalid_argument("missing field \"/"s + base + key + "\""s);
-        }
-    }
-}
-
-/// \brief Checks that a JSON object contains no fields
-/// \param j JSON object to test
-static void jsonrpc_check_no_params(const json &j) {
-    if (j.contains("params") && !j["params"].empty()) {
-        throw std::invalid_argument("unexpected \"params\" field");
-    }
-}
-
-/// \brief Type trait to test if a type has been encapsulated in an optional_param
-/// \tparam T type to test
-/// \details This is the default case
-template <typename T>
-struct is_optional_param : std::false_type {};
-
-/// \brief Type trait to test if a type has been encapsulated in an optional_param
-/// \tparam T type to test
-/// \details This is the encapsulated case
-template <typename T>
-struct is_optional_param<cartesi::optional_param<T>> : std::true_type {};
-
-/// \brief Shortcut to the type trait to test if a type has been encapsulated in an optional_param
-/// \tparam T type to test
-template <typename T>
-inline constexpr bool is_optional_param_v = is_optional_param<T>::value;
-
-/// \brief Counts the number of parameters that are mandatory (i.e., not wrapped in optional_param)
-/// \tparam ARGS Parameter pack to test
-/// \returns Number of parameters wrapped in optional_param
-template <typename... ARGS>
-constexpr size_t count_mandatory_params(void) {
-    return ((is_optional_param_v<ARGS> ? 0 : 1) + ... + 0);
-}
-
-/// \brief Returns index of the first parameter that is optional (i.e., wrapped in optional_param)
-/// \tparam ARGS Parameter pack to test
-/// \tparam I Parameter pack with indices of each parameter
-/// \returns Index of first parameter that is optional
-template <typename... ARGS, size_t... I>
-size_t first_optional_param(const std::tuple<ARGS...> &, std::index_sequence<I...>) {
-    if constexpr (sizeof...(ARGS) > 0) {
-        return std::min({(is_optional_param_v<ARGS> ? I + 1 : sizeof...(ARGS) + 1)...});
-    } else {
-        return sizeof...(ARGS) + 1;
-    }
-}
-
-/// \brief Returns index of the first parameter that is optional (i.e., wrapped in optional_param)
-/// \tparam ARGS Parameter pack to test
-/// \tparam I Parameter pack with indices of each parameter
-/// \returns Index of first parameter that is optional
-template <typename... ARGS, size_t... I>
-size_t last_mandatory_param(const std::tuple<ARGS...> &, std::index_sequence<I...>) {
-    if constexpr (sizeof...(ARGS) > 0) {
-        return std::max({(!is_optional_param_v<ARGS> ? I + 1 : 0)...});
-    } else {
-        return 0;
-    }
-}
-
-/// \brief Checks if an argument has a value
-/// \tparam T Type of argument
-/// \param t Argument
-/// \returns True if it has a value
-/// \details This is the default overload
-template <typename T>
-bool has_arg(const T &t) {
-    (void) t;
-    return true;
-}
-
-/// \brief Checks if an argument has a value
-/// \tparam T Type of argument
-/// \param t Argument
-/// \returns True if it has a value
-/// \details This is the overload for optional paramenters (i.e., wrapped in optional_param)
-template <typename T>
-bool has_arg(const cartesi::optional_param<T> &t) {
-    return t.has_value();
-}
-
-/// \brief Finds the index of the first missing optional argument (i.e., wrapped in optional_param)
-/// \tparam ARGS Parameter pack with parameter types
-/// \tparam I Parameter pack with indices of each parameter
-/// \returns Index of first optional argument that is missing
-/// \details The function returns the index + 1, so that sizeof...(ARGS)+1 means no missing optional arguments
-template <typename... ARGS, size_t... I>
-size_t first_missing_optional_arg(const std::tuple<ARGS...> &tup, std::index_sequence<I...>) {
-    if constexpr (sizeof...(ARGS) > 0) {
-        return std::min({(!has_arg(std::get<I>(tup)) ? I + 1 : sizeof...(ARGS) + 1)...});
-    } else {
-        return 1;
-    }
-}
-
-/// \brief Finds the index of the last argument that is present
-/// \tparam ARGS Parameter pack with parameter types
-/// \tparam I Parameter pack with indices of each parameter
-/// \returns Index of last argument that is present
-/// \details The function returns the index + 1, so that 0 means no arguments are present
-template <typename... ARGS, size_t... I>
-size_t last_present_arg(const std::tuple<ARGS...> &tup, std::index_sequence<I...>) {
-    if constexpr (sizeof...(ARGS) > 0) {
-        return std::max({(has_arg(std::get<I>(tup)) ? I + 1 : 0)...});
-    } else {
-        return 0;
-    }
-}
-
-/// \brief Counts the number of arguments provided
-/// \tparam ARGS Parameter pack with parameter types
-/// \tparam I Parameter pack with indices of each parameter
-/// \param tup Tupple with all arguments
-/// \param i Index sequence
-/// \returns Number of arguments provided
-template <typename... ARGS, size_t... I>
-size_t count_args(const std::tuple<ARGS...> &tup, const std::index_sequence<I...> &i) {
-    // check first optional parameter happens after last mandatory parameter
-    auto fop = first_optional_param(tup, i);
-    auto lmp = last_mandatory_param(tup, i);
-    if (fop <= lmp) {
-        throw std::invalid_argument{"first optional parameter must come after last mandatory parameter"};
-    }
-    // make sure last present optional argument comes before first missing optional argument
-    auto fmoa = first_missing_optional_arg(tup, i);
-    auto lpa = last_present_arg(tup, i);
-    if (lpa >= fmoa) {
-        throw std::invalid_argument{"first missing optional argument must come after last present argument"};
-    }
-    return std::max(lmp, lpa);
-}
-
-/// \brief Counts the number of arguments provided
-/// \tparam ARGS Parameter pack with parameter types
-/// \param tup Tupple with all arguments
-/// \returns Number of arguments provided
-template <typename... ARGS>
-size_t count_args(const std::tuple<ARGS...> &tup) {
-    return count_args(tup, std::make_index_sequence<sizeof...(ARGS)>{});
-}
-
-/// \brief Parse arguments from an array
-/// \tparam ARGS Parameter pack with parameter types
-/// \tparam I Parameter pack with indices of each parameter
-/// \param j JSONRPC request params
-/// \returns tuple with arguments
-template <typename... ARGS, size_t... I>
-std::tuple<ARGS...> parse_array_args(const json &j, std::index_sequence<I...>) {
-    std::tuple<ARGS...> tp;
-    (cartesi::ju_get_field(j, static_cast<uint64_t>(I), std::get<I>(tp)), ...);
-    return tp;
-}
-
-/// \brief Parse arguments from an array
-/// \tparam ARGS Parameter pack with parameter types
-/// \param j JSONRPC request params
-/// \returns tuple with arguments
-template <typename... ARGS>
-std::tuple<ARGS...> parse_array_args(const json &j) {
-    return parse_array_args<ARGS...>(j, std::make_index_sequence<sizeof...(ARGS)>{});
-}
-
-/// \brief Parse arguments from an object
-/// \tparam ARGS Parameter pack with parameter types
-/// \tparam I Parameter pack with indices of each parameter
-/// \param j JSONRPC request params
-/// \param param_name Name of each parameter
-/// \returns tuple with arguments
-template <typename... ARGS, size_t... I>
-std::tuple<ARGS...> parse_object_args(const json &j, const char *(&param_name)[sizeof...(ARGS)],
-    std::index_sequence<I...>) {
-    std::tuple<ARGS...> tp;
-    (cartesi::ju_get_field(j, std::string(param_name[I]), std::get<I>(tp)), ...);
-    return tp;
-}
-
-/// \brief Parse arguments from an object
-/// \tparam ARGS Parameter pack with parameter types
-/// \param j JSONRPC request params
-/// \param param_name Name of each parameter
-/// \returns tuple with arguments
-template <typename... ARGS>
-std::tuple<ARGS...> parse_object_args(const json &j, const char *(&param_name)[sizeof...(ARGS)]) {
-    return parse_object_args<ARGS...>(j, param_name, std::make_index_sequence<sizeof...(ARGS)>{});
-}
-
-/// \brief Parse arguments from an object or array
-/// \tparam ARGS Parameter pack with parameter types
-/// \param j JSONRPC request params
-/// \param param_name Name of each parameter
-/// \returns tuple with arguments
-template <typename... ARGS>
-std::tuple<ARGS...> parse_args(const json &j, const char *(&param_name)[sizeof...(ARGS)]) {
-    constexpr auto mandatory_params = count_mandatory_params<ARGS...>();
-    if (!j.contains("params")) {
-        if constexpr (mandatory_params == 0) {
-            return std::make_tuple(ARGS{}...);
-        }
-        throw std::invalid_argument("missing field \"params\"");
-    }
-    const json &params = j["params"];
-    if (!params.is_object() && !params.is_array()) {
-        throw std::invalid_argument("\"params\" field not object or array");
-    }
-    if (params.is_object()) {
-        //??D This could be optimized so we don't construct these sets every call
-        jsonrpc_check_mandatory_fields(params,
-            std::unordered_set<std::string>{param_name, param_name + mandatory_params});
-        jsonrpc_check_allowed_fields(params, std::unordered_set<std::string>{param_name, param_name + sizeof...(ARGS)});
-        return parse_object_args<ARGS...>(params, param_name);
-    }
-    if (params.size() < mandatory_params) {
-        throw std::invalid_argument("not enough entries in \"params\" array");
-    }
-    if (params.size() > sizeof...(ARGS)) {
-        throw std::invalid_argument("too many entries in \"params\" array");
-    }
-    return parse_array_args<ARGS...>(params);
-}
-
 /// \brief JSONRPC handler for the shutdown method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -726,6 +488,51 @@ static json jsonrpc_machine_destroy_handler(const json &j, mg_connection *con, h
     return jsonrpc_response_ok(j);
 }
 
+/// \brief JSONRPC handler for the machine.snapshot method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_snapshot_handler(const json &j, mg_connection *con, http_handler_data *h) {
+    (void) con;
+    if (!h->machine) {
+        return jsonrpc_response_invalid_request(j, "no machine");
+    }
+    jsonrpc_check_no_params(j);
+    h->machine->snapshot();
+    return jsonrpc_response_ok(j);
+}
+
+/// \brief JSONRPC handler for the machine.rollback method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_rollback_handler(const json &j, mg_connection *con, http_handler_data *h) {
+    (void) con;
+    if (!h->machine) {
+        return jsonrpc_response_invalid_request(j, "no machine");
+    }
+    jsonrpc_check_no_params(j);
+    h->machine->rollback();
+    return jsonrpc_response_ok(j);
+}
+
+/// \brief JSONRPC handler for the machine.commit method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_commit_handler(const json &j, mg_connection *con, http_handler_data *h) {
+    (void) con;
+    if (!h->machine) {
+        return jsonrpc_response_invalid_request(j, "no machine");
+    }
+    jsonrpc_check_no_params(j);
+    h->machine->commit();
+    return jsonrpc_response_ok(j);
+}
+
 /// \brief JSONRPC handler for the machine.store method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -742,70 +549,68 @@ static json jsonrpc_machine_store_handler(const json &j, mg_connection *con, htt
     return jsonrpc_response_ok(j);
 }
 
-/// \brief Translate an interpret_break_reason value to string
-/// \param reason interpret_break_reason value to translate
-/// \returns String representation of value
-static std::string interpreter_break_reason_name(cartesi::interpreter_break_reason reason) {
-    using R = cartesi::interpreter_break_reason;
-    switch (reason) {
-        case R::failed:
-            return "failed";
-        case R::halted:
-            return "halted";
-        case R::yielded_manually:
-            return "yielded_manually";
-        case R::yielded_automatically:
-            return "yielded_automatically";
-        case R::reached_target_mcycle:
-            return "reached_target_mcycle";
+/// \brief JSONRPC handler for the machine.store_delta method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_store_delta_handler(const json &j, mg_connection *con, http_handler_data *h) {
+    (void) con;
+    if (!h->machine) {
+        return jsonrpc_response_invalid_request(j, "no machine");
     }
-    throw std::domain_error{"invalid interpreter break reason"};
+    static const char *param_name[] = {"directory", "base_directory"};
+    auto args = parse_args<std::string, std::string>(j, param_name);
+    h->machine->store_delta(std::get<0>(args), std::get<1>(args));
+    return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.run method
+/// \brief JSONRPC handler for the machine.run_with_checkpoints method
 /// \param j JSON request object
 /// \param con Mongoose connection
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_run_handler(const json &j, mg_connection *con, http_handler_data *h) {
+static json jsonrpc_machine_run_with_checkpoints_handler(const json &j, mg_connection *con, http_handler_data *h) {
     (void) con;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"mcycle_end"};
-    auto args = parse_args<uint64_t>(j, param_name);
-    auto reason = h->machine->run(std::get<0>(args));
-    return jsonrpc_response_ok(j, interpreter_break_reason_name(reason));
+    static const char *param_name[] = {"mcycle_end", "period"};
+    auto args = parse_args<uint64_t, uint64_t>(j, param_name);
+    json checkpoints;
+    cartesi::to_json(checkpoints, h->machine->run_with_checkpoints(std::get<0>(args), std::get<1>(args)));
+    return jsonrpc_response_ok(j, checkpoints);
 }
 
-/// \brief Translate an uarch_interpret_break_reason value to string
-/// \param reason uarch_interpret_break_reason value to translate
-/// \returns String representation of value
-static std::string uarch_interpreter_break_reason_name(cartesi::uarch_interpreter_break_reason reason) {
-    using R = cartesi::uarch_interpreter_break_reason;
-    switch (reason) {
-        case R::uarch_halted:
-            return "uarch_halted";
-        case R::reached_target_cycle:
-            return "reached_target_cycle";
+/// \brief JSONRPC handler for the machine.transaction method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_transaction_handler(const json &j, mg_connection *con, http_handler_data *h) {
+    (void) con;
+    if (!h->machine) {
+        return jsonrpc_response_invalid_request(j, "no machine");
     }
-    throw std::domain_error{"invalid uarch interpreter break reason"};
+    static const char *param_name[] = {"operations"};
+    auto args = parse_args<json>(j, param_name);
+    return jsonrpc_response_ok(j, cartesi::run_transaction(*h->machine, std::get<0>(args)));
 }
 
-/// \brief JSONRPC handler for the machine.run_uarch method
+/// \brief JSONRPC handler for the machine methods that can also run in transactions
 /// \param j JSON request object
 /// \param con Mongoose connection
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_run_uarch_handler(const json &j, mg_connection *con, http_handler_data *h) {
+/// \details Requests and transactions run the same code, so arguments and results are the same in both.
+static json jsonrpc_machine_transaction_method_handler(const json &j, mg_connection *con, http_handler_data *h) {
     (void) con;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"uarch_cycle_end"};
-    auto args = parse_args<uint64_t>(j, param_name);
-    auto reason = h->machine->run_uarch(std::get<0>(args));
-    return jsonrpc_response_ok(j, uarch_interpreter_break_reason_name(reason));
+    // Only methods named "machine." followed by the name of a transaction method are dispatched here
+    const auto method = j["method"].get<std::string>().substr(std::strlen("machine."));
+    return jsonrpc_response_ok(j, cartesi::find_transaction_method<cartesi::machine>(method)(*h->machine, j, "params"));
 }
 
 /// \brief JSONRPC handler for the machine.log_uarch_step method
@@ -839,6 +644,25 @@ static json jsonrpc_machine_log_uarch_step_handler(const json &j, mg_connection
     return s;
 }
 
+/// \brief JSONRPC handler for the machine.log_uarch_steps method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_log_uarch_steps_handler(const json &j, mg_connection *con, http_handler_data *h) {
+    (void) con;
+    if (!h->machine) {
+        return jsonrpc_response_invalid_request(j, "no machine");
+    }
+    static const char *param_name[] = {"count", "log_type", "one_based"};
+    auto args = parse_args<uint64_t, cartesi::not_default_constructible<cartesi::access_log::type>,
+        cartesi::optional_param<bool>>(j, param_name);
+    (void) count_args(args);
+    return jsonrpc_response_ok(j,
+        // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+        h->machine->log_uarch_steps(std::get<0>(args), std::get<1>(args).value(), std::get<2>(args).value_or(false)));
+}
+
 /// \brief JSONRPC handler for the machine.verify_uarch_step_log method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -971,6 +795,25 @@ static json jsonrpc_machine_verify_uarch_step_state_transition_handler(const jso
     return jsonrpc_response_ok(j);
 }
 
+/// \brief JSONRPC handler for the machine.verify_uarch_step_state_transitions method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_verify_uarch_step_state_transitions_handler(const json &j, mg_connection *con,
+    http_handler_data *h) {
+    (void) con;
+    (void) h;
+    static const char *param_name[] = {"root_hashes_before", "logs", "root_hashes_after", "runtime", "one_based"};
+    auto args = parse_args<std::vector<cartesi::machine_merkle_tree::hash_type>, std::vector<cartesi::access_log>,
+        std::vector<cartesi::machine_merkle_tree::hash_type>, cartesi::optional_param<cartesi::machine_runtime_config>,
+        cartesi::optional_param<bool>>(j, param_name);
+    (void) count_args(args);
+    return jsonrpc_response_ok(j,
+        cartesi::machine::verify_uarch_step_state_transitions(std::get<0>(args), std::get<1>(args), std::get<2>(args),
+            std::get<3>(args).value_or(cartesi::machine_runtime_config{}), std::get<4>(args).value_or(false)));
+}
+
 /// \brief JSONRPC handler for the machine.verify_uarch_reset_state_transition method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -1026,250 +869,300 @@ static json jsonrpc_machine_get_proof_handler(const json &j, mg_connection *con,
     return jsonrpc_response_ok(j, h->machine->get_proof(std::get<0>(args), static_cast<int>(std::get<1>(args))));
 }
 
-/// \brief JSONRPC handler for the machine.verify_merkle_tree method
+/// \brief JSONRPC handler for the machine.get_multiproof method
 /// \param j JSON request object
 /// \param con Mongoose connection
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_verify_merkle_tree_handler(const json &j, mg_connection *con, http_handler_data *h) {
+static json jsonrpc_machine_get_multiproof_handler(const json &j, mg_connection *con, http_handler_data *h) {
     (void) con;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    jsonrpc_check_no_params(j);
-    return jsonrpc_response_ok(j, h->machine->verify_merkle_tree());
-}
-
-/// \brief JSONRPC handler for the machine.get_root_hash method
-/// \param j JSON request object
-/// \param con Mongoose connection
-/// \param h Handler data
-/// \returns JSON response object
-static json jsonrpc_machine_get_root_hash_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
+    static const char *param_name[] = {"addresses", "log2_size"};
+    auto args = parse_args<std::vector<uint64_t>, uint64_t>(j, param_name);
+    if (std::get<1>(args) > INT_MAX) {
+        throw std::domain_error("log2_size is out of range");
     }
-    jsonrpc_check_no_params(j);
-    cartesi::machine_merkle_tree::hash_type hash;
-    h->machine->get_root_hash(hash);
-    return jsonrpc_response_ok(j, cartesi::encode_base64(hash));
+    return jsonrpc_response_ok(j,
+        h->machine->get_multiproof(std::get<0>(args), static_cast<int>(std::get<1>(args))));
 }
 
-/// \brief JSONRPC handler for the machine.read_word method
+/// \brief JSONRPC handler for the machine.verify_merkle_tree method
 /// \param j JSON request object
 /// \param con Mongoose connection
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_read_word_handler(const json &j, mg_connection *con, http_handler_data *h) {
+static json jsonrpc_machine_verify_merkle_tree_handler(const json &j, mg_connection *con, http_handler_data *h) {
     (void) con;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"address"};
-    auto args = parse_args<uint64_t>(j, param_name);
-    auto address = std::get<0>(args);
-    return jsonrpc_response_ok(j, h->machine->read_word(address));
+    jsonrpc_check_no_params(j);
+    return jsonrpc_response_ok(j, h->machine->verify_merkle_tree());
 }
 
-/// \brief JSONRPC handler for the machine.read_memory method
+/// \brief Binary JSONRPC handler for the machine.read_memory method
 /// \param j JSON request object
-/// \param con Mongoose connection
+/// \param in Raw bytes that followed the request (unused)
+/// \param out Receives the raw bytes to send in response
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_read_memory_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
+static json jsonrpc_machine_read_memory_binary_handler(const json &j, std::string_view in, std::string &out,
+    http_handler_data *h) {
+    (void) in;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
     static const char *param_name[] = {"address", "length"};
     auto args = parse_args<uint64_t, uint64_t>(j, param_name);
-    auto address = std::get<0>(args);
-    auto length = std::get<1>(args);
-    auto data = cartesi::unique_calloc<unsigned char>(length);
-    h->machine->read_memory(address, data.get(), length);
-    return jsonrpc_response_ok(j, cartesi::encode_base64(data.get(), length));
+    out.resize(std::get<1>(args));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    h->machine->read_memory(std::get<0>(args), reinterpret_cast<unsigned char *>(out.data()), out.size());
+    return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.write_memory method
+/// \brief Binary JSONRPC handler for the machine.write_memory method
 /// \param j JSON request object
-/// \param con Mongoose connection
+/// \param in Raw bytes to write
+/// \param out Receives the raw bytes to send in response (unused)
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_write_memory_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
+static json jsonrpc_machine_write_memory_binary_handler(const json &j, std::string_view in, std::string &out,
+    http_handler_data *h) {
+    (void) out;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"address", "data"};
-    auto args = parse_args<uint64_t, std::string>(j, param_name);
-    auto address = std::get<0>(args);
-    auto bin = cartesi::decode_base64(std::get<1>(args));
+    static const char *param_name[] = {"address"};
+    auto args = parse_args<uint64_t>(j, param_name);
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    h->machine->write_memory(address, reinterpret_cast<unsigned char *>(bin.data()), bin.size());
+    h->machine->write_memory(std::get<0>(args), reinterpret_cast<const unsigned char *>(in.data()), in.size());
     return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.read_virtual_memory method
+/// \brief Binary JSONRPC handler for the machine.read_virtual_memory method
 /// \param j JSON request object
-/// \param con Mongoose connection
+/// \param in Raw bytes that followed the request (unused)
+/// \param out Receives the raw bytes to send in response
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_read_virtual_memory_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
+static json jsonrpc_machine_read_virtual_memory_binary_handler(const json &j, std::string_view in, std::string &out,
+    http_handler_data *h) {
+    (void) in;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
     static const char *param_name[] = {"address", "length"};
     auto args = parse_args<uint64_t, uint64_t>(j, param_name);
-    auto address = std::get<0>(args);
-    auto length = std::get<1>(args);
-    auto data = cartesi::unique_calloc<unsigned char>(length);
-    h->machine->read_virtual_memory(address, data.get(), length);
-    return jsonrpc_response_ok(j, cartesi::encode_base64(data.get(), length));
+    out.resize(std::get<1>(args));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    h->machine->read_virtual_memory(std::get<0>(args), reinterpret_cast<unsigned char *>(out.data()), out.size());
+    return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.write_virtual_memory method
+/// \brief Binary JSONRPC handler for the machine.write_virtual_memory method
 /// \param j JSON request object
-/// \param con Mongoose connection
+/// \param in Raw bytes to write
+/// \param out Receives the raw bytes to send in response (unused)
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_write_virtual_memory_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
+static json jsonrpc_machine_write_virtual_memory_binary_handler(const json &j, std::string_view in, std::string &out,
+    http_handler_data *h) {
+    (void) out;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"address", "data"};
-    auto args = parse_args<uint64_t, std::string>(j, param_name);
-    auto address = std::get<0>(args);
-    auto bin = cartesi::decode_base64(std::get<1>(args));
+    static const char *param_name[] = {"address"};
+    auto args = parse_args<uint64_t>(j, param_name);
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    h->machine->write_virtual_memory(address, reinterpret_cast<unsigned char *>(bin.data()), bin.size());
+    h->machine->write_virtual_memory(std::get<0>(args), reinterpret_cast<const unsigned char *>(in.data()),
+        in.size());
     return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.replace_memory_range method
+/// \brief Binary JSONRPC handler for the machine.log_uarch_step method
 /// \param j JSON request object
-/// \param con Mongoose connection
+/// \param in Raw bytes that followed the request (unused)
+/// \param out Receives the access log in the binary access log encoding
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_replace_memory_range_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
+static json jsonrpc_machine_log_uarch_step_binary_handler(const json &j, std::string_view in, std::string &out,
+    http_handler_data *h) {
+    (void) in;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"range"};
-    auto args = parse_args<cartesi::memory_range_config>(j, param_name);
-    h->machine->replace_memory_range(std::get<0>(args));
+    static const char *param_name[] = {"log_type", "one_based"};
+    auto args =
+        parse_args<cartesi::not_default_constructible<cartesi::access_log::type>, cartesi::optional_param<bool>>(j,
+            param_name);
+    (void) count_args(args);
+    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+    out = cartesi::encode_access_log_binary(
+        h->machine->log_uarch_step(std::get<0>(args).value(), std::get<1>(args).value_or(false)));
     return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.read_csr method
+/// \brief Binary JSONRPC handler for the machine.log_uarch_steps method
 /// \param j JSON request object
-/// \param con Mongoose connection
+/// \param in Raw bytes that followed the request (unused)
+/// \param out Receives the access logs in the binary access log encoding, one after the other
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_read_csr_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
+static json jsonrpc_machine_log_uarch_steps_binary_handler(const json &j, std::string_view in, std::string &out,
+    http_handler_data *h) {
+    (void) in;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"csr"};
-    auto args = parse_args<cartesi::machine::csr>(j, param_name);
-    return jsonrpc_response_ok(j, h->machine->read_csr(std::get<0>(args)));
+    static const char *param_name[] = {"count", "log_type", "one_based"};
+    auto args = parse_args<uint64_t, cartesi::not_default_constructible<cartesi::access_log::type>,
+        cartesi::optional_param<bool>>(j, param_name);
+    (void) count_args(args);
+    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+    out = cartesi::encode_access_logs_binary(h->machine->log_uarch_steps(std::get<0>(args), std::get<1>(args).value(),
+        std::get<2>(args).value_or(false)));
+    return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.write_csr method
+/// \brief Binary JSONRPC handler for the machine.log_uarch_reset method
 /// \param j JSON request object
-/// \param con Mongoose connection
+/// \param in Raw bytes that followed the request (unused)
+/// \param out Receives the access log in the binary access log encoding
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_write_csr_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
+static json jsonrpc_machine_log_uarch_reset_binary_handler(const json &j, std::string_view in, std::string &out,
+    http_handler_data *h) {
+    (void) in;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"csr", "value"};
-    auto args = parse_args<cartesi::machine::csr, uint64_t>(j, param_name);
-    h->machine->write_csr(std::get<0>(args), std::get<1>(args));
+    static const char *param_name[] = {"log_type", "one_based"};
+    auto args =
+        parse_args<cartesi::not_default_constructible<cartesi::access_log::type>, cartesi::optional_param<bool>>(j,
+            param_name);
+    (void) count_args(args);
+    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+    out = cartesi::encode_access_log_binary(
+        h->machine->log_uarch_reset(std::get<0>(args).value(), std::get<1>(args).value_or(false)));
     return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.read_x method
-/// \param j JSON request object
-/// \param con Mongoose connection
+/// \brief Binary JSONRPC handler for the machine.verify_uarch_step_log method
+/// \param j JSON request object, with all parameters but the log
+/// \param in Access log in the binary access log encoding
+/// \param out Receives the raw bytes to send in response (unused)
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_read_x_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    static const char *param_name[] = {"index"};
-    auto args = parse_args<uint64_t>(j, param_name);
-    const int i = static_cast<int>(std::get<0>(args));
-    if (i >= cartesi::X_REG_COUNT) {
-        throw std::domain_error{"index out of range"};
-    }
-    return jsonrpc_response_ok(j, h->machine->read_x(i));
+static json jsonrpc_machine_verify_uarch_step_log_binary_handler(const json &j, std::string_view in,
+    std::string &out, http_handler_data *h) {
+    (void) out;
+    (void) h;
+    static const char *param_name[] = {"runtime", "one_based"};
+    auto args =
+        parse_args<cartesi::optional_param<cartesi::machine_runtime_config>, cartesi::optional_param<bool>>(j,
+            param_name);
+    (void) count_args(args);
+    cartesi::machine::verify_uarch_step_log(cartesi::decode_access_log_binary(in),
+        std::get<0>(args).value_or(cartesi::machine_runtime_config{}), std::get<1>(args).value_or(false));
+    return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.write_x method
-/// \param j JSON request object
-/// \param con Mongoose connection
+/// \brief Binary JSONRPC handler for the machine.verify_uarch_reset_log method
+/// \param j JSON request object, with all parameters but the log
+/// \param in Access log in the binary access log encoding
+/// \param out Receives the raw bytes to send in response (unused)
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_write_x_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    static const char *param_name[] = {"index", "value"};
-    auto args = parse_args<uint64_t, uint64_t>(j, param_name);
-    const int i = static_cast<int>(std::get<0>(args));
-    if (i >= cartesi::X_REG_COUNT || i == 0) {
-        throw std::domain_error{"index out of range"};
-    }
-    h->machine->write_x(i, std::get<1>(args));
+static json jsonrpc_machine_verify_uarch_reset_log_binary_handler(const json &j, std::string_view in,
+    std::string &out, http_handler_data *h) {
+    (void) out;
+    (void) h;
+    static const char *param_name[] = {"runtime", "one_based"};
+    auto args =
+        parse_args<cartesi::optional_param<cartesi::machine_runtime_config>, cartesi::optional_param<bool>>(j,
+            param_name);
+    (void) count_args(args);
+    cartesi::machine::verify_uarch_reset_log(cartesi::decode_access_log_binary(in),
+        std::get<0>(args).value_or(cartesi::machine_runtime_config{}), std::get<1>(args).value_or(false));
     return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.read_f method
-/// \param j JSON request object
-/// \param con Mongoose connection
+/// \brief Binary JSONRPC handler for the machine.verify_uarch_step_state_transition method
+/// \param j JSON request object, with all parameters but the log
+/// \param in Access log in the binary access log encoding
+/// \param out Receives the raw bytes to send in response (unused)
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_read_f_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    static const char *param_name[] = {"index"};
-    auto args = parse_args<uint64_t>(j, param_name);
-    const int i = static_cast<int>(std::get<0>(args));
-    if (i >= cartesi::F_REG_COUNT) {
-        throw std::domain_error{"index out of range"};
-    }
-    return jsonrpc_response_ok(j, h->machine->read_f(i));
+static json jsonrpc_machine_verify_uarch_step_state_transition_binary_handler(const json &j, std::string_view in,
+    std::string &out, http_handler_data *h) {
+    (void) out;
+    (void) h;
+    static const char *param_name[] = {"root_hash_before", "root_hash_after", "runtime", "one_based"};
+    auto args = parse_args<cartesi::machine_merkle_tree::hash_type, cartesi::machine_merkle_tree::hash_type,
+        cartesi::optional_param<cartesi::machine_runtime_config>, cartesi::optional_param<bool>>(j, param_name);
+    (void) count_args(args);
+    cartesi::machine::verify_uarch_step_state_transition(std::get<0>(args), cartesi::decode_access_log_binary(in),
+        std::get<1>(args), std::get<2>(args).value_or(cartesi::machine_runtime_config{}),
+        std::get<3>(args).value_or(false));
+    return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.write_f method
+/// \brief Binary JSONRPC handler for the machine.verify_uarch_step_state_transitions method
+/// \param j JSON request object, with all parameters but the logs
+/// \param in Access logs in the binary access log encoding, one after the other
+/// \param out Receives the raw bytes to send in response (unused)
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_verify_uarch_step_state_transitions_binary_handler(const json &j, std::string_view in,
+    std::string &out, http_handler_data *h) {
+    (void) out;
+    (void) h;
+    static const char *param_name[] = {"root_hashes_before", "root_hashes_after", "runtime", "one_based"};
+    auto args = parse_args<std::vector<cartesi::machine_merkle_tree::hash_type>,
+        std::vector<cartesi::machine_merkle_tree::hash_type>, cartesi::optional_param<cartesi::machine_runtime_config>,
+        cartesi::optional_param<bool>>(j, param_name);
+    (void) count_args(args);
+    return jsonrpc_response_ok(j,
+        cartesi::machine::verify_uarch_step_state_transitions(std::get<0>(args),
+            cartesi::decode_access_logs_binary(in), std::get<1>(args),
+            std::get<2>(args).value_or(cartesi::machine_runtime_config{}), std::get<3>(args).value_or(false)));
+}
+
+/// \brief Binary JSONRPC handler for the machine.verify_uarch_reset_state_transition method
+/// \param j JSON request object, with all parameters but the log
+/// \param in Access log in the binary access log encoding
+/// \param out Receives the raw bytes to send in response (unused)
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_verify_uarch_reset_state_transition_binary_handler(const json &j, std::string_view in,
+    std::string &out, http_handler_data *h) {
+    (void) out;
+    (void) h;
+    static const char *param_name[] = {"root_hash_before", "root_hash_after", "runtime", "one_based"};
+    auto args = parse_args<cartesi::machine_merkle_tree::hash_type, cartesi::machine_merkle_tree::hash_type,
+        cartesi::optional_param<cartesi::machine_runtime_config>, cartesi::optional_param<bool>>(j, param_name);
+    (void) count_args(args);
+    cartesi::machine::verify_uarch_reset_state_transition(std::get<0>(args), cartesi::decode_access_log_binary(in),
+        std::get<1>(args), std::get<2>(args).value_or(cartesi::machine_runtime_config{}),
+        std::get<3>(args).value_or(false));
+    return jsonrpc_response_ok(j);
+}
+
+/// \brief JSONRPC handler for the machine.replace_memory_range method
 /// \param j JSON request object
 /// \param con Mongoose connection
 /// \param h Handler data
 /// \returns JSON response object
-static json jsonrpc_machine_write_f_handler(const json &j, mg_connection *con, http_handler_data *h) {
+static json jsonrpc_machine_replace_memory_range_handler(const json &j, mg_connection *con, http_handler_data *h) {
     (void) con;
     if (!h->machine) {
         return jsonrpc_response_invalid_request(j, "no machine");
     }
-    static const char *param_name[] = {"index", "value"};
-    auto args = parse_args<uint64_t, uint64_t>(j, param_name);
-    const int i = static_cast<int>(std::get<0>(args));
-    if (i >= cartesi::F_REG_COUNT) {
-        throw std::domain_error{"index out of range"};
-    }
-    h->machine->write_f(i, std::get<1>(args));
+    static const char *param_name[] = {"range"};
+    auto args = parse_args<cartesi::memory_range_config>(j, param_name);
+    h->machine->replace_memory_range(std::get<0>(args));
     return jsonrpc_response_ok(j);
 }
 
@@ -1376,50 +1269,6 @@ static json jsonrpc_machine_get_uarch_x_address_handler(const json &j, mg_connec
     return jsonrpc_response_ok(j, cartesi::machine::get_uarch_x_address(i));
 }
 
-/// \brief JSONRPC handler for the machine.reset_iflags_Y method
-/// \param j JSON request object
-/// \param con Mongoose connection
-/// \param h Handler data
-/// \returns JSON response object
-static json jsonrpc_machine_reset_iflags_Y_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    jsonrpc_check_no_params(j);
-    h->machine->reset_iflags_Y();
-    return jsonrpc_response_ok(j);
-}
-
-/// \brief JSONRPC handler for the machine.set_iflags_Y method
-/// \param j JSON request object
-/// \param con Mongoose connection
-/// \param h Handler data
-/// \returns JSON response object
-static json jsonrpc_machine_set_iflags_Y_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    jsonrpc_check_no_params(j);
-    h->machine->set_iflags_Y();
-    return jsonrpc_response_ok(j);
-}
-
-/// \brief JSONRPC handler for the machine.read_iflags_Y method
-/// \param j JSON request object
-/// \param con Mongoose connection
-/// \param h Handler data
-/// \returns JSON response object
-static json jsonrpc_machine_read_iflags_Y_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    jsonrpc_check_no_params(j);
-    return jsonrpc_response_ok(j, h->machine->read_iflags_Y());
-}
-
 /// \brief JSONRPC handler for the machine.set_iflags_X method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -1435,35 +1284,6 @@ static json jsonrpc_machine_set_iflags_X_handler(const json &j, mg_connection *c
     return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.reset_iflags_X method
-/// \param j JSON request object
-/// \param con Mongoose connection
-/// \param h Handler data
-/// \returns JSON response object
-static json jsonrpc_machine_reset_iflags_X_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    jsonrpc_check_no_params(j);
-    h->machine->reset_iflags_X();
-    return jsonrpc_response_ok(j);
-}
-
-/// \brief JSONRPC handler for the machine.read_iflags_X method
-/// \param j JSON request object
-/// \param con Mongoose connection
-/// \param h Handler data
-/// \returns JSON response object
-static json jsonrpc_machine_read_iflags_X_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    jsonrpc_check_no_params(j);
-    return jsonrpc_response_ok(j, h->machine->read_iflags_X());
-}
-
 /// \brief JSONRPC handler for the machine.set_iflags_H method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -1479,20 +1299,6 @@ static json jsonrpc_machine_set_iflags_H_handler(const json &j, mg_connection *c
     return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.read_iflags_H method
-/// \param j JSON request object
-/// \param con Mongoose connection
-/// \param h Handler data
-/// \returns JSON response object
-static json jsonrpc_machine_read_iflags_H_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    jsonrpc_check_no_params(j);
-    return jsonrpc_response_ok(j, h->machine->read_iflags_H());
-}
-
 /// \brief JSONRPC handler for the machine.read_iflags_PRV method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -1522,21 +1328,6 @@ static json jsonrpc_machine_set_uarch_halt_flag_handler(const json &j, mg_connec
     return jsonrpc_response_ok(j);
 }
 
-/// \brief JSONRPC handler for the machine.reset_uarch method
-/// \param j JSON request object
-/// \param con Mongoose connection
-/// \param h Handler data
-/// \returns JSON response object
-static json jsonrpc_machine_reset_uarch_handler(const json &j, mg_connection *con, http_handler_data *h) {
-    (void) con;
-    if (!h->machine) {
-        return jsonrpc_response_invalid_request(j, "no machine");
-    }
-    jsonrpc_check_no_params(j);
-    h->machine->reset_uarch();
-    return jsonrpc_response_ok(j);
-}
-
 /// \brief JSONRPC handler for the machine.read_uarch_halt_flag method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -1638,44 +1429,53 @@ static json jsonrpc_dispatch_method(const json &j, mg_connection *con, http_hand
         {"machine.machine.config", jsonrpc_machine_machine_config_handler},
         {"machine.machine.directory", jsonrpc_machine_machine_directory_handler},
         {"machine.destroy", jsonrpc_machine_destroy_handler},
+        {"machine.snapshot", jsonrpc_machine_snapshot_handler},
+        {"machine.rollback", jsonrpc_machine_rollback_handler},
+        {"machine.commit", jsonrpc_machine_commit_handler},
         {"machine.store", jsonrpc_machine_store_handler},
-        {"machine.run", jsonrpc_machine_run_handler},
-        {"machine.run_uarch", jsonrpc_machine_run_uarch_handler},
+        {"machine.store_delta", jsonrpc_machine_store_delta_handler},
+        {"machine.run", jsonrpc_machine_transaction_method_handler},
+        {"machine.run_with_checkpoints", jsonrpc_machine_run_with_checkpoints_handler},
+        {"machine.transaction", jsonrpc_machine_transaction_handler},
+        {"machine.run_uarch", jsonrpc_machine_transaction_method_handler},
         {"machine.log_uarch_step", jsonrpc_machine_log_uarch_step_handler},
-        {"machine.reset_uarch", jsonrpc_machine_reset_uarch_handler},
+        {"machine.log_uarch_steps", jsonrpc_machine_log_uarch_steps_handler},
+        {"machine.reset_uarch", jsonrpc_machine_transaction_method_handler},
         {"machine.log_uarch_reset", jsonrpc_machine_log_uarch_reset_handler},
         {"machine.verify_uarch_reset_log", jsonrpc_machine_verify_uarch_reset_log_handler},
         {"machine.verify_uarch_reset_state_transition", jsonrpc_machine_verify_uarch_reset_state_transition_handler},
         {"machine.verify_uarch_step_log", jsonrpc_machine_verify_uarch_step_log_handler},
         {"machine.verify_uarch_step_state_transition", jsonrpc_machine_verify_uarch_step_state_transition_handler},
+        {"machine.verify_uarch_step_state_transitions", jsonrpc_machine_verify_uarch_step_state_transitions_handler},
         {"machine.get_proof", jsonrpc_machine_get_proof_handler},
-        {"machine.get_root_hash", jsonrpc_machine_get_root_hash_handler},
-        {"machine.read_word", jsonrpc_machine_read_word_handler},
-        {"machine.read_memory", jsonrpc_machine_read_memory_handler},
-        {"machine.write_memory", jsonrpc_machine_write_memory_handler},
-        {"machine.read_virtual_memory", jsonrpc_machine_read_virtual_memory_handler},
-        {"machine.write_virtual_memory", jsonrpc_machine_write_virtual_memory_handler},
+        {"machine.get_multiproof", jsonrpc_machine_get_multiproof_handler},
+        {"machine.get_root_hash", jsonrpc_machine_transaction_method_handler},
+        {"machine.read_word", jsonrpc_machine_transaction_method_handler},
+        {"machine.read_memory", jsonrpc_machine_transaction_method_handler},
+        {"machine.write_memory", jsonrpc_machine_transaction_method_handler},
+        {"machine.read_virtual_memory", jsonrpc_machine_transaction_method_handler},
+        {"machine.write_virtual_memory", jsonrpc_machine_transaction_method_handler},
         {"machine.replace_memory_range", jsonrpc_machine_replace_memory_range_handler},
-        {"machine.read_csr", jsonrpc_machine_read_csr_handler},
-        {"machine.write_csr", jsonrpc_machine_write_csr_handler},
+        {"machine.read_csr", jsonrpc_machine_transaction_method_handler},
+        {"machine.write_csr", jsonrpc_machine_transaction_method_handler},
         {"machine.get_csr_address", jsonrpc_machine_get_csr_address_handler},
-        {"machine.read_x", jsonrpc_machine_read_x_handler},
-        {"machine.write_x", jsonrpc_machine_write_x_handler},
+        {"machine.read_x", jsonrpc_machine_transaction_method_handler},
+        {"machine.write_x", jsonrpc_machine_transaction_method_handler},
         {"machine.get_x_address", jsonrpc_machine_get_x_address_handler},
-        {"machine.read_f", jsonrpc_machine_read_f_handler},
-        {"machine.write_f", jsonrpc_machine_write_f_handler},
+        {"machine.read_f", jsonrpc_machine_transaction_method_handler},
+        {"machine.write_f", jsonrpc_machine_transaction_method_handler},
         {"machine.get_f_address", jsonrpc_machine_get_f_address_handler},
         {"machine.read_uarch_x", jsonrpc_machine_read_uarch_x_handler},
         {"machine.write_uarch_x", jsonrpc_machine_write_uarch_x_handler},
         {"machine.get_uarch_x_address", jsonrpc_machine_get_uarch_x_address_handler},
-        {"machine.set_iflags_Y", jsonrpc_machine_set_iflags_Y_handler},
-        {"machine.reset_iflags_Y", jsonrpc_machine_reset_iflags_Y_handler},
-        {"machine.read_iflags_Y", jsonrpc_machine_read_iflags_Y_handler},
+        {"machine.set_iflags_Y", jsonrpc_machine_transaction_method_handler},
+        {"machine.reset_iflags_Y", jsonrpc_machine_transaction_method_handler},
+        {"machine.read_iflags_Y", jsonrpc_machine_transaction_method_handler},
         {"machine.set_iflags_X", jsonrpc_machine_set_iflags_X_handler},
-        {"machine.reset_iflags_X", jsonrpc_machine_reset_iflags_X_handler},
-        {"machine.read_iflags_X", jsonrpc_machine_read_iflags_X_handler},
+        {"machine.reset_iflags_X", jsonrpc_machine_transaction_method_handler},
+        {"machine.read_iflags_X", jsonrpc_machine_transaction_method_handler},
         {"machine.set_iflags_H", jsonrpc_machine_set_iflags_H_handler},
-        {"machine.read_iflags_H", jsonrpc_machine_read_iflags_H_handler},
+        {"machine.read_iflags_H", jsonrpc_machine_transaction_method_handler},
         {"machine.read_iflags_PRV", jsonrpc_machine_read_iflags_PRV_handler},
         {"machine.read_uarch_halt_flag", jsonrpc_machine_read_uarch_halt_flag_handler},
         {"machine.set_uarch_halt_flag", jsonrpc_machine_set_uarch_halt_flag_handler},
@@ -1698,6 +1498,151 @@ static json jsonrpc_dispatch_method(const json &j, mg_connection *con, http_hand
     return jsonrpc_response_internal_error(j, x.what());
 }
 
+/// \brief Sends raw bytes as the response through the Mongoose connection
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \param data Bytes to send
+static void jsonrpc_send_binary_reply(mg_connection *con, http_handler_data *h, const std::string &data) {
+    SLOG(trace) << h->server_address << " response is " << data.size() << " bytes of binary data";
+    mg_printf(con,
+        "HTTP/1.1 200 OK\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: %lu\r\n"
+        "\r\n",
+        static_cast<unsigned long>(data.size()));
+    mg_send(con, data.data(), data.size());
+}
+
+/// \brief Binary jsonrpc handler is a function pointer
+using jsonrpc_binary_handler = json (*)(const json &j, std::string_view in, std::string &out, http_handler_data *h);
+
+/// \brief Dispatch request to appropriate binary JSONRPC handler
+/// \param j JSON request object
+/// \param in Raw bytes that followed the request
+/// \param out Receives the raw bytes to send in response, if any
+/// \param h_data Handler data
+/// \returns JSON with response
+static json jsonrpc_dispatch_binary_method(const json &j, std::string_view in, std::string &out,
+    http_handler_data *h) try {
+    static const std::unordered_map<std::string, jsonrpc_binary_handler> dispatch = {
+        {"machine.read_memory", jsonrpc_machine_read_memory_binary_handler},
+        {"machine.write_memory", jsonrpc_machine_write_memory_binary_handler},
+        {"machine.read_virtual_memory", jsonrpc_machine_read_virtual_memory_binary_handler},
+        {"machine.write_virtual_memory", jsonrpc_machine_write_virtual_memory_binary_handler},
+        {"machine.log_uarch_step", jsonrpc_machine_log_uarch_step_binary_handler},
+        {"machine.log_uarch_steps", jsonrpc_machine_log_uarch_steps_binary_handler},
+        {"machine.log_uarch_reset", jsonrpc_machine_log_uarch_reset_binary_handler},
+        {"machine.verify_uarch_step_log", jsonrpc_machine_verify_uarch_step_log_binary_handler},
+        {"machine.verify_uarch_reset_log", jsonrpc_machine_verify_uarch_reset_log_binary_handler},
+        {"machine.verify_uarch_step_state_transition",
+            jsonrpc_machine_verify_uarch_step_state_transition_binary_handler},
+        {"machine.verify_uarch_step_state_transitions",
+            jsonrpc_machine_verify_uarch_step_state_transitions_binary_handler},
+        {"machine.verify_uarch_reset_state_transition",
+            jsonrpc_machine_verify_uarch_reset_state_transition_binary_handler},
+    };
+    auto method = j["method"].get<std::string>();
+    SLOG(debug) << h->server_address << " handling binary \"" << method << "\" method";
+    auto found = dispatch.find(method);
+    if (found != dispatch.end()) {
+        return found->second(j, in, out, h);
+    }
+    return jsonrpc_response_method_not_found(j, method + " (binary transfer not supported)");
+} catch (std::invalid_argument &x) {
+    return jsonrpc_response_invalid_params(j, x.what());
+} catch (std::exception &x) {
+    return jsonrpc_response_internal_error(j, x.what());
+}
+
+/// \brief Checks if a media type is the binary media type
+/// \param media_type Media type, possibly followed by parameters (e.g., "application/octet-stream; q=0.9")
+/// \returns True if the media type, ignoring its parameters and surrounding whitespace, is application/octet-stream
+static bool http_media_type_is_binary(std::string_view media_type) {
+    media_type = media_type.substr(0, media_type.find(';'));
+    const auto begin = media_type.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return false;
+    }
+    media_type = media_type.substr(begin, media_type.find_last_not_of(" \t") + 1 - begin);
+    const mg_str type = mg_str_n(media_type.data(), media_type.size());
+    return mg_vcasecmp(&type, "application/octet-stream") == 0;
+}
+
+/// \brief Checks if an HTTP header of a request is present and names the binary media type
+/// \param hm HTTP request
+/// \param name Header name
+/// \returns True if the header value, or any entry in its comma-separated list, is application/octet-stream
+static bool http_header_is_binary(mg_http_message *hm, const char *name) {
+    const mg_str *value = mg_http_get_header(hm, name);
+    if (value == nullptr) {
+        return false;
+    }
+    std::string_view list{value->ptr, value->len};
+    for (;;) {
+        const auto comma = list.find(',');
+        if (http_media_type_is_binary(list.substr(0, comma))) {
+            return true;
+        }
+        if (comma == std::string_view::npos) {
+            return false;
+        }
+        list.remove_prefix(comma + 1);
+    }
+}
+
+/// \brief Handles a binary JSONRPC request
+/// \param con Mongoose connection
+/// \param hm HTTP request
+/// \param h Handler data
+/// \details The request body holds a single JSONRPC request object. When there are bytes to write, the object is
+/// followed by a NUL character and the raw bytes (JSON text never contains a NUL character). A successful read
+/// is answered with the raw bytes in an application/octet-stream body when the client accepts it. Everything else
+/// is answered in JSON.
+static void jsonrpc_binary_request(mg_connection *con, mg_http_message *hm, http_handler_data *h) {
+    const std::string_view body{hm->body.ptr, hm->body.len};
+    const auto separator = body.find('\0');
+    const std::string_view in = separator != std::string_view::npos ? body.substr(separator + 1) : std::string_view{};
+    json j;
+    try {
+        j = json::parse(body.substr(0, separator));
+    } catch (std::exception &x) {
+        return jsonrpc_http_reply(con, h, jsonrpc_response_parse_error(x.what()));
+    }
+    if (!j.is_object()) {
+        return jsonrpc_http_reply(con, h, jsonrpc_response_invalid_request(j, "binary request not an object"));
+    }
+    if (!j.contains("jsonrpc")) {
+        return jsonrpc_http_reply(con, h, jsonrpc_response_invalid_request(j, "missing field \"jsonrpc\""));
+    }
+    if (!j["jsonrpc"].is_string() || j["jsonrpc"] != "2.0") {
+        return jsonrpc_http_reply(con, h,
+            jsonrpc_response_invalid_request(j, R"(invalid field "jsonrpc" (expected "2.0"))"));
+    }
+    if (!j.contains("method") || !j["method"].is_string()) {
+        return jsonrpc_http_reply(con, h,
+            jsonrpc_response_invalid_request(j, "invalid field \"method\" (expected non-empty string)"));
+    }
+    std::string out;
+    json jr = jsonrpc_dispatch_binary_method(j, in, out, h);
+    if (jr.contains("error") || !http_header_is_binary(hm, "Accept")) {
+        return jsonrpc_http_reply(con, h, jr);
+    }
+    return jsonrpc_send_binary_reply(con, h, out);
+}
+
+/// \brief Checks if the client wants the connection kept alive to serve more requests after the response
+/// \param hm HTTP request
+/// \returns True unless the client asked the connection to be closed, or is an HTTP/1.0 client that did not ask
+/// for it to be kept alive
+static bool http_keep_alive(mg_http_message *hm) {
+    const mg_str *connection = mg_http_get_header(hm, "Connection");
+    if (mg_vcmp(&hm->proto, "HTTP/1.0") == 0) {
+        return connection != nullptr && mg_vcasecmp(connection, "keep-alive") == 0;
+    }
+    return connection == nullptr || mg_vcasecmp(connection, "close") != 0;
+}
+
 /// \brief Handler for HTTP requests
 /// \param con Mongoose connection
 /// \param ev Mongoose event
@@ -1707,6 +1652,10 @@ static void http_handler(mg_connection *con, int ev, void *ev_data, void *h_data
     auto *h = static_cast<http_handler_data *>(h_data);
     if (ev == MG_EV_HTTP_MSG) {
         auto *hm = static_cast<mg_http_message *>(ev_data);
+        // Connections are kept alive across requests, so clients need not connect again for each of them
+        if (!http_keep_alive(hm)) {
+            con->is_draining = 1;
+        }
         const std::string_view method{hm->method.ptr, hm->method.len};
         // Answer OPTIONS request to support cross origin resource sharing (CORS) preflighted browser requests
         if (method == "OPTIONS") {
@@ -1736,6 +1685,10 @@ static void http_handler(mg_connection *con, int ev, void *ev_data, void *h_data
             mg_http_reply(con, 404, "Access-Control-Allow-Origin: *\r\n", "not found");
             return;
         }
+        // Memory contents and access logs may travel as raw bytes rather than inside JSON
+        if (http_header_is_binary(hm, "Content-Type") || http_header_is_binary(hm, "Accept")) {
+            return jsonrpc_binary_request(con, hm, h);
+        }
         // Parse request body into a JSON object
         json j;
         try {
@@ -18,12 +18,14 @@
 #include <csignal>
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 #include <mongoose.h>
 
 #include "jsonrpc-mg-mgr.h"
 #include "jsonrpc-virtual-machine.h"
 
+#include "access-log-binary.h"
 #include "base64.h"
 #include "json-util.h"
 
@@ -50,69 +52,195 @@ std::string jsonrpc_post_data(const std::string &method, const std::tuple<Ts...>
 struct http_request_data {
     const std::string &url;
     const std::string &post_data;
-    std::string status_code;
-    std::string reason_phrase;
-    std::string entity_body;
-    bool done;
+    bool keep_alive;
+    bool idempotent{false};                 ///< Sending the request twice has the same effect as sending it once
+    const unsigned char *payload{nullptr};  ///< Raw bytes to send after the JSON request, if any
+    size_t payload_length{0};               ///< Length of raw bytes to send
+    unsigned char *binary_body{nullptr};    ///< Receives a raw response body, if the request accepts one
+    uint64_t binary_body_length{0};         ///< Expected length of raw response body
+    bool accept_binary{false};              ///< Accept a raw response body of any length into entity_body
+    bool binary_response{false};            ///< True if the response body was raw bytes rather than JSON
+    uint64_t binary_response_length{0};     ///< Length of raw response body
+    std::string status_code{};
+    std::string reason_phrase{};
+    std::string entity_body{};
+    bool done{false};
 };
 
+/// \brief Data of a connection to the server, which may be kept alive to serve later requests
+struct http_connection_data {
+    std::string url;             ///< URL the connection was made to
+    http_request_data *request;  ///< Request waiting for its response, or nullptr if the connection is idle
+};
+
+// Raw bytes go after the JSON request and a NUL character, which JSON text never contains
+static void json_post_send(struct mg_connection *c, const http_request_data &data) {
+    const struct mg_str host = mg_url_host(data.url.c_str());
+    const size_t content_length = data.post_data.size() + (data.payload ? data.payload_length + 1 : 0);
+    mg_printf(c,
+        "POST %s HTTP/1.1\r\n"
+        "Host: %.*s\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %lu\r\n"
+        "%s"
+        "%s"
+        "\r\n",
+        mg_url_uri(data.url.c_str()), static_cast<int>(host.len), host.ptr,
+        data.payload ? "application/octet-stream" : "application/json", static_cast<unsigned long>(content_length),
+        (data.binary_body || data.accept_binary) ? "Accept: application/octet-stream\r\n" : "",
+        data.keep_alive ? "" : "Connection: close\r\n");
+    mg_send(c, data.post_data.data(), data.post_data.size());
+    if (data.payload) {
+        mg_send(c, "", 1);
+        mg_send(c, data.payload, data.payload_length);
+    }
+}
+
+// Checks if the response body holds raw bytes rather than JSON, ignoring any media type parameters
+static bool json_post_is_binary(struct mg_http_message *hm) {
+    const struct mg_str *content_type = mg_http_get_header(hm, "Content-Type");
+    if (content_type == nullptr) {
+        return false;
+    }
+    std::string_view media_type{content_type->ptr, content_type->len};
+    media_type = media_type.substr(0, media_type.find(';'));
+    const auto end = media_type.find_last_not_of(" \t");
+    const struct mg_str type = mg_str_n(media_type.data(), end == std::string_view::npos ? 0 : end + 1);
+    return mg_vcasecmp(&type, "application/octet-stream") == 0;
+}
+
+// Checks if the server is willing to serve more requests on the connection after the response
+static bool json_post_keep_alive(struct mg_http_message *hm) {
+    const struct mg_str *connection = mg_http_get_header(hm, "Connection");
+    // In a response, the method holds the protocol version
+    if (mg_vcmp(&hm->method, "HTTP/1.0") == 0) {
+        return connection != nullptr && mg_vcasecmp(connection, "keep-alive") == 0;
+    }
+    return connection == nullptr || mg_vcasecmp(connection, "close") != 0;
+}
+
 // Print HTTP response and signal that we're done
 static void json_post_fn(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
-    http_request_data *data = static_cast<http_request_data *>(fn_data);
+    auto *connection = static_cast<http_connection_data *>(fn_data);
+    http_request_data *data = connection->request;
     if (ev == MG_EV_CONNECT) {
-        const struct mg_str host = mg_url_host(data->url.c_str());
-        mg_printf(c,
-            "POST %s HTTP/1.0\r\n"
-            "Host: %.*s\r\n"
-            "Content-Type: application/json\r\n"
-            "Content-Length: %d\r\n"
-            "\r\n",
-            mg_url_uri(data->url.c_str()), static_cast<int>(host.len), host.ptr, data->post_data.size());
-        mg_send(c, data->post_data.data(), data->post_data.size());
+        if (data) {
+            json_post_send(c, *data);
+        }
     } else if (ev == MG_EV_HTTP_MSG) {
         struct mg_http_message *hm = static_cast<struct mg_http_message *>(ev_data);
-        data->entity_body = std::string_view(hm->body.ptr, hm->body.len);
-        data->status_code = std::string_view(hm->uri.ptr, hm->uri.len);
-        data->reason_phrase = std::string_view(hm->proto.ptr, hm->proto.len);
-        c->is_closing = 1;
-        data->done = true;
+        if (!data || !data->keep_alive || !json_post_keep_alive(hm)) {
+            c->is_closing = 1;
+        }
+        if (data) {
+            // Raw bytes are copied straight to their destination
+            if (data->binary_body && json_post_is_binary(hm)) {
+                data->binary_response = true;
+                data->binary_response_length = hm->body.len;
+                data->entity_body.clear();
+                if (hm->body.len == data->binary_body_length) {
+                    std::memcpy(data->binary_body, hm->body.ptr, hm->body.len);
+                }
+            } else if (data->accept_binary && json_post_is_binary(hm)) {
+                data->binary_response = true;
+                data->binary_response_length = hm->body.len;
+                data->entity_body = std::string_view(hm->body.ptr, hm->body.len);
+            } else {
+                data->binary_response = false;
+                data->entity_body = std::string_view(hm->body.ptr, hm->body.len);
+            }
+            data->status_code = std::string_view(hm->uri.ptr, hm->uri.len);
+            data->reason_phrase = std::string_view(hm->proto.ptr, hm->proto.len);
+            data->done = true;
+            connection->request = nullptr;
+        }
     } else if (ev == MG_EV_ERROR) {
-        data->entity_body.clear();
-        data->status_code = "503";
-        data->reason_phrase = static_cast<char *>(ev_data);
-        data->done = true;
-    } else if (ev == MG_EV_CLOSE && !data->done) {
-        data->entity_body.clear();
-        data->status_code.clear();
-        data->reason_phrase = "connection closed";
-        data->done = true;
+        if (data) {
+            data->entity_body.clear();
+            data->status_code = "503";
+            data->reason_phrase = static_cast<char *>(ev_data);
+            data->done = true;
+            connection->request = nullptr;
+        }
+    } else if (ev == MG_EV_CLOSE) {
+        if (data && !data->done) {
+            data->entity_body.clear();
+            data->status_code.clear();
+            data->reason_phrase = "connection closed";
+            data->done = true;
+        }
+        delete connection;
+    }
+}
+
+// Finds an idle connection to url that was kept alive after its last request
+static struct mg_connection *json_post_find_connection(struct mg_mgr &mgr, const std::string &url) {
+    for (struct mg_connection *c = mgr.conns; c != nullptr; c = c->next) {
+        if (c->fn != json_post_fn || c->is_closing || c->is_draining) {
+            continue;
+        }
+        const auto *connection = static_cast<http_connection_data *>(c->fn_data);
+        if (connection->request == nullptr && connection->url == url) {
+            return c;
+        }
     }
+    return nullptr;
 }
 
-static std::string json_post(struct mg_mgr &mgr, const std::string &url, const std::string &post_data) {
-    http_request_data data{url, post_data, "", "", "", false};
-    if (!mg_http_connect(&mgr, url.c_str(), json_post_fn, &data)) {
-        throw std::runtime_error("connection to '"s + url + "' failed"s);
+// Sends the request, on an idle connection if one can be reused, and waits for the response
+// Returns true if the request was sent on an idle connection
+static bool json_post_wait(struct mg_mgr &mgr, http_request_data &data, bool reuse) {
+    if (reuse) {
+        // Notice idle connections the server has already closed, so they are not reused
+        mg_mgr_poll(&mgr, 0);
+    }
+    struct mg_connection *c = reuse ? json_post_find_connection(mgr, data.url) : nullptr;
+    if (c) {
+        static_cast<http_connection_data *>(c->fn_data)->request = &data;
+        json_post_send(c, data);
+    } else {
+        auto *connection = new http_connection_data{data.url, &data};
+        if (!mg_http_connect(&mgr, data.url.c_str(), json_post_fn, connection)) {
+            delete connection;
+            throw std::runtime_error("connection to '"s + data.url + "' failed"s);
+        }
     }
     while (!data.done) {
         mg_mgr_poll(&mgr, 1000);
     }
+    return c != nullptr;
+}
+
+static void json_post(cartesi::jsonrpc_mg_mgr &mgr, http_request_data &data) {
+    // The server may still close an idle connection just as a request is sent on it. The connection is then
+    // closed before any response arrives, and there is no telling whether the server received the request.
+    // Only requests that can safely be processed twice are sent again, on a new connection.
+    if (json_post_wait(mgr.get_mgr(), data, data.keep_alive) && data.status_code.empty() && data.idempotent) {
+        data.reason_phrase.clear();
+        data.done = false;
+        json_post_wait(mgr.get_mgr(), data, false);
+    }
     if (data.status_code.empty()) {
         throw std::runtime_error("http error: "s + data.reason_phrase);
     }
     if (data.status_code != "200") {
         throw std::runtime_error("http error: "s + data.reason_phrase + " (code "s + data.status_code + ")"s);
     }
+}
+
+static std::string json_post(cartesi::jsonrpc_mg_mgr &mgr, const std::string &url, const std::string &post_data,
+    bool idempotent) {
+    http_request_data data{url, post_data, mgr.is_keep_alive()};
+    data.idempotent = idempotent;
+    json_post(mgr, data);
     return std::move(data.entity_body);
 }
 
-template <typename R, typename... Ts>
-void jsonrpc_request(struct mg_mgr &mgr, const std::string &url, const std::string &method, const std::tuple<Ts...> &tp,
-    R &result) {
-    auto request = jsonrpc_post_data(method, tp);
+template <typename R>
+void jsonrpc_parse_response(const std::string &entity_body, R &result) {
     json response;
     try {
-        response = json::parse(json_post(mgr, url, request));
+        response = json::parse(entity_body);
     } catch (std::exception &x) {
         throw std::runtime_error("jsonrpc server error: invalid response ("s + x.what() + ")"s);
     }
@@ -156,6 +284,142 @@ void jsonrpc_request(struct mg_mgr &mgr, const std::string &url, const std::stri
     }
 }
 
+// Checks if a method only queries the server, so sending its request twice has the same effect as sending it once
+static bool jsonrpc_is_idempotent(const std::string &method) {
+    for (const char *prefix : {"machine.read_", "machine.get_", "machine.verify_"}) {
+        if (method.rfind(prefix, 0) == 0) {
+            return true;
+        }
+    }
+    return method == "rpc.discover" || method == "get_version";
+}
+
+template <typename R, typename... Ts>
+void jsonrpc_request(cartesi::jsonrpc_mg_mgr &mgr, const std::string &url, const std::string &method,
+    const std::tuple<Ts...> &tp, R &result) {
+    jsonrpc_parse_response(json_post(mgr, url, jsonrpc_post_data(method, tp), jsonrpc_is_idempotent(method)), result);
+}
+
+// Sends a request that reads memory, receiving the contents as raw bytes rather than base64 inside JSON
+template <typename... Ts>
+void jsonrpc_request_read_binary(cartesi::jsonrpc_mg_mgr &mgr, const std::string &url, const std::string &method,
+    const std::tuple<Ts...> &tp, unsigned char *data, uint64_t length) {
+    const auto request = jsonrpc_post_data(method, tp);
+    http_request_data post{url, request, mgr.is_keep_alive()};
+    post.idempotent = jsonrpc_is_idempotent(method);
+    post.binary_body = data;
+    post.binary_body_length = length;
+    json_post(mgr, post);
+    if (post.binary_response) {
+        if (post.binary_response_length != length) {
+            throw std::runtime_error("jsonrpc server error: invalid binary data length");
+        }
+        return;
+    }
+    // Errors always come in JSON, and so do contents from servers that only send them in base64
+    std::string result;
+    jsonrpc_parse_response(post.entity_body, result);
+    std::string bin = cartesi::decode_base64(result);
+    if (bin.size() != length) {
+        throw std::runtime_error("jsonrpc server error: invalid decoded base64 data length");
+    }
+    std::memcpy(data, bin.data(), length);
+}
+
+// Checks if the server failed to parse a request, which is how servers without binary support reply to raw bytes
+static bool jsonrpc_is_parse_error(const std::string &entity_body) {
+    const json response = json::parse(entity_body, nullptr, false);
+    return response.is_object() && response.contains("error") && response["error"].is_object() &&
+        response["error"].contains("code") && response["error"]["code"] == -32700;
+}
+
+// Sends a request with raw bytes following the JSON request, and receives the result in JSON
+// (servers that cannot parse such requests get the JSON request returned by fallback_request instead)
+template <typename R, typename F, typename... Ts>
+void jsonrpc_request_write_binary(cartesi::jsonrpc_mg_mgr &mgr, const std::string &url, const std::string &method,
+    const std::tuple<Ts...> &tp, const unsigned char *data, size_t length, const F &fallback_request, R &result) {
+    if (mgr.is_binary_requests()) {
+        const auto request = jsonrpc_post_data(method, tp);
+        http_request_data post{url, request, mgr.is_keep_alive()};
+        post.idempotent = jsonrpc_is_idempotent(method);
+        post.payload = data;
+        post.payload_length = length;
+        json_post(mgr, post);
+        if (!jsonrpc_is_parse_error(post.entity_body)) {
+            jsonrpc_parse_response(post.entity_body, result);
+            return;
+        }
+        // Nothing was executed, so the request can be sent again
+        mgr.set_binary_requests(false);
+    }
+    jsonrpc_parse_response(json_post(mgr, url, fallback_request(), jsonrpc_is_idempotent(method)), result);
+}
+
+// Sends a request that writes memory, with the contents as raw bytes rather than base64 inside JSON
+// (servers that cannot parse such requests get the contents in base64, after the other parameters)
+template <typename... Ts>
+void jsonrpc_request_write_memory(cartesi::jsonrpc_mg_mgr &mgr, const std::string &url, const std::string &method,
+    const std::tuple<Ts...> &tp, const unsigned char *data, size_t length) {
+    const auto fallback_request = [&]() {
+        const std::string b64 = cartesi::encode_base64(data, length);
+        return jsonrpc_post_data(method, std::tuple_cat(tp, std::tie(b64)));
+    };
+    bool result = false;
+    jsonrpc_request_write_binary(mgr, url, method, tp, data, length, fallback_request, result);
+}
+
+// Sends a request that returns an access log, receiving it in the binary access log encoding rather than JSON
+template <typename... Ts>
+cartesi::access_log jsonrpc_request_read_access_log(cartesi::jsonrpc_mg_mgr &mgr, const std::string &url,
+    const std::string &method, const std::tuple<Ts...> &tp) {
+    const auto request = jsonrpc_post_data(method, tp);
+    http_request_data post{url, request, mgr.is_keep_alive()};
+    post.idempotent = jsonrpc_is_idempotent(method);
+    post.accept_binary = true;
+    json_post(mgr, post);
+    if (post.binary_response) {
+        return cartesi::decode_access_log_binary(post.entity_body);
+    }
+    // Errors always come in JSON, and so do logs from servers that only send them in JSON
+    cartesi::not_default_constructible<cartesi::access_log> result;
+    jsonrpc_parse_response(post.entity_body, result);
+    if (!result.has_value()) {
+        throw std::runtime_error("jsonrpc server error: missing result");
+    }
+    return std::move(result).value();
+}
+
+// Sends a request that returns several access logs, receiving them in the binary access log encoding rather than JSON
+template <typename... Ts>
+std::vector<cartesi::access_log> jsonrpc_request_read_access_logs(cartesi::jsonrpc_mg_mgr &mgr,
+    const std::string &url, const std::string &method, const std::tuple<Ts...> &tp) {
+    const auto request = jsonrpc_post_data(method, tp);
+    http_request_data post{url, request, mgr.is_keep_alive()};
+    post.idempotent = jsonrpc_is_idempotent(method);
+    post.accept_binary = true;
+    json_post(mgr, post);
+    if (post.binary_response) {
+        return cartesi::decode_access_logs_binary(post.entity_body);
+    }
+    // Errors always come in JSON, and so do logs from servers that only send them in JSON
+    std::vector<cartesi::access_log> result;
+    jsonrpc_parse_response(post.entity_body, result);
+    return result;
+}
+
+// Sends a request that takes an access log, sending it in the binary access log encoding rather than JSON
+// (servers that cannot parse such requests get the parameters in fallback_tp instead, with the log in JSON)
+template <typename... Ts, typename... Us>
+void jsonrpc_request_write_access_log(cartesi::jsonrpc_mg_mgr &mgr, const std::string &url, const std::string &method,
+    const std::tuple<Ts...> &tp, const cartesi::access_log &log, const std::tuple<Us...> &fallback_tp) {
+    const std::string data = cartesi::encode_access_log_binary(log);
+    const auto fallback_request = [&]() { return jsonrpc_post_data(method, fallback_tp); };
+    bool result = false;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    jsonrpc_request_write_binary(mgr, url, method, tp, reinterpret_cast<const unsigned char *>(data.data()),
+        data.size(), fallback_request, result);
+}
+
 namespace cartesi {
 
 jsonrpc_mg_mgr::jsonrpc_mg_mgr(std::string remote_address) {
@@ -181,6 +445,30 @@ const struct mg_mgr &jsonrpc_mg_mgr::get_mgr(void) const {
     return m_mgr;
 }
 
+bool jsonrpc_mg_mgr::is_keep_alive(void) const {
+    return m_keep_alive;
+}
+
+bool jsonrpc_mg_mgr::is_binary_requests(void) const {
+    return m_binary_requests;
+}
+
+void jsonrpc_mg_mgr::set_binary_requests(bool binary_requests) {
+    m_binary_requests = binary_requests;
+}
+
+void jsonrpc_mg_mgr::set_keep_alive(bool keep_alive) {
+    m_keep_alive = keep_alive;
+    if (!keep_alive) {
+        // Close connections that were kept alive so far
+        for (struct mg_connection *c = m_mgr.conns; c != nullptr; c = c->next) {
+            if (c->fn == json_post_fn) {
+                c->is_closing = 1;
+            }
+        }
+    }
+}
+
 const std::string &jsonrpc_mg_mgr::get_remote_address(void) const {
     if (is_shutdown()) {
         throw std::out_of_range("remote server is shutdown");
@@ -201,13 +489,13 @@ void jsonrpc_mg_mgr::snapshot(void) {
     // then we behave as if we were not forked
     if (is_forked()) {
         bool result = false;
-        jsonrpc_request(get_mgr(), get_remote_parent_address(), "shutdown", std::tie(), result);
+        jsonrpc_request(*this, get_remote_parent_address(), "shutdown", std::tie(), result);
         std::swap(m_address[0], m_address[1]);
         m_address.pop_back();
     }
     // If we are not forked, we fork a new server as the child and get its remote address
     std::string child_address;
-    jsonrpc_request(get_mgr(), get_remote_address(), "fork", std::tie(), child_address);
+    jsonrpc_request(*this, get_remote_address(), "fork", std::tie(), child_address);
     m_address.push_back(std::move(child_address));
 }
 
@@ -219,7 +507,7 @@ void jsonrpc_mg_mgr::rollback() {
     }
     // If we are forked, we kill the child and expose the parent server
     bool result = false;
-    jsonrpc_request(get_mgr(), get_remote_address(), "shutdown", std::tie(), result);
+    jsonrpc_request(*this, get_remote_address(), "shutdown", std::tie(), result);
     m_address.pop_back();
 }
 
@@ -230,9 +518,9 @@ bool jsonrpc_mg_mgr::is_forked(void) const {
 void jsonrpc_mg_mgr::shutdown(void) {
     bool result = false;
     if (is_forked()) {
-        jsonrpc_request(get_mgr(), get_remote_parent_address(), "shutdown", std::tie(), result);
+        jsonrpc_request(*this, get_remote_parent_address(), "shutdown", std::tie(), result);
     }
-    jsonrpc_request(get_mgr(), get_remote_address(), "shutdown", std::tie(), result);
+    jsonrpc_request(*this, get_remote_address(), "shutdown", std::tie(), result);
     m_address.clear();
 }
 
@@ -246,7 +534,7 @@ jsonrpc_virtual_machine::jsonrpc_virtual_machine(jsonrpc_mg_mgr_ptr mgr, const s
     const machine_runtime_config &runtime) :
     m_mgr(std::move(mgr)) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.machine.directory",
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.machine.directory",
         std::tie(directory, runtime), result);
 }
 
@@ -254,7 +542,7 @@ jsonrpc_virtual_machine::jsonrpc_virtual_machine(jsonrpc_mg_mgr_ptr mgr, const m
     const machine_runtime_config &runtime) :
     m_mgr(std::move(mgr)) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.machine.config", std::tie(config, runtime),
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.machine.config", std::tie(config, runtime),
         result);
 }
 
@@ -262,19 +550,19 @@ jsonrpc_virtual_machine::~jsonrpc_virtual_machine(void) = default;
 
 machine_config jsonrpc_virtual_machine::do_get_initial_config(void) const {
     machine_config result;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.get_initial_config", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.get_initial_config", std::tie(), result);
     return result;
 }
 
 machine_config jsonrpc_virtual_machine::get_default_config(const jsonrpc_mg_mgr_ptr &mgr) {
     machine_config result;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.get_default_config", std::tie(), result);
+    jsonrpc_request(*mgr, mgr->get_remote_address(), "machine.get_default_config", std::tie(), result);
     return result;
 }
 
 semantic_version jsonrpc_virtual_machine::get_version(const jsonrpc_mg_mgr_ptr &mgr) {
     semantic_version result;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "get_version", std::tie(), result);
+    jsonrpc_request(*mgr, mgr->get_remote_address(), "get_version", std::tie(), result);
     return result;
 }
 
@@ -287,146 +575,180 @@ void jsonrpc_virtual_machine::shutdown(const jsonrpc_mg_mgr_ptr &mgr) {
 
 void jsonrpc_virtual_machine::verify_uarch_step_log(const jsonrpc_mg_mgr_ptr &mgr, const access_log &log,
     const machine_runtime_config &runtime, bool one_based) {
-    bool result = false;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.verify_uarch_step_log",
-        std::tie(log, runtime, one_based), result);
+    jsonrpc_request_write_access_log(*mgr, mgr->get_remote_address(), "machine.verify_uarch_step_log",
+        std::tie(runtime, one_based), log, std::tie(log, runtime, one_based));
 }
 
 void jsonrpc_virtual_machine::verify_uarch_step_state_transition(const jsonrpc_mg_mgr_ptr &mgr,
     const hash_type &root_hash_before, const access_log &log, const hash_type &root_hash_after,
     const machine_runtime_config &runtime, bool one_based) {
-    bool result = false;
     auto b64_root_hash_before = encode_base64(root_hash_before);
     auto b64_root_hash_after = encode_base64(root_hash_after);
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.verify_uarch_step_state_transition",
-        std::tie(b64_root_hash_before, log, b64_root_hash_after, runtime, one_based), result);
+    jsonrpc_request_write_access_log(*mgr, mgr->get_remote_address(), "machine.verify_uarch_step_state_transition",
+        std::tie(b64_root_hash_before, b64_root_hash_after, runtime, one_based), log,
+        std::tie(b64_root_hash_before, log, b64_root_hash_after, runtime, one_based));
+}
+
+std::vector<std::string> jsonrpc_virtual_machine::verify_uarch_step_state_transitions(const jsonrpc_mg_mgr_ptr &mgr,
+    const std::vector<hash_type> &root_hashes_before, const std::vector<access_log> &logs,
+    const std::vector<hash_type> &root_hashes_after, const machine_runtime_config &runtime, bool one_based) {
+    std::vector<std::string> b64_root_hashes_before;
+    b64_root_hashes_before.reserve(root_hashes_before.size());
+    for (const auto &hash : root_hashes_before) {
+        b64_root_hashes_before.push_back(encode_base64(hash));
+    }
+    std::vector<std::string> b64_root_hashes_after;
+    b64_root_hashes_after.reserve(root_hashes_after.size());
+    for (const auto &hash : root_hashes_after) {
+        b64_root_hashes_after.push_back(encode_base64(hash));
+    }
+    // All logs go in the body, in the binary access log encoding, one after the other
+    const std::string data = encode_access_logs_binary(logs);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto *payload = reinterpret_cast<const unsigned char *>(data.data());
+    const auto fallback_request = [&]() {
+        return jsonrpc_post_data("machine.verify_uarch_step_state_transitions",
+            std::tie(b64_root_hashes_before, logs, b64_root_hashes_after, runtime, one_based));
+    };
+    std::vector<std::string> errors;
+    jsonrpc_request_write_binary(*mgr, mgr->get_remote_address(), "machine.verify_uarch_step_state_transitions",
+        std::tie(b64_root_hashes_before, b64_root_hashes_after, runtime, one_based), payload, data.size(),
+        fallback_request, errors);
+    if (errors.size() != logs.size()) {
+        throw std::runtime_error("jsonrpc server error: wrong number of results");
+    }
+    return errors;
 }
 
 void jsonrpc_virtual_machine::verify_uarch_reset_log(const jsonrpc_mg_mgr_ptr &mgr, const access_log &log,
     const machine_runtime_config &runtime, bool one_based) {
-    bool result = false;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.verify_uarch_reset_log",
-        std::tie(log, runtime, one_based), result);
+    jsonrpc_request_write_access_log(*mgr, mgr->get_remote_address(), "machine.verify_uarch_reset_log",
+        std::tie(runtime, one_based), log, std::tie(log, runtime, one_based));
 }
 
 void jsonrpc_virtual_machine::verify_uarch_reset_state_transition(const jsonrpc_mg_mgr_ptr &mgr,
     const hash_type &root_hash_before, const access_log &log, const hash_type &root_hash_after,
     const machine_runtime_config &runtime, bool one_based) {
-    bool result = false;
     auto b64_root_hash_before = encode_base64(root_hash_before);
     auto b64_root_hash_after = encode_base64(root_hash_after);
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.verify_uarch_reset_state_transition",
-        std::tie(b64_root_hash_before, log, b64_root_hash_after, runtime, one_based), result);
+    jsonrpc_request_write_access_log(*mgr, mgr->get_remote_address(), "machine.verify_uarch_reset_state_transition",
+        std::tie(b64_root_hash_before, b64_root_hash_after, runtime, one_based), log,
+        std::tie(b64_root_hash_before, log, b64_root_hash_after, runtime, one_based));
 }
 
 interpreter_break_reason jsonrpc_virtual_machine::do_run(uint64_t mcycle_end) {
     interpreter_break_reason result = interpreter_break_reason::failed;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.run", std::tie(mcycle_end), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.run", std::tie(mcycle_end), result);
+    return result;
+}
+
+std::vector<std::pair<uint64_t, jsonrpc_virtual_machine::hash_type>> jsonrpc_virtual_machine::do_run_with_checkpoints(
+    uint64_t mcycle_end, uint64_t period) {
+    std::vector<std::pair<uint64_t, hash_type>> result;
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.run_with_checkpoints", std::tie(mcycle_end, period),
+        result);
     return result;
 }
 
+std::string jsonrpc_virtual_machine::do_transaction(const std::string &operations) {
+    const json ops = json::parse(operations);
+    json result;
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.transaction", std::tie(ops), result);
+    return result.dump();
+}
+
 void jsonrpc_virtual_machine::do_store(const std::string &directory) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.store", std::tie(directory), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.store", std::tie(directory), result);
+}
+
+void jsonrpc_virtual_machine::do_store_delta(const std::string &directory, const std::string &base_directory) {
+    bool result = false;
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.store_delta",
+        std::tie(directory, base_directory), result);
 }
 
 uint64_t jsonrpc_virtual_machine::do_read_csr(csr r) const {
     uint64_t result = 0;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_csr", std::tie(r), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_csr", std::tie(r), result);
     return result;
 }
 
 void jsonrpc_virtual_machine::do_write_csr(csr w, uint64_t val) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.write_csr", std::tie(w, val), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.write_csr", std::tie(w, val), result);
 }
 
 uint64_t jsonrpc_virtual_machine::get_csr_address(const jsonrpc_mg_mgr_ptr &mgr, csr w) {
     uint64_t result = 0;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.get_csr_address", std::tie(w), result);
+    jsonrpc_request(*mgr, mgr->get_remote_address(), "machine.get_csr_address", std::tie(w), result);
     return result;
 }
 
 uint64_t jsonrpc_virtual_machine::do_read_x(int i) const {
     uint64_t result = 0;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_x", std::tie(i), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_x", std::tie(i), result);
     return result;
 }
 
 void jsonrpc_virtual_machine::do_write_x(int i, uint64_t val) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.write_x", std::tie(i, val), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.write_x", std::tie(i, val), result);
 }
 
 uint64_t jsonrpc_virtual_machine::get_x_address(const jsonrpc_mg_mgr_ptr &mgr, int i) {
     uint64_t result = 0;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.get_x_address", std::tie(i), result);
+    jsonrpc_request(*mgr, mgr->get_remote_address(), "machine.get_x_address", std::tie(i), result);
     return result;
 }
 
 std::string jsonrpc_virtual_machine::fork(const jsonrpc_mg_mgr_ptr &mgr) {
     std::string result;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "fork", std::tie(), result);
+    jsonrpc_request(*mgr, mgr->get_remote_address(), "fork", std::tie(), result);
     return result;
 }
 
 uint64_t jsonrpc_virtual_machine::do_read_f(int i) const {
     uint64_t result = 0;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_f", std::tie(i), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_f", std::tie(i), result);
     return result;
 }
 
 void jsonrpc_virtual_machine::do_write_f(int i, uint64_t val) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.write_f", std::tie(i, val), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.write_f", std::tie(i, val), result);
 }
 
 uint64_t jsonrpc_virtual_machine::get_f_address(const jsonrpc_mg_mgr_ptr &mgr, int i) {
     uint64_t result = 0;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.get_f_address", std::tie(i), result);
+    jsonrpc_request(*mgr, mgr->get_remote_address(), "machine.get_f_address", std::tie(i), result);
     return result;
 }
 
 uint64_t jsonrpc_virtual_machine::get_uarch_x_address(const jsonrpc_mg_mgr_ptr &mgr, int i) {
     uint64_t result = 0;
-    jsonrpc_request(mgr->get_mgr(), mgr->get_remote_address(), "machine.get_uarch_x_address", std::tie(i), result);
+    jsonrpc_request(*mgr, mgr->get_remote_address(), "machine.get_uarch_x_address", std::tie(i), result);
     return result;
 }
 
 void jsonrpc_virtual_machine::do_read_memory(uint64_t address, unsigned char *data, uint64_t length) const {
-    std::string result;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_memory", std::tie(address, length),
-        result);
-    std::string bin = cartesi::decode_base64(result);
-    if (bin.size() != length) {
-        throw std::runtime_error("jsonrpc server error: invalid decoded base64 data length");
-    }
-    std::memcpy(data, bin.data(), length);
+    jsonrpc_request_read_binary(*m_mgr, m_mgr->get_remote_address(), "machine.read_memory",
+        std::tie(address, length), data, length);
 }
 
 void jsonrpc_virtual_machine::do_write_memory(uint64_t address, const unsigned char *data, size_t length) {
-    bool result = false;
-    std::string b64 = cartesi::encode_base64(data, length);
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.write_memory", std::tie(address, b64),
-        result);
+    jsonrpc_request_write_memory(*m_mgr, m_mgr->get_remote_address(), "machine.write_memory", std::tie(address),
+        data, length);
 }
 
 void jsonrpc_virtual_machine::do_read_virtual_memory(uint64_t address, unsigned char *data, uint64_t length) const {
-    std::string result;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_virtual_memory",
-        std::tie(address, length), result);
-    std::string bin = cartesi::decode_base64(result);
-    if (bin.size() != length) {
-        throw std::runtime_error("jsonrpc server error: invalid decoded base64 data length");
-    }
-    std::memcpy(data, bin.data(), length);
+    jsonrpc_request_read_binary(*m_mgr, m_mgr->get_remote_address(), "machine.read_virtual_memory",
+        std::tie(address, length), data, length);
 }
 
 void jsonrpc_virtual_machine::do_write_virtual_memory(uint64_t address, const unsigned char *data, size_t length) {
-    bool result = false;
-    std::string b64 = cartesi::encode_base64(data, length);
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.write_virtual_memory",
-        std::tie(address, b64), result);
+    jsonrpc_request_write_memory(*m_mgr, m_mgr->get_remote_address(), "machine.write_virtual_memory",
+        std::tie(address), data, length);
 }
 
 uint64_t jsonrpc_virtual_machine::do_read_pc(void) const {
@@ -655,71 +977,66 @@ uint64_t jsonrpc_virtual_machine::do_read_iflags(void) const {
 
 bool jsonrpc_virtual_machine::do_read_iflags_H(void) const {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_iflags_H", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_iflags_H", std::tie(), result);
     return result;
 }
 
 bool jsonrpc_virtual_machine::do_read_iflags_Y(void) const {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_iflags_Y", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_iflags_Y", std::tie(), result);
     return result;
 }
 
 bool jsonrpc_virtual_machine::do_read_iflags_X(void) const {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_iflags_X", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_iflags_X", std::tie(), result);
     return result;
 }
 
 void jsonrpc_virtual_machine::do_set_iflags_H(void) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.set_iflags_H", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.set_iflags_H", std::tie(), result);
 }
 
 void jsonrpc_virtual_machine::do_set_iflags_Y(void) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.set_iflags_Y", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.set_iflags_Y", std::tie(), result);
 }
 
 void jsonrpc_virtual_machine::do_set_iflags_X(void) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.set_iflags_X", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.set_iflags_X", std::tie(), result);
 }
 
 void jsonrpc_virtual_machine::do_reset_iflags_Y(void) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.reset_iflags_Y", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.reset_iflags_Y", std::tie(), result);
 }
 
 void jsonrpc_virtual_machine::do_reset_iflags_X(void) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.reset_iflags_X", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.reset_iflags_X", std::tie(), result);
 }
 
 bool jsonrpc_virtual_machine::do_read_uarch_halt_flag(void) const {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_uarch_halt_flag", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_uarch_halt_flag", std::tie(), result);
     return result;
 }
 
 void jsonrpc_virtual_machine::do_set_uarch_halt_flag(void) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.set_uarch_halt_flag", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.set_uarch_halt_flag", std::tie(), result);
 }
 
 void jsonrpc_virtual_machine::do_reset_uarch(void) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.reset_uarch", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.reset_uarch", std::tie(), result);
 }
 
 access_log jsonrpc_virtual_machine::do_log_uarch_reset(const access_log::type &log_type, bool one_based) {
-    not_default_constructible<access_log> result;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.log_uarch_reset",
-        std::tie(log_type, one_based), result);
-    if (!result.has_value()) {
-        throw std::runtime_error("jsonrpc server error: missing result");
-    }
-    return std::move(result).value();
+    return jsonrpc_request_read_access_log(*m_mgr, m_mgr->get_remote_address(), "machine.log_uarch_reset",
+        std::tie(log_type, one_based));
 }
 
 void jsonrpc_virtual_machine::do_write_iflags(uint64_t val) {
@@ -791,12 +1108,23 @@ void jsonrpc_virtual_machine::do_write_clint_mtimecmp(uint64_t val) {
 }
 
 void jsonrpc_virtual_machine::do_get_root_hash(hash_type &hash) const {
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.get_root_hash", std::tie(), hash);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.get_root_hash", std::tie(), hash);
 }
 
 machine_merkle_tree::proof_type jsonrpc_virtual_machine::do_get_proof(uint64_t address, int log2_size) const {
     not_default_constructible<machine_merkle_tree::proof_type> result;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.get_proof", std::tie(address, log2_size),
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.get_proof", std::tie(address, log2_size),
+        result);
+    if (!result.has_value()) {
+        throw std::runtime_error("jsonrpc server error: missing result");
+    }
+    return std::move(result).value();
+}
+
+machine_merkle_tree::multiproof_type jsonrpc_virtual_machine::do_get_multiproof(
+    const std::vector<uint64_t> &addresses, int log2_size) const {
+    not_default_constructible<machine_merkle_tree::multiproof_type> result;
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.get_multiproof", std::tie(addresses, log2_size),
         result);
     if (!result.has_value()) {
         throw std::runtime_error("jsonrpc server error: missing result");
@@ -806,53 +1134,54 @@ machine_merkle_tree::proof_type jsonrpc_virtual_machine::do_get_proof(uint64_t a
 
 void jsonrpc_virtual_machine::do_replace_memory_range(const memory_range_config &new_range) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.replace_memory_range", std::tie(new_range),
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.replace_memory_range", std::tie(new_range),
         result);
 }
 
 access_log jsonrpc_virtual_machine::do_log_uarch_step(const access_log::type &log_type, bool one_based) {
-    not_default_constructible<access_log> result;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.log_uarch_step",
-        std::tie(log_type, one_based), result);
-    if (!result.has_value()) {
-        throw std::runtime_error("jsonrpc server error: missing result");
-    }
-    return std::move(result).value();
+    return jsonrpc_request_read_access_log(*m_mgr, m_mgr->get_remote_address(), "machine.log_uarch_step",
+        std::tie(log_type, one_based));
+}
+
+std::vector<access_log> jsonrpc_virtual_machine::do_log_uarch_steps(uint64_t count, const access_log::type &log_type,
+    bool one_based) {
+    return jsonrpc_request_read_access_logs(*m_mgr, m_mgr->get_remote_address(), "machine.log_uarch_steps",
+        std::tie(count, log_type, one_based));
 }
 
 void jsonrpc_virtual_machine::do_destroy() {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.destroy", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.destroy", std::tie(), result);
 }
 
 bool jsonrpc_virtual_machine::do_verify_dirty_page_maps(void) const {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.verify_dirty_page_maps", std::tie(),
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.verify_dirty_page_maps", std::tie(),
         result);
     return result;
 }
 
 uint64_t jsonrpc_virtual_machine::do_read_word(uint64_t address) const {
     uint64_t result = 0;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_word", std::tie(address), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_word", std::tie(address), result);
     return result;
 }
 
 bool jsonrpc_virtual_machine::do_verify_merkle_tree(void) const {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.verify_merkle_tree", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.verify_merkle_tree", std::tie(), result);
     return result;
 }
 
 uint64_t jsonrpc_virtual_machine::do_read_uarch_x(int i) const {
     uint64_t result = 0;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_uarch_x", std::tie(i), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.read_uarch_x", std::tie(i), result);
     return result;
 }
 
 void jsonrpc_virtual_machine::do_write_uarch_x(int i, uint64_t val) {
     bool result = false;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.write_uarch_x", std::tie(i, val), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.write_uarch_x", std::tie(i, val), result);
 }
 
 uint64_t jsonrpc_virtual_machine::do_read_uarch_pc(void) const {
@@ -872,23 +1201,30 @@ void jsonrpc_virtual_machine::do_write_uarch_cycle(uint64_t val) {
 }
 
 void jsonrpc_virtual_machine::do_snapshot(void) {
-    m_mgr->snapshot();
+    bool result = false;
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.snapshot", std::tie(), result);
 }
 
 void jsonrpc_virtual_machine::do_rollback(void) {
-    m_mgr->rollback();
+    bool result = false;
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.rollback", std::tie(), result);
+}
+
+void jsonrpc_virtual_machine::do_commit(void) {
+    bool result = false;
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.commit", std::tie(), result);
 }
 
 uarch_interpreter_break_reason jsonrpc_virtual_machine::do_run_uarch(uint64_t uarch_cycle_end) {
     uarch_interpreter_break_reason result = uarch_interpreter_break_reason::reached_target_cycle;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.run_uarch", std::tie(uarch_cycle_end),
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.run_uarch", std::tie(uarch_cycle_end),
         result);
     return result;
 }
 
 machine_memory_range_descrs jsonrpc_virtual_machine::do_get_memory_ranges(void) const {
     machine_memory_range_descrs result;
-    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.get_memory_ranges", std::tie(), result);
+    jsonrpc_request(*m_mgr, m_mgr->get_remote_address(), "machine.get_memory_ranges", std::tie(), result);
     return result;
 }
 
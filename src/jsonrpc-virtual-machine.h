@@ -59,6 +59,11 @@ public:
         const access_log &log, const hash_type &root_hash_after, const machine_runtime_config &r = {},
         bool one_based = false);
 
+    static std::vector<std::string> verify_uarch_step_state_transitions(const jsonrpc_mg_mgr_ptr &mgr,
+        const std::vector<hash_type> &root_hashes_before, const std::vector<access_log> &logs,
+        const std::vector<hash_type> &root_hashes_after, const machine_runtime_config &r = {},
+        bool one_based = false);
+
     static void verify_uarch_reset_log(const jsonrpc_mg_mgr_ptr &mgr, const access_log &log,
         const machine_runtime_config &r = {}, bool one_based = false);
 
@@ -76,7 +81,11 @@ private:
     machine_config do_get_initial_config(void) const override;
 
     interpreter_break_reason do_run(uint64_t mcycle_end) override;
+    std::vector<std::pair<uint64_t, hash_type>> do_run_with_checkpoints(uint64_t mcycle_end,
+        uint64_t period) override;
+    std::string do_transaction(const std::string &operations) override;
     void do_store(const std::string &dir) override;
+    void do_store_delta(const std::string &dir, const std::string &base_dir) override;
     uint64_t do_read_csr(csr r) const override;
     void do_write_csr(csr w, uint64_t val) override;
     uint64_t do_read_x(int i) const override;
@@ -174,11 +183,16 @@ private:
     void do_write_clint_mtimecmp(uint64_t val) override;
     void do_get_root_hash(hash_type &hash) const override;
     machine_merkle_tree::proof_type do_get_proof(uint64_t address, int log2_size) const override;
+    machine_merkle_tree::multiproof_type do_get_multiproof(const std::vector<uint64_t> &addresses,
+        int log2_size) const override;
     void do_replace_memory_range(const memory_range_config &new_range) override;
     access_log do_log_uarch_step(const access_log::type &log_type, bool /*one_based = false*/) override;
+    std::vector<access_log> do_log_uarch_steps(uint64_t count, const access_log::type &log_type,
+        bool /*one_based = false*/) override;
     void do_destroy() override;
     void do_snapshot() override;
     void do_rollback() override;
+    void do_commit() override;
     bool do_verify_dirty_page_maps(void) const override;
     uint64_t do_read_word(uint64_t address) const override;
     bool do_verify_merkle_tree(void) const override;
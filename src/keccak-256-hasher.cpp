@@ -0,0 +1,216 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "keccak-256-hasher.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define KECCAK_256_HASH_BATCH_X86 1
+#endif
+
+#if defined(__clang__)
+#define KECCAK_UNROLL(n) _Pragma(KECCAK_TO_STRING(unroll(n)))
+#else
+#define KECCAK_UNROLL(n) _Pragma(KECCAK_TO_STRING(GCC unroll(n)))
+#endif
+#define KECCAK_TO_STRING(X) #X
+
+#define KECCAK_ROTL64(x, y) (((x) << (y)) | ((x) >> (64 - (y))))
+
+namespace cartesi {
+
+/// \brief Number of message bytes absorbed by each Keccak-f[1600] permutation in Keccak-256
+constexpr size_t KECCAK_256_RATE = 136;
+
+/// \brief Number of 64-bit words in a Keccak-256 hash
+constexpr int KECCAK_256_HASH_WORDS = 4;
+
+static void keccak_256_hash_batch_scalar(const unsigned char *data, size_t length, size_t count,
+    unsigned char *hashes) {
+    for (size_t i = 0; i < count; ++i, data += length, hashes += KECCAK_256_HASH_WORDS * sizeof(uint64_t)) {
+        sha3_ctx_t ctx{};
+        sha3_init(&ctx, KECCAK_256_HASH_WORDS * sizeof(uint64_t), 0x01);
+        sha3_update(&ctx, data, length);
+        sha3_final(hashes, &ctx);
+    }
+}
+
+#ifdef KECCAK_256_HASH_BATCH_X86
+
+constexpr std::array<uint64_t, 24> keccakf_rndc = {0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+    0x8000000080008000, 0x000000000000808b, 0x0000000080000001, 0x8000000080008081, 0x8000000000008009,
+    0x000000000000008a, 0x0000000000000088, 0x0000000080008009, 0x000000008000000a, 0x000000008000808b,
+    0x800000000000008b, 0x8000000000008089, 0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+    0x000000000000800a, 0x800000008000000a, 0x8000000080008081, 0x8000000000008080, 0x0000000080000001,
+    0x8000000080008008};
+
+constexpr std::array<int, 24> keccakf_rotc = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62,
+    18, 39, 61, 20, 44};
+
+constexpr std::array<int, 24> keccakf_piln = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20,
+    14, 22, 9, 6, 1};
+
+/// \brief Applies Keccak-f[1600] to several independent states at once
+/// \tparam V Vector type holding the same state word of every lane
+/// \param st State words, one vector per word
+/// \details Mirrors sha3_keccakf() from tiny_sha3, with each uint64_t replaced by a vector.
+/// Must be inlined into a function compiled for the instruction set that supports V.
+template <typename V>
+static inline __attribute__((always_inline)) void keccakf_lanes(V *st) {
+    for (int r = 0; r < 24; r++) {
+        V bc[5];
+        // Theta
+        KECCAK_UNROLL(5)
+        for (int i = 0; i < 5; i++) {
+            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        }
+        KECCAK_UNROLL(5)
+        for (int i = 0; i < 5; i++) {
+            const V t = bc[(i + 4) % 5] ^ KECCAK_ROTL64(bc[(i + 1) % 5], 1);
+            KECCAK_UNROLL(5)
+            for (int j = 0; j < 25; j += 5) {
+                st[j + i] ^= t;
+            }
+        }
+        // Rho Pi
+        V t = st[1];
+        KECCAK_UNROLL(24)
+        for (int i = 0; i < 24; i++) {
+            const int j = keccakf_piln[i];
+            bc[0] = st[j];
+            st[j] = KECCAK_ROTL64(t, keccakf_rotc[i]);
+            t = bc[0];
+        }
+        // Chi
+        KECCAK_UNROLL(5)
+        for (int j = 0; j < 25; j += 5) {
+            KECCAK_UNROLL(5)
+            for (int i = 0; i < 5; i++) {
+                bc[i] = st[j + i];
+            }
+            KECCAK_UNROLL(5)
+            for (int i = 0; i < 5; i++) {
+                st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+            }
+        }
+        // Iota
+        st[0] ^= keccakf_rndc[r];
+    }
+}
+
+/// \brief XORs one rate-sized block of each lane into the states
+/// \tparam V Vector type holding the same state word of every lane
+/// \tparam N Number of lanes in V
+/// \param st State words, one vector per word
+/// \param block Pointer to the block of the first lane
+/// \param stride Distance between the blocks of consecutive lanes
+template <typename V, int N>
+static inline __attribute__((always_inline)) void keccak_256_absorb_lanes(V *st, const unsigned char *block,
+    size_t stride) {
+    for (size_t w = 0; w < KECCAK_256_RATE / sizeof(uint64_t); ++w) {
+        V lanes{};
+        for (int l = 0; l < N; ++l) {
+            uint64_t word = 0;
+            memcpy(&word, block + l * stride + w * sizeof(uint64_t), sizeof(uint64_t));
+            lanes[l] = word;
+        }
+        st[w] ^= lanes;
+    }
+}
+
+/// \brief Computes the Keccak-256 hashes of N equally sized messages at once
+/// \tparam V Vector type holding the same state word of every lane
+/// \tparam N Number of lanes in V
+/// \param data Pointer to the N messages, stored back to back
+/// \param length Length of each message
+/// \param hashes Receives the N hashes, back to back
+template <typename V, int N>
+static inline __attribute__((always_inline)) void keccak_256_hash_lanes(const unsigned char *data, size_t length,
+    unsigned char *hashes) {
+    V st[25]{};
+    size_t offset = 0;
+    for (; length - offset >= KECCAK_256_RATE; offset += KECCAK_256_RATE) {
+        keccak_256_absorb_lanes<V, N>(st, data + offset, length);
+        keccakf_lanes(st);
+    }
+    // Pad the trailing partial block of each message, exactly as sha3_final() does
+    std::array<std::array<unsigned char, KECCAK_256_RATE>, N> last{};
+    const size_t rest = length - offset;
+    for (int l = 0; l < N; ++l) {
+        memcpy(last[l].data(), data + l * length + offset, rest);
+        last[l][rest] ^= 0x01;
+        last[l][KECCAK_256_RATE - 1] ^= 0x80;
+    }
+    keccak_256_absorb_lanes<V, N>(st, last[0].data(), KECCAK_256_RATE);
+    keccakf_lanes(st);
+    for (int l = 0; l < N; ++l) {
+        for (int w = 0; w < KECCAK_256_HASH_WORDS; ++w) {
+            const uint64_t word = st[w][l];
+            memcpy(hashes + (l * KECCAK_256_HASH_WORDS + w) * sizeof(uint64_t), &word, sizeof(uint64_t));
+        }
+    }
+}
+
+using keccak_lanes_x4 [[gnu::vector_size(4 * sizeof(uint64_t))]] = uint64_t;
+using keccak_lanes_x8 [[gnu::vector_size(8 * sizeof(uint64_t))]] = uint64_t;
+
+__attribute__((target("avx2"))) static void keccak_256_hash_batch_avx2(const unsigned char *data, size_t length,
+    size_t count, unsigned char *hashes) {
+    constexpr int n = 4;
+    for (; count >= n; count -= n, data += n * length, hashes += n * KECCAK_256_HASH_WORDS * sizeof(uint64_t)) {
+        keccak_256_hash_lanes<keccak_lanes_x4, n>(data, length, hashes);
+    }
+    keccak_256_hash_batch_scalar(data, length, count, hashes);
+}
+
+__attribute__((target("avx2,avx512f"))) static void keccak_256_hash_batch_avx512(const unsigned char *data,
+    size_t length, size_t count, unsigned char *hashes) {
+    constexpr int n = 8;
+    for (; count >= n; count -= n, data += n * length, hashes += n * KECCAK_256_HASH_WORDS * sizeof(uint64_t)) {
+        keccak_256_hash_lanes<keccak_lanes_x8, n>(data, length, hashes);
+    }
+    keccak_256_hash_batch_avx2(data, length, count, hashes);
+}
+
+#endif
+
+using keccak_256_hash_batch_function = void (*)(const unsigned char *data, size_t length, size_t count,
+    unsigned char *hashes);
+
+/// \brief Picks the widest batch implementation supported by the host
+static keccak_256_hash_batch_function select_keccak_256_hash_batch(void) {
+#ifdef KECCAK_256_HASH_BATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2")) {
+        return keccak_256_hash_batch_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return keccak_256_hash_batch_avx2;
+    }
+#endif
+    return keccak_256_hash_batch_scalar;
+}
+
+void keccak_256_hash_batch(const unsigned char *data, size_t length, size_t count, unsigned char *hashes) {
+    static const keccak_256_hash_batch_function hash_batch = select_keccak_256_hash_batch();
+    hash_batch(data, length, count, hashes);
+}
+
+} // namespace cartesi
@@ -17,6 +17,7 @@
 #ifndef KECCAK_256_HASHER_H
 #define KECCAK_256_HASHER_H
 
+#include <cstddef>
 #include <type_traits>
 
 #include "i-hasher.h"
@@ -27,6 +28,15 @@ extern "C" {
 
 namespace cartesi {
 
+/// \brief Computes the Keccak-256 hashes of a batch of equally sized messages
+/// \param data Pointer to the messages, stored back to back
+/// \param length Length of each message
+/// \param count Number of messages
+/// \param hashes Receives the 32-byte hash of each message, back to back
+/// \details Uses multi-lane AVX-512 or AVX2 implementations of Keccak-f[1600] when the host supports them,
+/// falling back to the scalar implementation otherwise.
+void keccak_256_hash_batch(const unsigned char *data, size_t length, size_t count, unsigned char *hashes);
+
 struct keccak_instance final {
     union {
         uint8_t b[200];
@@ -52,6 +62,12 @@ class keccak_256_hasher final : public i_hasher<keccak_256_hasher, std::integral
         sha3_final(hash.data(), &m_ctx);
     }
 
+    void do_hash_batch(const unsigned char *data, size_t length, size_t count, hash_type *hashes) {
+        static_assert(sizeof(hash_type) == 32, "hashes must be stored back to back");
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        keccak_256_hash_batch(data, length, count, reinterpret_cast<unsigned char *>(hashes));
+    }
+
 public:
     /// \brief Default constructor
     keccak_256_hasher(void) = default;
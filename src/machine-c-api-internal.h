@@ -18,6 +18,7 @@
 #define CM_C_API_INTERNAL_H
 
 #include <string>
+#include <vector>
 
 #include "machine-c-api.h"
 #include "machine-c-defines.h"
@@ -63,4 +64,14 @@ cartesi::access_log convert_from_c(const cm_access_log *c_acc_log);
 /// \brief Helper function converts C++ string to allocated C string
 char *convert_to_c(const std::string &cpp_str);
 
+/// \brief Helper function that parses an array of hashes from C
+std::vector<cartesi::machine_merkle_tree::hash_type> convert_from_c(const cm_hash *c_hashes, size_t count);
+
+/// \brief Helper function that parses an array of access logs from C
+std::vector<cartesi::access_log> convert_from_c(const cm_access_log *const *c_logs, size_t count);
+
+/// \brief Helper function that converts per-log verification errors to C strings
+/// \details Entries for valid logs receive NULL.
+void convert_to_c(const std::vector<std::string> &cpp_errors, char **c_errors);
+
 #endif // CM_C_API_INTERNAL_H
@@ -19,11 +19,14 @@
 #include <exception>
 #include <functional>
 #include <ios>
+#include <memory>
 #include <optional>
 #include <regex>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
+#include "access-log-binary.h"
 #include "i-virtual-machine.h"
 #include "machine-c-api-internal.h"
 #include "machine-c-api.h"
@@ -122,6 +125,19 @@ char *convert_to_c(const std::string &cpp_str) {
     return copy_cstring(cpp_str.c_str());
 }
 
+void convert_to_c(const std::vector<std::string> &cpp_errors, char **c_errors) {
+    // Hold the copies until all are made, so none leak if one fails
+    std::vector<std::unique_ptr<char[]>> copies(cpp_errors.size());
+    for (size_t i = 0; i < cpp_errors.size(); ++i) {
+        if (!cpp_errors[i].empty()) {
+            copies[i].reset(convert_to_c(cpp_errors[i]));
+        }
+    }
+    for (size_t i = 0; i < copies.size(); ++i) {
+        c_errors[i] = copies[i].release();
+    }
+}
+
 // --------------------------------------------
 // Machine pointer conversion functions
 // --------------------------------------------
@@ -364,8 +380,13 @@ cartesi::machine_runtime_config convert_from_c(const cm_machine_runtime_config *
     }
     cartesi::machine_runtime_config new_cpp_machine_runtime_config{};
     new_cpp_machine_runtime_config.concurrency =
-        cartesi::concurrency_runtime_config{c_config->concurrency.update_merkle_tree};
+        cartesi::concurrency_runtime_config{c_config->concurrency.update_merkle_tree,
+            c_config->concurrency.verify_uarch_step};
     new_cpp_machine_runtime_config.htif = cartesi::htif_runtime_config{c_config->htif.no_console_putchar};
+    new_cpp_machine_runtime_config.host_tlb =
+        cartesi::host_tlb_runtime_config{c_config->host_tlb.size, c_config->host_tlb.ways};
+    new_cpp_machine_runtime_config.page_hash_cache_size = c_config->page_hash_cache_size;
+    new_cpp_machine_runtime_config.map_ram_image = c_config->map_ram_image;
     new_cpp_machine_runtime_config.skip_root_hash_check = c_config->skip_root_hash_check;
     new_cpp_machine_runtime_config.skip_version_check = c_config->skip_version_check;
     return new_cpp_machine_runtime_config;
@@ -433,6 +454,17 @@ cartesi::machine_merkle_tree::hash_type convert_from_c(const cm_hash *c_hash) {
     return cpp_hash;
 }
 
+std::vector<cartesi::machine_merkle_tree::hash_type> convert_from_c(const cm_hash *c_hashes, size_t count) {
+    if (c_hashes == nullptr && count > 0) {
+        throw std::invalid_argument("invalid hashes");
+    }
+    std::vector<cartesi::machine_merkle_tree::hash_type> cpp_hashes(count);
+    for (size_t i = 0; i < count; ++i) {
+        cpp_hashes[i] = convert_from_c(&c_hashes[i]);
+    }
+    return cpp_hashes;
+}
+
 std::vector<cartesi::machine_merkle_tree::hash_type> convert_from_c(const cm_hash_array *c_array) {
     auto new_array = std::vector<cartesi::machine_merkle_tree::hash_type>(c_array->count);
     for (size_t i = 0; i < c_array->count; ++i) {
@@ -510,6 +542,46 @@ static cm_merkle_tree_proof *convert_to_c(const cartesi::machine_merkle_tree::pr
     return new_merkle_tree_proof;
 }
 
+static cm_merkle_tree_multiproof *convert_to_c(const cartesi::machine_merkle_tree::multiproof_type &proof) {
+    auto *new_multiproof = new cm_merkle_tree_multiproof{};
+    new_multiproof->log2_root_size = proof.get_log2_root_size();
+    new_multiproof->log2_target_size = proof.get_log2_target_size();
+    memcpy(&new_multiproof->root_hash, static_cast<const uint8_t *>(proof.get_root_hash().data()), sizeof(cm_hash));
+    const auto &targets = proof.get_targets();
+    new_multiproof->target_addresses = new uint64_t[targets.size()];
+    new_multiproof->target_hashes.count = targets.size();
+    new_multiproof->target_hashes.entry = new cm_hash[targets.size()];
+    for (size_t i = 0; i < targets.size(); ++i) {
+        new_multiproof->target_addresses[i] = targets[i].address;
+        memcpy(&new_multiproof->target_hashes.entry[i], static_cast<const uint8_t *>(targets[i].hash.data()),
+            sizeof(cm_hash));
+    }
+    const auto &sibling_hashes = proof.get_sibling_hashes();
+    new_multiproof->sibling_hashes.count = sibling_hashes.size();
+    new_multiproof->sibling_hashes.entry = new cm_hash[sibling_hashes.size()];
+    for (size_t i = 0; i < sibling_hashes.size(); ++i) {
+        memcpy(&new_multiproof->sibling_hashes.entry[i], static_cast<const uint8_t *>(sibling_hashes[i].data()),
+            sizeof(cm_hash));
+    }
+    return new_multiproof;
+}
+
+static cartesi::machine_merkle_tree::multiproof_type convert_from_c(const cm_merkle_tree_multiproof *c_proof) {
+    if (c_proof == nullptr) {
+        throw std::invalid_argument("invalid multiproof");
+    }
+    cartesi::machine_merkle_tree::multiproof_type proof{static_cast<int>(c_proof->log2_root_size),
+        static_cast<int>(c_proof->log2_target_size)};
+    proof.set_root_hash(convert_from_c(&c_proof->root_hash));
+    for (size_t i = 0; i < c_proof->target_hashes.count; ++i) {
+        proof.add_target(c_proof->target_addresses[i], convert_from_c(&c_proof->target_hashes.entry[i]));
+    }
+    for (size_t i = 0; i < c_proof->sibling_hashes.count; ++i) {
+        proof.add_sibling_hash(convert_from_c(&c_proof->sibling_hashes.entry[i]));
+    }
+    return proof;
+}
+
 // ----------------------------------------------
 // Access log conversion functions
 // ----------------------------------------------
@@ -705,6 +777,18 @@ cartesi::access_log convert_from_c(const cm_access_log *c_acc_log) {
     return new_cpp_acc_log;
 }
 
+std::vector<cartesi::access_log> convert_from_c(const cm_access_log *const *c_logs, size_t count) {
+    if (c_logs == nullptr && count > 0) {
+        throw std::invalid_argument("invalid access logs");
+    }
+    std::vector<cartesi::access_log> cpp_logs;
+    cpp_logs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        cpp_logs.push_back(convert_from_c(c_logs[i]));
+    }
+    return cpp_logs;
+}
+
 // --------------------------------------------
 // Memory range description conversion functions
 // --------------------------------------------
@@ -814,6 +898,21 @@ int cm_store(cm_machine *m, const char *dir, char **err_msg) try {
     return cm_result_failure(err_msg);
 }
 
+int cm_store_delta(cm_machine *m, const char *dir, const char *base_dir, char **err_msg) try {
+    auto *cpp_machine = convert_from_c(m);
+    cpp_machine->store_delta(null_to_empty(dir), null_to_empty(base_dir));
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
+int cm_compact_delta(const char *dir, const char *compacted_dir, char **err_msg) try {
+    cartesi::machine::compact_delta(null_to_empty(dir), null_to_empty(compacted_dir));
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
 int cm_machine_run(cm_machine *m, uint64_t mcycle_end, CM_BREAK_REASON *break_reason_result, char **err_msg) try {
     auto *cpp_machine = convert_from_c(m);
     cartesi::interpreter_break_reason break_reason = cpp_machine->run(mcycle_end);
@@ -828,6 +927,49 @@ int cm_machine_run(cm_machine *m, uint64_t mcycle_end, CM_BREAK_REASON *break_re
     return cm_result_failure(err_msg);
 }
 
+int cm_machine_run_with_checkpoints(cm_machine *m, uint64_t mcycle_end, uint64_t period,
+    cm_checkpoint_array **checkpoints, char **err_msg) try {
+    if (checkpoints == nullptr) {
+        throw std::invalid_argument("invalid checkpoints output");
+    }
+    auto *cpp_machine = convert_from_c(m);
+    const auto cpp_checkpoints = cpp_machine->run_with_checkpoints(mcycle_end, period);
+    auto *new_checkpoints = new cm_checkpoint_array{};
+    new_checkpoints->count = cpp_checkpoints.size();
+    new_checkpoints->entry = new cm_checkpoint[cpp_checkpoints.size()]{};
+    for (size_t i = 0; i < cpp_checkpoints.size(); ++i) {
+        new_checkpoints->entry[i].mcycle = cpp_checkpoints[i].first;
+        memcpy(new_checkpoints->entry[i].root_hash, static_cast<const uint8_t *>(cpp_checkpoints[i].second.data()),
+            sizeof(cm_hash));
+    }
+    *checkpoints = new_checkpoints;
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
+void cm_delete_checkpoint_array(cm_checkpoint_array *checkpoints) {
+    if (checkpoints == nullptr) {
+        return;
+    }
+    delete[] checkpoints->entry;
+    delete checkpoints;
+}
+
+int cm_transaction(cm_machine *m, const char *operations, char **results, char **err_msg) try {
+    if (results == nullptr) {
+        throw std::invalid_argument("invalid results output");
+    }
+    auto *cpp_machine = convert_from_c(m);
+    *results = convert_to_c(cpp_machine->transaction(null_to_empty(operations)));
+    return cm_result_success(err_msg);
+} catch (...) {
+    if (results) {
+        *results = nullptr;
+    }
+    return cm_result_failure(err_msg);
+}
+
 int cm_read_uarch_x(const cm_machine *m, int i, uint64_t *val, char **err_msg) try {
     if (val == nullptr) {
         throw std::invalid_argument("invalid val output");
@@ -911,6 +1053,37 @@ int cm_log_uarch_step(cm_machine *m, cm_access_log_type log_type, bool one_based
     return cm_result_failure(err_msg);
 }
 
+int cm_log_uarch_steps(cm_machine *m, uint64_t count, cm_access_log_type log_type, bool one_based,
+    cm_access_log_array **access_logs, char **err_msg) try {
+    if (access_logs == nullptr) {
+        throw std::invalid_argument("invalid access logs output");
+    }
+    auto *cpp_machine = convert_from_c(m);
+    cartesi::access_log::type cpp_log_type{log_type.proofs, log_type.annotations};
+    const auto cpp_access_logs = cpp_machine->log_uarch_steps(count, cpp_log_type, one_based);
+    auto *new_access_logs = new cm_access_log_array{};
+    new_access_logs->count = cpp_access_logs.size();
+    new_access_logs->entry = new cm_access_log *[cpp_access_logs.size()]{};
+    for (size_t i = 0; i < cpp_access_logs.size(); ++i) {
+        new_access_logs->entry[i] = convert_to_c(cpp_access_logs[i]);
+    }
+    *access_logs = new_access_logs;
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
+void cm_delete_access_log_array(cm_access_log_array *access_logs) {
+    if (access_logs == nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < access_logs->count; ++i) {
+        cm_delete_access_log(access_logs->entry[i]);
+    }
+    delete[] access_logs->entry;
+    delete access_logs;
+}
+
 void cm_delete_access_log(cm_access_log *acc_log) {
     if (acc_log == nullptr) {
         return;
@@ -931,6 +1104,41 @@ void cm_delete_access_log(cm_access_log *acc_log) {
     delete acc_log;
 }
 
+int cm_encode_access_log_binary(const cm_access_log *log, unsigned char **data, size_t *length, char **err_msg) try {
+    if (data == nullptr) {
+        throw std::invalid_argument("invalid data output");
+    }
+    if (length == nullptr) {
+        throw std::invalid_argument("invalid length output");
+    }
+    const std::string encoded = cartesi::encode_access_log_binary(convert_from_c(log));
+    *data = new unsigned char[encoded.size()];
+    memcpy(*data, encoded.data(), encoded.size());
+    *length = encoded.size();
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
+int cm_decode_access_log_binary(const unsigned char *data, size_t length, cm_access_log **log, char **err_msg) try {
+    if (data == nullptr) {
+        throw std::invalid_argument("invalid data");
+    }
+    if (log == nullptr) {
+        throw std::invalid_argument("invalid access log output");
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const std::string_view encoded{reinterpret_cast<const char *>(data), length};
+    *log = convert_to_c(cartesi::decode_access_log_binary(encoded));
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
+void cm_delete_access_log_binary(unsigned char *data) {
+    delete[] data;
+}
+
 int cm_verify_uarch_step_log(const cm_access_log *log, const cm_machine_runtime_config *runtime_config, bool one_based,
     char **err_msg) try {
     const cartesi::access_log cpp_log = convert_from_c(log);
@@ -965,6 +1173,24 @@ int cm_verify_uarch_step_state_transition(const cm_hash *root_hash_before, const
     return cm_result_failure(err_msg);
 }
 
+int cm_verify_uarch_step_state_transitions(const cm_hash *root_hashes_before, const cm_access_log *const *logs,
+    const cm_hash *root_hashes_after, size_t count, const cm_machine_runtime_config *runtime_config, bool one_based,
+    char **log_err_msgs, char **err_msg) try {
+    if (log_err_msgs == nullptr && count > 0) {
+        throw std::invalid_argument("invalid log error messages output");
+    }
+    const auto cpp_root_hashes_before = convert_from_c(root_hashes_before, count);
+    const auto cpp_logs = convert_from_c(logs, count);
+    const auto cpp_root_hashes_after = convert_from_c(root_hashes_after, count);
+    const cartesi::machine_runtime_config cpp_runtime_config = convert_from_c(runtime_config);
+    convert_to_c(cartesi::machine::verify_uarch_step_state_transitions(cpp_root_hashes_before, cpp_logs,
+                     cpp_root_hashes_after, cpp_runtime_config, one_based),
+        log_err_msgs);
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
 int cm_verify_uarch_reset_state_transition(const cm_hash *root_hash_before, const cm_access_log *log,
     const cm_hash *root_hash_after, const cm_machine_runtime_config *runtime_config, bool one_based,
     char **err_msg) try {
@@ -1000,6 +1226,42 @@ void cm_delete_merkle_tree_proof(cm_merkle_tree_proof *proof) {
     delete proof;
 }
 
+int cm_get_multiproof(const cm_machine *m, const uint64_t *addresses, size_t count, int log2_size,
+    cm_merkle_tree_multiproof **proof, char **err_msg) try {
+    if (proof == nullptr) {
+        throw std::invalid_argument("invalid proof output");
+    }
+    if (addresses == nullptr && count > 0) {
+        throw std::invalid_argument("invalid addresses");
+    }
+    const auto *cpp_machine = convert_from_c(m);
+    const std::vector<uint64_t> cpp_addresses(addresses, addresses + count);
+    *proof = convert_to_c(cpp_machine->get_multiproof(cpp_addresses, log2_size));
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
+int cm_verify_merkle_tree_multiproof(const cm_merkle_tree_multiproof *proof, bool *result, char **err_msg) try {
+    if (result == nullptr) {
+        throw std::invalid_argument("invalid result output");
+    }
+    *result = convert_from_c(proof).verify(cartesi::machine_merkle_tree::hasher_type{});
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
+void cm_delete_merkle_tree_multiproof(cm_merkle_tree_multiproof *proof) {
+    if (proof == nullptr) {
+        return;
+    }
+    delete[] proof->target_addresses;
+    delete[] proof->target_hashes.entry;
+    delete[] proof->sibling_hashes.entry;
+    delete proof;
+}
+
 void cm_delete_semantic_version(const cm_semantic_version *version) {
     if (version == nullptr) {
         return;
@@ -1424,6 +1686,14 @@ int cm_rollback(cm_machine *m, char **err_msg) try {
     return cm_result_failure(err_msg);
 }
 
+int cm_commit(cm_machine *m, char **err_msg) try {
+    auto *cpp_machine = convert_from_c(m);
+    cpp_machine->commit();
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
 CM_API int cm_get_memory_ranges(cm_machine *m, cm_memory_range_descr_array **mrds, char **err_msg) try {
     if (mrds == nullptr) {
         throw std::invalid_argument("invalid memory range output");
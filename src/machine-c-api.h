@@ -285,6 +285,22 @@ typedef struct { // NOLINT(modernize-use-using)
     cm_hash_array sibling_hashes;
 } cm_merkle_tree_proof;
 
+/// \brief Merkle tree multiproof structure
+/// \details
+/// This structure holds a proof that several nodes spanning a log2_target_size
+/// at given addresses in the tree have certain hashes.
+/// Target addresses are sorted, and target_hashes.count gives their number.
+/// Sibling hashes are the hashes of the largest subtrees that contain no target, in the order
+/// a depth-first traversal from the root, visiting left children first, meets them.
+typedef struct { // NOLINT(modernize-use-using)
+    size_t log2_target_size;
+    size_t log2_root_size;
+    cm_hash root_hash;
+    uint64_t *target_addresses;
+    cm_hash_array target_hashes;
+    cm_hash_array sibling_hashes;
+} cm_merkle_tree_multiproof;
+
 /// \brief Type of state access
 typedef enum {       // NOLINT(modernize-use-using)
     CM_ACCESS_READ,  ///< Read operation
@@ -351,9 +367,28 @@ typedef struct {                    // NOLINT(modernize-use-using)
     cm_access_log_type log_type;    ///< Log type
 } cm_access_log;
 
+/// \brief Array of state access logs
+typedef struct { // NOLINT(modernize-use-using)
+    cm_access_log **entry;
+    size_t count;
+} cm_access_log_array;
+
+/// \brief Cycle and root hash of the machine state at a checkpoint
+typedef struct {       // NOLINT(modernize-use-using)
+    uint64_t mcycle;   ///< Value of mcycle at the checkpoint
+    cm_hash root_hash; ///< Root hash of the machine state at the checkpoint
+} cm_checkpoint;
+
+/// \brief Array of checkpoints
+typedef struct { // NOLINT(modernize-use-using)
+    cm_checkpoint *entry;
+    size_t count;
+} cm_checkpoint_array;
+
 /// \brief Concurrency runtime configuration
 typedef struct { // NOLINT(modernize-use-using)
     uint64_t update_merkle_tree;
+    uint64_t verify_uarch_step; ///< Number of threads verifying batches of uarch step logs, or 0 for all
 } cm_concurrency_runtime_config;
 
 /// \brief HTIF runtime configuration
@@ -361,10 +396,19 @@ typedef struct { // NOLINT(modernize-use-using)
     bool no_console_putchar;
 } cm_htif_runtime_config;
 
+/// \brief Host TLB runtime configuration
+typedef struct {   // NOLINT(modernize-use-using)
+    uint64_t size; ///< Number of entries of each type, or 0 to disable the host TLB
+    uint64_t ways; ///< Number of entries in each set (1, 2, or 4)
+} cm_host_tlb_runtime_config;
+
 /// \brief Machine runtime configuration
 typedef struct { // NOLINT(modernize-use-using)
     cm_concurrency_runtime_config concurrency;
     cm_htif_runtime_config htif;
+    cm_host_tlb_runtime_config host_tlb;
+    uint64_t page_hash_cache_size; ///< Number of pages whose inner hashes are cached, or 0 to disable the cache
+    bool map_ram_image;
     bool skip_root_hash_check;
     bool skip_version_check;
 } cm_machine_runtime_config;
@@ -450,6 +494,29 @@ CM_API int cm_load_machine(const char *dir, const cm_machine_runtime_config *run
 /// \returns 0 for success, non zero code for error
 CM_API int cm_store(cm_machine *m, const char *dir, char **err_msg);
 
+/// \brief Serialize only the pages that changed since a previously stored machine to directory
+/// \param m Pointer to valid machine instance
+/// \param dir Directory where the delta will be serialized
+/// \param base_dir Directory where the base machine was stored, either in full or as a delta
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \details The base must have been stored with the same memory ranges, and must stay in place
+/// for as long as the delta is in use. Deltas are loaded with cm_load_machine, with no shared memory ranges.
+/// \returns 0 for success, non zero code for error
+CM_API int cm_store_delta(cm_machine *m, const char *dir, const char *base_dir, char **err_msg);
+
+/// \brief Merges a chain of deltas into a single delta over the full machine at its root
+/// \param dir Directory where the newest delta in the chain was stored
+/// \param compacted_dir Directory where the compacted delta will be stored
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+CM_API int cm_compact_delta(const char *dir, const char *compacted_dir, char **err_msg);
+
 /// \brief Deletes machine instance
 /// \param m Valid pointer to the existing machine instance
 CM_API void cm_delete_machine(cm_machine *m);
@@ -465,6 +532,42 @@ CM_API void cm_delete_machine(cm_machine *m);
 /// \returns 0 for success, non zero code for error
 CM_API int cm_machine_run(cm_machine *m, uint64_t mcycle_end, CM_BREAK_REASON *break_reason_result, char **err_msg);
 
+/// \brief Runs the machine until mcycle reaches mcycle_end, the machine halts or yields, obtaining the root hash
+/// at periodic checkpoints.
+/// \param m Pointer to valid machine instance
+/// \param mcycle_end End cycle value
+/// \param period Number of cycles between checkpoints, counted from the current value of mcycle
+/// \param checkpoints Receives the checkpoints, starting with the state before running. It must be deleted
+/// with cm_delete_checkpoint_array
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \details When the machine stops before a checkpoint, the state where it stopped is the last checkpoint.
+/// Local machines hash the pages changed up to each checkpoint while they run towards the next one.
+/// \returns 0 for success, non zero code for error
+CM_API int cm_machine_run_with_checkpoints(cm_machine *m, uint64_t mcycle_end, uint64_t period,
+    cm_checkpoint_array **checkpoints, char **err_msg);
+
+/// \brief Deletes the instance of cm_checkpoint_array acquired from cm_machine_run_with_checkpoints
+/// \param checkpoints Valid pointer to cm_checkpoint_array object
+CM_API void cm_delete_checkpoint_array(cm_checkpoint_array *checkpoints);
+
+/// \brief Runs a sequence of operations on the machine, all in a single request to remote machines
+/// \param m Pointer to valid machine instance
+/// \param operations JSON array with the operations. Each one is an object with a "method" field
+/// naming a machine method and "params" with its arguments, by position or by name, as in the JSONRPC interface.
+/// An argument {"$result": i} is replaced by the result of the i-th operation
+/// \param results Receives the JSON array with the result of each operation. It must be deleted
+/// with cm_delete_cstring
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \details Operations run in order and stop at the first failure, without undoing earlier ones
+/// \returns 0 for success, non zero code for error
+CM_API int cm_transaction(cm_machine *m, const char *operations, char **results, char **err_msg);
+
 /// \brief Runs the machine for one micro cycle logging all accesses to the state.
 /// \param m Pointer to valid machine instance
 /// \param log_type Type of access log to generate.
@@ -478,10 +581,60 @@ CM_API int cm_machine_run(cm_machine *m, uint64_t mcycle_end, CM_BREAK_REASON *b
 CM_API int cm_log_uarch_step(cm_machine *m, cm_access_log_type log_type, bool one_based, cm_access_log **access_log,
     char **err_msg);
 
+/// \brief Runs the machine for several micro cycles logging all accesses to the state in each.
+/// \param m Pointer to valid machine instance
+/// \param count Maximum number of micro cycles to run.
+/// \param log_type Type of access logs to generate.
+/// \param one_based Use 1-based indices when reporting errors.
+/// \param access_logs Receives the state access logs, one per micro cycle, which must be deleted with
+/// cm_delete_access_log_array.
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+/// \details Stops early after the micro cycle in which the microarchitecture halts.
+/// This is much faster than calling cm_log_uarch_step repeatedly, because the Merkle tree is fully updated only once.
+CM_API int cm_log_uarch_steps(cm_machine *m, uint64_t count, cm_access_log_type log_type, bool one_based,
+    cm_access_log_array **access_logs, char **err_msg);
+
+/// \brief Deletes the instance of cm_access_log_array acquired from cm_log_uarch_steps
+/// \param access_logs Valid pointer to cm_access_log_array object
+CM_API void cm_delete_access_log_array(cm_access_log_array *access_logs);
+
 /// \brief  Deletes the instance of cm_access_log acquired from cm_step
 /// \param acc_log Valid pointer to cm_access_log object
 CM_API void cm_delete_access_log(cm_access_log *acc_log);
 
+/// \brief Encodes an access log in the compact binary format
+/// \param log Valid pointer to cm_access_log object
+/// \param data Receives the encoded log, which must be deleted with cm_delete_access_log_binary
+/// \param length Receives the length of the encoded log
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+/// \details Hashes shared across accesses, such as most sibling hashes, are encoded only once.
+CM_API int cm_encode_access_log_binary(const cm_access_log *log, unsigned char **data, size_t *length,
+    char **err_msg);
+
+/// \brief Decodes an access log from the compact binary format
+/// \param data Encoded log, as produced by cm_encode_access_log_binary
+/// \param length Length of the encoded log
+/// \param log Receives the access log, which must be deleted with cm_delete_access_log
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+CM_API int cm_decode_access_log_binary(const unsigned char *data, size_t length, cm_access_log **log,
+    char **err_msg);
+
+/// \brief Deletes an encoded log acquired from cm_encode_access_log_binary
+/// \param data Encoded log
+CM_API void cm_delete_access_log_binary(unsigned char *data);
+
 /// \brief Checks the internal consistency of an access log
 /// \param log State access log to be verified
 /// \param r Machine runtime configuration to use during verification. Must be pointer to valid object
@@ -508,6 +661,26 @@ CM_API int cm_verify_uarch_step_log(const cm_access_log *log, const cm_machine_r
 CM_API int cm_verify_uarch_step_state_transition(const cm_hash *root_hash_before, const cm_access_log *log,
     const cm_hash *root_hash_after, const cm_machine_runtime_config *runtime_config, bool one_based, char **err_msg);
 
+/// \brief Checks the validity of many independent state transitions, in parallel
+/// \param root_hashes_before Array with the state hash before each step
+/// \param logs Array with the step state access logs
+/// \param root_hashes_after Array with the state hash after each step
+/// \param count Number of entries in each array
+/// \param runtime_config Machine runtime configuration to use during verification. Must be pointer to valid object
+/// \param one_based Use 1-based indices when reporting errors
+/// \param log_err_msgs Array of count entries. Each receives NULL if its state transition is valid,
+/// or the reason it is not, which must be deleted by the function caller using cm_delete_cstring.
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 if all state transitions were checked, valid or not, non zero code for error
+/// \details Uses up to runtime_config->concurrency.verify_uarch_step threads.
+/// Node hashes shared by proofs in different logs are computed only once.
+CM_API int cm_verify_uarch_step_state_transitions(const cm_hash *root_hashes_before, const cm_access_log *const *logs,
+    const cm_hash *root_hashes_after, size_t count, const cm_machine_runtime_config *runtime_config, bool one_based,
+    char **log_err_msgs, char **err_msg);
+
 /// \brief Checks the validity of a state transition caused by a uarch state reset
 /// \param root_hash_before State hash before step
 /// \param log Step state access log produced by cm_log_uarch_reset
@@ -554,6 +727,37 @@ CM_API int cm_get_proof(const cm_machine *m, uint64_t address, int log2_size, cm
 /// \param proof Valid pointer to cm_merkle_tree_proof object
 CM_API void cm_delete_merkle_tree_proof(cm_merkle_tree_proof *proof);
 
+/// \brief Obtains a single proof for several nodes of the same size in the Merkle tree
+/// \param m Pointer to valid machine instance
+/// \param addresses Addresses of target nodes, in any order. Each must be aligned to a 2<sup>log2_size</sup> boundary
+/// \param count Number of addresses
+/// \param log2_size log<sub>2</sub> of size subintended by each target node.
+/// Must be between 3 (for a word) and 64 (for the entire address space), inclusive
+/// \param proof Receives the multiproof, with targets sorted by address and without duplicates
+/// proof must be deleted with the function cm_delete_merkle_tree_multiproof
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+/// \details Sibling hashes shared by paths to several targets are included only once.
+CM_API int cm_get_multiproof(const cm_machine *m, const uint64_t *addresses, size_t count, int log2_size,
+    cm_merkle_tree_multiproof **proof, char **err_msg);
+
+/// \brief Verifies a Merkle tree multiproof
+/// \param proof Valid pointer to cm_merkle_tree_multiproof object
+/// \param result Receives true if the multiproof is valid, false otherwise
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+CM_API int cm_verify_merkle_tree_multiproof(const cm_merkle_tree_multiproof *proof, bool *result, char **err_msg);
+
+/// \brief  Deletes the instance of cm_merkle_tree_multiproof acquired from cm_get_multiproof
+/// \param proof Valid pointer to cm_merkle_tree_multiproof object
+CM_API void cm_delete_merkle_tree_multiproof(cm_merkle_tree_multiproof *proof);
+
 /// \brief Obtains the root hash of the Merkle tree
 /// \param m Pointer to valid machine instance
 /// \param hash Valid pointer to cm_hash structure that  receives the hash.
@@ -1632,6 +1836,14 @@ CM_API int cm_snapshot(cm_machine *m, char **err_msg);
 /// \returns 0 for success, non zero code for error
 CM_API int cm_rollback(cm_machine *m, char **err_msg);
 
+/// \brief Commits the changes made since the last snapshot
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+CM_API int cm_commit(cm_machine *m, char **err_msg);
+
 /// \brief Reads the value of a microarchitecture general-purpose register.
 /// \param m Pointer to valid machine instance
 /// \param i Register index. Between 0 and UARCH_X_REG_COUNT-1, inclusive.
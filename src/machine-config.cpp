@@ -17,11 +17,15 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_set>
+#include <vector>
 
 #include "json-util.h"
 #include "machine-config.h"
+#include "os.h"
 #include "pma-constants.h"
 
 static constexpr uint32_t archive_version = 5;
@@ -42,6 +46,36 @@ std::string machine_config::get_config_filename(const std::string &dir) {
     return dir + "/config.json";
 }
 
+std::string machine_config::get_base_filename(const std::string &dir) {
+    return dir + "/base";
+}
+
+std::string machine_config::load_base(const std::string &dir) {
+    auto name = get_base_filename(dir);
+    std::ifstream ifs(name, std::ios::binary);
+    if (!ifs) {
+        return {};
+    }
+    std::string base{std::istreambuf_iterator<char>(ifs), {}};
+    if (base.empty()) {
+        throw std::runtime_error{"invalid base directory in '" + name + "'"};
+    }
+    return base;
+}
+
+std::vector<std::string> machine_config::load_base_chain(const std::string &dir) {
+    std::vector<std::string> chain{dir};
+    std::unordered_set<std::string> visited{os_get_absolute_path(dir.c_str())};
+    for (auto base = load_base(dir); !base.empty(); base = load_base(chain.back())) {
+        // A base that refers back to a directory already in the chain would have us go around forever
+        if (!visited.insert(os_get_absolute_path(base.c_str())).second) {
+            throw std::runtime_error{"cycle in chain of bases of '" + dir + "' at '" + chain.back() + "'"};
+        }
+        chain.push_back(std::move(base));
+    }
+    return chain;
+}
+
 static void adjust_image_filenames(machine_config &c, const std::string &dir) {
     c.dtb.image_filename = c.get_image_filename(dir, PMA_DTB_START, PMA_DTB_LENGTH);
     c.ram.image_filename = c.get_image_filename(dir, PMA_RAM_START, c.ram.length);
@@ -59,6 +93,20 @@ static void adjust_image_filenames(machine_config &c, const std::string &dir) {
     }
 }
 
+static void clear_shared_flags(machine_config &c) {
+    for (auto &f : c.flash_drive) {
+        f.shared = false;
+    }
+    if (c.rollup.has_value()) {
+        auto &r = c.rollup.value();
+        r.rx_buffer.shared = false;
+        r.tx_buffer.shared = false;
+        r.input_metadata.shared = false;
+        r.voucher_hashes.shared = false;
+        r.notice_hashes.shared = false;
+    }
+}
+
 machine_config machine_config::load(const std::string &dir) {
     machine_config c;
     auto name = machine_config::get_config_filename(dir);
@@ -80,7 +128,15 @@ machine_config machine_config::load(const std::string &dir) {
                 std::to_string(jv.get<int>()) + ")");
         }
         ju_get_field(j, std::string("config"), c, "");
-        adjust_image_filenames(c, dir);
+        // Deltas only store the pages that changed, over the images of the full machine at the root of their chain
+        const std::string root = load_base_chain(dir).back();
+        adjust_image_filenames(c, root);
+        if (root != dir) {
+            // The pages of the deltas are written over the images at the root, which other deltas may share
+            clear_shared_flags(c);
+        }
+        // The shadow TLB is always stored in full
+        c.tlb.image_filename = c.get_image_filename(dir, PMA_SHADOW_TLB_START, PMA_SHADOW_TLB_LENGTH);
     } catch (std::exception &e) {
         throw std::runtime_error{e.what()};
     }
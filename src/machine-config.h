@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "riscv-constants.h"
 #include "uarch-config.h"
@@ -146,9 +147,25 @@ struct machine_config final {
     static std::string get_image_filename(const std::string &dir, uint64_t start, uint64_t length);
     static std::string get_image_filename(const std::string &dir, const memory_range_config &c);
 
+    /// \brief Get the name where the base of a delta will be stored in a directory
+    static std::string get_base_filename(const std::string &dir);
+
+    /// \brief Loads the directory of the machine a delta was stored over
+    /// \param dir Directory from whence "base" will be loaded
+    /// \returns The base directory, or an empty string if \p dir has a full machine rather than a delta
+    static std::string load_base(const std::string &dir);
+
+    /// \brief Loads the chain of directories a delta was stored over
+    /// \param dir Directory with a full machine or a delta
+    /// \returns \p dir, followed by its base, the base of its base, and so on, down to the full machine at the root
+    /// \details Throws if a directory appears twice in the chain.
+    static std::vector<std::string> load_base_chain(const std::string &dir);
+
     /// \brief Loads a machine config from a directory
     /// \param dir Directory from whence "config" will be loaded
     /// \returns The config loaded
+    /// \details For deltas, the memory range images are those in the full machine at the root of the chain,
+    /// and no memory range is shared, so these images are never modified.
     static machine_config load(const std::string &dir);
 
     /// \brief Stores the machine config to a directory
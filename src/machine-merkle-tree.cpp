@@ -16,6 +16,7 @@
 
 #include "machine-merkle-tree.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cinttypes>
 #include <cstdlib>
@@ -23,6 +24,11 @@
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#include "os.h"
 
 /// \file
 /// \brief Merkle tree implementation.
@@ -40,11 +46,35 @@ constexpr machine_merkle_tree::address_type machine_merkle_tree::get_page_index(
     return address & m_page_index_mask;
 }
 
+/// \brief Finds the first page range that starts after a page index.
+/// \param ranges Page ranges sorted by start.
+/// \param page_index Page index.
+/// \returns Iterator to range, or end of \p ranges if none.
+template <typename RANGES>
+static auto upper_bound_page_range(RANGES &ranges, uint64_t page_index) {
+    return std::upper_bound(ranges.begin(), ranges.end(), page_index,
+        [](uint64_t index, const auto &range) { return index < range.start; });
+}
+
+std::vector<machine_merkle_tree::page_range>::const_iterator machine_merkle_tree::find_page_range(
+    address_type page_index) const {
+    // Find first range that starts after page index, then check the one before it
+    auto it = upper_bound_page_range(m_page_ranges, page_index);
+    if (it == m_page_ranges.begin()) {
+        return m_page_ranges.end();
+    }
+    --it;
+    if (((page_index - it->start) >> get_log2_page_size()) >= it->nodes.size()) {
+        return m_page_ranges.end();
+    }
+    return it;
+}
+
 machine_merkle_tree::tree_node *machine_merkle_tree::get_page_node(address_type page_index) const {
-    // Look for entry in page map hash table
-    auto it = m_page_node_map.find(page_index);
-    if (it != m_page_node_map.end()) {
-        return it->second;
+    // Look for entry in page ranges
+    auto it = find_page_range(page_index);
+    if (it != m_page_ranges.end()) {
+        return it->nodes[(page_index - it->start) >> get_log2_page_size()];
     } else {
         return nullptr;
     }
@@ -54,30 +84,71 @@ constexpr machine_merkle_tree::address_type machine_merkle_tree::get_offset_in_p
     return address & m_page_offset_mask;
 }
 
+void machine_merkle_tree::add_page_range(address_type start, address_type length) {
+    assert(get_offset_in_page(start) == 0 && get_offset_in_page(length) == 0);
+    if (length == 0) {
+        return;
+    }
+    auto it = upper_bound_page_range(m_page_ranges, start);
+    // Ignore ranges that overlap the ranges before or after them
+    if (it != m_page_ranges.end() && it->start - start < length) {
+        return;
+    }
+    if (it != m_page_ranges.begin()) {
+        const auto &prev = *std::prev(it);
+        if (((start - prev.start) >> get_log2_page_size()) < prev.nodes.size()) {
+            return;
+        }
+    }
+    m_page_ranges.insert(it, page_range{start, std::vector<tree_node *>(length >> get_log2_page_size(), nullptr)});
+}
+
 int machine_merkle_tree::set_page_node_map(address_type page_index, tree_node *node) {
-    m_page_node_map[page_index] = node;
+    auto it = upper_bound_page_range(m_page_ranges, page_index);
+    if (it != m_page_ranges.begin()) {
+        auto &prev = *std::prev(it);
+        const address_type offset = (page_index - prev.start) >> get_log2_page_size();
+        // Page index is inside the range before it
+        if (offset < prev.nodes.size()) {
+            prev.nodes[offset] = node;
+            return 1;
+        }
+        // Page index is right after the range before it, so extend it
+        if (offset == prev.nodes.size()) {
+            prev.nodes.push_back(node);
+            return 1;
+        }
+    }
+    // Otherwise, page gets a range of its own
+    m_page_ranges.insert(it, page_range{page_index, std::vector<tree_node *>{node}});
     return 1;
 }
 
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-machine_merkle_tree::tree_node *machine_merkle_tree::create_node(void) const {
+machine_merkle_tree::tree_node *machine_merkle_tree::create_node(int log2_size) {
+    assert(log2_size >= get_log2_page_size() && log2_size < get_log2_root_size());
+    auto &slabs = m_node_slabs[log2_size - get_log2_page_size()];
+    if (slabs.empty() || slabs.back().used == slabs.back().size) {
+        // Slabs double in size up to a maximum, so sparsely populated levels do not waste memory
+        uint64_t size = slabs.empty() ? NODE_SLAB_MIN_SIZE : std::min(NODE_SLAB_MAX_SIZE, 2 * slabs.back().size);
+        // There are at most 2^(LOG2_ROOT_SIZE-log2_size) nodes in a level
+        size = std::min(size, UINT64_C(1) << (get_log2_root_size() - log2_size));
+        slabs.push_back(node_slab{std::unique_ptr<tree_node[]>(new (std::nothrow) tree_node[size]()), 0, size});
+        if (!slabs.back().nodes) {
+            slabs.pop_back();
+            return nullptr;
+        }
+    }
 #ifdef MERKLE_DUMP_STATS
     m_num_nodes++;
 #endif
-    return new tree_node{};
-}
-
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-void machine_merkle_tree::destroy_node(tree_node *node) const {
-#ifdef MERKLE_DUMP_STATS
-    --m_num_nodes;
-#endif
-    delete node;
+    auto &slab = slabs.back();
+    return &slab.nodes[slab.used++];
 }
 
 machine_merkle_tree::tree_node *machine_merkle_tree::new_page_node(address_type page_index) {
     // Start with the first bit in the address space
-    address_type bit_mask = UINT64_C(1) << (get_log2_root_size() - 1);
+    int log2_size = get_log2_root_size() - 1;
+    address_type bit_mask = UINT64_C(1) << log2_size;
     tree_node *node = m_root;
     // Descend tree until we reach the node at the end of the
     // path determined by the page index,
@@ -86,14 +157,17 @@ machine_merkle_tree::tree_node *machine_merkle_tree::new_page_node(address_type
         const int bit = (page_index & bit_mask) != 0;
         tree_node *child = node->child[bit];
         if (!child) {
-            child = create_node();
+            child = create_node(log2_size);
             if (!child) {
                 return nullptr;
             }
+            // Until updated, the new node stands for the pristine subtree it replaces
+            child->hash = get_pristine_hash(log2_size);
             child->parent = node;
             node->child[bit] = child;
         }
         node = child;
+        --log2_size;
         bit_mask >>= 1;
         if (!(bit_mask & m_page_index_mask)) {
             break;
@@ -109,19 +183,21 @@ machine_merkle_tree::tree_node *machine_merkle_tree::new_page_node(address_type
 
 void machine_merkle_tree::get_page_node_hash(hasher_type &h, const unsigned char *start, int log2_size,
     hash_type &hash) const {
-    if (log2_size > get_log2_word_size()) {
-        hash_type child0;
-        hash_type child1;
-        --log2_size;
-        const address_type size = UINT64_C(1) << log2_size;
-        get_page_node_hash(h, start, log2_size, child0);
-        get_page_node_hash(h, start + size, log2_size, child1);
-        get_concat_hash(h, child0, child1, hash);
-    } else {
-        h.begin();
-        h.add_data(start, get_word_size());
-        h.end(hash);
+    assert(log2_size >= get_log2_word_size() && log2_size <= get_log2_page_size());
+    // Hash all words first, then each level of the subtree, one batch per level,
+    // alternating between two buffers
+    std::array<hash_type, get_page_size() / get_word_size()> even;
+    std::array<hash_type, get_page_size() / get_word_size() / 2> odd;
+    size_t count = static_cast<size_t>(1) << (log2_size - get_log2_word_size());
+    h.hash_batch(start, get_word_size(), count, even.data());
+    hash_type *level = even.data();
+    while (count > 1) {
+        count /= 2;
+        hash_type *parent = (level == even.data()) ? odd.data() : even.data();
+        h.hash_batch(level->data(), 2 * hasher_type::hash_size, count, parent);
+        level = parent;
     }
+    hash = *level;
 }
 
 void machine_merkle_tree::get_page_node_hash(hasher_type &h, const unsigned char *page_data, hash_type &hash) const {
@@ -142,6 +218,101 @@ void machine_merkle_tree::get_page_node_hash(address_type page_index, hash_type
     }
 }
 
+constexpr size_t machine_merkle_tree::get_page_hashes_index(address_type address, int log2_size) {
+    return (static_cast<size_t>(1) << (get_log2_page_size() - log2_size)) +
+        static_cast<size_t>(get_offset_in_page(address) >> log2_size);
+}
+
+void machine_merkle_tree::hash_page_hashes(hasher_type &h, page_hashes &entry) {
+    // Hash all words first, then each level of the page, one batch per level, from the bottom up
+    size_t count = get_page_size() / get_word_size();
+    h.hash_batch(entry.data.data(), get_word_size(), count, &entry.hashes[count]);
+    while (count > 1) {
+        count /= 2;
+        h.hash_batch(entry.hashes[2 * count].data(), 2 * hasher_type::hash_size, count, &entry.hashes[count]);
+    }
+}
+
+void machine_merkle_tree::update_page_hashes(hasher_type &h, page_hashes &entry, const unsigned char *page_data) {
+    // Find the words that changed since the hashes were computed
+    constexpr size_t word_count = get_page_size() / get_word_size();
+    std::vector<size_t> changed;
+    for (size_t i = 0; i < word_count; ++i) {
+        const size_t offset = i * get_word_size();
+        if (memcmp(entry.data.data() + offset, page_data + offset, get_word_size()) != 0) {
+            changed.push_back(word_count + i);
+        }
+    }
+    memcpy(entry.data.data(), page_data, get_page_size());
+    if (changed.size() > PAGE_HASHES_REHASH_WORDS) {
+        hash_page_hashes(h, entry);
+        return;
+    }
+    // Hash the changed words, then the nodes along their paths to the page node, one level at a time
+    for (const size_t index : changed) {
+        h.begin();
+        h.add_data(entry.data.data() + (index - word_count) * get_word_size(), get_word_size());
+        h.end(entry.hashes[index]);
+    }
+    while (changed.front() > 1) {
+        for (auto &index : changed) {
+            index /= 2;
+        }
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+        for (const size_t index : changed) {
+            get_concat_hash(h, entry.hashes[2 * index], entry.hashes[2 * index + 1], entry.hashes[index]);
+        }
+    }
+}
+
+const machine_merkle_tree::page_hashes *machine_merkle_tree::get_page_hashes(hasher_type &h,
+    address_type page_address, const unsigned char *page_data) const {
+    if (m_page_hash_cache_size == 0) {
+        return nullptr;
+    }
+    ++m_page_hash_cache_tick;
+    auto found = m_page_hash_cache_index.find(page_address);
+    page_hashes *entry = nullptr;
+    if (found == m_page_hash_cache_index.end()) {
+        // Take a new entry while the cache is not full, otherwise replace the least recently used one
+        if (m_page_hash_cache.size() < m_page_hash_cache_size) {
+            entry = m_page_hash_cache.emplace_back(std::make_unique<page_hashes>()).get();
+        } else {
+            auto lru = std::min_element(m_page_hash_cache.begin(), m_page_hash_cache.end(),
+                [](const auto &a, const auto &b) { return a->last_use < b->last_use; });
+            entry = lru->get();
+            m_page_hash_cache_index.erase(entry->page_address);
+        }
+        entry->page_address = page_address;
+        memcpy(entry->data.data(), page_data, get_page_size());
+        hash_page_hashes(h, *entry);
+        m_page_hash_cache_index.emplace(page_address, entry);
+    } else {
+        entry = found->second;
+        if (memcmp(entry->data.data(), page_data, get_page_size()) != 0) {
+            update_page_hashes(h, *entry, page_data);
+        }
+    }
+    entry->last_use = m_page_hash_cache_tick;
+    return entry;
+}
+
+void machine_merkle_tree::get_page_node_hash(hasher_type &h, address_type page_address, const unsigned char *page_data,
+    hash_type &hash) const {
+    const page_hashes *cached = get_page_hashes(h, page_address, page_data);
+    if (cached) {
+        hash = cached->hashes[1];
+    } else {
+        get_page_node_hash(h, page_data, hash);
+    }
+}
+
+void machine_merkle_tree::set_page_hash_cache_size(size_t size) {
+    m_page_hash_cache.clear();
+    m_page_hash_cache_index.clear();
+    m_page_hash_cache_size = size;
+}
+
 const machine_merkle_tree::hash_type &machine_merkle_tree::get_child_hash(int child_log2_size, const tree_node *node,
     int bit) {
     const tree_node *child = node->child[bit];
@@ -182,20 +353,16 @@ void machine_merkle_tree::dump_merkle_tree(tree_node *node, uint64_t address, in
     }
 }
 
-void machine_merkle_tree::destroy_merkle_tree(tree_node *node, int log2_size) {
-    if (node) {
-        // If this is an inner node, invoke recursively
-        if (log2_size > get_log2_page_size()) {
-            destroy_merkle_tree(node->child[0], log2_size - 1);
-            destroy_merkle_tree(node->child[1], log2_size - 1);
+void machine_merkle_tree::destroy_merkle_tree(void) {
+    m_page_ranges.clear();
+    for (auto &slabs : m_node_slabs) {
+#ifdef MERKLE_DUMP_STATS
+        for (const auto &slab : slabs) {
+            m_num_nodes -= slab.used;
         }
-        destroy_node(node);
+#endif
+        slabs.clear();
     }
-}
-
-void machine_merkle_tree::destroy_merkle_tree(void) {
-    destroy_merkle_tree(m_root_storage.child[0], get_log2_root_size() - 1);
-    destroy_merkle_tree(m_root_storage.child[1], get_log2_root_size() - 1);
     memset(&m_root_storage, 0, sizeof(m_root_storage));
 }
 
@@ -248,7 +415,7 @@ void machine_merkle_tree::dump_merkle_tree(void) const {
 }
 
 bool machine_merkle_tree::begin_update(void) {
-    m_merkle_update_fifo.clear();
+    m_merkle_update_nodes.clear();
     return true;
 }
 
@@ -264,34 +431,80 @@ bool machine_merkle_tree::update_page_node_hash(address_type page_index, const h
         return false;
     }
     // Copy new hash value to node
+    save_node_hash(node);
     node->hash = hash;
-    // Add parent to fifo so we propagate changes
+    // Add parent to the nodes to update so we propagate changes
     if (node->parent && node->parent->mark != m_merkle_update_nonce) {
-        m_merkle_update_fifo.emplace_back(get_log2_page_size() + 1, node->parent);
+        m_merkle_update_nodes.push_back(node->parent);
         node->parent->mark = m_merkle_update_nonce;
     }
     return true;
 }
 
-bool machine_merkle_tree::end_update(hasher_type &h) {
-    // Now go over the queue of inner nodes updating their hashes and
-    // enqueueing their parents until the queue is empty
-    while (!m_merkle_update_fifo.empty()) {
-        int log2_size{};
-        tree_node *node{};
-        std::tie(log2_size, node) = m_merkle_update_fifo.front();
-        update_inner_node_hash(h, log2_size, node);
-        m_merkle_update_fifo.pop_front();
-        if (node->parent && node->parent->mark != m_merkle_update_nonce) {
-            m_merkle_update_fifo.emplace_back(log2_size + 1, node->parent);
-            node->parent->mark = m_merkle_update_nonce;
+bool machine_merkle_tree::end_update(hasher_type &h, uint64_t concurrency) {
+    // Now go over the inner nodes one level at a time, updating their hashes
+    // and collecting their parents as the next level, until there are no more levels.
+    // Nodes in the same level do not depend on each other, so they can be updated in parallel.
+    std::vector<tree_node *> next_nodes;
+    int log2_size = get_log2_page_size() + 1;
+    while (!m_merkle_update_nodes.empty()) {
+        for (tree_node *node : m_merkle_update_nodes) {
+            save_node_hash(node);
         }
+        const uint64_t nodes_count = m_merkle_update_nodes.size();
+        const uint64_t n = std::min(concurrency, nodes_count / PARALLEL_UPDATE_MIN_NODES);
+        if (n > 1) {
+            os_parallel_for_chunks(n, nodes_count, PARALLEL_UPDATE_MIN_NODES / 4,
+                [&](uint64_t /*j*/, uint64_t begin, uint64_t end) -> bool {
+                    hasher_type th;
+                    for (uint64_t i = begin; i < end; ++i) {
+                        update_inner_node_hash(th, log2_size, m_merkle_update_nodes[i]);
+                    }
+                    return true;
+                });
+        } else {
+            for (tree_node *node : m_merkle_update_nodes) {
+                update_inner_node_hash(h, log2_size, node);
+            }
+        }
+        next_nodes.clear();
+        for (tree_node *node : m_merkle_update_nodes) {
+            if (node->parent && node->parent->mark != m_merkle_update_nonce) {
+                next_nodes.push_back(node->parent);
+                node->parent->mark = m_merkle_update_nonce;
+            }
+        }
+        std::swap(m_merkle_update_nodes, next_nodes);
+        ++log2_size;
     }
     ++m_merkle_update_nonce;
     return true;
 }
 
-machine_merkle_tree::machine_merkle_tree(void) : m_root_storage{}, m_root{&m_root_storage}, m_merkle_update_nonce{1} {
+void machine_merkle_tree::begin_snapshot(void) {
+    m_snapshot_hashes.clear();
+    m_snapshot_active = true;
+}
+
+void machine_merkle_tree::rollback_snapshot(void) {
+    for (const auto &[node, hash] : m_snapshot_hashes) {
+        node->hash = hash;
+    }
+    end_snapshot();
+}
+
+void machine_merkle_tree::end_snapshot(void) {
+    m_snapshot_hashes.clear();
+    m_snapshot_active = false;
+}
+
+machine_merkle_tree::machine_merkle_tree(void) :
+    m_root_storage{},
+    m_root{&m_root_storage},
+    m_merkle_update_nonce{1},
+    m_snapshot_active{false},
+    m_page_hash_cache_tick{0},
+    m_page_hash_cache_size{0} {
     m_root->hash = get_pristine_hash(get_log2_root_size());
 #ifdef MERKLE_DUMP_STATS
     m_num_nodes = 0;
@@ -371,8 +584,14 @@ machine_merkle_tree::proof_type machine_merkle_tree::get_proof(address_type targ
     // Case 1
     // We hit a pristine node along the path to the target node
     if (!node) {
+        // Pristine pages have no node in the tree, so data given for them must be pristine too
         if (page_data) {
-            throw std::runtime_error{"inconsistent merkle tree"};
+            hasher_type h;
+            hash_type page_hash;
+            get_page_node_hash(h, page_data, page_hash);
+            if (page_hash != get_pristine_hash(get_log2_page_size())) {
+                throw std::runtime_error{"inconsistent merkle tree"};
+            }
         }
         // All remaining siblings along the path are pristine
         for (int i = log2_node_size - 1; i >= log2_target_size; --i) {
@@ -387,8 +606,18 @@ machine_merkle_tree::proof_type machine_merkle_tree::get_proof(address_type targ
         hash_type page_hash;
         // If target node is smaller than page size
         if (log2_target_size < get_log2_page_size()) {
-            // If we were given the page data, compute from it
-            if (page_data) {
+            hasher_type h;
+            const page_hashes *cached =
+                page_data ? get_page_hashes(h, get_page_index(target_address), page_data) : nullptr;
+            // If the hashes inside the page are cached, copy them
+            if (cached) {
+                page_hash = cached->hashes[1];
+                for (int i = get_log2_page_size() - 1; i >= log2_target_size; --i) {
+                    proof.set_sibling_hash(cached->hashes[get_page_hashes_index(target_address, i) ^ 1], i);
+                }
+                proof.set_target_hash(cached->hashes[get_page_hashes_index(target_address, log2_target_size)]);
+                // Otherwise, if we were given the page data, compute from it
+            } else if (page_data) {
                 get_inside_page_sibling_hashes(target_address, log2_target_size, proof.get_target_hash(), page_data,
                     page_hash, proof);
                 // Otherwise, if page is pristine
@@ -428,6 +657,111 @@ machine_merkle_tree::proof_type machine_merkle_tree::get_proof(address_type targ
     return proof;
 }
 
+void machine_merkle_tree::get_inside_page_multiproof_node(hasher_type &h, const unsigned char *page_data,
+    address_type node_address, int log2_node_size, const address_type *begin, const address_type *end,
+    multiproof_type &proof, hash_type &hash, const page_hashes *cached) const {
+    // Node is either a target or has no targets, so hash it as a whole
+    if (begin == end || log2_node_size == proof.get_log2_target_size()) {
+        if (cached) {
+            hash = cached->hashes[get_page_hashes_index(node_address, log2_node_size)];
+        } else if (page_data) {
+            get_page_node_hash(h, page_data + get_offset_in_page(node_address), log2_node_size, hash);
+        } else {
+            hash = get_pristine_hash(log2_node_size);
+        }
+        if (begin == end) {
+            proof.add_sibling_hash(hash);
+        } else {
+            proof.add_target(node_address, hash);
+        }
+        return;
+    }
+    const int log2_child_size = log2_node_size - 1;
+    const address_type child_address = node_address | (UINT64_C(1) << log2_child_size);
+    const address_type *middle = std::lower_bound(begin, end, child_address);
+    hash_type first_hash;
+    hash_type second_hash;
+    get_inside_page_multiproof_node(h, page_data, node_address, log2_child_size, begin, middle, proof, first_hash,
+        cached);
+    get_inside_page_multiproof_node(h, page_data, child_address, log2_child_size, middle, end, proof, second_hash,
+        cached);
+    if (cached) {
+        hash = cached->hashes[get_page_hashes_index(node_address, log2_node_size)];
+    } else {
+        get_concat_hash(h, first_hash, second_hash, hash);
+    }
+}
+
+void machine_merkle_tree::get_multiproof_node(hasher_type &h, const tree_node *node, address_type node_address,
+    int log2_node_size, const address_type *begin, const address_type *end, const page_data_getter &get_page_data,
+    multiproof_type &proof) const {
+    // Node has no targets, so its hash is a sibling hash
+    if (begin == end) {
+        proof.add_sibling_hash(node ? node->hash : get_pristine_hash(log2_node_size));
+        return;
+    }
+    // Node is a target
+    if (log2_node_size == proof.get_log2_target_size()) {
+        proof.add_target(node_address, node ? node->hash : get_pristine_hash(log2_node_size));
+        return;
+    }
+    // Targets are inside a page that is not pristine, so hashes come from its data
+    if (node && log2_node_size == get_log2_page_size()) {
+        hash_type page_hash;
+        const unsigned char *page_data = get_page_data(node_address);
+        const page_hashes *cached = page_data ? get_page_hashes(h, node_address, page_data) : nullptr;
+        get_inside_page_multiproof_node(h, page_data, node_address, log2_node_size, begin, end, proof, page_hash,
+            cached);
+        // Check if hash stored in node matches what we just computed
+        if (node->hash != page_hash) {
+            // Caller probably forgot to update the Merkle tree
+            throw std::runtime_error{"inconsistent merkle tree"};
+        }
+        return;
+    }
+    // Split targets between children, visiting the first child before the second
+    const int log2_child_size = log2_node_size - 1;
+    const address_type child_address = node_address | (UINT64_C(1) << log2_child_size);
+    const address_type *middle = std::lower_bound(begin, end, child_address);
+    get_multiproof_node(h, node ? node->child[0] : nullptr, node_address, log2_child_size, begin, middle,
+        get_page_data, proof);
+    get_multiproof_node(h, node ? node->child[1] : nullptr, child_address, log2_child_size, middle, end,
+        get_page_data, proof);
+}
+
+machine_merkle_tree::multiproof_type machine_merkle_tree::get_multiproof(
+    const std::vector<address_type> &target_addresses, int log2_target_size,
+    const page_data_getter &get_page_data) const {
+    // Check for valid target node size
+    if (log2_target_size > get_log2_root_size() || log2_target_size < get_log2_word_size()) {
+        throw std::runtime_error{"log2_target_size is out of bounds"};
+    }
+    if (target_addresses.empty()) {
+        throw std::runtime_error{"no target addresses"};
+    }
+    for (size_t i = 0; i < target_addresses.size(); ++i) {
+        // Check target address alignment
+        if (target_addresses[i] & ((~UINT64_C(0)) >> (get_log2_root_size() - log2_target_size))) {
+            throw std::runtime_error{"misaligned target address"};
+        }
+        if (i > 0 && target_addresses[i - 1] >= target_addresses[i]) {
+            throw std::runtime_error{"target addresses are not sorted and unique"};
+        }
+    }
+    multiproof_type proof{get_log2_root_size(), log2_target_size};
+    hasher_type h;
+    get_multiproof_node(h, m_root, 0, get_log2_root_size(), target_addresses.data(),
+        target_addresses.data() + target_addresses.size(), get_page_data, proof);
+    proof.set_root_hash(m_root->hash); // NOLINT: m_root can't be nullptr
+#ifndef NDEBUG
+    // Return proof only if it passes verification
+    if (!proof.verify(hasher_type{})) {
+        throw std::runtime_error{"multiproof failed verification"};
+    }
+#endif
+    return proof;
+}
+
 std::ostream &operator<<(std::ostream &out, const machine_merkle_tree::hash_type &hash) {
     auto f = out.flags();
     for (const unsigned b : hash) {
@@ -22,12 +22,15 @@
 
 #include <array>
 #include <cstdint>
-#include <deque>
+#include <functional>
 #include <iosfwd>
+#include <memory>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include "keccak-256-hasher.h"
+#include "merkle-tree-multiproof.h"
 #include "merkle-tree-proof.h"
 #include "pristine-merkle-tree.h"
 
@@ -73,6 +76,9 @@ private:
     /// I.e., log<sub>2</sub> of number of bytes subintended by the
     /// the deepest tree nodes.
     static constexpr int LOG2_WORD_SIZE = 3;
+    /// \brief PARALLEL_UPDATE_MIN_NODES Minimum number of inner nodes each thread
+    /// must have to update in a level of the tree for it to be worth updating the level in parallel.
+    static constexpr uint64_t PARALLEL_UPDATE_MIN_NODES = 256;
     /// \brief DEPTH Depth of Merkle tree.
     static constexpr int DEPTH = LOG2_ROOT_SIZE - LOG2_WORD_SIZE;
 
@@ -123,21 +129,64 @@ public:
     /// the path from the root to target node.
     using siblings_type = proof_type::sibling_hashes_type;
 
+    /// \brief Storage for the proof of several nodes at once.
+    using multiproof_type = merkle_tree_multiproof<hash_type, address_type>;
+
+    /// \brief Callback that returns the contents of a page, or nullptr if the page is pristine.
+    using page_data_getter = std::function<const unsigned char *(address_type page_address)>;
+
 private:
     /// \brief Merkle tree node structure.
     /// \details A node is known to be an inner-node or a page-node implicitly
     /// based on its height in the tree.
     //??D This is assumed to be a POD type in the implementation
-    struct tree_node {
+    struct alignas(64) tree_node {
         hash_type hash;                   ///< Hash of subintended data.
         tree_node *parent;                ///< Pointer to parent node (nullptr for root).
         std::array<tree_node *, 2> child; ///< Children nodes.
         uint64_t mark;                    ///< Helper for traversal algorithms.
     };
 
-    // Sparse map from virtual page index to the
-    // corresponding page node in the Merkle tree.
-    std::unordered_map<address_type, tree_node *> m_page_node_map;
+    /// \brief Flat index of the page nodes in a contiguous range of addresses.
+    struct page_range {
+        address_type start;             ///< Page index of first page in range.
+        std::vector<tree_node *> nodes; ///< Page nodes in range, nullptr where pristine.
+    };
+
+    /// \brief Slab of tree nodes at the same level of the tree.
+    struct node_slab {
+        std::unique_ptr<tree_node[]> nodes; ///< Storage for nodes.
+        uint64_t used;                      ///< Number of nodes already handed out.
+        uint64_t size;                      ///< Number of nodes in storage.
+    };
+
+    /// \brief Hashes of all nodes inside a page, together with the data they were computed from.
+    /// \details Nodes are laid out as a binary heap: the page node is at index 1, and the children of
+    /// the node at index i are at indices 2i and 2i+1. Words are thus at the second half of the array.
+    struct page_hashes {
+        address_type page_address;                                     ///< Address of page.
+        uint64_t last_use;                                             ///< Tick of last use, for LRU replacement.
+        std::array<unsigned char, m_page_size> data;                   ///< Page data the hashes were computed from.
+        std::array<hash_type, 2 * (m_page_size / m_word_size)> hashes; ///< Node hashes, from index 1.
+    };
+
+    /// \brief PAGE_HASHES_REHASH_WORDS Number of changed words above which all hashes in a page are recomputed.
+    static constexpr size_t PAGE_HASHES_REHASH_WORDS = 64;
+
+    /// \brief NODE_SLAB_MIN_SIZE Number of nodes in the first slab allocated for a level of the tree.
+    static constexpr uint64_t NODE_SLAB_MIN_SIZE = 4;
+    /// \brief NODE_SLAB_MAX_SIZE Maximum number of nodes in a slab.
+    static constexpr uint64_t NODE_SLAB_MAX_SIZE = 4096;
+
+    // Page ranges sorted by start, with the page node for each page index.
+    // One range is added for each PMA, so lookups are a binary search over
+    // a handful of ranges followed by direct indexing.
+    std::vector<page_range> m_page_ranges;
+
+    // Arena for inner and page nodes, with a separate list of slabs for each
+    // level of the tree. Nodes at the same level, which are visited together when
+    // updates are propagated up the tree, are thus packed together in memory.
+    std::array<std::vector<node_slab>, LOG2_ROOT_SIZE - LOG2_PAGE_SIZE> m_node_slabs;
 
     // Root of the Merkle tree.
     tree_node m_root_storage;
@@ -147,27 +196,46 @@ private:
     // bottom up in breadth to propagate changes from dirty
     // pages all the way up to the tree root.
     uint64_t m_merkle_update_nonce;
-    // FIFO to process pages in bottom-up order.
-    std::deque<std::pair<int, tree_node *>> m_merkle_update_fifo;
+    // Parents of updated page nodes, i.e., the first level
+    // of inner nodes to process in bottom-up order.
+    std::vector<tree_node *> m_merkle_update_nodes;
+
+    // Hashes of the nodes changed since the snapshot was taken,
+    // as they were right before each node first changed.
+    std::unordered_map<tree_node *, hash_type> m_snapshot_hashes;
+    // Whether changed nodes must have their hashes saved.
+    bool m_snapshot_active;
+
+    // Hashes inside the most recently used pages, up to m_page_hash_cache_size pages,
+    // and the entry for each page address. Entries are checked against the page data
+    // on every use, so writes to a page never leave stale hashes behind.
+    mutable std::vector<std::unique_ptr<page_hashes>> m_page_hash_cache;
+    mutable std::unordered_map<address_type, page_hashes *> m_page_hash_cache_index;
+    mutable uint64_t m_page_hash_cache_tick;
+    size_t m_page_hash_cache_size;
 
     // For statistics.
 #ifdef MERKLE_DUMP_STATS
     mutable uint64_t m_num_nodes;
 #endif
 
+    /// \brief Finds the page range containing a page index.
+    /// \param page_index Page index.
+    /// \return Iterator to range, or end of m_page_ranges if not found.
+    std::vector<page_range>::const_iterator find_page_range(address_type page_index) const;
+
     /// \brief Maps a page_index to a node.
     /// \param page_index Page index.
     /// \param node Node subintending page.
     /// \return 1 if succeeded, 0 othewise.
+    /// \details Page indices outside all page ranges either extend the range
+    /// that ends right before them or get a range of their own.
     int set_page_node_map(address_type page_index, tree_node *node);
 
     /// \brief Creates and returns a new tree node.
+    /// \param log2_size log<sub>2</sub> of size subintended by node.
     /// \return Newly created node or nullptr if out-of-memory.
-    tree_node *create_node(void) const;
-
-    /// \brief Deallocates node.
-    /// \param node Node to be deallocated.
-    void destroy_node(tree_node *node) const;
+    tree_node *create_node(int log2_size);
 
     /// \brief Creates a new page node and insert it into the Merkle tree.
     /// \param page_index Page index for node.
@@ -176,6 +244,15 @@ private:
     /// Maps new node to the page index.
     tree_node *new_page_node(address_type page_index);
 
+    /// \brief Saves the hash of a node that is about to change, if a snapshot is active
+    /// and the node has not changed since the snapshot was taken.
+    /// \param node Node about to change.
+    void save_node_hash(tree_node *node) {
+        if (m_snapshot_active) {
+            m_snapshot_hashes.emplace(node, node->hash);
+        }
+    }
+
     /// \brief Updates an inner node hash from its children.
     /// \param h Hasher object.
     /// \param log2_size log<sub>2</sub> of size subintended by node.
@@ -203,11 +280,6 @@ private:
     /// \brief Dumps the entire tree rooted to std::cerr.
     void dump_merkle_tree(void) const;
 
-    /// \brief Destroys tree rooted at node.
-    /// \param node Root of subtree.
-    /// \param  log2_size log<sub>2</sub> of size subintended by \p node.
-    void destroy_merkle_tree(tree_node *node, int log2_size);
-
     /// \brief Destroys entire Merkle tree.
     void destroy_merkle_tree(void);
 
@@ -233,8 +305,8 @@ private:
     /// \return The node, if found, or nullptr otherwise.
     tree_node *get_page_node(address_type page_index) const;
 
-    /// \brief Recursively builds hash for log2_size node
-    /// from contiguous memory.
+    /// \brief Builds hash for log2_size node from contiguous memory,
+    /// hashing each level of the subtree as a batch.
     /// \param h Hasher object.
     /// \param start Start of contiguous memory subintended by node.
     /// \param log2_size log<sub>2</sub> of size subintended by node.
@@ -273,6 +345,58 @@ private:
     void get_inside_page_sibling_hashes(address_type address, int log2_size, hash_type &hash,
         const unsigned char *page_data, hash_type &page_hash, proof_type &proof) const;
 
+    /// \brief Returns the index of a node inside a page in page_hashes::hashes.
+    /// \param address Address of node.
+    /// \param log2_size log<sub>2</sub> of size subintended by node.
+    static constexpr size_t get_page_hashes_index(address_type address, int log2_size);
+
+    /// \brief Computes all hashes inside a page from its data.
+    /// \param h Hasher object.
+    /// \param entry Entry with page data, that receives the hashes.
+    static void hash_page_hashes(hasher_type &h, page_hashes &entry);
+
+    /// \brief Brings all hashes inside a page up to date with its data.
+    /// \param h Hasher object.
+    /// \param entry Entry with the hashes to update.
+    /// \param page_data Pointer to start of contiguous page data, which differs from the entry data.
+    /// \details Only the words that changed, and the nodes on their paths to the page node, are hashed again.
+    static void update_page_hashes(hasher_type &h, page_hashes &entry, const unsigned char *page_data);
+
+    /// \brief Returns the hashes inside a page from the cache, bringing them up to date with its data.
+    /// \param h Hasher object.
+    /// \param page_address Address of page.
+    /// \param page_data Pointer to start of contiguous page data.
+    /// \returns Pointer to the hashes, or nullptr if the cache is disabled.
+    const page_hashes *get_page_hashes(hasher_type &h, address_type page_address,
+        const unsigned char *page_data) const;
+
+    /// \brief Adds the targets and sibling hashes under a node to a multiproof.
+    /// \param h Hasher object.
+    /// \param node Node being visited, or nullptr if it is pristine.
+    /// \param node_address Address of node being visited.
+    /// \param log2_node_size log<sub>2</sub> of size subintended by node being visited.
+    /// \param begin Start of sorted target addresses under node.
+    /// \param end End of sorted target addresses under node.
+    /// \param get_page_data Callback that returns the contents of a page.
+    /// \param proof Multiproof to receive targets and sibling hashes.
+    void get_multiproof_node(hasher_type &h, const tree_node *node, address_type node_address, int log2_node_size,
+        const address_type *begin, const address_type *end, const page_data_getter &get_page_data,
+        multiproof_type &proof) const;
+
+    /// \brief Adds the targets and sibling hashes under a node inside a page to a multiproof.
+    /// \param h Hasher object.
+    /// \param page_data Pointer to start of contiguous page data, or nullptr if page is pristine.
+    /// \param node_address Address of node being visited.
+    /// \param log2_node_size log<sub>2</sub> of size subintended by node being visited.
+    /// \param begin Start of sorted target addresses under node.
+    /// \param end End of sorted target addresses under node.
+    /// \param proof Multiproof to receive targets and sibling hashes.
+    /// \param hash Receives the hash for node being visited.
+    /// \param cached Hashes inside the page from the cache, or nullptr to compute them from \p page_data.
+    void get_inside_page_multiproof_node(hasher_type &h, const unsigned char *page_data, address_type node_address,
+        int log2_node_size, const address_type *begin, const address_type *end, multiproof_type &proof,
+        hash_type &hash, const page_hashes *cached) const;
+
     // Precomputed hashes of spans of zero bytes with
     // increasing power-of-two sizes, from 2^LOG2_WORD_SIZE
     // to 2^LOG2_ROOT_SIZE bytes.
@@ -300,6 +424,14 @@ public:
     /// \details Releases all used memory
     ~machine_merkle_tree();
 
+    /// \brief Adds a flat page index for a range of addresses.
+    /// \param start Start of range. Must be aligned to a page boundary.
+    /// \param length Length of range. Must be a multiple of the page size.
+    /// \details Should be called for each PMA before its pages are first updated,
+    /// so that page nodes in the range are found by direct indexing.
+    /// Ranges that overlap a range already added are ignored.
+    void add_page_range(address_type start, address_type length);
+
     /// \brief Returns the root hash.
     /// \param hash Receives the hash.
     void get_root_hash(hash_type &hash) const;
@@ -320,10 +452,24 @@ public:
 
     /// \brief End tree update.
     /// \param h Hasher object.
+    /// \param concurrency Maximum number of threads to use when propagating changes to the root.
     /// \returns True if succeeded, false otherwise.
-    /// \details This method is not thread safe, so be careful when using
+    /// \details Changes are propagated one level at a time, bottom up. Levels with enough
+    /// updated inner nodes have their hashes computed in parallel.
+    /// This method is not thread safe, so be careful when using
     /// parallelization to compute Merkle trees
-    bool end_update(hasher_type &h);
+    bool end_update(hasher_type &h, uint64_t concurrency = 1);
+
+    /// \brief Starts saving the hashes of nodes before they first change.
+    /// \details Discards the hashes saved for any snapshot taken before.
+    void begin_snapshot(void);
+
+    /// \brief Restores the hashes of all nodes changed since begin_snapshot() and stops saving them.
+    /// \details Nodes created since then are kept, with the hash of pristine data.
+    void rollback_snapshot(void);
+
+    /// \brief Discards the hashes saved since begin_snapshot() and stops saving them.
+    void end_snapshot(void);
 
     /// \brief Returns the proof for a node in the tree.
     /// \param target_address Address of target node. Must be aligned
@@ -337,12 +483,40 @@ public:
     /// \returns Proof if successful, otherwise throws exception.
     proof_type get_proof(address_type target_address, int log2_target_size, const unsigned char *page_data) const;
 
+    /// \brief Returns the multiproof for several nodes in the tree.
+    /// \param target_addresses Addresses of target nodes, sorted and without duplicates. Each must be
+    /// aligned to a 2<sup>log2_target_size</sup> boundary.
+    /// \param log2_target_size log<sub>2</sub> of size subintended by
+    /// each target node. Must be between LOG2_WORD_SIZE and LOG2_ROOT_SIZE,
+    /// inclusive.
+    /// \param get_page_data When log2_target_size smaller than LOG2_PAGE_SIZE,
+    /// called once for each page containing targets, with the page address.
+    /// \returns Multiproof if successful, otherwise throws exception.
+    /// \details Sibling hashes shared by paths to several targets are included only once,
+    /// and are all collected in a single traversal of the tree.
+    multiproof_type get_multiproof(const std::vector<address_type> &target_addresses, int log2_target_size,
+        const page_data_getter &get_page_data) const;
+
     /// \brief Recursively builds hash for page node from contiguous memory.
     /// \param h Hasher object.
     /// \param page_data Pointer to start of contiguous page data.
     /// \param hash Receives the hash.
     void get_page_node_hash(hasher_type &h, const unsigned char *page_data, hash_type &hash) const;
 
+    /// \brief Builds hash for page node from contiguous memory, going through the page hash cache.
+    /// \param h Hasher object.
+    /// \param page_address Address of page.
+    /// \param page_data Pointer to start of contiguous page data.
+    /// \param hash Receives the hash.
+    /// \details Meant for pages that are hashed again and again after changes to a few words.
+    /// Unlike the other overloads, this one is not safe to call from several threads at once.
+    void get_page_node_hash(hasher_type &h, address_type page_address, const unsigned char *page_data,
+        hash_type &hash) const;
+
+    /// \brief Sets the number of pages whose inner hashes are cached.
+    /// \param size Number of pages, or 0 to disable the cache.
+    void set_page_hash_cache_size(size_t size);
+
     /// \brief Gets currently stored hash for page node.
     /// \param page_index Page index for node.
     /// \param hash Receives the hash.
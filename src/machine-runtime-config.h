@@ -25,6 +25,7 @@ namespace cartesi {
 /// \brief Concurrency runtime configuration
 struct concurrency_runtime_config {
     uint64_t update_merkle_tree{};
+    uint64_t verify_uarch_step{};
 };
 
 /// \brief HTIF runtime configuration
@@ -32,10 +33,19 @@ struct htif_runtime_config {
     bool no_console_putchar;
 };
 
+/// \brief Host TLB runtime configuration
+struct host_tlb_runtime_config {
+    uint64_t size{}; ///< Number of entries of each type, or 0 to disable the host TLB
+    uint64_t ways{}; ///< Number of entries in each set (1, 2, or 4)
+};
+
 /// \brief Machine runtime configuration
 struct machine_runtime_config {
     concurrency_runtime_config concurrency{};
     htif_runtime_config htif{};
+    host_tlb_runtime_config host_tlb{};
+    uint64_t page_hash_cache_size{};
+    bool map_ram_image{};
     bool skip_root_hash_check{};
     bool skip_version_check{};
 };
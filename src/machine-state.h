@@ -20,6 +20,8 @@
 /// \file
 /// \brief Cartesi machine state structure definition.
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <iostream>
@@ -30,6 +32,8 @@
 
 #include <boost/container/static_vector.hpp>
 
+#include "decoded-insn-cache.h"
+#include "host-tlb.h"
 #include "machine-statistics.h"
 #include "pma.h"
 #include "riscv-constants.h"
@@ -44,6 +48,69 @@ struct unpacked_iflags {
     bool H;      ///< CPU has been permanently halted.
 };               ///< Cartesi-specific unpacked CSR iflags.
 
+/// \brief Index of the PMA entries sorted by start address
+/// \details Finds the entry containing a physical memory range with a binary search,
+/// instead of a linear scan over all entries. Entries never overlap, so the only
+/// candidate is the entry with the largest start that does not exceed the address.
+class pma_lookup_table {
+    std::array<uint64_t, PMA_MAX> m_start{};  ///< Start of each non-empty entry, in increasing order
+    std::array<uint64_t, PMA_MAX> m_length{}; ///< Length of each non-empty entry, in the same order
+    std::array<int, PMA_MAX> m_index{};       ///< Position of each non-empty entry in the PMA array
+    int m_count{0};                           ///< Number of non-empty entries
+    int m_sentinel{0};                        ///< Position of the sentinel in the PMA array
+
+public:
+    /// \brief Rebuilds the index from the PMA array
+    /// \tparam CONTAINER Container of PMA entries
+    /// \param pmas PMA array, ending with the sentinel
+    /// \details Entries after the first empty entry are ignored, just like in a linear scan.
+    template <typename CONTAINER>
+    void build(const CONTAINER &pmas) {
+        std::array<int, PMA_MAX> order{};
+        m_count = 0;
+        m_sentinel = static_cast<int>(pmas.size()) - 1;
+        for (int i = 0; i < static_cast<int>(pmas.size()); ++i) {
+            if (pmas[i].get_length() == 0) {
+                m_sentinel = i;
+                break;
+            }
+            order[m_count++] = i;
+        }
+        std::sort(order.begin(), order.begin() + m_count,
+            [&pmas](int a, int b) { return pmas[a].get_start() < pmas[b].get_start(); });
+        for (int j = 0; j < m_count; ++j) {
+            m_start[j] = pmas[order[j]].get_start();
+            m_length[j] = pmas[order[j]].get_length();
+            m_index[j] = order[j];
+        }
+    }
+
+    /// \brief Finds the entry containing a physical memory range
+    /// \param paddr Start of range
+    /// \param length Length of range
+    /// \returns Position of the entry in the PMA array, or of the sentinel if no entry contains the range
+    int find(uint64_t paddr, uint64_t length) const {
+        if (m_count == 0 || paddr < m_start[0]) {
+            return m_sentinel;
+        }
+        // Find the last entry whose start is at most paddr
+        int first = 0;
+        int n = m_count;
+        while (n > 1) {
+            const int half = n / 2;
+            if (m_start[first + half] <= paddr) {
+                first += half;
+            }
+            n -= half;
+        }
+        // Same overflow-safe order of operations used by the linear scans
+        if (m_length[first] >= length && paddr - m_start[first] <= m_length[first] - length) {
+            return m_index[first];
+        }
+        return m_sentinel;
+    }
+};
+
 /// \brief Machine state.
 /// \details The machine_state structure contains the entire
 /// state of a Cartesi machine.
@@ -122,6 +189,12 @@ struct machine_state {
 
     // Entries below this mark are not needed in the blockchain
 
+    pma_lookup_table pma_lookup; ///< Sorted index of pmas, rebuilt whenever the array changes
+
+    decoded_insn_cache dcache; ///< Decoded instruction cache
+
+    host_tlb_state host_tlb; ///< Host TLB, consulted on shadow TLB misses
+
 #ifdef DUMP_COUNTERS
     machine_statistics stats;
 #endif
@@ -56,6 +56,12 @@ struct machine_statistics {
     uint64_t tlb_flush_fence_vma_asid;       ///< Counts TLB flush originated from SFENCE.VMA (asid)
     uint64_t tlb_flush_fence_vma_vaddr;      ///< Counts TLB flush originated from SFENCE.VMA (vaddr)
     uint64_t tlb_flush_fence_vma_asid_vaddr; ///< Counts TLB flush originated originated from SFENCE.VMA (vaddr,asid)
+    uint64_t host_tlb_hit;                   ///< Counts host TLB hits after shadow TLB misses
+    uint64_t host_tlb_miss;                  ///< Counts host TLB misses after shadow TLB misses
+
+    // Decoded instruction cache
+    uint64_t dcache_hit;  ///< Counts decoded instruction cache hits
+    uint64_t dcache_miss; ///< Counts decoded instruction cache misses
 };
 
 #ifdef DUMP_COUNTERS
@@ -0,0 +1,276 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef MACHINE_TRANSACTION_H
+#define MACHINE_TRANSACTION_H
+
+/// \file
+/// \brief Runs a sequence of machine operations described in JSON
+/// \details A transaction is a JSON array of operations. Each operation is an object with a "method" field, naming
+/// a machine method, and optional "params", with its arguments given as in the JSONRPC interface (by position in an
+/// array, or by name in an object). An argument of the form {"$result": i} is replaced by the result of the i-th
+/// operation in the transaction (counting from 0), which must have run before. The result of a transaction is a JSON array with the result of each
+/// operation (true for methods that return nothing). Operations run in order, and the first one to fail fails
+/// the transaction. The effects of operations that ran before it are not undone.
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include "json-util.h"
+#include "jsonrpc-params.h"
+#include "riscv-constants.h"
+
+namespace cartesi {
+
+/// \brief Replaces references to results of earlier operations in the arguments of an operation
+/// \param params JSON array or object with arguments
+/// \param results JSON array with results of earlier operations
+/// \param path Path to params, for error messages
+/// \returns JSON array or object with arguments
+inline nlohmann::json transaction_resolve_params(const nlohmann::json &params, const nlohmann::json &results,
+    const std::string &path) {
+    if (!params.is_array() && !params.is_object()) {
+        throw std::invalid_argument("\""s + path + "\" field not object or array"s);
+    }
+    nlohmann::json resolved = params;
+    for (auto &param : resolved) {
+        if (param.is_object() && param.contains("$result")) {
+            const auto &index = param["$result"];
+            if (!index.is_number_unsigned() || index.get<uint64_t>() >= results.size()) {
+                throw std::invalid_argument("field \""s + path + "\" refers to result of operation that has "s +
+                    "not run before");
+            }
+            param = results[index.get<uint64_t>()];
+        }
+    }
+    return resolved;
+}
+
+/// \brief Gets a register index argument and checks that it is in range
+/// \param index Index argument
+/// \param count Number of registers
+/// \returns Register index
+inline int transaction_get_reg_index(uint64_t index, int count) {
+    if (index >= static_cast<uint64_t>(count)) {
+        throw std::domain_error{"index out of range"};
+    }
+    return static_cast<int>(index);
+}
+
+/// \brief Machine method that can run in a transaction
+/// \tparam MACHINE Either machine or i_virtual_machine
+/// \param m Machine to run method on
+/// \param j JSONRPC request, or any object with a params field, with the arguments
+/// \param path Path to params, for error messages
+/// \returns JSON with the result (true for methods that return nothing)
+/// \details The JSONRPC server runs the same methods, so arguments and results are the same in both.
+template <typename MACHINE>
+using transaction_method = nlohmann::json (*)(MACHINE &m, const nlohmann::json &j, const std::string &path);
+
+/// \brief Finds a machine method that can run in a transaction
+/// \tparam MACHINE Either machine or i_virtual_machine
+/// \param name Name of method, without the "machine." prefix of the JSONRPC interface
+/// \returns Method, or nullptr if there is no such method
+template <typename MACHINE>
+transaction_method<MACHINE> find_transaction_method(const std::string &name) {
+    using json = nlohmann::json;
+    static const std::unordered_map<std::string, transaction_method<MACHINE>> methods = {
+        {"run",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"mcycle_end"};
+                auto [mcycle_end] = parse_args<uint64_t>(j, param_name, path);
+                return m.run(mcycle_end);
+            }},
+        {"run_uarch",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"uarch_cycle_end"};
+                auto [uarch_cycle_end] = parse_args<uint64_t>(j, param_name, path);
+                return m.run_uarch(uarch_cycle_end);
+            }},
+        {"reset_uarch",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                jsonrpc_check_no_params(j, path);
+                m.reset_uarch();
+                return true;
+            }},
+        {"get_root_hash",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                jsonrpc_check_no_params(j, path);
+                machine_merkle_tree::hash_type hash;
+                m.get_root_hash(hash);
+                return encode_base64(hash);
+            }},
+        {"read_word",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"address"};
+                auto [address] = parse_args<uint64_t>(j, param_name, path);
+                return m.read_word(address);
+            }},
+        {"read_memory",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"address", "length"};
+                auto [address, length] = parse_args<uint64_t, uint64_t>(j, param_name, path);
+                std::string data(length, '\0');
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+                m.read_memory(address, reinterpret_cast<unsigned char *>(data.data()), length);
+                return encode_base64(data);
+            }},
+        {"write_memory",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"address", "data"};
+                auto [address, b64] = parse_args<uint64_t, std::string>(j, param_name, path);
+                auto data = decode_base64(b64);
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+                m.write_memory(address, reinterpret_cast<const unsigned char *>(data.data()), data.size());
+                return true;
+            }},
+        {"read_virtual_memory",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"address", "length"};
+                auto [address, length] = parse_args<uint64_t, uint64_t>(j, param_name, path);
+                std::string data(length, '\0');
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+                m.read_virtual_memory(address, reinterpret_cast<unsigned char *>(data.data()), length);
+                return encode_base64(data);
+            }},
+        {"write_virtual_memory",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"address", "data"};
+                auto [address, b64] = parse_args<uint64_t, std::string>(j, param_name, path);
+                auto data = decode_base64(b64);
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+                m.write_virtual_memory(address, reinterpret_cast<const unsigned char *>(data.data()), data.size());
+                return true;
+            }},
+        {"read_csr",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"csr"};
+                auto [r] = parse_args<machine::csr>(j, param_name, path);
+                return m.read_csr(r);
+            }},
+        {"write_csr",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"csr", "value"};
+                auto [w, val] = parse_args<machine::csr, uint64_t>(j, param_name, path);
+                m.write_csr(w, val);
+                return true;
+            }},
+        {"read_x",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"index"};
+                auto [index] = parse_args<uint64_t>(j, param_name, path);
+                return m.read_x(transaction_get_reg_index(index, X_REG_COUNT));
+            }},
+        {"write_x",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"index", "value"};
+                auto [index, val] = parse_args<uint64_t, uint64_t>(j, param_name, path);
+                if (index == 0) {
+                    throw std::domain_error{"index out of range"};
+                }
+                m.write_x(transaction_get_reg_index(index, X_REG_COUNT), val);
+                return true;
+            }},
+        {"read_f",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"index"};
+                auto [index] = parse_args<uint64_t>(j, param_name, path);
+                return m.read_f(transaction_get_reg_index(index, F_REG_COUNT));
+            }},
+        {"write_f",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                static const char *param_name[] = {"index", "value"};
+                auto [index, val] = parse_args<uint64_t, uint64_t>(j, param_name, path);
+                m.write_f(transaction_get_reg_index(index, F_REG_COUNT), val);
+                return true;
+            }},
+        {"read_iflags_H",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                jsonrpc_check_no_params(j, path);
+                return m.read_iflags_H();
+            }},
+        {"read_iflags_Y",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                jsonrpc_check_no_params(j, path);
+                return m.read_iflags_Y();
+            }},
+        {"set_iflags_Y",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                jsonrpc_check_no_params(j, path);
+                m.set_iflags_Y();
+                return true;
+            }},
+        {"reset_iflags_Y",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                jsonrpc_check_no_params(j, path);
+                m.reset_iflags_Y();
+                return true;
+            }},
+        {"read_iflags_X",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                jsonrpc_check_no_params(j, path);
+                return m.read_iflags_X();
+            }},
+        {"reset_iflags_X",
+            [](MACHINE &m, const json &j, const std::string &path) -> json {
+                jsonrpc_check_no_params(j, path);
+                m.reset_iflags_X();
+                return true;
+            }},
+    };
+    auto found = methods.find(name);
+    return found != methods.end() ? found->second : nullptr;
+}
+
+/// \brief Runs a transaction on a machine
+/// \tparam MACHINE Either machine or i_virtual_machine
+/// \param m Machine to run operations on
+/// \param operations JSON array with operations
+/// \returns JSON array with the result of each operation
+template <typename MACHINE>
+nlohmann::json run_transaction(MACHINE &m, const nlohmann::json &operations) {
+    using json = nlohmann::json;
+    if (!operations.is_array()) {
+        throw std::invalid_argument("operations not an array");
+    }
+    json results = json::array();
+    for (const auto &op : operations) {
+        const std::string path = "operations/"s + std::to_string(results.size()) + "/"s;
+        if (!op.is_object()) {
+            throw std::invalid_argument("field \""s + path + "\" not an object");
+        }
+        std::string method;
+        ju_get_field(op, "method"s, method, path);
+        const auto run_method = find_transaction_method<MACHINE>(method);
+        if (!run_method) {
+            throw std::invalid_argument("field \""s + path + "method\" has unsupported method \""s + method + "\""s);
+        }
+        // Methods take their arguments from the params field, just like JSONRPC requests
+        json request = json::object();
+        if (op.contains("params")) {
+            request["params"] = transaction_resolve_params(op["params"], results, path + "params"s);
+        }
+        results.push_back(run_method(m, request, path + "params"s));
+    }
+    return results;
+}
+
+} // namespace cartesi
+
+#endif
@@ -14,17 +14,27 @@
 // with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
+#include <array>
 #include <boost/range/adaptor/sliced.hpp>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
+#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <unordered_map>
 
 #include "clint-factory.h"
+#include "concat-hash-cache.h"
 #include "dtb.h"
 #include "htif-factory.h"
 #include "interpret.h"
+#include "is-pristine.h"
 #include "machine.h"
 #include "riscv-constants.h"
 #include "rtc.h"
@@ -217,6 +227,94 @@ static bool DID_is_protected(PMA_ISTART_DID DID) {
     }
 }
 
+struct machine::snapshot_state {
+    uint64_t mcycle;
+    uint64_t pc;
+    std::array<uint64_t, X_REG_COUNT> x;
+    uint64_t fcsr;
+    std::array<uint64_t, F_REG_COUNT> f;
+    uint64_t icycleinstret;
+    uint64_t mstatus;
+    uint64_t mtvec;
+    uint64_t mscratch;
+    uint64_t mepc;
+    uint64_t mcause;
+    uint64_t mtval;
+    uint64_t misa;
+    uint64_t mie;
+    uint64_t mip;
+    uint64_t medeleg;
+    uint64_t mideleg;
+    uint64_t mcounteren;
+    uint64_t menvcfg;
+    uint64_t stvec;
+    uint64_t sscratch;
+    uint64_t sepc;
+    uint64_t scause;
+    uint64_t stval;
+    uint64_t satp;
+    uint64_t scounteren;
+    uint64_t senvcfg;
+    uint64_t ilrsc;
+    unpacked_iflags iflags;
+    decltype(machine_state::clint) clint;
+    shadow_tlb_state tlb;
+    decltype(machine_state::htif) htif;
+    struct {
+        uint64_t pc;
+        std::array<uint64_t, UARCH_X_REG_COUNT> x;
+        uint64_t cycle;
+        bool halt_flag;
+    } uarch;
+    std::vector<std::pair<int, pma_entry>> replaced_pmas; ///< Memory ranges replaced since the snapshot, by index
+};
+
+/// \brief Copies the registers of a machine state to or from a snapshot
+template <typename FROM, typename TO>
+static void copy_registers(const FROM &from, TO &to) {
+    to.mcycle = from.mcycle;
+    to.pc = from.pc;
+    to.x = from.x;
+    to.fcsr = from.fcsr;
+    to.f = from.f;
+    to.icycleinstret = from.icycleinstret;
+    to.mstatus = from.mstatus;
+    to.mtvec = from.mtvec;
+    to.mscratch = from.mscratch;
+    to.mepc = from.mepc;
+    to.mcause = from.mcause;
+    to.mtval = from.mtval;
+    to.misa = from.misa;
+    to.mie = from.mie;
+    to.mip = from.mip;
+    to.medeleg = from.medeleg;
+    to.mideleg = from.mideleg;
+    to.mcounteren = from.mcounteren;
+    to.menvcfg = from.menvcfg;
+    to.stvec = from.stvec;
+    to.sscratch = from.sscratch;
+    to.sepc = from.sepc;
+    to.scause = from.scause;
+    to.stval = from.stval;
+    to.satp = from.satp;
+    to.scounteren = from.scounteren;
+    to.senvcfg = from.senvcfg;
+    to.ilrsc = from.ilrsc;
+    to.iflags = from.iflags;
+    to.clint = from.clint;
+    to.tlb = from.tlb;
+    to.htif = from.htif;
+}
+
+/// \brief Copies the registers of a microarchitecture state to or from a snapshot
+template <typename FROM, typename TO>
+static void copy_uarch_registers(const FROM &from, TO &to) {
+    to.pc = from.pc;
+    to.x = from.x;
+    to.cycle = from.cycle;
+    to.halt_flag = from.halt_flag;
+}
+
 void machine::replace_memory_range(const memory_range_config &range) {
     for (auto &pma : m_s.pmas) {
         if (pma.get_start() == range.start && pma.get_length() == range.length) {
@@ -225,13 +323,79 @@ void machine::replace_memory_range(const memory_range_config &range) {
                 throw std::invalid_argument{"attempt to replace a protected range "s + pma.get_description()};
             }
             // replace range preserving original flags
-            pma = make_memory_range_pma_entry(pma.get_description(), range).set_flags(pma.get_flags());
+            auto new_pma = make_memory_range_pma_entry(pma.get_description(), range).set_flags(pma.get_flags());
+            // keep the range as it was when the snapshot was taken, so rollback can bring it back
+            if (m_snapshot) {
+                const int index = static_cast<int>(&pma - m_s.pmas.data());
+                auto &replaced = m_snapshot->replaced_pmas;
+                const auto same_index = [index](const auto &r) { return r.first == index; };
+                if (std::none_of(replaced.begin(), replaced.end(), same_index)) {
+                    replaced.emplace_back(index, std::move(pma));
+                }
+            }
+            pma = std::move(new_pma);
+            m_s.pma_lookup.build(m_s.pmas);
+            // Host TLB entries may point into the memory of the range just replaced
+            m_s.host_tlb.flush();
             return;
         }
     }
     throw std::invalid_argument{"attempt to replace inexistent memory range"};
 }
 
+void machine::snapshot(void) {
+    if (m_snapshot) {
+        commit();
+    }
+    // Saved pages are restored as clean, so the Merkle tree must be up to date with their contents
+    if (!update_merkle_tree()) {
+        throw std::runtime_error{"error updating Merkle tree"};
+    }
+    auto s = std::make_unique<snapshot_state>();
+    copy_registers(m_s, *s);
+    copy_uarch_registers(m_uarch.get_state(), s->uarch);
+    m_t.begin_snapshot();
+    for (auto *pma : m_pmas) {
+        pma->begin_snapshot();
+    }
+    m_snapshot = std::move(s);
+    // Pages already in the write TLB will be written to without being marked dirty, so save them now
+    mark_write_tlb_dirty_pages();
+}
+
+void machine::rollback(void) {
+    if (!m_snapshot) {
+        throw std::runtime_error{"no snapshot to roll back to"};
+    }
+    // Bring back replaced memory ranges first, so the pages they saved are also restored
+    if (!m_snapshot->replaced_pmas.empty()) {
+        for (auto &[index, pma] : m_snapshot->replaced_pmas) {
+            m_s.pmas[index] = std::move(pma);
+        }
+        m_s.pma_lookup.build(m_s.pmas);
+    }
+    for (auto *pma : m_pmas) {
+        pma->rollback_snapshot();
+    }
+    m_t.rollback_snapshot();
+    copy_registers(*m_snapshot, m_s);
+    copy_uarch_registers(m_snapshot->uarch, m_uarch.get_state());
+    // Host TLB entries may point into the memory of ranges replaced since the snapshot
+    m_s.host_tlb.flush();
+    m_snapshot.reset();
+}
+
+void machine::commit(void) {
+    if (!m_snapshot) {
+        throw std::runtime_error{"no snapshot to commit"};
+    }
+    for (auto *pma : m_pmas) {
+        pma->end_snapshot();
+    }
+    m_t.end_snapshot();
+    m_snapshot.reset();
+}
+
 template <TLB_entry_type ETYPE>
 static void load_tlb_entry(machine &m, uint64_t eidx, unsigned char *hmem) {
     tlb_hot_entry &tlbhe = m.get_state().tlb.hot[ETYPE][eidx];
@@ -307,6 +471,9 @@ machine::machine(const machine_config &c, const machine_runtime_config &r) :
         throw std::invalid_argument{"mimpid mismatch, emulator version is incompatible"};
     }
 
+    m_s.host_tlb.configure(r.host_tlb.size, r.host_tlb.ways);
+    m_t.set_page_hash_cache_size(r.page_hash_cache_size);
+
     // General purpose registers
     for (int i = 1; i < X_REG_COUNT; i++) {
         write_x(i, m_c.processor.x[i]);
@@ -348,6 +515,9 @@ machine::machine(const machine_config &c, const machine_runtime_config &r) :
     // Register RAM
     if (m_c.ram.image_filename.empty()) {
         register_pma_entry(make_callocd_memory_pma_entry("RAM"s, PMA_RAM_START, m_c.ram.length).set_flags(m_ram_flags));
+    } else if (r.map_ram_image) {
+        register_pma_entry(make_lazy_memory_pma_entry("RAM"s, PMA_RAM_START, m_c.ram.length, m_c.ram.image_filename)
+                               .set_flags(m_ram_flags));
     } else {
         register_pma_entry(make_callocd_memory_pma_entry("RAM"s, PMA_RAM_START, m_c.ram.length, m_c.ram.image_filename)
                                .set_flags(m_ram_flags));
@@ -434,11 +604,15 @@ machine::machine(const machine_config &c, const machine_runtime_config &r) :
     if (m_c.dtb.image_filename.empty()) {
         // Write the FDT (flattened device tree) into DTB
         dtb_init(m_c, dtb.get_memory().get_host_memory(), PMA_DTB_LENGTH);
+        dtb.mark_dirty_pages(dtb.get_start(), PMA_DTB_LENGTH);
     }
 
     // Add sentinel to PMA vector
     register_pma_entry(make_empty_pma_entry("sentinel"s, 0, 0));
 
+    // Index the PMA vector for fast lookups
+    m_s.pma_lookup.build(m_s.pmas);
+
     // Initialize the vector of the pmas used by the merkle tree to compute hashes.
     // First, add the pmas visible to the big machine, except the sentinel
     for (auto &pma : m_s.pmas | sliced(0, m_s.pmas.size() - 1)) {
@@ -452,6 +626,11 @@ machine::machine(const machine_config &c, const machine_runtime_config &r) :
     // Last, add sentinel
     m_pmas.push_back(&m_s.empty_pma);
 
+    // Give each PMA a flat index of page nodes in the Merkle tree
+    for (const auto *pma : m_pmas) {
+        m_t.add_page_range(pma->get_start(), pma->get_length());
+    }
+
     // Initialize TLB device
     // this must be done after all PMA entries are already registered, so we can lookup page addresses
     if (!m_c.tlb.image_filename.empty()) {
@@ -496,17 +675,188 @@ static void load_hash(const std::string &dir, machine::hash_type &h) {
     }
 }
 
+/// \brief Header of the files with per-page data stored with a machine.
+/// \details The header is followed by \p count entries, each with a page address and data about the page.
+struct page_file_header {
+    std::array<char, 8> magic; ///< Identifies the kind of file
+    uint32_t version;          ///< Version of the file format
+    uint32_t log2_page_size;   ///< log<sub>2</sub> of the page size
+    uint64_t count;            ///< Number of entries
+};
+
+/// \brief Magic of the file with the hash of each non-pristine page in memory ranges
+static constexpr std::array<char, 8> PAGE_HASHES_MAGIC{'C', 'M', 'P', 'G', 'H', 'A', 'S', 'H'};
+/// \brief Magic of the file with the contents of each page that changed since the base of a delta
+static constexpr std::array<char, 8> DELTA_PAGES_MAGIC{'C', 'M', 'D', 'E', 'L', 'T', 'A', 'S'};
+static constexpr uint32_t PAGE_FILE_VERSION = 1;
+/// \brief Number of pages hashed again to check the stored page hashes
+static constexpr uint64_t PAGE_HASHES_SAMPLE_SIZE = 256;
+
+static void write_page_file_header(FILE *fp, const std::string &name, const std::array<char, 8> &magic,
+    uint64_t count) {
+    const page_file_header header{magic, PAGE_FILE_VERSION, machine_merkle_tree::get_log2_page_size(), count};
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        throw std::runtime_error{"error writing to '" + name + "'"};
+    }
+}
+
+/// \brief Reads the header of a page file
+/// \returns False if the file has another magic, version, or page size
+static bool read_page_file_header(FILE *fp, const std::string &name, const std::array<char, 8> &magic,
+    uint64_t &count) {
+    page_file_header header{};
+    if (fread(&header, sizeof(header), 1, fp) != 1) {
+        throw std::runtime_error{"error reading from '" + name + "'"};
+    }
+    if (header.magic != magic || header.version != PAGE_FILE_VERSION ||
+        header.log2_page_size != machine_merkle_tree::get_log2_page_size()) {
+        return false;
+    }
+    count = header.count;
+    return true;
+}
+
+/// \brief Reads the page hashes stored with a machine
+/// \returns False if there are no page hashes in a supported format
+static bool read_page_hashes(const std::string &dir, std::vector<std::pair<uint64_t, machine::hash_type>> &hashes) {
+    auto name = dir + "/page-hashes";
+    auto fp = unique_fopen(name.c_str(), "rb", std::nothrow_t{});
+    // Machines stored by older versions have no page hashes
+    if (!fp) {
+        return false;
+    }
+    uint64_t count = 0;
+    if (!read_page_file_header(fp.get(), name, PAGE_HASHES_MAGIC, count)) {
+        return false;
+    }
+    hashes.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t page_address = 0;
+        machine::hash_type hash;
+        if (fread(&page_address, sizeof(page_address), 1, fp.get()) != 1 ||
+            fread(hash.data(), 1, hash.size(), fp.get()) != hash.size()) {
+            throw std::runtime_error{"error reading from '" + name + "'"};
+        }
+        hashes.emplace_back(page_address, hash);
+    }
+    return true;
+}
+
+void machine::store_page_hashes(const std::string &dir) const {
+    const auto &pristine_hash = machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+    std::vector<std::pair<uint64_t, hash_type>> page_hashes;
+    for (const auto *pma : m_pmas) {
+        if (!pma->get_istart_M() || pma->get_istart_E()) {
+            continue;
+        }
+        for (uint64_t page_start_in_range = 0; page_start_in_range < pma->get_length();
+             page_start_in_range += PMA_PAGE_SIZE) {
+            const uint64_t page_address = pma->get_start() + page_start_in_range;
+            hash_type hash;
+            m_t.get_page_node_hash(page_address, hash);
+            // Pages missing from the file are pristine
+            if (hash != pristine_hash) {
+                page_hashes.emplace_back(page_address, hash);
+            }
+        }
+    }
+    auto name = dir + "/page-hashes";
+    auto fp = unique_fopen(name.c_str(), "wb");
+    write_page_file_header(fp.get(), name, PAGE_HASHES_MAGIC, page_hashes.size());
+    for (const auto &[page_address, hash] : page_hashes) {
+        if (fwrite(&page_address, sizeof(page_address), 1, fp.get()) != 1 ||
+            fwrite(hash.data(), 1, hash.size(), fp.get()) != hash.size()) {
+            throw std::runtime_error{"error writing to '" + name + "'"};
+        }
+    }
+}
+
+bool machine::load_page_hashes(const std::string &dir) {
+    std::vector<std::pair<uint64_t, hash_type>> page_hashes;
+    if (!read_page_hashes(dir, page_hashes)) {
+        return false;
+    }
+    machine_merkle_tree::hasher_type gh;
+    m_t.begin_update();
+    for (const auto &[page_address, hash] : page_hashes) {
+        const auto &pma = find_pma_entry(m_pmas, page_address, PMA_PAGE_SIZE);
+        if (!pma.get_istart_M() || pma.get_istart_E() || (page_address & (PMA_PAGE_SIZE - 1)) != 0) {
+            m_t.end_update(gh);
+            throw std::runtime_error{"invalid page address in '" + dir + "/page-hashes'"};
+        }
+        if (!m_t.update_page_node_hash(page_address, hash)) {
+            m_t.end_update(gh);
+            throw std::runtime_error{"error updating Merkle tree"};
+        }
+    }
+    if (!m_t.end_update(gh)) {
+        throw std::runtime_error{"error updating Merkle tree"};
+    }
+    for (auto *pma : m_pmas) {
+        pma->mark_pages_clean();
+    }
+    // Leave a sample of the pages dirty, so they are hashed again and checked against the stored root hash
+    const uint64_t stride = std::max(page_hashes.size() / PAGE_HASHES_SAMPLE_SIZE, UINT64_C(1));
+    for (uint64_t i = 0; i < page_hashes.size(); i += stride) {
+        const uint64_t page_address = page_hashes[i].first;
+        auto &pma = find_pma_entry(m_pmas, page_address, PMA_PAGE_SIZE);
+        pma.mark_dirty_page(page_address - pma.get_start());
+    }
+    return true;
+}
+
+void machine::load_delta_pages(const std::string &dir) {
+    // Deltas are layered in the order they were stored, over the images of the full machine at the root
+    const auto chain = machine_config::load_base_chain(dir);
+    std::vector<unsigned char> page(PMA_PAGE_SIZE);
+    for (auto it = std::next(chain.rbegin()); it != chain.rend(); ++it) {
+        auto name = *it + "/delta-pages";
+        auto fp = unique_fopen(name.c_str(), "rb");
+        uint64_t count = 0;
+        if (!read_page_file_header(fp.get(), name, DELTA_PAGES_MAGIC, count)) {
+            throw std::runtime_error{"unsupported format in '" + name + "'"};
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t page_address = 0;
+            if (fread(&page_address, sizeof(page_address), 1, fp.get()) != 1 ||
+                fread(page.data(), 1, page.size(), fp.get()) != page.size()) {
+                throw std::runtime_error{"error reading from '" + name + "'"};
+            }
+            auto &pma = find_pma_entry(m_pmas, page_address, PMA_PAGE_SIZE);
+            if (!pma.get_istart_M() || pma.get_istart_E() || (page_address & (PMA_PAGE_SIZE - 1)) != 0) {
+                throw std::runtime_error{"invalid page address in '" + name + "'"};
+            }
+            pma.write_memory(page_address, page.data(), page.size());
+        }
+    }
+}
+
 machine::machine(const std::string &dir, const machine_runtime_config &r) : machine{machine_config::load(dir), r} {
+    load_delta_pages(dir);
     if (r.skip_root_hash_check) {
         return;
     }
     hash_type hstored;
     hash_type hrestored;
     load_hash(dir, hstored);
+    // Reusing the stored page hashes spares hashing every page again
+    const bool page_hashes_loaded = load_page_hashes(dir);
     if (!update_merkle_tree()) {
         throw std::runtime_error{"error updating Merkle tree"};
     }
     m_t.get_root_hash(hrestored);
+    if (hstored != hrestored && page_hashes_loaded) {
+        // The stored page hashes may be stale, so hash all pages again before giving up
+        for (auto *pma : m_pmas) {
+            if (pma->get_istart_M() && !pma->get_istart_E()) {
+                pma->mark_dirty_pages(pma->get_start(), pma->get_length());
+            }
+        }
+        if (!update_merkle_tree()) {
+            throw std::runtime_error{"error updating Merkle tree"};
+        }
+        m_t.get_root_hash(hrestored);
+    }
     if (hstored != hrestored) {
         throw std::runtime_error{"stored and restored hashes do not match"};
     }
@@ -596,23 +946,20 @@ static void store_device_pma(const machine &m, const pma_entry &pma, const std::
     }
     auto scratch = unique_calloc<unsigned char>(PMA_PAGE_SIZE); // will throw if it fails
     auto name = machine_config::get_image_filename(dir, pma.get_start(), pma.get_length());
-    auto fp = unique_fopen(name.c_str(), "wb");
+    // Gather all pages, so pages that are all zeros can be left as holes in the file
+    std::vector<unsigned char> data(pma.get_length());
     for (uint64_t page_start_in_range = 0; page_start_in_range < pma.get_length();
          page_start_in_range += PMA_PAGE_SIZE) {
         const unsigned char *page_data = nullptr;
         auto peek = pma.get_peek();
         if (!peek(pma, m, page_start_in_range, &page_data, scratch.get())) {
             throw std::runtime_error{"peek failed"};
-        } else {
-            if (!page_data) {
-                memset(scratch.get(), 0, PMA_PAGE_SIZE);
-                page_data = scratch.get();
-            }
-            if (fwrite(page_data, 1, PMA_PAGE_SIZE, fp.get()) != PMA_PAGE_SIZE) {
-                throw std::system_error{errno, std::generic_category(), "error writing to '" + name + "'"};
-            }
+        }
+        if (page_data) {
+            memcpy(data.data() + page_start_in_range, page_data, PMA_PAGE_SIZE);
         }
     }
+    os_write_sparse_file(name.c_str(), data.data(), data.size(), PMA_PAGE_SIZE);
 }
 
 static void store_memory_pma(const pma_entry &pma, const std::string &dir) {
@@ -620,11 +967,8 @@ static void store_memory_pma(const pma_entry &pma, const std::string &dir) {
         throw std::runtime_error{"attempt to save non-memory PMA"};
     }
     auto name = machine_config::get_image_filename(dir, pma.get_start(), pma.get_length());
-    auto fp = unique_fopen(name.c_str(), "wb");
-    const pma_memory &mem = pma.get_memory();
-    if (fwrite(mem.get_host_memory(), 1, pma.get_length(), fp.get()) != pma.get_length()) {
-        throw std::runtime_error{"error writing to '" + name + "'"};
-    }
+    // Pages that are all zeros are left as holes in the file, so mostly zero ranges take little disk space
+    os_write_sparse_file(name.c_str(), pma.get_memory().get_host_memory(), pma.get_length(), PMA_PAGE_SIZE);
 }
 
 pma_entry &machine::find_pma_entry(uint64_t paddr, size_t length) {
@@ -633,7 +977,7 @@ pma_entry &machine::find_pma_entry(uint64_t paddr, size_t length) {
 }
 
 const pma_entry &machine::find_pma_entry(uint64_t paddr, size_t length) const {
-    return find_pma_entry(m_s.pmas, paddr, length);
+    return m_s.pmas[m_s.pma_lookup.find(paddr, length)];
 }
 
 template <typename CONTAINER>
@@ -711,11 +1055,170 @@ void machine::store(const std::string &dir) const {
     hash_type h;
     m_t.get_root_hash(h);
     store_hash(h, dir);
+    store_page_hashes(dir);
     auto c = get_serialization_config();
     c.store(dir);
     store_pmas(c, dir);
 }
 
+static bool has_same_memory_ranges(const machine_config &a, const machine_config &b) {
+    const auto same = [](const memory_range_config &x, const memory_range_config &y) {
+        return x.start == y.start && x.length == y.length;
+    };
+    if (a.ram.length != b.ram.length || a.flash_drive.size() != b.flash_drive.size() ||
+        a.rollup.has_value() != b.rollup.has_value()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.flash_drive.size(); ++i) {
+        if (!same(a.flash_drive[i], b.flash_drive[i])) {
+            return false;
+        }
+    }
+    if (a.rollup.has_value()) {
+        const auto &ra = a.rollup.value();
+        const auto &rb = b.rollup.value();
+        return same(ra.rx_buffer, rb.rx_buffer) && same(ra.tx_buffer, rb.tx_buffer) &&
+            same(ra.input_metadata, rb.input_metadata) && same(ra.voucher_hashes, rb.voucher_hashes) &&
+            same(ra.notice_hashes, rb.notice_hashes);
+    }
+    return true;
+}
+
+static void store_base(const std::string &dir, const std::string &base_dir) {
+    auto name = machine_config::get_base_filename(dir);
+    auto fp = unique_fopen(name.c_str(), "wb");
+    if (fwrite(base_dir.data(), 1, base_dir.size(), fp.get()) != base_dir.size()) {
+        throw std::runtime_error{"error writing to '" + name + "'"};
+    }
+}
+
+static void copy_file(const std::string &from, const std::string &to) {
+    auto ifp = unique_fopen(from.c_str(), "rb");
+    auto ofp = unique_fopen(to.c_str(), "wb");
+    std::vector<unsigned char> buf(PMA_PAGE_SIZE);
+    size_t read = 0;
+    while ((read = fread(buf.data(), 1, buf.size(), ifp.get())) != 0) {
+        if (fwrite(buf.data(), 1, read, ofp.get()) != read) {
+            throw std::runtime_error{"error writing to '" + to + "'"};
+        }
+    }
+    if (ferror(ifp.get()) != 0) {
+        throw std::runtime_error{"error reading from '" + from + "'"};
+    }
+}
+
+void machine::store_delta(const std::string &dir, const std::string &base_dir) const {
+    // Pages that changed since the base are those whose hashes differ from the ones stored with it
+    std::vector<std::pair<uint64_t, hash_type>> base_page_hashes;
+    if (!read_page_hashes(base_dir, base_page_hashes)) {
+        throw std::invalid_argument{"machine in '" + base_dir + "' has no page hashes"};
+    }
+    auto c = get_serialization_config();
+    if (!has_same_memory_ranges(c, machine_config::load(base_dir))) {
+        throw std::invalid_argument{"machine in '" + base_dir + "' has different memory ranges"};
+    }
+    if (os_mkdir(dir.c_str(), 0700)) {
+        throw std::runtime_error{"error creating directory '" + dir + "'"};
+    }
+    if (!update_merkle_tree()) {
+        throw std::runtime_error{"error updating Merkle tree"};
+    }
+    hash_type h;
+    m_t.get_root_hash(h);
+    store_hash(h, dir);
+    store_page_hashes(dir);
+    c.store(dir);
+    store_device_pma(*this, find_pma_entry<uint64_t>(PMA_SHADOW_TLB_START), dir);
+    // The base must still be found when the delta is loaded from another working directory
+    store_base(dir, os_get_absolute_path(base_dir.c_str()));
+    const std::unordered_map<uint64_t, hash_type> base_hashes(base_page_hashes.begin(), base_page_hashes.end());
+    const auto &pristine_hash = machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+    std::vector<uint64_t> page_addresses;
+    for (const auto *pma : m_pmas) {
+        if (!pma->get_istart_M() || pma->get_istart_E()) {
+            continue;
+        }
+        for (uint64_t page_start_in_range = 0; page_start_in_range < pma->get_length();
+             page_start_in_range += PMA_PAGE_SIZE) {
+            const uint64_t page_address = pma->get_start() + page_start_in_range;
+            hash_type hash;
+            m_t.get_page_node_hash(page_address, hash);
+            // Pages missing from the base page hashes are pristine there
+            const auto it = base_hashes.find(page_address);
+            if (hash != (it != base_hashes.end() ? it->second : pristine_hash)) {
+                page_addresses.push_back(page_address);
+            }
+        }
+    }
+    auto name = dir + "/delta-pages";
+    auto fp = unique_fopen(name.c_str(), "wb");
+    write_page_file_header(fp.get(), name, DELTA_PAGES_MAGIC, page_addresses.size());
+    for (const uint64_t page_address : page_addresses) {
+        const auto &pma = find_pma_entry(m_pmas, page_address, PMA_PAGE_SIZE);
+        const unsigned char *page = pma.get_memory().get_host_memory() + (page_address - pma.get_start());
+        if (fwrite(&page_address, sizeof(page_address), 1, fp.get()) != 1 ||
+            fwrite(page, 1, PMA_PAGE_SIZE, fp.get()) != PMA_PAGE_SIZE) {
+            throw std::runtime_error{"error writing to '" + name + "'"};
+        }
+    }
+}
+
+void machine::compact_delta(const std::string &dir, const std::string &compacted_dir) {
+    // Walk the chain of deltas, from the newest down to the full machine at its root
+    std::vector<std::string> deltas = machine_config::load_base_chain(dir);
+    const std::string root = deltas.back();
+    deltas.pop_back();
+    if (deltas.empty()) {
+        throw std::invalid_argument{"machine in '" + dir + "' is not a delta"};
+    }
+    // Find where the newest contents of each page are, applying the deltas in the order they were stored
+    std::vector<unique_file_ptr> files;
+    std::map<uint64_t, std::pair<size_t, long>> pages;
+    for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+        auto name = *it + "/delta-pages";
+        auto fp = unique_fopen(name.c_str(), "rb");
+        uint64_t count = 0;
+        if (!read_page_file_header(fp.get(), name, DELTA_PAGES_MAGIC, count)) {
+            throw std::runtime_error{"unsupported format in '" + name + "'"};
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t page_address = 0;
+            if (fread(&page_address, sizeof(page_address), 1, fp.get()) != 1) {
+                throw std::runtime_error{"error reading from '" + name + "'"};
+            }
+            pages[page_address] = {files.size(), ftell(fp.get())};
+            if (fseek(fp.get(), PMA_PAGE_SIZE, SEEK_CUR) != 0) {
+                throw std::runtime_error{"error reading from '" + name + "'"};
+            }
+        }
+        files.push_back(std::move(fp));
+    }
+    if (os_mkdir(compacted_dir.c_str(), 0700)) {
+        throw std::runtime_error{"error creating directory '" + compacted_dir + "'"};
+    }
+    // Everything but the pages is the same as in the newest delta
+    copy_file(machine_config::get_config_filename(dir), machine_config::get_config_filename(compacted_dir));
+    copy_file(dir + "/hash", compacted_dir + "/hash");
+    copy_file(dir + "/page-hashes", compacted_dir + "/page-hashes");
+    copy_file(machine_config::get_image_filename(dir, PMA_SHADOW_TLB_START, PMA_SHADOW_TLB_LENGTH),
+        machine_config::get_image_filename(compacted_dir, PMA_SHADOW_TLB_START, PMA_SHADOW_TLB_LENGTH));
+    store_base(compacted_dir, os_get_absolute_path(root.c_str()));
+    auto name = compacted_dir + "/delta-pages";
+    auto fp = unique_fopen(name.c_str(), "wb");
+    write_page_file_header(fp.get(), name, DELTA_PAGES_MAGIC, pages.size());
+    std::vector<unsigned char> page(PMA_PAGE_SIZE);
+    for (const auto &[page_address, location] : pages) {
+        auto *from = files[location.first].get();
+        if (fseek(from, location.second, SEEK_SET) != 0 || fread(page.data(), 1, page.size(), from) != page.size()) {
+            throw std::runtime_error{"error reading delta pages"};
+        }
+        if (fwrite(&page_address, sizeof(page_address), 1, fp.get()) != 1 ||
+            fwrite(page.data(), 1, page.size(), fp.get()) != page.size()) {
+            throw std::runtime_error{"error writing to '" + name + "'"};
+        }
+    }
+}
+
 // NOLINTNEXTLINE(modernize-use-equals-default)
 machine::~machine() {
     // Cleanup TTY if console input was enabled
@@ -766,6 +1269,12 @@ machine::~machine() {
     (void) fprintf(stderr, "tlb_flush_fence_vma_asid: %" PRIu64 "\n", m_s.stats.tlb_flush_fence_vma_asid);
     (void) fprintf(stderr, "tlb_flush_fence_vma_vaddr: %" PRIu64 "\n", m_s.stats.tlb_flush_fence_vma_vaddr);
     (void) fprintf(stderr, "tlb_flush_fence_vma_asid_vaddr: %" PRIu64 "\n", m_s.stats.tlb_flush_fence_vma_asid_vaddr);
+    (void) fprintf(stderr, "host tlb hit ratio: %.4f\n", TLB_HIT_RATIO(m_s, host_tlb_miss, host_tlb_hit));
+    (void) fprintf(stderr, "host_tlb_hit: %" PRIu64 "\n", m_s.stats.host_tlb_hit);
+    (void) fprintf(stderr, "host_tlb_miss: %" PRIu64 "\n", m_s.stats.host_tlb_miss);
+    (void) fprintf(stderr, "decoded insn cache hit ratio: %.4f\n", TLB_HIT_RATIO(m_s, dcache_miss, dcache_hit));
+    (void) fprintf(stderr, "dcache_hit: %" PRIu64 "\n", m_s.stats.dcache_hit);
+    (void) fprintf(stderr, "dcache_miss: %" PRIu64 "\n", m_s.stats.dcache_miss);
 #endif
 }
 
@@ -1453,73 +1962,98 @@ bool machine::update_merkle_tree(void) const {
         "PMA and machine_merkle_tree page sizes must match");
     // Go over the write TLB and mark as dirty all pages currently there
     mark_write_tlb_dirty_pages();
+    // We launch as many threads as defined on concurrency runtime config or as the hardware supports
+    const uint64_t concurrency = get_task_concurrency(m_r.concurrency.update_merkle_tree);
     // Now go over all PMAs and updating the Merkle tree
     m_t.begin_update();
+    std::vector<uint64_t> dirty_pages;
+    // Each thread collects the new hashes of its pages in its own buffer, so threads never wait for each other
+    std::vector<std::vector<std::pair<uint64_t, hash_type>>> page_hashes(concurrency);
+    // ... and the pages it found to be pristine
+    std::vector<std::vector<uint64_t>> pristine_pages(concurrency);
     for (const auto &pma : m_pmas) {
         auto peek = pma->get_peek();
-        // Each PMA has a number of pages
-        auto pages_in_range = (pma->get_length() + PMA_PAGE_SIZE - 1) / PMA_PAGE_SIZE;
-        // For each PMA, we launch as many threads (n) as defined on concurrency
-        // runtime config or as the hardware supports.
-        const uint64_t n = get_task_concurrency(m_r.concurrency.update_merkle_tree);
-        const bool succeeded = os_parallel_for(n, [&](int j, const parallel_for_mutex &mutex) -> bool {
-            auto scratch = unique_calloc<unsigned char>(PMA_PAGE_SIZE, std::nothrow_t{});
-            if (!scratch) {
-                return false;
-            }
-            machine_merkle_tree::hasher_type h;
-            // Thread j is responsible for page i if i % n == j.
-            for (uint64_t i = j; i < pages_in_range; i += n) {
-                const uint64_t page_start_in_range = i * PMA_PAGE_SIZE;
-                const uint64_t page_address = pma->get_start() + page_start_in_range;
-                const unsigned char *page_data = nullptr;
-                // Skip any clean pages
-                if (!pma->is_page_marked_dirty(page_start_in_range)) {
-                    continue;
-                }
-                // If the peek failed, or if it returned a page for update but
-                // we failed updating it, the entire process failed
-                if (!peek(*pma, *this, page_start_in_range, &page_data, scratch.get())) {
+        // Only dirty pages need updating, so there is no need to go over all pages in range
+        pma->get_dirty_pages(dirty_pages);
+        if (dirty_pages.empty()) {
+            continue;
+        }
+        const uint64_t dirty_pages_count = dirty_pages.size();
+        // Threads pick dirty pages a chunk at a time, so pages that take longer to hash do not hold everyone back
+        constexpr uint64_t pages_per_chunk = 16;
+        const uint64_t n = std::min(concurrency, (dirty_pages_count + pages_per_chunk - 1) / pages_per_chunk);
+        for (uint64_t j = 0; j < n; ++j) {
+            page_hashes[j].clear();
+            pristine_pages[j].clear();
+        }
+        const bool succeeded = os_parallel_for_chunks(n, dirty_pages_count, pages_per_chunk,
+            [&](uint64_t j, uint64_t begin, uint64_t end) -> bool {
+                auto scratch = unique_calloc<unsigned char>(PMA_PAGE_SIZE, std::nothrow_t{});
+                if (!scratch) {
                     return false;
                 }
-                if (page_data) {
-                    const bool is_pristine = std::all_of(page_data, page_data + PMA_PAGE_SIZE,
-                        [](unsigned char pp) -> bool { return pp == '\0'; });
-
-                    if (is_pristine) {
-                        // The update_page_node_hash function in the machine_merkle_tree is not thread
-                        // safe, so we protect it with a mutex
-                        const parallel_for_mutex_guard lock(mutex);
-                        if (!m_t.update_page_node_hash(page_address,
-                                machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size()))) {
+                machine_merkle_tree::hasher_type h;
+                auto &thread_page_hashes = page_hashes[j];
+                auto &thread_pristine_pages = pristine_pages[j];
+                const auto &pristine_hash =
+                    machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+                for (uint64_t i = begin; i < end; ++i) {
+                    const uint64_t page_start_in_range = dirty_pages[i];
+                    const uint64_t page_address = pma->get_start() + page_start_in_range;
+                    const unsigned char *page_data = nullptr;
+                    bool is_pristine_page = pma->is_page_marked_pristine(page_start_in_range);
+                    if (!is_pristine_page) {
+                        // If the peek failed, the entire process failed
+                        if (!peek(*pma, *this, page_start_in_range, &page_data, scratch.get())) {
                             return false;
                         }
+                        if (!page_data) {
+                            continue;
+                        }
+                        is_pristine_page = is_pristine(page_data, PMA_PAGE_SIZE);
+                        if (is_pristine_page) {
+                            thread_pristine_pages.push_back(page_start_in_range);
+                        }
+                    }
+                    if (is_pristine_page) {
+                        // The tree is not modified while threads run, so it is safe to look up the stored hash.
+                        // Pages that were pristine all along need no update, and no node in the tree.
+                        hash_type stored;
+                        m_t.get_page_node_hash(page_address, stored);
+                        if (stored != pristine_hash) {
+                            thread_page_hashes.emplace_back(page_address, pristine_hash);
+                        }
                     } else {
                         hash_type hash;
                         m_t.get_page_node_hash(h, page_data, hash);
-                        {
-                            // The update_page_node_hash function in the machine_merkle_tree is not thread
-                            // safe, so we protect it with a mutex
-                            const parallel_for_mutex_guard lock(mutex);
-                            if (!m_t.update_page_node_hash(page_address, hash)) {
-                                return false;
-                            }
-                        }
+                        thread_page_hashes.emplace_back(page_address, hash);
                     }
                 }
-            }
-            return true;
-        });
+                return true;
+            });
         // If any thread failed, we also failed
         if (!succeeded) {
             m_t.end_update(gh);
             return false;
         }
-        // Otherwise, mark all pages in PMA as clean and move on to next
+        // Hashing was the expensive part, inserting the hashes into the tree is cheap
+        for (uint64_t j = 0; j < n; ++j) {
+            for (const auto &[page_address, hash] : page_hashes[j]) {
+                if (!m_t.update_page_node_hash(page_address, hash)) {
+                    m_t.end_update(gh);
+                    return false;
+                }
+            }
+            // Remember pristine pages, so they are not even read until they are written to again
+            for (const uint64_t page_start_in_range : pristine_pages[j]) {
+                pma->mark_pristine_page(page_start_in_range);
+            }
+        }
+        // Mark all pages in PMA as clean and move on to next
         pma->mark_pages_clean();
     }
-    const bool ret = m_t.end_update(gh);
-    return ret;
+    // Propagate the changes up to the root, also in parallel
+    return m_t.end_update(gh, concurrency);
 }
 
 bool machine::update_merkle_tree_page(uint64_t address) {
@@ -1544,7 +2078,13 @@ bool machine::update_merkle_tree_page(uint64_t address) {
     if (page_data) {
         const uint64_t page_address = pma.get_start() + page_start_in_range;
         hash_type hash;
-        m_t.get_page_node_hash(h, page_data, hash);
+        if (is_pristine(page_data, PMA_PAGE_SIZE)) {
+            hash = machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+            pma.mark_pristine_page(page_start_in_range);
+        } else {
+            // Pages updated one at a time are usually hashed again after a few words change
+            m_t.get_page_node_hash(h, page_address, page_data, hash);
+        }
         if (!m_t.update_page_node_hash(page_address, hash)) {
             m_t.end_update(h);
             return false;
@@ -1554,6 +2094,226 @@ bool machine::update_merkle_tree_page(uint64_t address) {
     return m_t.end_update(h);
 }
 
+/// \brief Pages that changed between two checkpoints, copied so they can be hashed while the machine runs on
+struct checkpoint_pages {
+    uint64_t mcycle{};                        ///< Value of mcycle at the checkpoint
+    std::vector<uint64_t> pristine_addresses; ///< Addresses of pages known to be pristine, which need no copy
+    std::vector<uint64_t> addresses;          ///< Addresses of copied pages
+    std::vector<unsigned char> data;          ///< Contents of copied pages, one after the other
+};
+
+std::vector<std::pair<uint64_t, machine::hash_type>> machine::run_with_checkpoints(uint64_t mcycle_end,
+    uint64_t period) {
+    static_assert(PMA_PAGE_SIZE == machine_merkle_tree::get_page_size(),
+        "PMA and machine_merkle_tree page sizes must match");
+    if (period == 0) {
+        throw std::invalid_argument{"checkpoint period cannot be zero"};
+    }
+    const uint64_t mcycle_start = read_mcycle();
+    if (mcycle_end < mcycle_start) {
+        throw std::invalid_argument{"mcycle is past"};
+    }
+    std::vector<std::pair<uint64_t, hash_type>> checkpoints;
+    // Each checkpoint only hashes the pages that changed since the previous one, so the tree must start up to date
+    get_root_hash(checkpoints.emplace_back(mcycle_start, hash_type{}).second);
+
+    // Copies the pages that changed since the previous checkpoint and marks them clean
+    const auto copy_dirty_pages = [this](checkpoint_pages &pages) {
+        auto scratch = unique_calloc<unsigned char>(PMA_PAGE_SIZE);
+        // Pages in the write TLB may have been written to without being marked dirty
+        mark_write_tlb_dirty_pages();
+        std::vector<uint64_t> dirty_pages;
+        for (auto *pma : m_pmas) {
+            auto peek = pma->get_peek();
+            pma->get_dirty_pages(dirty_pages);
+            for (const uint64_t page_start_in_range : dirty_pages) {
+                const uint64_t page_address = pma->get_start() + page_start_in_range;
+                if (pma->is_page_marked_pristine(page_start_in_range)) {
+                    pages.pristine_addresses.push_back(page_address);
+                    continue;
+                }
+                const unsigned char *page_data = nullptr;
+                if (!peek(*pma, *this, page_start_in_range, &page_data, scratch.get())) {
+                    throw std::runtime_error{"error updating Merkle tree"};
+                }
+                if (!page_data) {
+                    continue;
+                }
+                if (is_pristine(page_data, PMA_PAGE_SIZE)) {
+                    // Remember pristine pages, so they are not even read until they are written to again
+                    pma->mark_pristine_page(page_start_in_range);
+                    pages.pristine_addresses.push_back(page_address);
+                } else {
+                    pages.addresses.push_back(page_address);
+                    pages.data.insert(pages.data.end(), page_data, page_data + PMA_PAGE_SIZE);
+                }
+            }
+        }
+        // Only clean pages once all copies were made, so a failure leaves them all dirty
+        for (auto *pma : m_pmas) {
+            pma->mark_pages_clean();
+        }
+    };
+
+    // Brings the Merkle tree up to date with the pages copied at a checkpoint
+    const auto update_merkle_tree_from_copies = [this](const checkpoint_pages &pages, hash_type &root_hash) -> bool {
+        const auto &pristine_hash = machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+        const uint64_t concurrency = get_task_concurrency(m_r.concurrency.update_merkle_tree);
+        const uint64_t count = pages.addresses.size();
+        std::vector<hash_type> hashes(count);
+        constexpr uint64_t pages_per_chunk = 16;
+        os_parallel_for_chunks(concurrency, count, pages_per_chunk,
+            [&](uint64_t /*j*/, uint64_t begin, uint64_t end) -> bool {
+                machine_merkle_tree::hasher_type h;
+                for (uint64_t i = begin; i < end; ++i) {
+                    m_t.get_page_node_hash(h, pages.data.data() + i * PMA_PAGE_SIZE, hashes[i]);
+                }
+                return true;
+            });
+        machine_merkle_tree::hasher_type gh;
+        m_t.begin_update();
+        for (const uint64_t page_address : pages.pristine_addresses) {
+            hash_type stored;
+            m_t.get_page_node_hash(page_address, stored);
+            if (stored != pristine_hash && !m_t.update_page_node_hash(page_address, pristine_hash)) {
+                m_t.end_update(gh);
+                return false;
+            }
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            if (!m_t.update_page_node_hash(pages.addresses[i], hashes[i])) {
+                m_t.end_update(gh);
+                return false;
+            }
+        }
+        if (!m_t.end_update(gh, concurrency)) {
+            return false;
+        }
+        m_t.get_root_hash(root_hash);
+        return true;
+    };
+
+    // Pages copied at checkpoints whose hashes are not yet in the tree
+    std::deque<checkpoint_pages> pending;
+    std::mutex mutex;
+    std::condition_variable pending_cv;
+    bool running_done = false;
+    bool hashing_failed = false;
+
+    // Puts the hashes of the pages copied at a checkpoint in the tree, or keeps the pages pending on failure
+    const auto hash_checkpoint = [&](checkpoint_pages &&pages) -> bool {
+        bool updated = false;
+        hash_type root_hash;
+        try {
+            updated = update_merkle_tree_from_copies(pages, root_hash);
+        } catch (...) {
+            updated = false;
+        }
+        if (!updated) {
+            // Keep the pages, so they are marked dirty again
+            const std::lock_guard<std::mutex> lock(mutex);
+            pending.push_front(std::move(pages));
+            hashing_failed = true;
+            pending_cv.notify_all();
+            return false;
+        }
+        checkpoints.emplace_back(pages.mcycle, root_hash);
+        return true;
+    };
+
+    // Runs the machine from checkpoint to checkpoint, handing the pages copied at each one to submit
+    const auto run_to_checkpoints = [&](const std::function<bool(checkpoint_pages &&)> &submit) {
+        uint64_t next_checkpoint = mcycle_start;
+        uint64_t mcycle = mcycle_start;
+        while (mcycle < mcycle_end) {
+            next_checkpoint = (UINT64_MAX - next_checkpoint > period) ? next_checkpoint + period : UINT64_MAX;
+            const auto reason = run(std::min(next_checkpoint, mcycle_end));
+            const uint64_t previous_mcycle = std::exchange(mcycle, read_mcycle());
+            // A machine that was already halted or yielded did not advance, so there is nothing new to hash
+            if (mcycle != previous_mcycle) {
+                checkpoint_pages pages;
+                pages.mcycle = mcycle;
+                copy_dirty_pages(pages);
+                if (!submit(std::move(pages))) {
+                    return;
+                }
+            }
+            if (reason != interpreter_break_reason::reached_target_mcycle) {
+                return;
+            }
+        }
+    };
+
+    // Pages whose hashes never made it into the tree must be hashed again by the next update
+    const auto mark_pending_pages_dirty = [&]() {
+        for (const auto &pages : pending) {
+            for (const auto &addresses : {std::cref(pages.pristine_addresses), std::cref(pages.addresses)}) {
+                for (const uint64_t page_address : addresses.get()) {
+                    auto &pma = find_pma_entry(m_pmas, page_address, sizeof(uint64_t));
+                    pma.mark_dirty_page(page_address - pma.get_start());
+                }
+            }
+        }
+    };
+
+    try {
+        // A dedicated thread hashes the pages copied at one checkpoint while the machine runs towards the next.
+        // It stays out of the thread pool, which it uses to hash the pages in parallel.
+        const bool hashed_in_background = os_run_in_background(
+            [&]() {
+                while (true) {
+                    checkpoint_pages pages;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        pending_cv.wait(lock, [&] { return !pending.empty() || running_done; });
+                        if (pending.empty()) {
+                            return;
+                        }
+                        pages = std::move(pending.front());
+                        pending.pop_front();
+                        pending_cv.notify_all();
+                    }
+                    if (!hash_checkpoint(std::move(pages))) {
+                        return;
+                    }
+                }
+            },
+            [&]() {
+                const auto finish_running = [&]() {
+                    const std::lock_guard<std::mutex> lock(mutex);
+                    running_done = true;
+                    pending_cv.notify_all();
+                };
+                try {
+                    run_to_checkpoints([&](checkpoint_pages &&pages) -> bool {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        // Keep at most one checkpoint waiting, so copies do not pile up when hashing falls behind
+                        pending_cv.wait(lock, [&] { return pending.empty() || hashing_failed; });
+                        pending.push_back(std::move(pages));
+                        pending_cv.notify_all();
+                        return !hashing_failed;
+                    });
+                } catch (...) {
+                    finish_running();
+                    throw;
+                }
+                finish_running();
+            });
+        // Without threads, each checkpoint is hashed before the machine runs on
+        if (!hashed_in_background) {
+            run_to_checkpoints(hash_checkpoint);
+        }
+    } catch (...) {
+        mark_pending_pages_dirty();
+        throw;
+    }
+    if (hashing_failed) {
+        mark_pending_pages_dirty();
+        throw std::runtime_error{"error updating Merkle tree"};
+    }
+    return checkpoints;
+}
+
 const boost::container::static_vector<pma_entry, PMA_MAX> &machine::get_pmas(void) const {
     return m_s.pmas;
 }
@@ -1620,6 +2380,45 @@ machine_merkle_tree::proof_type machine::get_proof(uint64_t address, int log2_si
     return get_proof(address, log2_size, skip_merkle_tree_update);
 }
 
+machine_merkle_tree::multiproof_type machine::get_multiproof(const std::vector<uint64_t> &addresses,
+    int log2_size) const {
+    // Check for valid target node size
+    if (log2_size > machine_merkle_tree::get_log2_root_size() ||
+        log2_size < machine_merkle_tree::get_log2_word_size()) {
+        throw std::invalid_argument{"invalid log2_size"};
+    }
+    if (addresses.empty()) {
+        throw std::invalid_argument{"no addresses"};
+    }
+    // Check target address alignment
+    for (const uint64_t address : addresses) {
+        if (address & ((~UINT64_C(0)) >> (64 - log2_size))) {
+            throw std::invalid_argument{"address not aligned to log2_size"};
+        }
+    }
+    if (!update_merkle_tree()) {
+        throw std::runtime_error{"error updating Merkle tree"};
+    }
+    std::vector<uint64_t> sorted{addresses};
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    // Pages are only needed for targets smaller than a page, and each is peeked once,
+    // right before the tree traversal visits the targets inside it
+    auto scratch = unique_calloc<unsigned char>(PMA_PAGE_SIZE);
+    return m_t.get_multiproof(sorted, log2_size, [this, &scratch](uint64_t page_address) {
+        const pma_entry &pma = find_pma_entry(m_pmas, page_address, PMA_PAGE_SIZE);
+        const unsigned char *page_data = nullptr;
+        // If the PMA range is empty, the page is pristine
+        if (!pma.get_istart_E()) {
+            auto peek = pma.get_peek();
+            if (!peek(pma, *this, page_address - pma.get_start(), &page_data, scratch.get())) {
+                throw std::runtime_error{"PMA peek failed"};
+            }
+        }
+        return page_data;
+    });
+}
+
 void machine::read_memory(uint64_t address, unsigned char *data, uint64_t length) const {
     if (length == 0) {
         return;
@@ -1894,6 +2693,108 @@ access_log machine::log_uarch_step(const access_log::type &log_type, bool one_ba
     return std::move(*a.get_log());
 }
 
+std::vector<access_log> machine::log_uarch_steps(uint64_t count, const access_log::type &log_type, bool one_based) {
+    if (m_uarch.get_state().ram.get_istart_E()) {
+        throw std::runtime_error("microarchitecture RAM is not present");
+    }
+    const bool has_proofs = log_type.has_proofs();
+    // Logs of steps recorded so far, and the root hashes between them: root_hashes[i] is the hash before step i
+    // and root_hashes[i+1] the hash after it. Elements of a deque stay in place as more are appended, so the
+    // verifier can use them outside the lock.
+    std::deque<access_log> logs;
+    std::deque<hash_type> root_hashes;
+    if (has_proofs && count > 0) {
+        // This is the only full Merkle tree update. From here on, every write during a step updates its page.
+        get_root_hash(root_hashes.emplace_back());
+    }
+    std::mutex mutex;
+    std::condition_variable recorded_cv;
+    bool recording_done = false;
+    bool verification_failed = false;
+    const auto finish_recording = [&]() {
+        const std::lock_guard<std::mutex> lock(mutex);
+        recording_done = true;
+        recorded_cv.notify_one();
+    };
+    // Records the steps, handing each log to the verifier as soon as it is ready
+    const auto record_steps = [&]() {
+        try {
+            for (uint64_t i = 0; i < count; ++i) {
+                {
+                    const std::lock_guard<std::mutex> lock(mutex);
+                    if (verification_failed) {
+                        break;
+                    }
+                }
+                uarch_record_step_state_access a(m_uarch.get_state(), *this, log_type);
+                a.push_bracket(bracket_type::begin, "step");
+                uarch_step(a);
+                a.push_bracket(bracket_type::end, "step");
+                hash_type root_hash_after;
+                if (has_proofs) {
+                    // The tree is up to date, so there is no need for update_merkle_tree()
+                    m_t.get_root_hash(root_hash_after);
+                }
+                const bool halted = read_uarch_halt_flag();
+                {
+                    const std::lock_guard<std::mutex> lock(mutex);
+                    logs.push_back(std::move(*a.get_log()));
+                    if (has_proofs) {
+                        root_hashes.push_back(root_hash_after);
+                    }
+                    recorded_cv.notify_one();
+                }
+                if (halted) {
+                    break;
+                }
+            }
+        } catch (...) {
+            finish_recording();
+            throw;
+        }
+        finish_recording();
+    };
+    // Verifies each log in order, until all recorded logs were verified
+    const auto verify_steps = [&]() {
+        for (uint64_t i = 0;; ++i) {
+            const access_log *log = nullptr;
+            const hash_type *root_hash_before = nullptr;
+            const hash_type *root_hash_after = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                recorded_cv.wait(lock, [&] { return logs.size() > i || recording_done; });
+                if (logs.size() <= i) {
+                    return;
+                }
+                log = &logs[i];
+                if (has_proofs) {
+                    root_hash_before = &root_hashes[i];
+                    root_hash_after = &root_hashes[i + 1];
+                }
+            }
+            try {
+                if (has_proofs) {
+                    verify_uarch_step_state_transition(*root_hash_before, *log, *root_hash_after, m_r, one_based);
+                } else {
+                    verify_uarch_step_log(*log, m_r, one_based);
+                }
+            } catch (...) {
+                const std::lock_guard<std::mutex> lock(mutex);
+                verification_failed = true;
+                throw;
+            }
+        }
+    };
+    // A dedicated thread verifies each step while the next one is being recorded. It stays out of the thread pool,
+    // which it would otherwise hold for as long as steps are recorded. Without threads, all steps are recorded
+    // first and then verified.
+    if (!os_run_in_background(verify_steps, record_steps)) {
+        record_steps();
+        verify_steps();
+    }
+    return {std::make_move_iterator(logs.begin()), std::make_move_iterator(logs.end())};
+}
+
 void machine::verify_uarch_step_log(const access_log &log, const machine_runtime_config &r, bool one_based) {
     (void) r;
     // There must be at least one access in log
@@ -1905,9 +2806,15 @@ void machine::verify_uarch_step_log(const access_log &log, const machine_runtime
     a.finish();
 }
 
-void machine::verify_uarch_step_state_transition(const hash_type &root_hash_before, const access_log &log,
-    const hash_type &root_hash_after, const machine_runtime_config &r, bool one_based) {
-    (void) r;
+/// \brief Checks the validity of a state transition caused by a uarch step
+/// \param root_hash_before State hash before step.
+/// \param log Step state access log.
+/// \param root_hash_after State hash after step.
+/// \param one_based Use 1-based indices when reporting errors.
+/// \param hash_cache Memo of node hashes to use when verifying proofs, or nullptr
+static void verify_uarch_step_state_transition_with(const machine::hash_type &root_hash_before, const access_log &log,
+    const machine::hash_type &root_hash_after, bool one_based,
+    concat_hash_cache<machine_merkle_tree::hasher_type> *hash_cache) {
     // We need proofs in order to verify the state transition
     if (!log.get_log_type().has_proofs()) {
         throw std::invalid_argument{"log has no proofs"};
@@ -1917,17 +2824,51 @@ void machine::verify_uarch_step_state_transition(const hash_type &root_hash_befo
         throw std::invalid_argument{"too few accesses in log"};
     }
     // Verify all intermediate state transitions
-    uarch_replay_step_state_access a(log, true /* verify proofs! */, root_hash_before, one_based);
+    uarch_replay_step_state_access a(log, true /* verify proofs! */, root_hash_before, one_based, hash_cache);
     uarch_step(a);
     a.finish();
     // Make sure the access log ends at the same root hash as the state
-    hash_type obtained_root_hash;
+    machine::hash_type obtained_root_hash;
     a.get_root_hash(obtained_root_hash);
     if (obtained_root_hash != root_hash_after) {
         throw std::invalid_argument{"mismatch in root hash after replay"};
     }
 }
 
+void machine::verify_uarch_step_state_transition(const hash_type &root_hash_before, const access_log &log,
+    const hash_type &root_hash_after, const machine_runtime_config &r, bool one_based) {
+    (void) r;
+    verify_uarch_step_state_transition_with(root_hash_before, log, root_hash_after, one_based, nullptr);
+}
+
+std::vector<std::string> machine::verify_uarch_step_state_transitions(const std::vector<hash_type> &root_hashes_before,
+    const std::vector<access_log> &logs, const std::vector<hash_type> &root_hashes_after,
+    const machine_runtime_config &r, bool one_based) {
+    if (root_hashes_before.size() != logs.size() || root_hashes_after.size() != logs.size()) {
+        throw std::invalid_argument{"number of root hashes does not match number of logs"};
+    }
+    const uint64_t count = logs.size();
+    std::vector<std::string> errors(count);
+    // Logs in a batch usually touch the same few pages, so their proofs share most node hashes
+    concat_hash_cache<machine_merkle_tree::hasher_type> hash_cache;
+    const uint64_t concurrency = get_task_concurrency(r.concurrency.verify_uarch_step);
+    os_parallel_for_chunks(concurrency, count, 1, [&](uint64_t /*j*/, uint64_t begin, uint64_t end) -> bool {
+        for (uint64_t i = begin; i < end; ++i) {
+            try {
+                verify_uarch_step_state_transition_with(root_hashes_before[i], logs[i], root_hashes_after[i],
+                    one_based, &hash_cache);
+            } catch (std::exception &e) {
+                errors[i] = e.what();
+                if (errors[i].empty()) {
+                    errors[i] = "unknown error";
+                }
+            }
+        }
+        return true;
+    });
+    return errors;
+}
+
 machine_config machine::get_default_config(void) {
     return machine_config{};
 }
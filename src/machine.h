@@ -62,6 +62,9 @@ private:
     machine_runtime_config m_r;         ///< Copy of initialization runtime config
     machine_memory_range_descrs m_mrds; ///< List of memory ranges returned by get_memory_ranges().
 
+    struct snapshot_state;                      ///< Registers and replaced memory ranges saved by snapshot()
+    std::unique_ptr<snapshot_state> m_snapshot; ///< State saved by the active snapshot, or nullptr if none
+
     static const pma_entry::flags m_dtb_flags;                   ///< PMA flags used for DTB
     static const pma_entry::flags m_ram_flags;                   ///< PMA flags used for RAM
     static const pma_entry::flags m_flash_drive_flags;           ///< PMA flags used for flash drives
@@ -118,6 +121,23 @@ private:
     /// \param directory Directory where PMAs will be stored
     void store_pmas(const machine_config &config, const std::string &directory) const;
 
+    /// \brief Saves the Merkle tree hashes of all non-pristine pages in memory ranges
+    /// \param directory Directory where page hashes will be stored
+    /// \details Assumes the Merkle tree is up to date.
+    void store_page_hashes(const std::string &directory) const;
+
+    /// \brief Loads the page hashes saved by store_page_hashes() into the Merkle tree
+    /// \param directory Directory where page hashes were stored
+    /// \returns True if page hashes were loaded, false if there were none in a known format
+    /// \details Marks all pages in memory ranges clean, except for a sample that is left dirty,
+    /// so the next Merkle tree update hashes them again.
+    bool load_page_hashes(const std::string &directory);
+
+    /// \brief Writes the pages stored in a delta, and in the deltas it was stored over, into memory ranges
+    /// \param directory Directory where the delta was stored
+    /// \details Does nothing if \p directory has a full machine.
+    void load_delta_pages(const std::string &directory);
+
     /// \brief Obtain PMA entry that covers a given physical memory region
     /// \param pmas Container of pmas to be searched.
     /// \param s Pointer to machine state.
@@ -189,12 +209,30 @@ public:
     /// \brief Constructor from previously serialized directory
     /// \param directory Directory to load stored machine from
     /// \param runtime Runtime config to use with machine
+    /// \details Unless runtime.skip_root_hash_check is set, the root hash of the loaded machine is checked
+    /// against the one stored. When the directory also has the page hashes stored with it, these are reused
+    /// and only a sample of pages is hashed again, so changes to other pages since the machine was stored
+    /// go undetected. If the directory has a delta, memory ranges are loaded from the full machine at the root of
+    /// its chain and the pages stored in each delta are written over them.
     explicit machine(const std::string &directory, const machine_runtime_config &runtime = {});
 
     /// \brief Serialize entire state to directory
     /// \param directory Directory to store machine into
     void store(const std::string &directory) const;
 
+    /// \brief Serialize state to directory, storing only the pages that changed since a previously stored machine
+    /// \param directory Directory to store delta into
+    /// \param base_directory Directory where the base machine was stored, either in full or as a delta
+    /// \details The base must have been stored with its page hashes and with the same memory ranges. It is
+    /// referenced by absolute path and must stay in place for as long as the delta is in use.
+    /// Memory ranges of machines loaded from deltas are never shared, since their images belong to the base.
+    void store_delta(const std::string &directory, const std::string &base_directory) const;
+
+    /// \brief Merges a chain of deltas into a single delta over the full machine at its root
+    /// \param directory Directory where the newest delta in the chain was stored
+    /// \param compacted_directory Directory to store the compacted delta into
+    static void compact_delta(const std::string &directory, const std::string &compacted_directory);
+
     /// \brief No default constructor
     machine(void) = delete;
     /// \brief No copy constructor
@@ -213,6 +251,16 @@ public:
     ///  frequent scenario is when the program executes a WFI instruction. Another example is when the machine halts.
     interpreter_break_reason run(uint64_t mcycle_end);
 
+    /// \brief Runs the machine until mcycle reaches mcycle_end, the machine halts or yields, obtaining the root hash
+    /// at periodic checkpoints.
+    /// \param mcycle_end Maximum value of mcycle before function returns.
+    /// \param period Number of cycles between checkpoints, counted from the current value of mcycle.
+    /// \returns The value of mcycle and the root hash at each checkpoint, starting with the current state.
+    /// \details When the machine stops before a checkpoint, because it halted or yielded, or because it reached
+    /// mcycle_end, its state there is the last checkpoint. The Merkle tree is updated with the pages that changed
+    /// up to each checkpoint while the machine runs towards the next one.
+    std::vector<std::pair<uint64_t, hash_type>> run_with_checkpoints(uint64_t mcycle_end, uint64_t period);
+
     /// \brief Runs the machine in the microarchitecture until the mcycles advances by one unit or the micro cycle
     /// counter (uarch_cycle) reaches uarch_cycle_end
     /// \param uarch_cycle_end uarch_cycle limit
@@ -224,6 +272,16 @@ public:
     /// \returns The state access log.
     access_log log_uarch_step(const access_log::type &log_type, bool one_based = false);
 
+    /// \brief Advances several consecutive micro steps and returns a state access log for each.
+    /// \param count Maximum number of micro steps.
+    /// \param log_type Type of access log to generate.
+    /// \param one_based Use 1-based indices when reporting errors.
+    /// \returns The state access logs, in order.
+    /// \details Stops early after the step in which the microarchitecture halts.
+    /// The Merkle tree is fully updated only once, before the first step. Each log is verified while the next
+    /// step is being recorded.
+    std::vector<access_log> log_uarch_steps(uint64_t count, const access_log::type &log_type, bool one_based = false);
+
     /// \brief Resets the microarchitecture state
     void reset_uarch();
 
@@ -250,6 +308,18 @@ public:
     static void verify_uarch_step_state_transition(const hash_type &root_hash_before, const access_log &log,
         const hash_type &root_hash_after, const machine_runtime_config &runtime = {}, bool one_based = false);
 
+    /// \brief Checks the validity of many independent state transitions, in parallel.
+    /// \param root_hashes_before State hash before each step.
+    /// \param logs Step state access logs.
+    /// \param root_hashes_after State hash after each step.
+    /// \param runtime Machine runtime configuration to use during verification.
+    /// \param one_based Use 1-based indices when reporting errors.
+    /// \returns For each log, an empty string if its transition is valid, or the reason it is not.
+    /// \details Node hashes shared by proofs in different logs are computed only once.
+    static std::vector<std::string> verify_uarch_step_state_transitions(const std::vector<hash_type> &root_hashes_before,
+        const std::vector<access_log> &logs, const std::vector<hash_type> &root_hashes_after,
+        const machine_runtime_config &runtime = {}, bool one_based = false);
+
     /// \brief Checks the internal consistency of an access log produced by log_uarch_reset
     /// \param log State access log to be verified.
     /// \param runtime Machine runtime configuration to use during verification.
@@ -313,6 +383,15 @@ public:
     /// This overload is used to optimize proof generation when the caller knows that the tree is already up to date.
     machine_merkle_tree::proof_type get_proof(uint64_t address, int log2_size, skip_merkle_tree_update_t) const;
 
+    /// \brief Obtains a single proof for several nodes of the same size in the Merkle tree.
+    /// \param addresses Addresses of target nodes, in any order. Each must be aligned to a 2<sup>log2_size</sup>
+    /// boundary.
+    /// \param log2_size log<sub>2</sub> of size subintended by each target node.
+    /// Must be between 3 (for a word) and 64 (for the entire address space), inclusive.
+    /// \returns The multiproof, with targets sorted by address and without duplicates.
+    /// \details Sibling hashes shared by paths to several targets are included only once.
+    machine_merkle_tree::multiproof_type get_multiproof(const std::vector<uint64_t> &addresses, int log2_size) const;
+
     /// \brief Obtains the root hash of the Merkle tree.
     /// \param hash Receives the hash.
     void get_root_hash(hash_type &hash) const;
@@ -798,6 +877,19 @@ public:
     /// matching the start and length specified in range.
     void replace_memory_range(const memory_range_config &range);
 
+    /// \brief Takes a snapshot of the machine state, to be restored by rollback().
+    /// \details The state is not copied. Instead, each page is saved right before it is first written to,
+    /// and each Merkle tree node right before its hash first changes, so rolling back costs time proportional
+    /// to the number of pages modified since the snapshot. Taking a snapshot while another is active
+    /// commits the older one.
+    void snapshot(void);
+
+    /// \brief Restores the machine state saved by the active snapshot, and discards the snapshot.
+    void rollback(void);
+
+    /// \brief Keeps all changes made since the active snapshot was taken, and discards the snapshot.
+    void commit(void);
+
     /// \brief Reads the value of a microarchitecture register.
     /// \param index Register index. Between 0 and UARCH_X_REG_COUNT-1, inclusive.
     /// \returns The value of the register.
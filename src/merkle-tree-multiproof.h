@@ -0,0 +1,287 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef MERKLE_TREE_MULTIPROOF_H
+#define MERKLE_TREE_MULTIPROOF_H
+
+/// \file
+/// \brief Merkle tree multiproof structure
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "i-hasher.h"
+#include "merkle-tree-proof.h"
+
+namespace cartesi {
+
+/// \brief Merkle tree multiproof structure
+/// \details \{
+/// This structure holds a proof that several nodes spanning a log2_target_size
+/// at given addresses in the tree have certain hashes.
+/// Paths from the root to the targets share most of their siblings. The multiproof
+/// holds only the hashes of the largest subtrees that contain no target, in the order in
+/// which a depth-first traversal from the root, visiting left children first, meets them.
+/// \}
+/// \tparam HASH_TYPE the type that holds a hash
+/// \tparam ADDRESS_TYPE the type that holds an address
+template <typename HASH_TYPE, typename ADDRESS_TYPE = uint64_t>
+class merkle_tree_multiproof final {
+public:
+    using hash_type = HASH_TYPE;
+
+    using address_type = ADDRESS_TYPE;
+
+    /// \brief Single-target proof from which multiproofs can be assembled
+    using proof_type = merkle_tree_proof<hash_type, address_type>;
+
+    /// \brief Target node
+    struct target_type {
+        address_type address; ///< Address of target node
+        hash_type hash;       ///< Hash of target node
+        bool operator==(const target_type &other) const {
+            return address == other.address && hash == other.hash;
+        }
+    };
+
+    /// \brief Storage for the target nodes, sorted by address
+    using targets_type = std::vector<target_type>;
+
+    /// \brief Storage for the sibling hashes, in traversal order
+    using sibling_hashes_type = std::vector<hash_type>;
+
+    /// \brief Constructs an empty merkle_tree_multiproof object
+    merkle_tree_multiproof(int log2_root_size, int log2_target_size) :
+        m_log2_target_size{log2_target_size},
+        m_log2_root_size{log2_root_size},
+        m_root_hash{} {
+        if (log2_root_size <= 0) {
+            throw std::out_of_range{"log2_root_size is not positive"};
+        }
+        if (log2_target_size < 0) {
+            throw std::out_of_range{"log2_target_size is negative"};
+        }
+        if (log2_target_size > log2_root_size) {
+            throw std::out_of_range{"log2_target_size is greater than log2_root_size"};
+        }
+    }
+
+    merkle_tree_multiproof(const merkle_tree_multiproof &other) = default;
+    merkle_tree_multiproof(merkle_tree_multiproof &&other) noexcept = default;
+    merkle_tree_multiproof &operator=(const merkle_tree_multiproof &other) = default;
+    merkle_tree_multiproof &operator=(merkle_tree_multiproof &&other) noexcept = default;
+    ~merkle_tree_multiproof() = default;
+
+    /// \brief Gets log<sub>2</sub> of size subintended by entire tree.
+    /// \returns log<sub>2</sub> of size subintended by entire tree.
+    int get_log2_root_size(void) const {
+        return m_log2_root_size;
+    }
+
+    /// \brief Gets log<sub>2</sub> of size subintended by each target node.
+    /// \returns log<sub>2</sub> of size subintended by each target node.
+    int get_log2_target_size(void) const {
+        return m_log2_target_size;
+    }
+
+    /// \brief Set hash of root node
+    /// \param hash New hash.
+    void set_root_hash(const hash_type &hash) {
+        m_root_hash = hash;
+    }
+
+    /// \brief Gets hash of root node
+    /// \return Reference to hash.
+    const hash_type &get_root_hash(void) const {
+        return m_root_hash;
+    }
+
+    /// \brief Appends a target node
+    /// \param address Address of target node.
+    /// \param hash Hash of target node.
+    void add_target(address_type address, const hash_type &hash) {
+        m_targets.push_back(target_type{address, hash});
+    }
+
+    /// \brief Gets the target nodes
+    /// \return Reference to target nodes, sorted by address.
+    const targets_type &get_targets(void) const {
+        return m_targets;
+    }
+
+    /// \brief Appends a sibling hash
+    /// \param hash New hash.
+    void add_sibling_hash(const hash_type &hash) {
+        m_sibling_hashes.push_back(hash);
+    }
+
+    /// \brief Gets the sibling hashes
+    /// \return Reference to sibling hashes, in traversal order.
+    const sibling_hashes_type &get_sibling_hashes(void) const {
+        return m_sibling_hashes;
+    }
+
+    /// \brief Checks if two Merkle multiproofs are equal
+    bool operator==(const merkle_tree_multiproof &other) const {
+        return get_log2_target_size() == other.get_log2_target_size() &&
+            get_log2_root_size() == other.get_log2_root_size() && get_root_hash() == other.get_root_hash() &&
+            m_targets == other.m_targets && m_sibling_hashes == other.m_sibling_hashes;
+    }
+
+    /// \brief Checks if two Merkle multiproofs are different
+    bool operator!=(const merkle_tree_multiproof &other) const {
+        return !(operator==(other));
+    }
+
+    ///< \brief Verify if multiproof is valid
+    ///< \tparam HASHER_TYPE Hasher class to use
+    ///< \param h Hasher object to use
+    ///< \return True if multiproof is valid, false otherwise
+    template <typename HASHER_TYPE>
+    bool verify(HASHER_TYPE &&h) const {
+        static_assert(is_an_i_hasher<HASHER_TYPE>::value, "not an i_hasher");
+        static_assert(std::is_same<typename remove_cvref<HASHER_TYPE>::type::hash_type, hash_type>::value,
+            "incompatible hash types");
+        if (m_targets.empty()) {
+            return false;
+        }
+        // Targets must be aligned, and sorted so the traversal meets them in order
+        for (size_t i = 0; i < m_targets.size(); ++i) {
+            if (!is_aligned(m_targets[i].address, m_log2_target_size) ||
+                !contains(0, m_log2_root_size, m_targets[i].address) ||
+                (i > 0 && m_targets[i - 1].address >= m_targets[i].address)) {
+                return false;
+            }
+        }
+        size_t target_index = 0;
+        size_t sibling_index = 0;
+        hash_type hash;
+        if (!get_node_hash(h, 0, m_log2_root_size, target_index, sibling_index, hash)) {
+            return false;
+        }
+        return target_index == m_targets.size() && sibling_index == m_sibling_hashes.size() && hash == m_root_hash;
+    }
+
+    /// \brief Assembles a multiproof from single-target proofs
+    /// \param proofs Proofs for each target, all with the same root and target sizes, and the same root hash.
+    /// \return Multiproof for all targets
+    /// \details This only picks sibling hashes from the proofs, without computing any hash.
+    static merkle_tree_multiproof from_proofs(const std::vector<proof_type> &proofs) {
+        if (proofs.empty()) {
+            throw std::invalid_argument{"no proofs"};
+        }
+        std::vector<const proof_type *> sorted;
+        sorted.reserve(proofs.size());
+        for (const auto &proof : proofs) {
+            if (proof.get_log2_root_size() != proofs[0].get_log2_root_size() ||
+                proof.get_log2_target_size() != proofs[0].get_log2_target_size() ||
+                proof.get_root_hash() != proofs[0].get_root_hash()) {
+                throw std::invalid_argument{"proofs are not from the same tree"};
+            }
+            sorted.push_back(&proof);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const proof_type *a, const proof_type *b) {
+            return a->get_target_address() < b->get_target_address();
+        });
+        sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                         [](const proof_type *a, const proof_type *b) {
+                             return a->get_target_address() == b->get_target_address();
+                         }),
+            sorted.end());
+        merkle_tree_multiproof multiproof{proofs[0].get_log2_root_size(), proofs[0].get_log2_target_size()};
+        multiproof.set_root_hash(proofs[0].get_root_hash());
+        multiproof.add_from_proofs(sorted.data(), sorted.data() + sorted.size(), 0, multiproof.get_log2_root_size());
+        return multiproof;
+    }
+
+private:
+    static constexpr int ADDRESS_BITS = static_cast<int>(sizeof(address_type) * 8);
+
+    /// \brief Checks if an address is aligned to a node size
+    static bool is_aligned(address_type address, int log2_size) {
+        return log2_size >= ADDRESS_BITS || (address & ((static_cast<address_type>(1) << log2_size) - 1)) == 0;
+    }
+
+    /// \brief Checks if a node contains an address
+    static bool contains(address_type node_address, int log2_node_size, address_type address) {
+        return log2_node_size >= ADDRESS_BITS || (address >> log2_node_size) == (node_address >> log2_node_size);
+    }
+
+    /// \brief Computes the hash of a node from the targets and sibling hashes it consumes
+    /// \return False if the multiproof ran out of sibling hashes
+    template <typename HASHER_TYPE>
+    bool get_node_hash(HASHER_TYPE &&h, address_type node_address, int log2_node_size, size_t &target_index,
+        size_t &sibling_index, hash_type &hash) const {
+        if (target_index >= m_targets.size() ||
+            !contains(node_address, log2_node_size, m_targets[target_index].address)) {
+            if (sibling_index >= m_sibling_hashes.size()) {
+                return false;
+            }
+            hash = m_sibling_hashes[sibling_index++];
+            return true;
+        }
+        if (log2_node_size == m_log2_target_size) {
+            hash = m_targets[target_index++].hash;
+            return true;
+        }
+        const int log2_child_size = log2_node_size - 1;
+        hash_type left;
+        hash_type right;
+        if (!get_node_hash(h, node_address, log2_child_size, target_index, sibling_index, left) ||
+            !get_node_hash(h, node_address | (static_cast<address_type>(1) << log2_child_size), log2_child_size,
+                target_index, sibling_index, right)) {
+            return false;
+        }
+        get_concat_hash(h, left, right, hash);
+        return true;
+    }
+
+    /// \brief Adds targets and sibling hashes under a node from the proofs of the targets it contains
+    void add_from_proofs(const proof_type *const *begin, const proof_type *const *end, address_type node_address,
+        int log2_node_size) {
+        if (log2_node_size == m_log2_target_size) {
+            add_target(node_address, (*begin)->get_target_hash());
+            return;
+        }
+        const int log2_child_size = log2_node_size - 1;
+        const address_type right_address = node_address | (static_cast<address_type>(1) << log2_child_size);
+        const auto *middle = std::partition_point(begin, end,
+            [right_address](const proof_type *p) { return p->get_target_address() < right_address; });
+        // The hash of a child with no targets is the sibling hash at its level in any proof under the other child
+        if (begin == middle) {
+            add_sibling_hash((*middle)->get_sibling_hash(log2_child_size));
+        } else {
+            add_from_proofs(begin, middle, node_address, log2_child_size);
+        }
+        if (middle == end) {
+            add_sibling_hash((*begin)->get_sibling_hash(log2_child_size));
+        } else {
+            add_from_proofs(middle, end, right_address, log2_child_size);
+        }
+    }
+
+    int m_log2_target_size;               ///< log<sub>2</sub> of size subintended by each target node
+    int m_log2_root_size;                 ///< log<sub>2</sub> of size subintended by tree
+    hash_type m_root_hash;                ///< Hash of root node
+    targets_type m_targets;               ///< Target nodes, sorted by address
+    sibling_hashes_type m_sibling_hashes; ///< Hashes of subtrees with no targets, in traversal order
+};
+
+} // namespace cartesi
+
+#endif
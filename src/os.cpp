@@ -34,25 +34,40 @@
 #define HAVE_MKDIR
 #endif
 
+#if !defined(_WIN32) && !defined(__wasi__) && !defined(NO_SPARSE_FILES)
+#define HAVE_SPARSE_FILES
+#endif
+
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <system_error>
+#include <utility>
 #include <vector>
 
+#include "is-pristine.h"
 #include "os.h"
 #include "unique-c-ptr.h"
 
 #ifdef HAVE_THREADS
-#include <future>
+#include <condition_variable>
+#include <exception>
 #include <mutex>
 #include <thread>
 #endif
 
-#if defined(HAVE_TTY) || defined(HAVE_MMAP) || defined(HAVE_TERMIOS) || defined(_WIN32)
+#if defined(HAVE_THREADS) && !defined(_WIN32)
+#include <pthread.h> // pthread_atfork
+#endif
+
+#if defined(HAVE_TTY) || defined(HAVE_MMAP) || defined(HAVE_TERMIOS) || defined(HAVE_SPARSE_FILES) || defined(_WIN32)
 #include <fcntl.h> // open
 #endif
 
@@ -64,7 +79,7 @@
 #include <sys/mman.h> // mmap/munmap
 #endif
 
-#if defined(HAVE_MMAP) || defined(HAVE_MKDIR) || defined(_WIN32)
+#if defined(HAVE_MMAP) || defined(HAVE_MKDIR) || defined(HAVE_SPARSE_FILES) || defined(_WIN32)
 #include <sys/stat.h> // fstat/mkdir
 #endif
 
@@ -88,8 +103,8 @@
 
 #else // not _WIN32
 
-#if defined(HAVE_TTY) || defined(HAVE_MMAP) || defined(HAVE_TERMIOS)
-#include <unistd.h> // write/read/close
+#if defined(HAVE_TTY) || defined(HAVE_MMAP) || defined(HAVE_TERMIOS) || defined(HAVE_SPARSE_FILES)
+#include <unistd.h> // write/read/close/lseek/ftruncate
 #endif
 
 #if defined(HAVE_TTY)
@@ -372,7 +387,23 @@ int os_mkdir(const char *path, int mode) {
 #endif // HAVE_MKDIR
 }
 
-unsigned char *os_map_file(const char *path, uint64_t length, bool shared) {
+std::string os_get_absolute_path(const char *path) {
+#ifdef _WIN32
+    std::array<char, _MAX_PATH> absolute_path{};
+    if (!_fullpath(absolute_path.data(), path, absolute_path.size())) {
+        throw std::system_error{errno, std::generic_category(), "could not resolve path '"s + path + "'"s};
+    }
+    return absolute_path.data();
+#else
+    const unique_calloc_ptr<char> absolute_path{realpath(path, nullptr)};
+    if (!absolute_path) {
+        throw std::system_error{errno, std::generic_category(), "could not resolve path '"s + path + "'"s};
+    }
+    return absolute_path.get();
+#endif
+}
+
+unsigned char *os_map_file(const char *path, uint64_t length, bool shared, uint64_t *image_length) {
     if (!path || *path == '\0') {
         throw std::runtime_error{"image file path must be specified"s};
     }
@@ -394,18 +425,37 @@ unsigned char *os_map_file(const char *path, uint64_t length, bool shared) {
             "unable to obtain length of image file '"s + path + "'"s};
     }
 
-    // Check that it matches range length
-    if (static_cast<uint64_t>(statbuf.st_size) != length) {
+    // Check that it matches range length, or fits in it when the rest can be zero-filled
+    const auto file_length = static_cast<uint64_t>(statbuf.st_size);
+    const bool zero_fill = !shared && image_length != nullptr && file_length < length;
+    if (file_length != length && !zero_fill) {
         close(backing_file);
-        throw std::invalid_argument{"image file '"s + path + "' size ("s +
-            std::to_string(static_cast<uint64_t>(statbuf.st_size)) + ") does not match range length ("s +
-            std::to_string(length) + ")"s};
+        throw std::invalid_argument{"image file '"s + path + "' size ("s + std::to_string(file_length) +
+            ") does not match range length ("s + std::to_string(length) + ")"s};
     }
 
     // Try to map image file to host memory
-    const int mflag = shared ? MAP_SHARED : MAP_PRIVATE;
-    auto *host_memory =
-        static_cast<unsigned char *>(mmap(nullptr, length, PROT_READ | PROT_WRITE, mflag, backing_file, 0));
+    unsigned char *host_memory = nullptr;
+    if (!zero_fill) {
+        const int mflag = shared ? MAP_SHARED : MAP_PRIVATE;
+        host_memory =
+            static_cast<unsigned char *>(mmap(nullptr, length, PROT_READ | PROT_WRITE, mflag, backing_file, 0));
+    } else {
+        // Reserve the entire range with zero-filled pages, then map the file over its start
+        host_memory = static_cast<unsigned char *>(
+            mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (host_memory != MAP_FAILED && file_length > 0) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+            void *image = mmap(host_memory, file_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                backing_file, 0);
+            if (image == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+                const int saved_errno = errno;
+                munmap(host_memory, length);
+                errno = saved_errno;
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+                host_memory = static_cast<unsigned char *>(MAP_FAILED);
+            }
+        }
+    }
     if (host_memory == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
         close(backing_file);
         throw std::system_error{errno, std::generic_category(), "could not map image file '"s + path + "' to memory"s};
@@ -413,6 +463,9 @@ unsigned char *os_map_file(const char *path, uint64_t length, bool shared) {
 
     // We can close the file after mapping it, because the OS will retain a reference of the file on its own
     close(backing_file);
+    if (image_length) {
+        *image_length = file_length;
+    }
     return host_memory;
 
 #elif defined(_WIN32)
@@ -459,6 +512,9 @@ unsigned char *os_map_file(const char *path, uint64_t length, bool shared) {
 
     // We can close the file after mapping it, because the OS will retain a reference of the file on its own
     _close(backing_file);
+    if (image_length) {
+        *image_length = length;
+    }
     return host_memory;
 
 #else
@@ -498,6 +554,9 @@ unsigned char *os_map_file(const char *path, uint64_t length, bool shared) {
     if (ferror(fp.get())) {
         throw std::system_error{errno, std::generic_category(), "error reading from image file '"s + path + "'"s};
     }
+    if (image_length) {
+        *image_length = static_cast<uint64_t>(file_length);
+    }
     return host_memory;
 
 #endif // HAVE_MMAP
@@ -518,6 +577,101 @@ void os_unmap_file(unsigned char *host_memory, uint64_t length) {
 #endif // HAVE_MMAP
 }
 
+void os_write_sparse_file(const char *path, const unsigned char *data, uint64_t length, uint64_t block_size) {
+#ifdef HAVE_SPARSE_FILES
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(), "error opening '"s + path + "' for writing"s};
+    }
+    // Blocks that are all zeros are skipped, so they become holes in the file
+    for (uint64_t offset = 0; offset < length; offset += block_size) {
+        const uint64_t size = std::min(block_size, length - offset);
+        if (is_pristine(data + offset, size)) {
+            continue;
+        }
+        for (uint64_t written = 0; written < size;) {
+            const auto ret = pwrite(fd, data + offset + written, size - written, static_cast<off_t>(offset + written));
+            if (ret < 0) {
+                const int saved_errno = errno;
+                close(fd);
+                throw std::system_error{saved_errno, std::generic_category(), "error writing to '"s + path + "'"s};
+            }
+            written += static_cast<uint64_t>(ret);
+        }
+    }
+    // Extending the file covers the trailing blocks that were skipped
+    if (ftruncate(fd, static_cast<off_t>(length)) < 0) {
+        const int saved_errno = errno;
+        close(fd);
+        throw std::system_error{saved_errno, std::generic_category(), "error writing to '"s + path + "'"s};
+    }
+    if (close(fd) < 0) {
+        throw std::system_error{errno, std::generic_category(), "error writing to '"s + path + "'"s};
+    }
+#else
+    (void) block_size;
+    auto fp = unique_fopen(path, "wb");
+    if (fwrite(data, 1, length, fp.get()) != length) {
+        throw std::system_error{errno, std::generic_category(), "error writing to '"s + path + "'"s};
+    }
+#endif // HAVE_SPARSE_FILES
+}
+
+std::vector<os_file_extent> os_get_file_data_extents(const char *path) {
+    std::vector<os_file_extent> extents;
+#ifdef HAVE_SPARSE_FILES
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(), "could not open image file '"s + path + "'"s};
+    }
+    struct stat statbuf {};
+    if (fstat(fd, &statbuf) < 0) {
+        const int saved_errno = errno;
+        close(fd);
+        throw std::system_error{saved_errno, std::generic_category(),
+            "unable to obtain length of image file '"s + path + "'"s};
+    }
+    const auto file_length = static_cast<uint64_t>(statbuf.st_size);
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    for (off_t offset = 0; static_cast<uint64_t>(offset) < file_length;) {
+        const off_t data_start = lseek(fd, offset, SEEK_DATA);
+        if (data_start < 0) {
+            // No data past offset, or the file system cannot tell where the holes are
+            if (errno != ENXIO) {
+                extents.clear();
+                extents.push_back({0, file_length});
+            }
+            break;
+        }
+        const off_t data_end = lseek(fd, data_start, SEEK_HOLE);
+        if (data_end < 0) {
+            extents.clear();
+            extents.push_back({0, file_length});
+            break;
+        }
+        extents.push_back({static_cast<uint64_t>(data_start), static_cast<uint64_t>(data_end - data_start)});
+        offset = data_end;
+    }
+#else
+    if (file_length > 0) {
+        extents.push_back({0, file_length});
+    }
+#endif
+    close(fd);
+#else
+    auto fp = unique_fopen(path, "rb");
+    if (fseek(fp.get(), 0, SEEK_END) != 0) {
+        throw std::system_error{errno, std::generic_category(),
+            "unable to obtain length of image file '"s + path + "'"s};
+    }
+    const auto file_length = static_cast<uint64_t>(ftell(fp.get()));
+    if (file_length > 0) {
+        extents.push_back({0, file_length});
+    }
+#endif // HAVE_SPARSE_FILES
+    return extents;
+}
+
 int64_t os_now_us() {
     std::chrono::time_point<std::chrono::high_resolution_clock> start{};
     static bool started = false;
@@ -537,23 +691,141 @@ uint64_t os_get_concurrency() {
 #endif
 }
 
+#ifdef HAVE_THREADS
+/// \brief Persistent pool of threads used by os_parallel_for()
+/// \details Threads are created on demand, as jobs ask for more of them, and live until the process exits.
+/// Each job runs a task a given number of times, each time with a different index j.
+/// The thread submitting a job runs its share of the task as well, so jobs submitted concurrently by
+/// different threads share the pool instead of waiting for each other.
+class parallel_for_pool final {
+    /// \brief State of a job, owned by the thread that submitted it
+    struct job_state {
+        const std::function<bool(uint64_t j)> *task{nullptr}; ///< Task to run
+        uint64_t n{0};                                         ///< Number of indices
+        uint64_t next{0};                                      ///< Next index to hand out
+        uint64_t pending{0};                                   ///< Number of indices that have not completed
+        bool succeeded{true};                                  ///< False if any index failed
+        std::exception_ptr exception;                          ///< First exception thrown by the task, if any
+    };
+
+    std::mutex m_mutex;                ///< Protects all fields below, and the state of all jobs
+    std::condition_variable m_job_cv;  ///< Signaled when a new job is available
+    std::condition_variable m_done_cv; ///< Signaled when all indices of some job have completed
+    uint64_t m_threads{0};             ///< Number of threads in pool
+    std::vector<job_state *> m_jobs;   ///< Jobs with indices left to hand out, in submission order
+
+    /// \brief True while the current thread is running a task for the pool
+    static thread_local bool m_in_task;
+
+    /// \brief Runs the next index of a job
+    /// \param lock Lock on m_mutex, held on entry and on exit
+    /// \param job Job with indices left to hand out
+    void run_next_index(std::unique_lock<std::mutex> &lock, job_state &job) {
+        const uint64_t j = job.next++;
+        if (job.next == job.n) {
+            m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+        }
+        lock.unlock();
+        bool succeeded = false;
+        std::exception_ptr exception;
+        m_in_task = true;
+        try {
+            succeeded = (*job.task)(j);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+        m_in_task = false;
+        lock.lock();
+        job.succeeded = job.succeeded && succeeded;
+        if (exception && !job.exception) {
+            job.exception = exception;
+        }
+        if (--job.pending == 0) {
+            m_done_cv.notify_all();
+        }
+    }
+
+    /// \brief Body of pool threads
+    void work(void) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_job_cv.wait(lock, [&] { return !m_jobs.empty(); });
+            run_next_index(lock, *m_jobs.front());
+        }
+    }
+
+public:
+    /// \brief Tells if the current thread is running a task for the pool
+    static bool in_task(void) {
+        return m_in_task;
+    }
+
+    /// \brief Runs a task n times in parallel, with indices 0 to n-1
+    /// \returns True if all runs succeeded
+    /// \details Rethrows the first exception thrown by the task, if any.
+    bool run(uint64_t n, const std::function<bool(uint64_t j)> &task) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // The calling thread is one of the n
+        while (m_threads + 1 < n) {
+            std::thread(&parallel_for_pool::work, this).detach();
+            ++m_threads;
+        }
+        job_state job;
+        job.task = &task;
+        job.n = n;
+        job.pending = n;
+        m_jobs.push_back(&job);
+        m_job_cv.notify_all();
+        while (job.next < job.n) {
+            run_next_index(lock, job);
+        }
+        m_done_cv.wait(lock, [&] { return job.pending == 0; });
+        if (job.exception) {
+            std::rethrow_exception(job.exception);
+        }
+        return job.succeeded;
+    }
+};
+
+thread_local bool parallel_for_pool::m_in_task = false;
+
+/// \brief Process-wide pool, created on first use
+static parallel_for_pool *parallel_for_pool_instance = nullptr;
+
+/// \brief Protects parallel_for_pool_instance, and keeps fork() from happening while the pool is created
+static std::mutex parallel_for_pool_mutex;
+
+/// \brief Returns the process-wide pool, creating it if needed
+static parallel_for_pool &get_parallel_for_pool(void) {
+    const std::lock_guard<std::mutex> lock(parallel_for_pool_mutex);
+    if (parallel_for_pool_instance == nullptr) {
+#ifndef _WIN32
+        // Pool threads do not survive fork(), so the child must start over with a new pool.
+        // The old pool is leaked on purpose: its mutexes and condition variables may be in use by
+        // threads that no longer exist in the child, so it cannot be safely destroyed.
+        static const bool registered = [] {
+            return pthread_atfork([] { parallel_for_pool_mutex.lock(); }, [] { parallel_for_pool_mutex.unlock(); },
+                       [] {
+                           parallel_for_pool_instance = nullptr;
+                           parallel_for_pool_mutex.unlock();
+                       }) == 0;
+        }();
+        (void) registered;
+#endif
+        parallel_for_pool_instance = new parallel_for_pool;
+    }
+    return *parallel_for_pool_instance;
+}
+#endif
+
 bool os_parallel_for(uint64_t n, const std::function<bool(uint64_t j, const parallel_for_mutex &mutex)> &task) {
 #ifdef HAVE_THREADS
-    if (n > 1) {
+    // Tasks that themselves call os_parallel_for() run their loops without extra threads
+    if (n > 1 && !parallel_for_pool::in_task()) {
         std::mutex mutex;
         const parallel_for_mutex for_mutex = {[&] { mutex.lock(); }, [&] { mutex.unlock(); }};
-        std::vector<std::future<bool>> futures;
-        futures.reserve(n);
-        for (uint64_t j = 0; j < n; ++j) {
-            futures.emplace_back(std::async(std::launch::async, task, j, for_mutex));
-        }
-        // Check if any thread failed
-        bool succeeded = true;
-        for (auto &f : futures) {
-            succeeded = succeeded && f.get();
-        }
-        // Return overall status
-        return succeeded;
+        const std::function<bool(uint64_t j)> job = [&](uint64_t j) -> bool { return task(j, for_mutex); };
+        return get_parallel_for_pool().run(n, job);
     }
 #endif
     // Run without extra threads when concurrency is 1 or as fallback
@@ -565,4 +837,71 @@ bool os_parallel_for(uint64_t n, const std::function<bool(uint64_t j, const para
     return succeeded;
 }
 
+bool os_parallel_for_chunks(uint64_t n, uint64_t count, uint64_t chunk_size,
+    const std::function<bool(uint64_t j, uint64_t begin, uint64_t end)> &task) {
+    chunk_size = std::max(chunk_size, UINT64_C(1));
+    const uint64_t chunks = (count + chunk_size - 1) / chunk_size;
+    n = std::min(n, chunks);
+    if (n == 0) {
+        return true;
+    }
+    // Each thread owns a contiguous share of the chunks, and claims them one at a time from the share's cursor.
+    // Once its own share is exhausted, it steals chunks from the shares of the other threads, the same way.
+    struct alignas(64) chunk_share {
+        std::atomic<uint64_t> next;
+        uint64_t end;
+    };
+    std::vector<chunk_share> shares(n);
+    for (uint64_t j = 0; j < n; ++j) {
+        shares[j].next.store(chunks * j / n, std::memory_order_relaxed);
+        shares[j].end = chunks * (j + 1) / n;
+    }
+    return os_parallel_for(n, [&](uint64_t j, const parallel_for_mutex & /*mutex*/) -> bool {
+        for (uint64_t k = 0; k < n; ++k) {
+            auto &share = shares[(j + k) % n];
+            for (uint64_t chunk = share.next.fetch_add(1, std::memory_order_relaxed); chunk < share.end;
+                 chunk = share.next.fetch_add(1, std::memory_order_relaxed)) {
+                const uint64_t begin = chunk * chunk_size;
+                if (!task(j, begin, std::min(begin + chunk_size, count))) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    });
+}
+
+bool os_run_in_background(const std::function<void()> &background, const std::function<void()> &foreground) {
+#ifdef HAVE_THREADS
+    std::exception_ptr background_exception;
+    std::thread thread;
+    try {
+        thread = std::thread{[&] {
+            try {
+                background();
+            } catch (...) {
+                background_exception = std::current_exception();
+            }
+        }};
+    } catch (std::system_error &) {
+        return false;
+    }
+    try {
+        foreground();
+    } catch (...) {
+        thread.join();
+        throw;
+    }
+    thread.join();
+    if (background_exception) {
+        std::rethrow_exception(background_exception);
+    }
+    return true;
+#else
+    (void) background;
+    (void) foreground;
+    return false;
+#endif
+}
+
 } // namespace cartesi
@@ -20,6 +20,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <string>
+#include <vector>
 
 /// \file
 /// \brief System-specific OS handling operations
@@ -47,12 +49,43 @@ void os_putchar(uint8_t ch);
 /// \brief Creates a new directory
 int os_mkdir(const char *path, int mode);
 
+/// \brief Gets the absolute path of an existing file or directory
+/// \param path Path to the file or directory
+/// \returns Absolute path
+std::string os_get_absolute_path(const char *path);
+
 /// \brief Maps a file to memory
-unsigned char *os_map_file(const char *path, uint64_t length, bool shared);
+/// \param path Path to the file
+/// \param length Length of the mapping
+/// \param shared If true, writes to memory go to the file. Otherwise, they are private to the process.
+/// \param image_length If not null, the file of a private mapping may be shorter than \p length,
+/// and the memory past its end is filled with zeros. Receives the length of the file.
+/// \returns Start of the mapped memory
+unsigned char *os_map_file(const char *path, uint64_t length, bool shared, uint64_t *image_length = nullptr);
 
 /// \brief Unmaps a file from memory
 void os_unmap_file(unsigned char *host_memory, uint64_t length);
 
+/// \brief Part of a file that holds data
+struct os_file_extent {
+    uint64_t start;  ///< Offset of the first byte in the file
+    uint64_t length; ///< Number of bytes
+};
+
+/// \brief Writes data to a file, leaving holes in place of blocks that are all zeros
+/// \param path Path to the file
+/// \param data Data to write
+/// \param length Length of data
+/// \param block_size Size of the blocks that may be left as holes
+/// \details Where sparse files are not supported, all data is written.
+void os_write_sparse_file(const char *path, const unsigned char *data, uint64_t length, uint64_t block_size);
+
+/// \brief Gets the parts of a file that hold data, in increasing order
+/// \param path Path to the file
+/// \returns Extents with data. Anything else in the file is a hole that reads as zeros.
+/// \details Where holes cannot be found, the entire file is a single extent.
+std::vector<os_file_extent> os_get_file_data_extents(const char *path);
+
 /// \brief Get time elapsed since its first call with microsecond precision
 int64_t os_now_us();
 
@@ -86,8 +119,30 @@ private:
 
 /// \brief Runs a for loop in parallel using up to n threads
 /// \return True if all thread tasks succeeded
+/// \details Threads come from a persistent process-wide pool that survives fork().
+/// Calls from within a task run without extra threads.
 bool os_parallel_for(uint64_t n, const std::function<bool(uint64_t j, const parallel_for_mutex &mutex)> &task);
 
+/// \brief Runs a loop over iterations 0 to count-1 in parallel using up to n threads, a chunk at a time
+/// \param n Maximum number of threads
+/// \param count Number of iterations
+/// \param chunk_size Number of consecutive iterations in each chunk
+/// \param task Called with the index j < n of the calling thread and the iterations [begin, end) of a chunk
+/// \return True if all chunks succeeded
+/// \details Each thread starts with a contiguous share of the chunks and steals chunks from other
+/// threads once its own share is exhausted, so threads are kept busy even when chunks take uneven time.
+bool os_parallel_for_chunks(uint64_t n, uint64_t count, uint64_t chunk_size,
+    const std::function<bool(uint64_t j, uint64_t begin, uint64_t end)> &task);
+
+/// \brief Runs a task in a dedicated thread while the calling thread runs another
+/// \param background Task to run in the dedicated thread
+/// \param foreground Task to run in the calling thread
+/// \return False if no thread could be started, in which case neither task ran
+/// \details The dedicated thread is not part of the os_parallel_for() pool, so long-running tasks do not
+/// hold pool threads, and both tasks can use the pool to run their own loops in parallel.
+/// Returns once both tasks are done. Exceptions thrown by either task are rethrown, those of \p foreground first.
+bool os_run_in_background(const std::function<void()> &background, const std::function<void()> &foreground);
+
 } // namespace cartesi
 
 #endif
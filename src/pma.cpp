@@ -14,6 +14,7 @@
 // with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <string>
@@ -36,6 +37,7 @@ void pma_memory::release(void) {
     }
     m_host_memory = nullptr;
     m_length = 0;
+    m_image_extents.clear();
 }
 
 pma_memory::~pma_memory() {
@@ -44,16 +46,19 @@ pma_memory::~pma_memory() {
 
 pma_memory::pma_memory(pma_memory &&other) noexcept :
     m_length{std::move(other.m_length)},
+    m_image_extents{std::move(other.m_image_extents)},
     m_host_memory{std::move(other.m_host_memory)},
     m_mmapped{std::move(other.m_mmapped)} {
     // set other to safe state
     other.m_host_memory = nullptr;
     other.m_mmapped = false;
     other.m_length = 0;
+    other.m_image_extents.clear();
 }
 
 pma_memory::pma_memory(const std::string &description, uint64_t length, const callocd &c) :
     m_length{length},
+    m_image_extents{},
     m_host_memory{nullptr},
     m_mmapped{false} {
     (void) c;
@@ -67,6 +72,7 @@ pma_memory::pma_memory(const std::string &description, uint64_t length, const ca
 
 pma_memory::pma_memory(const std::string &description, uint64_t length, const mockd &m) :
     m_length{length},
+    m_image_extents{{0, length}},
     m_host_memory{nullptr},
     m_mmapped{false} {
     (void) m;
@@ -96,24 +102,52 @@ pma_memory::pma_memory(const std::string &description, uint64_t length, const st
         if (static_cast<uint64_t>(file_length) > length) {
             throw std::runtime_error{"image file '"s + path + "' of "s + description + " is too large for range"s};
         }
-        // Read to host memory
-        auto read = fread(m_host_memory, 1, length, fp.get());
-        (void) read;
-        if (ferror(fp.get())) {
-            throw std::system_error{errno, std::generic_category(),
-                "error reading from image file '"s + path + "' when initializing "s + description};
+        try {
+            m_image_extents = os_get_file_data_extents(path.c_str());
+        } catch (std::exception &e) {
+            throw std::runtime_error{e.what() + " when initializing "s + description};
+        }
+        // Read to host memory, skipping holes in sparse files since memory is already zeroed
+        for (const auto &extent : m_image_extents) {
+            if (extent.start + extent.length > static_cast<uint64_t>(file_length) ||
+                fseek(fp.get(), static_cast<long>(extent.start), SEEK_SET) != 0 ||
+                fread(m_host_memory + extent.start, 1, extent.length, fp.get()) != extent.length) {
+                throw std::system_error{errno, std::generic_category(),
+                    "error reading from image file '"s + path + "' when initializing "s + description};
+            }
         }
     }
 }
 
 pma_memory::pma_memory(const std::string &description, uint64_t length, const std::string &path, const mmapd &m) :
     m_length{length},
+    m_image_extents{},
     m_host_memory{nullptr},
     m_mmapped{false} {
     try {
         m_host_memory = os_map_file(path.c_str(), length, m.shared);
         m_mmapped = true;
+        m_image_extents = os_get_file_data_extents(path.c_str());
+    } catch (std::exception &e) {
+        release();
+        throw std::runtime_error{e.what() + " when initializing "s + description};
+    }
+}
+
+pma_memory::pma_memory(const std::string &description, uint64_t length, const std::string &path, const lazyd &l) :
+    m_length{length},
+    m_image_extents{},
+    m_host_memory{nullptr},
+    m_mmapped{false} {
+    (void) l;
+    try {
+        // Passing the image length allows the file to be shorter than the range
+        uint64_t image_length = 0;
+        m_host_memory = os_map_file(path.c_str(), length, false, &image_length);
+        m_mmapped = true;
+        m_image_extents = os_get_file_data_extents(path.c_str());
     } catch (std::exception &e) {
+        release();
         throw std::runtime_error{e.what() + " when initializing "s + description};
     }
 }
@@ -124,10 +158,12 @@ pma_memory &pma_memory::operator=(pma_memory &&other) noexcept {
     m_host_memory = std::move(other.m_host_memory);
     m_mmapped = std::move(other.m_mmapped);
     m_length = std::move(other.m_length);
+    m_image_extents = std::move(other.m_image_extents);
     // set other to safe state
     other.m_host_memory = nullptr;
     other.m_mmapped = false;
     other.m_length = 0;
+    other.m_image_extents.clear();
     return *this;
 }
 
@@ -159,8 +195,8 @@ void pma_entry::write_memory(uint64_t paddr, const unsigned char *data, uint64_t
     if (!data) {
         throw std::invalid_argument{"invalid data buffer"};
     }
-    memcpy(get_memory().get_host_memory() + (paddr - get_start()), data, size);
     mark_dirty_pages(paddr, size);
+    memcpy(get_memory().get_host_memory() + (paddr - get_start()), data, size);
 }
 
 void pma_entry::fill_memory(uint64_t paddr, unsigned char value, uint64_t size) {
@@ -170,8 +206,62 @@ void pma_entry::fill_memory(uint64_t paddr, unsigned char value, uint64_t size)
     if (!contains(paddr, size)) {
         throw std::invalid_argument{"range not contained in pma"};
     }
-    memset(get_memory().get_host_memory() + (paddr - get_start()), value, size);
     mark_dirty_pages(paddr, size);
+    memset(get_memory().get_host_memory() + (paddr - get_start()), value, size);
+    // Pages entirely filled with zeros are now known to be pristine
+    if (value == 0) {
+        const uint64_t offset = paddr - get_start();
+        const uint64_t first_page = (offset + PMA_PAGE_SIZE - 1) & ~(PMA_PAGE_SIZE - 1);
+        const uint64_t end_page = (offset + size) & ~(PMA_PAGE_SIZE - 1);
+        for (uint64_t page = first_page; page < end_page; page += PMA_PAGE_SIZE) {
+            mark_pristine_page(page);
+        }
+    }
+}
+
+void pma_entry::save_page(uint64_t page_number) {
+    const uint64_t start_in_range = page_number << PMA_constants::PMA_PAGE_SIZE_LOG2;
+    const uint64_t bit = UINT64_C(1) << (page_number & 63);
+    m_saved_page_map[page_number >> 6] |= bit;
+    // The maps may have bits set past the end of the range
+    if (start_in_range >= get_length()) {
+        return;
+    }
+    m_saved_pages.push_back(saved_page{start_in_range, (m_pristine_page_map[page_number >> 6] & bit) != 0});
+    const uint64_t offset = m_saved_page_data.size();
+    m_saved_page_data.resize(offset + PMA_PAGE_SIZE);
+    const uint64_t length = std::min<uint64_t>(PMA_PAGE_SIZE, get_length() - start_in_range);
+    memcpy(m_saved_page_data.data() + offset, get_memory().get_host_memory() + start_in_range, length);
+}
+
+void pma_entry::begin_snapshot(void) {
+    end_snapshot();
+    m_saved_page_map.resize(m_dirty_page_map.size(), 0);
+}
+
+void pma_entry::rollback_snapshot(void) {
+    unsigned char *hmem = m_saved_pages.empty() ? nullptr : get_memory().get_host_memory();
+    for (uint64_t i = 0; i < m_saved_pages.size(); ++i) {
+        const auto &page = m_saved_pages[i];
+        const uint64_t length = std::min<uint64_t>(PMA_PAGE_SIZE, get_length() - page.start_in_range);
+        memcpy(hmem + page.start_in_range, m_saved_page_data.data() + i * PMA_PAGE_SIZE, length);
+        mark_clean_page(page.start_in_range);
+        const uint64_t page_number = page.start_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
+        const uint64_t bit = UINT64_C(1) << (page_number & 63);
+        if (page.pristine) {
+            m_pristine_page_map[page_number >> 6] |= bit;
+        } else {
+            m_pristine_page_map[page_number >> 6] &= ~bit;
+        }
+    }
+    end_snapshot();
+}
+
+void pma_entry::end_snapshot(void) {
+    m_saved_page_map.clear();
+    m_saved_pages.clear();
+    m_saved_page_data.clear();
+    m_saved_page_data.shrink_to_fit();
 }
 
 bool pma_peek_error(const pma_entry &, const machine &, uint64_t, const unsigned char **, unsigned char *) {
@@ -225,6 +315,15 @@ pma_entry make_callocd_memory_pma_entry(const std::string &description, uint64_t
         memory_peek};
 }
 
+pma_entry make_lazy_memory_pma_entry(const std::string &description, uint64_t start, uint64_t length,
+    const std::string &path) {
+    if (length == 0) {
+        throw std::invalid_argument{description + " length cannot be zero"s};
+    }
+    return pma_entry{description, start, length, pma_memory{description, length, path, pma_memory::lazyd{}},
+        memory_peek};
+}
+
 pma_entry make_mockd_memory_pma_entry(const std::string &description, uint64_t start, uint64_t length) {
     if (length == 0) {
         throw std::invalid_argument{description + " length cannot be zero"s};
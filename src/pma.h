@@ -17,6 +17,7 @@
 #ifndef PMA_H
 #define PMA_H
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <stdexcept>
@@ -24,6 +25,7 @@
 #include <variant>
 #include <vector>
 
+#include "os.h"
 #include "pma-constants.h"
 #include "pma-driver.h"
 
@@ -93,8 +95,9 @@ public:
 class pma_memory final {
 
     uint64_t m_length;            ///< Length of memory range (copy of PMA length field).
-    unsigned char *m_host_memory; ///< Start of associated memory region in host.
-    bool m_mmapped;               ///< True if memory was mapped from a file.
+    std::vector<os_file_extent> m_image_extents; ///< Parts of range loaded from data in a file. The rest starts zeroed.
+    unsigned char *m_host_memory;                ///< Start of associated memory region in host.
+    bool m_mmapped;                              ///< True if memory was mapped from a file.
 
     /// \brief Close file and/or release memory.
     void release(void);
@@ -112,6 +115,19 @@ public:
     /// \param m Mmap'd range data (shared or not).
     pma_memory(const std::string &description, uint64_t length, const std::string &path, const mmapd &m);
 
+    /// \brief Lazily loaded range data (just a tag).
+    struct lazyd {};
+
+    /// \brief Constructor for lazily loaded ranges.
+    /// \param description Informative description of PMA entry for use in error messages
+    /// \param length Length of range.
+    /// \param path Path for backing file.
+    /// \param l Lazily loaded range data (just a tag).
+    /// \details The backing file is mapped privately, so its pages are only read when first accessed,
+    /// and changes to the range are never written to it. The file may be shorter than the range,
+    /// in which case the rest of the range starts zeroed.
+    pma_memory(const std::string &description, uint64_t length, const std::string &path, const lazyd &l);
+
     /// \brief Calloc'd range data (just a tag).
     struct callocd {};
 
@@ -166,6 +182,12 @@ public:
     uint64_t get_length(void) const {
         return m_length;
     }
+
+    /// \brief Returns parts of range loaded from data in a file, in increasing order.
+    /// \details Memory anywhere else, including holes in sparse image files, was zeroed when the range was created.
+    const std::vector<os_file_extent> &get_image_extents(void) const {
+        return m_image_extents;
+    }
 };
 
 /// \brief Data for empty memory ranges (nothing, really)
@@ -198,7 +220,19 @@ private:
 
     pma_peek m_peek; ///< Callback for peek operations.
 
-    std::vector<uint8_t> m_dirty_page_map; ///< Map of dirty pages.
+    std::vector<uint64_t> m_dirty_page_map; ///< Map of dirty pages, one bit per page.
+    std::vector<uint64_t> m_dirty_word_map; ///< Map of words in m_dirty_page_map that may be non-zero.
+    std::vector<uint64_t> m_pristine_page_map; ///< Map of pages known to be pristine, one bit per page.
+
+    /// \brief Page saved before its first write since the snapshot.
+    struct saved_page {
+        uint64_t start_in_range; ///< Start of page in range.
+        bool pristine;           ///< Whether the page was known to be pristine.
+    };
+
+    std::vector<uint64_t> m_saved_page_map;       ///< Map of pages saved since the snapshot, empty if none was taken.
+    std::vector<saved_page> m_saved_pages;        ///< Pages saved since the snapshot, in the order they were saved.
+    std::vector<unsigned char> m_saved_page_data; ///< Contents of saved pages, one page after the other.
 
     std::variant<pma_empty, ///< Data specific to E ranges
         pma_device,         ///< Data specific to IO ranges
@@ -206,6 +240,10 @@ private:
         >
         m_data;
 
+    /// \brief Saves the contents of a page and marks it as saved
+    /// \param page_number Index of page in range
+    void save_page(uint64_t page_number);
+
 public:
     /// \brief No copy constructor
     pma_entry(const pma_entry &) = delete;
@@ -261,8 +299,25 @@ public:
         m_flags{},
         m_peek{peek},
         m_data{std::move(memory)} {
-        // allocate dirty page map and mark all pages as dirty
-        m_dirty_page_map.resize(length / (8 * PMA_PAGE_SIZE) + 1, 0xff);
+        // allocate dirty page maps and mark all pages as dirty
+        m_dirty_word_map.resize(length / (64 * 64 * PMA_PAGE_SIZE) + 1, ~UINT64_C(0));
+        m_dirty_page_map.resize(m_dirty_word_map.size() * 64, ~UINT64_C(0));
+        // allocate pristine page map and mark all pages without data from the image as pristine
+        m_pristine_page_map.resize(m_dirty_page_map.size(), 0);
+        const uint64_t pages_in_range = (length + PMA_PAGE_SIZE - 1) >> PMA_constants::PMA_PAGE_SIZE_LOG2;
+        uint64_t first_pristine_page = 0;
+        const auto mark_pristine_pages = [this](uint64_t first_page, uint64_t end_page) {
+            for (uint64_t page_number = first_page; page_number < end_page; ++page_number) {
+                m_pristine_page_map[page_number >> 6] |= UINT64_C(1) << (page_number & 63);
+            }
+        };
+        for (const auto &extent : std::get<pma_memory>(m_data).get_image_extents()) {
+            const uint64_t first_data_page = extent.start >> PMA_constants::PMA_PAGE_SIZE_LOG2;
+            mark_pristine_pages(first_pristine_page, std::min(first_data_page, pages_in_range));
+            first_pristine_page = std::max(first_pristine_page,
+                (extent.start + extent.length + PMA_PAGE_SIZE - 1) >> PMA_constants::PMA_PAGE_SIZE_LOG2);
+        }
+        mark_pristine_pages(first_pristine_page, pages_in_range);
     }
 
     /// \brief Constructor for device entry
@@ -420,12 +475,21 @@ public:
 
     /// \brief Mark a given page as dirty
     /// \param address_in_range Any address within page in range
+    /// \details The page is no longer known to be pristine.
+    /// While a snapshot is active, the page contents are saved the first time it is marked,
+    /// so pages must be marked dirty *before* they are written to.
     void mark_dirty_page(uint64_t address_in_range) {
         if (!m_dirty_page_map.empty()) {
             auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
-            auto map_index = page_number >> 3;
+            auto map_index = page_number >> 6;
             assert(map_index < m_dirty_page_map.size());
-            m_dirty_page_map[map_index] |= (1 << (page_number & 7));
+            // Save the page contents the first time it is marked since the snapshot
+            if (!m_saved_page_map.empty() && !(m_saved_page_map[map_index] & (UINT64_C(1) << (page_number & 63)))) {
+                save_page(page_number);
+            }
+            m_dirty_page_map[map_index] |= (UINT64_C(1) << (page_number & 63));
+            m_dirty_word_map[map_index >> 6] |= (UINT64_C(1) << (map_index & 63));
+            m_pristine_page_map[map_index] &= ~(UINT64_C(1) << (page_number & 63));
         }
     }
     /// \brief Mark all pages in rage as dirty
@@ -456,9 +520,9 @@ public:
     void mark_clean_page(uint64_t address_in_range) {
         if (!m_dirty_page_map.empty()) {
             auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
-            auto map_index = page_number >> 3;
+            auto map_index = page_number >> 6;
             assert(map_index < m_dirty_page_map.size());
-            m_dirty_page_map[map_index] &= ~(1 << (page_number & 7));
+            m_dirty_page_map[map_index] &= ~(UINT64_C(1) << (page_number & 63));
         }
     }
 
@@ -468,17 +532,82 @@ public:
     bool is_page_marked_dirty(uint64_t address_in_range) const {
         if (!m_dirty_page_map.empty()) {
             auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
-            auto map_index = page_number >> 3;
+            auto map_index = page_number >> 6;
             assert(map_index < m_dirty_page_map.size());
-            return m_dirty_page_map[map_index] & (1 << (page_number & 7));
+            return m_dirty_page_map[map_index] & (UINT64_C(1) << (page_number & 63));
         } else {
             return true;
         }
     }
 
+    /// \brief Mark a given page as known to be pristine
+    /// \param address_in_range Any address within page in range
+    /// \details Must only be called for pages that are entirely filled with zeros.
+    /// Marking the page dirty again clears the mark.
+    void mark_pristine_page(uint64_t address_in_range) {
+        if (!m_pristine_page_map.empty()) {
+            auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
+            auto map_index = page_number >> 6;
+            assert(map_index < m_pristine_page_map.size());
+            m_pristine_page_map[map_index] |= (UINT64_C(1) << (page_number & 63));
+        }
+    }
+
+    /// \brief Checks if a given page is known to be pristine
+    /// \param address_in_range Any address within page in range
+    /// \returns true if page is known to be filled with zeros, false if unknown
+    /// \details Pages in the write TLB may have been written to without being marked dirty,
+    /// so these must be marked dirty first for the result to be reliable.
+    bool is_page_marked_pristine(uint64_t address_in_range) const {
+        if (!m_pristine_page_map.empty()) {
+            auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
+            auto map_index = page_number >> 6;
+            assert(map_index < m_pristine_page_map.size());
+            return m_pristine_page_map[map_index] & (UINT64_C(1) << (page_number & 63));
+        } else {
+            return false;
+        }
+    }
+
     /// \brief Marks all pages in range as clean
+    /// \details Only visits the words of the dirty page map that may be non-zero.
     void mark_pages_clean(void) {
-        return std::fill(m_dirty_page_map.begin(), m_dirty_page_map.end(), 0);
+        for (uint64_t i = 0; i < m_dirty_word_map.size(); ++i) {
+            for (uint64_t words = m_dirty_word_map[i]; words != 0; words &= words - 1) {
+                m_dirty_page_map[(i << 6) + __builtin_ctzll(words)] = 0;
+            }
+            m_dirty_word_map[i] = 0;
+        }
+    }
+
+    /// \brief Obtains the pages in range that are marked dirty
+    /// \param pages Receives the start of each dirty page in range, in increasing order.
+    /// \details Takes time proportional to the number of dirty pages, plus one probe per 4096 pages in range.
+    ///  Ranges without a dirty page map, such as devices, have all their pages reported as dirty.
+    void get_dirty_pages(std::vector<uint64_t> &pages) const {
+        constexpr const auto log2_page_size = PMA_constants::PMA_PAGE_SIZE_LOG2;
+        const uint64_t pages_in_range = (get_length() + PMA_constants::PMA_PAGE_SIZE - 1) >> log2_page_size;
+        pages.clear();
+        if (m_dirty_page_map.empty()) {
+            pages.reserve(pages_in_range);
+            for (uint64_t page_number = 0; page_number < pages_in_range; ++page_number) {
+                pages.push_back(page_number << log2_page_size);
+            }
+            return;
+        }
+        for (uint64_t i = 0; i < m_dirty_word_map.size(); ++i) {
+            for (uint64_t words = m_dirty_word_map[i]; words != 0; words &= words - 1) {
+                const uint64_t map_index = (i << 6) + __builtin_ctzll(words);
+                for (uint64_t bits = m_dirty_page_map[map_index]; bits != 0; bits &= bits - 1) {
+                    const uint64_t page_number = (map_index << 6) + __builtin_ctzll(bits);
+                    // The maps may have bits set past the end of the range
+                    if (page_number >= pages_in_range) {
+                        return;
+                    }
+                    pages.push_back(page_number << log2_page_size);
+                }
+            }
+        }
     }
 
     /// \brief Returns PMA description as a string
@@ -498,6 +627,19 @@ public:
         return address >= get_start() && get_length() >= length && address - get_start() <= get_length() - length;
     }
 
+    /// \brief Starts saving the contents of pages before they are first written to
+    /// \details Assumes the Merkle tree is up to date with the contents of all pages in range.
+    /// Ranges without a dirty page map, such as devices, have no pages to save.
+    void begin_snapshot(void);
+
+    /// \brief Restores the contents of all pages saved since begin_snapshot() and stops saving them
+    /// \details Restored pages are marked clean, since their contents are back to what the Merkle tree had
+    /// when the snapshot was taken.
+    void rollback_snapshot(void);
+
+    /// \brief Discards the contents of all pages saved since begin_snapshot() and stops saving them
+    void end_snapshot(void);
+
     /// \brief  Writes data to pma memory
     /// \param paddr Destination address within pma range
     /// \param data Source data
@@ -544,6 +686,17 @@ pma_entry make_callocd_memory_pma_entry(const std::string &description, uint64_t
 pma_entry make_mmapd_memory_pma_entry(const std::string &description, uint64_t start, uint64_t length,
     const std::string &path, bool shared);
 
+/// \brief Creates a PMA entry for a new memory range initially filled with the contents of a backing file,
+/// which are only read from the file when first accessed.
+/// \param description Informative description of PMA entry for use in error messages
+/// \param start Start of PMA range.
+/// \param length Length of PMA range.
+/// \param path Path to backing file.
+/// \returns Corresponding PMA entry
+/// \details The backing file must not be modified while the range exists.
+pma_entry make_lazy_memory_pma_entry(const std::string &description, uint64_t start, uint64_t length,
+    const std::string &path);
+
 /// \brief Creates a PMA entry for a new mock memory region (no allocation).
 /// \param description Informative description of PMA entry for use in error messages
 /// \param start Start of physical memory range in the target address
@@ -18,7 +18,6 @@
 #include <cstdint>
 #include <exception>
 #include <string>
-#include <sys/wait.h>
 #include <thread>
 #include <typeinfo>
 
@@ -121,12 +120,11 @@ struct handler_context {
     std::unique_ptr<ServerCompletionQueue> cq;
     std::optional<checkin_context> checkin;
     bool ok;
-    bool forked;
 };
 
 class i_handler {
 public:
-    enum class side_effect { none, snapshot, rollback, shutdown };
+    enum class side_effect { none, shutdown };
 
     side_effect advance(handler_context &hctx) {
         return do_advance(hctx);
@@ -228,73 +226,6 @@ public:
     }
 };
 
-static void squash_parent(bool &forked) {
-    SLOG(trace) << "squash_parent called with forked: " << forked;
-    // If we are a forked child, we have a parent waiting.
-    // We want to take its place before exiting.
-    // Wake parent up by signaling ourselves to stop.
-    // Parent will wake us back up and then exit.
-    if (forked) {
-        SLOG(trace) << "rasing SIGSTOP";
-        const int result = raise(SIGSTOP);
-        if (result != 0) {
-            // If raise SIGSTOP failed we should abort cause something went
-            // wrong and we don't have information to recover.
-            SLOG(fatal) << "error raising SIGSTOP: " << std::strerror(errno);
-            exit(1);
-        }
-        // When we wake up, we took the parent's place, so we are not "forked" anymore
-        forked = false;
-    }
-}
-
-static void snapshot(bool &forked) {
-    SLOG(trace) << "snapshot called with forked: " << forked;
-    squash_parent(forked);
-    // Now actually fork
-    const pid_t childid = fork();
-    if (childid == 0) {
-        SLOG(trace) << "Child after fork will continue serving requests";
-        // Child simply goes on with next loop iteration.
-        forked = true;
-    } else {
-        SLOG(trace) << "Parent after fork will call waitpid";
-        // Parent waits on child.
-        int wstatus{};
-        const pid_t pid = waitpid(childid, &wstatus, WUNTRACED);
-        SLOG(trace) << "Waitpid result: " << pid;
-        if (pid == -1) {
-            // If waitpid failed we should abort cause something went
-            // wrong and we don't have information to recover.
-            SLOG(fatal) << "Error on waitpid: " << std::strerror(errno);
-            exit(1);
-        }
-        if (WIFSTOPPED(wstatus)) {
-            SLOG(trace) << "Parent observed that the child has raised SIGSTOP and will send SIGCONT to it and exit";
-            // Here the child wants to take our place.
-            // Wake child and exit.
-            kill(childid, SIGCONT);
-            exit(0);
-        } else {
-            SLOG(trace) << "Parent observed that the child has exited. This process will take it's place";
-            // Here the child exited.
-            // We take its place, but are not "forked" anymore.
-            // We go on with next loop iteration.
-            forked = false;
-        }
-    }
-}
-
-static void rollback(bool &forked) {
-    SLOG(trace) << "rollback called with forked: " << forked;
-    if (forked) {
-        SLOG(trace) << "Calling exit";
-        // Here, we are a child and forked.
-        // We simply exit so parent can take our place.
-        exit(0);
-    }
-}
-
 using machine_ptr = std::unique_ptr<machine>;
 
 class handler_GetVersion final : public handler<Void, GetVersionResponse> {
@@ -471,7 +402,6 @@ class handler_Destroy final : public handler<Void, Void> {
 
     side_effect go(handler_context &hctx, Void *req, ServerAsyncResponseWriter<Void> *writer) override {
         (void) req;
-        squash_parent(hctx.forked);
         if (hctx.m) {
             hctx.m.reset();
         }
@@ -490,12 +420,15 @@ class handler_Snapshot final : public handler<Void, Void> {
     side_effect prepare(handler_context &hctx, ServerContext *sctx, Void *req,
         ServerAsyncResponseWriter<Void> *writer) override {
         hctx.s->RequestSnapshot(sctx, req, writer, hctx.cq.get(), hctx.cq.get(), this);
-        return side_effect::snapshot;
+        return side_effect::none;
     }
 
     side_effect go(handler_context &hctx, Void *req, ServerAsyncResponseWriter<Void> *writer) override {
-        (void) hctx;
         (void) req;
+        if (!hctx.m) {
+            return finish_with_error_no_machine(writer);
+        }
+        hctx.m->snapshot();
         const Void resp;
         return finish_ok(writer, resp);
     }
@@ -511,12 +444,15 @@ class handler_Rollback final : public handler<Void, Void> {
     side_effect prepare(handler_context &hctx, ServerContext *sctx, Void *req,
         ServerAsyncResponseWriter<Void> *writer) override {
         hctx.s->RequestRollback(sctx, req, writer, hctx.cq.get(), hctx.cq.get(), this);
-        return side_effect::rollback;
+        return side_effect::none;
     }
 
     side_effect go(handler_context &hctx, Void *req, ServerAsyncResponseWriter<Void> *writer) override {
-        (void) hctx;
         (void) req;
+        if (!hctx.m) {
+            return finish_with_error_no_machine(writer);
+        }
+        hctx.m->rollback();
         const Void resp;
         return finish_ok(writer, resp);
     }
@@ -1454,7 +1390,7 @@ static void server_loop(const char *server_address, const char *session_id, cons
         const handler_VerifyUarchResetLog hVerifyUarchResetLog(hctx);
         const handler_VerifyUarchResetStateTransition hVerifyUarchResetStateTransition(hctx);
 
-        // The invariant before and after snapshot/rollbacks is that all handlers
+        // The invariant before and after side effects is that all handlers
         // are in waiting mode
         using side_effect = i_handler::side_effect;
         side_effect s_effect = side_effect::none;
@@ -1502,18 +1438,8 @@ static void server_loop(const char *server_address, const char *session_id, cons
                 SLOG(debug) << "Handling side effect side effect none";
                 // do nothing
                 break;
-            case side_effect::snapshot:
-                SLOG(debug) << "Handling side effect side effect snapshot";
-                snapshot(hctx.forked);
-                break;
-            case side_effect::rollback:
-                SLOG(debug) << "Handling side effect side effect rollback";
-                rollback(hctx.forked);
-                break;
             case side_effect::shutdown:
                 SLOG(debug) << "Handling side effect side effect shutdown";
-                // Make sure we don't leave a snapshot burried
-                squash_parent(hctx.forked);
                 return;
         }
     }
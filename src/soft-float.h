@@ -872,7 +872,7 @@ using i_sfloat32 = i_sfloat<uint32_t, 23, 8>;  // Interface for single-precision
 using i_sfloat64 = i_sfloat<uint64_t, 52, 11>; // Interface for double-precision floating-point
 
 /// \brief Conversion from float32 to float64.
-static uint64_t sfloat_cvt_f32_f64(uint32_t a, uint32_t *pfflags) {
+static inline uint64_t sfloat_cvt_f32_f64(uint32_t a, uint32_t *pfflags) {
     uint32_t a_sign = 0;
     int32_t a_exp = 0;
     i_sfloat64::F_UINT a_mant = i_sfloat32::unpack(&a_sign, &a_exp, a);
@@ -902,7 +902,7 @@ static uint64_t sfloat_cvt_f32_f64(uint32_t a, uint32_t *pfflags) {
 }
 
 /// \brief Conversion from float64 to float32.
-static uint32_t sfloat_cvt_f64_f32(uint64_t a, FRM_modes rm, uint32_t *pfflags) {
+static inline uint32_t sfloat_cvt_f64_f32(uint64_t a, FRM_modes rm, uint32_t *pfflags) {
     uint32_t a_sign = 0;
     int32_t a_exp = 0;
     i_sfloat64::F_UINT a_mant = i_sfloat64::unpack(&a_sign, &a_exp, a);
@@ -454,26 +454,10 @@ private:
 
     template <typename T>
     pma_entry &do_find_pma_entry(uint64_t paddr) {
-        int i = 0;
-        while (true) {
-            auto &pma = m_m.get_state().pmas[i];
-            // The pmas array always contain a sentinel. It is an entry with
-            // zero length. If we hit it, return it
-            if (pma.get_length() == 0) {
-                return pma;
-            }
-            // Otherwise, if we found an entry where the access fits, return it
-            // Note the "strange" order of arithmetic operations.
-            // This is to ensure there is no overflow.
-            // Since we know paddr >= start, there is no chance of overflow
-            // in the first subtraction.
-            // Since length is at least 4096 (an entire page), there is no
-            // chance of overflow in the second subtraction.
-            if (paddr >= pma.get_start() && paddr - pma.get_start() <= pma.get_length() - sizeof(T)) {
-                return pma;
-            }
-            i++;
-        }
+        auto &s = m_m.get_state();
+        // The pmas array always contain a sentinel. It is an entry with
+        // zero length, returned when no entry contains the access
+        return s.pmas[s.pma_lookup.find(paddr, sizeof(T))];
     }
 
     static unsigned char *do_get_host_memory(pma_entry &pma) {
@@ -557,6 +541,10 @@ private:
         }
         const uint64_t vaddr_page = vaddr & ~PAGE_OFFSET_MASK;
         const uint64_t paddr_page = paddr & ~PAGE_OFFSET_MASK;
+        // Pages in the write TLB are written to without being marked dirty, so mark them before that happens
+        if constexpr (ETYPE == TLB_WRITE) {
+            pma.mark_dirty_page(paddr_page - pma.get_start());
+        }
         unsigned char *hpage = pma.get_memory_noexcept().get_host_memory() + (paddr_page - pma.get_start());
         tlbhe.vaddr_page = vaddr_page;
         tlbhe.vh_offset = cast_ptr_to_addr<uint64_t>(hpage) - vaddr_page;
@@ -565,6 +553,48 @@ private:
         return hpage;
     }
 
+    /// \brief Returns the machine state that page table walks for a TLB entry type depend on.
+    template <TLB_entry_type ETYPE>
+    host_tlb_context get_host_tlb_context(void) {
+        const auto &s = m_m.get_state();
+        uint64_t priv = s.iflags.PRV;
+        // Code fetches ignore MPRV, and can never use SUM or MXR to reach a page
+        if constexpr (ETYPE == TLB_CODE) {
+            return host_tlb_context{s.satp, priv};
+        }
+        if (s.mstatus & MSTATUS_MPRV_MASK) {
+            priv = (s.mstatus & MSTATUS_MPP_MASK) >> MSTATUS_MPP_SHIFT;
+        }
+        return host_tlb_context{s.satp, priv | (s.mstatus & (MSTATUS_SUM_MASK | MSTATUS_MXR_MASK))};
+    }
+
+    template <TLB_entry_type ETYPE>
+    bool do_translate_vaddr_via_host_tlb(uint64_t vaddr, uint64_t *ppaddr) {
+        auto &host_tlb = m_m.get_state().host_tlb;
+        return host_tlb.is_enabled() && host_tlb.template translate<ETYPE>(get_host_tlb_context<ETYPE>(), vaddr, ppaddr);
+    }
+
+    template <TLB_entry_type ETYPE>
+    void do_insert_host_tlb_entry(uint64_t vaddr, uint64_t paddr, const page_table_walk &walk) {
+        auto &host_tlb = m_m.get_state().host_tlb;
+        // Translations that need no walk are not worth caching
+        if (!host_tlb.is_enabled() || walk.levels == 0) {
+            return;
+        }
+        host_tlb_entry entry{};
+        entry.vaddr_page = vaddr & ~PAGE_OFFSET_MASK;
+        entry.paddr_page = paddr & ~PAGE_OFFSET_MASK;
+        entry.levels = walk.levels;
+        for (int i = 0; i < walk.levels; ++i) {
+            // The walk only succeeds after reading every entry from memory, so the lookup cannot fail
+            pma_entry &pma = do_find_pma_entry<uint64_t>(walk.pte_addr[i]);
+            entry.hpte[i] = reinterpret_cast<const uint64_t *>( // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                do_get_host_memory(pma) + (walk.pte_addr[i] - pma.get_start()));
+            entry.pte[i] = walk.pte[i];
+        }
+        host_tlb.template insert<ETYPE>(get_host_tlb_context<ETYPE>(), entry);
+    }
+
     template <TLB_entry_type ETYPE>
     void do_flush_tlb_entry(uint64_t eidx) {
         tlb_hot_entry &tlbhe = m_m.get_state().tlb.hot[ETYPE][eidx];
@@ -600,6 +630,10 @@ private:
         do_flush_tlb_type<TLB_WRITE>();
     }
 
+    decoded_insn_slot *do_get_decoded_insn_slots(const unsigned char *hpage) {
+        return m_m.get_state().dcache.get_page_slots(hpage);
+    }
+
 #ifdef DUMP_COUNTERS
     machine_statistics &do_get_statistics() {
         return m_m.get_state().stats;
@@ -0,0 +1,190 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <array>
+#include <cfenv>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#if defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
+
+#include "host-float.h"
+#include "riscv-constants.h"
+#include "soft-float.h"
+
+using namespace cartesi;
+
+/// \brief Generates a random operand biased towards cases the host FPU path must get right or hand over to soft-float
+/// \param gen Random number generator
+/// \returns Operand bits
+template <typename SFLOAT>
+static typename SFLOAT::F_UINT random_float_operand(std::mt19937_64 &gen) {
+    using F_UINT = typename SFLOAT::F_UINT;
+    const auto bits = static_cast<F_UINT>(gen());
+    const F_UINT sign = bits & SFLOAT::SIGN_MASK;
+    F_UINT mant = bits & SFLOAT::MANT_MASK;
+    // Few significant bits make exact results likely
+    if (gen() % 4 == 0) {
+        mant &= ~static_cast<F_UINT>(SFLOAT::MANT_MASK >> (gen() % 8));
+    }
+    F_UINT exp = 0;
+    switch (gen() % 8) {
+        case 0: // any exponent, including zeros, subnormals, infinities and NaNs
+            exp = static_cast<F_UINT>(gen()) & SFLOAT::EXP_MASK;
+            break;
+        case 1: // close to the underflow threshold
+            exp = static_cast<F_UINT>(gen() % (3 * SFLOAT::MANT_SIZE));
+            break;
+        case 2: // close to the overflow threshold
+            exp = SFLOAT::EXP_MASK - 1 - static_cast<F_UINT>(gen() % (3 * SFLOAT::MANT_SIZE));
+            break;
+        case 3: // zero
+            return sign;
+        default: // close to one
+            exp = SFLOAT::EXP_MASK / 2 - 8 + static_cast<F_UINT>(gen() % 16);
+            break;
+    }
+    return sign | (exp << SFLOAT::MANT_SIZE) | mant;
+}
+
+/// \brief Checks that a host FPU operation matches the soft-float operation
+/// \param name Operation name
+/// \param hr Host FPU result
+/// \param hflags Host FPU exception flags
+/// \param sr Soft-float result
+/// \param sflags Soft-float exception flags
+/// \param a First operand
+/// \param b Second operand
+/// \returns True if results and flags match, false otherwise
+static bool check_same(const char *name, uint64_t hr, uint32_t hflags, uint64_t sr, uint32_t sflags, uint64_t a,
+    uint64_t b) {
+    if (hr != sr || hflags != sflags) {
+        (void) fprintf(stderr,
+            "%s %" PRIx64 " %" PRIx64 ": host gave %" PRIx64 " (flags %x), soft-float gave %" PRIx64 " (flags %x)\n",
+            name, a, b, hr, hflags, sr, sflags);
+        return false;
+    }
+    return true;
+}
+
+/// \brief Compares host FPU and soft-float operations on random operands
+/// \param seed Random number generator seed
+/// \returns True if all operations match, false otherwise
+template <typename HFLOAT, typename SFLOAT>
+static bool check_host_float_operations(uint64_t seed) {
+    using F_UINT = typename SFLOAT::F_UINT;
+    std::mt19937_64 gen{seed};
+    const std::array<FRM_modes, 2> rms{FRM_RNE, FRM_RTZ};
+    for (int i = 0; i < 1000000; ++i) {
+        const F_UINT a = random_float_operand<SFLOAT>(gen);
+        // Operands of similar magnitudes exercise cancellation
+        const F_UINT b =
+            (gen() % 4 == 0) ? a + static_cast<F_UINT>(gen() % 16) - 8 : random_float_operand<SFLOAT>(gen);
+        const auto rm = rms[i % rms.size()];
+        uint32_t hflags = 0;
+        uint32_t sflags = 0;
+        F_UINT hr = HFLOAT::add(a, b, rm, &hflags);
+        F_UINT sr = SFLOAT::add(a, b, rm, &sflags);
+        if (!check_same("add", hr, hflags, sr, sflags, a, b)) {
+            return false;
+        }
+        hflags = sflags = 0;
+        hr = HFLOAT::mul(a, b, rm, &hflags);
+        sr = SFLOAT::mul(a, b, rm, &sflags);
+        if (!check_same("mul", hr, hflags, sr, sflags, a, b)) {
+            return false;
+        }
+        hflags = sflags = 0;
+        hr = HFLOAT::div(a, b, rm, &hflags);
+        sr = SFLOAT::div(a, b, rm, &sflags);
+        if (!check_same("div", hr, hflags, sr, sflags, a, b)) {
+            return false;
+        }
+        hflags = sflags = 0;
+        hr = HFLOAT::sqrt(a, rm, &hflags);
+        sr = SFLOAT::sqrt(a, rm, &sflags);
+        if (!check_same("sqrt", hr, hflags, sr, sflags, a, 0)) {
+            return false;
+        }
+        // Products of square roots are often exact
+        hflags = sflags = 0;
+        const F_UINT c = sr;
+        hr = HFLOAT::mul(c, c, rm, &hflags);
+        sr = SFLOAT::mul(c, c, rm, &sflags);
+        if (!check_same("mul", hr, hflags, sr, sflags, c, c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// \brief Compares host FPU and soft-float operations in both formats
+/// \param mode Description of the host FPU mode
+/// \returns True if all operations match, false otherwise
+static bool check_host_float(const char *mode) {
+    (void) fprintf(stderr, "checking host FPU operations %s\n", mode);
+    // Subnormal operands and results must not reach the host FPU
+    // (volatile keeps the compiler from evaluating the sum in its own default mode)
+    volatile uint64_t a = 0x3;
+    volatile uint64_t b = 0x5;
+    uint32_t fflags = 0;
+    if (!check_same("add", i_hfloat64::add(a, b, FRM_RNE, &fflags), fflags, 0x8, 0, a, b)) {
+        return false;
+    }
+    return check_host_float_operations<i_hfloat32, i_sfloat32>(32) &&
+        check_host_float_operations<i_hfloat64, i_sfloat64>(64);
+}
+
+/// \brief Makes the host FPU flush subnormal operands and results to zero, where supported
+/// \returns True if the mode was changed, false otherwise
+static bool set_host_flush_to_zero() {
+#if defined(__x86_64__)
+    // Flush-to-zero and denormals-are-zero bits of MXCSR
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+    return true;
+#elif defined(__aarch64__)
+    // Flush-to-zero bit of FPCR
+    uint64_t fpcr = 0;
+    asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr |= UINT64_C(1) << 24;
+    asm volatile("msr fpcr, %0" : : "r"(fpcr));
+    return true;
+#else
+    return false;
+#endif
+}
+
+int main() {
+    if (!check_host_float("in the default mode")) {
+        return 1;
+    }
+    if (std::fesetround(FE_UPWARD) != 0 || !check_host_float("rounding upward")) {
+        return 1;
+    }
+    if (std::fesetround(FE_TONEAREST) != 0) {
+        return 1;
+    }
+    if (set_host_flush_to_zero() && !check_host_float("flushing subnormals to zero")) {
+        return 1;
+    }
+    (void) fprintf(stderr, "passed\n");
+    return 0;
+}
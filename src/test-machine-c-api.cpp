@@ -20,6 +20,11 @@
 #include <tuple>
 #include <vector>
 
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "access-log-binary.h"
 #include "grpc-machine-c-api.h"
 #include "json-util.h"
 #include "machine-c-api.h"
@@ -179,6 +184,33 @@ public:
 protected:
     cm_machine_config _machine_config;
 
+    // Layout of the files with per-page data stored with machines (see page_file_header in machine.cpp)
+    static constexpr uint64_t _page_file_header_size = 8 + 4 + 4 + 8; // magic, version, log2 page size and count
+    static constexpr uint64_t _page_address_size = 8;
+    static constexpr uint64_t _page_hashes_entry_size = _page_address_size + sizeof(cm_hash);
+    static constexpr uint64_t _delta_pages_entry_size = _page_address_size + 4096;
+
+    /// \brief Loads a stored machine and checks it against the root hash it had when stored
+    /// \param dir Directory the machine was stored in
+    /// \param origin_hash Root hash of the machine when stored
+    /// \returns Loaded machine, to be deleted with cm_delete_machine
+    cm_machine *_load_and_check_root_hash(const std::filesystem::path &dir, const cm_hash &origin_hash) {
+        cm_machine *restored_machine{};
+        char *err_msg{};
+        int error_code = cm_load_machine(dir.c_str(), &_runtime_config, &restored_machine, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        cm_hash restored_hash{};
+        error_code = cm_get_root_hash(restored_machine, &restored_hash, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_CHECK_EQUAL(0, memcmp(origin_hash, restored_hash, sizeof(cm_hash)));
+        bool ret{};
+        error_code = cm_verify_merkle_tree(restored_machine, &ret, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_CHECK(ret);
+        return restored_machine;
+    }
+
     static void _clone_machine_config(const cm_machine_config *source, cm_machine_config *target) {
         target->processor = source->processor;
         target->ram.length = source->ram.length;
@@ -602,6 +634,339 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(serde_complex_test, ordinary_machine_fixture) {
     cm_delete_machine(restored_machine);
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(load_machine_page_hashes_test, incomplete_machine_fixture) {
+    // Enough non-pristine pages for only a sample of them to be hashed again on load
+    _machine_config.ram.length = 4 << 20;
+    cm_machine *machine{};
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    std::array<unsigned char, 16> data{};
+    data.fill(0xda);
+    for (uint64_t page = 0; page < (_machine_config.ram.length >> 12); ++page) {
+        error_code = cm_write_memory(machine, 0x80000000 + (page << 12), data.data(), data.size(), &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    }
+    cm_hash origin_hash{};
+    error_code = cm_get_root_hash(machine, &origin_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    const auto dir = std::filesystem::temp_directory_path() / "test-page-hashes-machine";
+    std::filesystem::remove_all(dir);
+    error_code = cm_store(machine, dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    cm_delete_machine(machine);
+    const auto page_hashes_path = dir / "page-hashes";
+    BOOST_REQUIRE(std::filesystem::exists(page_hashes_path));
+
+    // Stored page hashes are reused
+    cm_delete_machine(_load_and_check_root_hash(dir, origin_hash));
+
+    // A stale hash for a page that is not in the sample is caught by the root hash check,
+    // and then all pages are hashed again
+    {
+        // Skip the header, the first entry, and the address in the second entry
+        std::fstream f(page_hashes_path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(_page_file_header_size + _page_hashes_entry_size + _page_address_size);
+        f.put(0);
+    }
+    cm_delete_machine(_load_and_check_root_hash(dir, origin_hash));
+
+    // Machines stored without page hashes still load
+    std::filesystem::remove(page_hashes_path);
+    cm_delete_machine(_load_and_check_root_hash(dir, origin_hash));
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(store_delta_test, incomplete_machine_fixture) {
+    cm_machine *machine{};
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    const auto tmp = std::filesystem::temp_directory_path();
+    const auto base_dir = tmp / "test-delta-base-machine";
+    const auto delta1_dir = tmp / "test-delta1-machine";
+    const auto delta2_dir = tmp / "test-delta2-machine";
+    const auto compacted_dir = tmp / "test-delta-compacted-machine";
+    for (const auto &dir : {base_dir, delta1_dir, delta2_dir, compacted_dir}) {
+        std::filesystem::remove_all(dir);
+    }
+    std::array<unsigned char, 16> data{};
+    data.fill(0xda);
+    error_code = cm_write_memory(machine, 0x80000000, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_store(machine, base_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    // Each delta only has the pages written since its base
+    data.fill(0xdb);
+    error_code = cm_write_memory(machine, 0x80001000, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_store_delta(machine, delta1_dir.c_str(), base_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    data.fill(0xdc);
+    error_code = cm_write_memory(machine, 0x80000000, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_write_memory(machine, 0x80002000, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_store_delta(machine, delta2_dir.c_str(), delta1_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(std::filesystem::file_size(delta1_dir / "delta-pages"),
+        _page_file_header_size + 1 * _delta_pages_entry_size);
+    BOOST_CHECK_EQUAL(std::filesystem::file_size(delta2_dir / "delta-pages"),
+        _page_file_header_size + 2 * _delta_pages_entry_size);
+    cm_hash origin_hash{};
+    error_code = cm_get_root_hash(machine, &origin_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    cm_delete_machine(machine);
+
+    auto check_restored_hash = [&](const std::filesystem::path &dir) {
+        cm_machine *restored_machine = _load_and_check_root_hash(dir, origin_hash);
+        std::array<unsigned char, 16> read_data{};
+        error_code = cm_read_memory(restored_machine, 0x80001000, read_data.data(), read_data.size(), &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_CHECK_EQUAL(read_data[0], 0xdb);
+        cm_delete_machine(restored_machine);
+    };
+
+    check_restored_hash(delta2_dir);
+
+    // Compacting merges the chain into a single delta over the full machine
+    error_code = cm_compact_delta(delta2_dir.c_str(), compacted_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(std::filesystem::file_size(compacted_dir / "delta-pages"),
+        _page_file_header_size + 3 * _delta_pages_entry_size);
+    std::filesystem::remove_all(delta1_dir);
+    std::filesystem::remove_all(delta2_dir);
+    check_restored_hash(compacted_dir);
+
+    // A full machine is not a delta
+    error_code = cm_compact_delta(base_dir.c_str(), delta1_dir.c_str(), &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), "machine in '" + base_dir.string() + "' is not a delta");
+    cm_delete_cstring(err_msg);
+
+    std::filesystem::remove_all(base_dir);
+    std::filesystem::remove_all(compacted_dir);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(store_delta_base_cycle_test, incomplete_machine_fixture) {
+    cm_machine *machine{};
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    const auto tmp = std::filesystem::temp_directory_path();
+    const auto base_dir = tmp / "test-delta-cycle-base-machine";
+    const auto delta1_dir = tmp / "test-delta-cycle1-machine";
+    const auto delta2_dir = tmp / "test-delta-cycle2-machine";
+    const auto compacted_dir = tmp / "test-delta-cycle-compacted-machine";
+    for (const auto &dir : {base_dir, delta1_dir, delta2_dir, compacted_dir}) {
+        std::filesystem::remove_all(dir);
+    }
+    error_code = cm_store(machine, base_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_store_delta(machine, delta1_dir.c_str(), base_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_store_delta(machine, delta2_dir.c_str(), delta1_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    cm_delete_machine(machine);
+
+    auto check_cycle_rejected = [&]() {
+        cm_machine *restored_machine{};
+        int error_code = cm_load_machine(delta2_dir.c_str(), &_runtime_config, &restored_machine, &err_msg);
+        BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
+        BOOST_REQUIRE_NE(err_msg, nullptr);
+        BOOST_CHECK_NE(std::string(err_msg).find("cycle"), std::string::npos);
+        cm_delete_cstring(err_msg);
+        err_msg = nullptr;
+        error_code = cm_compact_delta(delta2_dir.c_str(), compacted_dir.c_str(), &err_msg);
+        BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
+        BOOST_REQUIRE_NE(err_msg, nullptr);
+        BOOST_CHECK_NE(std::string(err_msg).find("cycle"), std::string::npos);
+        cm_delete_cstring(err_msg);
+        err_msg = nullptr;
+        BOOST_CHECK(!std::filesystem::exists(compacted_dir));
+    };
+
+    // A delta that is its own base
+    {
+        std::ofstream base_file(delta2_dir / "base", std::ios::binary | std::ios::trunc);
+        base_file << delta2_dir.string();
+    }
+    check_cycle_rejected();
+
+    // Two deltas that are each other's base, one of them by a relative path
+    {
+        std::ofstream base_file(delta2_dir / "base", std::ios::binary | std::ios::trunc);
+        base_file << delta1_dir.string();
+    }
+    {
+        std::ofstream base_file(delta1_dir / "base", std::ios::binary | std::ios::trunc);
+        base_file << (delta2_dir / ".." / delta2_dir.filename()).string();
+    }
+    check_cycle_rejected();
+
+    for (const auto &dir : {base_dir, delta1_dir, delta2_dir, compacted_dir}) {
+        std::filesystem::remove_all(dir);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(store_delta_shared_flash_drive_test, machine_flash_simple_fixture) {
+    cm_machine *machine{};
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    // Relative to the current working directory
+    const std::filesystem::path base_dir = "test-delta-shared-base-machine";
+    const std::filesystem::path delta_dir = "test-delta-shared-machine";
+    std::filesystem::remove_all(base_dir);
+    std::filesystem::remove_all(delta_dir);
+    const uint64_t flash_start = _machine_config.flash_drive.entry[0].start;
+    error_code = cm_store(machine, base_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    std::array<unsigned char, 16> data{};
+    data.fill(0xdb);
+    error_code = cm_write_memory(machine, flash_start, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_store_delta(machine, delta_dir.c_str(), base_dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    cm_delete_machine(machine);
+
+    // The delta finds its base from any working directory
+    const auto cwd = std::filesystem::current_path();
+    const auto absolute_base_dir = std::filesystem::absolute(base_dir);
+    const auto absolute_delta_dir = std::filesystem::absolute(delta_dir);
+    std::filesystem::current_path(std::filesystem::temp_directory_path());
+    cm_machine *restored_machine{};
+    error_code = cm_load_machine(absolute_delta_dir.c_str(), &_runtime_config, &restored_machine, &err_msg);
+    std::filesystem::current_path(cwd);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    // The flash drive of the delta is not shared, so neither the pages of the delta
+    // nor later writes reach the image stored with the base
+    std::array<unsigned char, 16> read_data{};
+    error_code = cm_read_memory(restored_machine, flash_start, read_data.data(), read_data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(read_data[0], 0xdb);
+    data.fill(0xdc);
+    error_code = cm_write_memory(restored_machine, flash_start, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    cm_delete_machine(restored_machine);
+    std::ifstream base_image(absolute_base_dir / "0080000000000000-3c00000.bin", std::ios::binary);
+    BOOST_REQUIRE(base_image.is_open());
+    BOOST_CHECK_EQUAL(base_image.get(), 'a');
+    base_image.close();
+
+    std::filesystem::remove_all(base_dir);
+    std::filesystem::remove_all(delta_dir);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(store_sparse_memory_test, incomplete_machine_fixture) {
+    _machine_config.ram.length = 16 << 20;
+    cm_machine *machine{};
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    // A single page in the middle of the range and one at its end have data
+    std::array<unsigned char, 16> data{};
+    data.fill(0xda);
+    for (const uint64_t address : {0x80000000 + (8 << 20), 0x80000000 + (16 << 20) - 4096}) {
+        error_code = cm_write_memory(machine, address, data.data(), data.size(), &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    }
+    cm_hash origin_hash{};
+    error_code = cm_get_root_hash(machine, &origin_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    const auto dir = std::filesystem::temp_directory_path() / "test-sparse-machine";
+    std::filesystem::remove_all(dir);
+    error_code = cm_store(machine, dir.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    cm_delete_machine(machine);
+    // Holes read as zeros, so image files keep the length of their ranges
+    BOOST_CHECK_EQUAL(std::filesystem::file_size(dir / "0000000080000000-1000000.bin"), 16 << 20);
+    // ...but the holes take no disk space, so only the two pages written are allocated
+    struct stat image_stat {};
+    BOOST_REQUIRE_EQUAL(stat((dir / "0000000080000000-1000000.bin").c_str(), &image_stat), 0);
+    BOOST_CHECK_LT(static_cast<uint64_t>(image_stat.st_blocks) * 512, UINT64_C(1) << 20);
+
+    // Pages in holes start pristine, and the rest is hashed as usual
+    std::filesystem::remove(dir / "page-hashes");
+    cm_machine *restored_machine = _load_and_check_root_hash(dir, origin_hash);
+    std::array<unsigned char, 16> read_data{};
+    error_code = cm_read_memory(restored_machine, 0x80000000 + (16 << 20) - 4096, read_data.data(), read_data.size(),
+        &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK(read_data == data);
+    cm_delete_machine(restored_machine);
+
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(map_ram_image_test, incomplete_machine_fixture) {
+    // An image shorter than RAM that does not end at a page boundary
+    const std::string ram_image_path = "./test-map-ram-image.bin";
+    std::vector<unsigned char> image(5000);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<unsigned char>(i % 251 + 1);
+    }
+    std::ofstream of(ram_image_path, std::ios::binary);
+    of.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+    of.close();
+    delete[] _machine_config.ram.image_filename;
+    _machine_config.ram.image_filename = new_cstr(ram_image_path.c_str());
+
+    char *err_msg{};
+    cm_machine *read_machine{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &read_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    cm_machine_runtime_config map_runtime_config = _runtime_config;
+    map_runtime_config.map_ram_image = true;
+    cm_machine *mapped_machine{};
+    error_code = cm_create_machine(&_machine_config, &map_runtime_config, &mapped_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    auto check_same_state = [&](cm_machine *a, cm_machine *b) {
+        std::array<unsigned char, 32> data_a{};
+        std::array<unsigned char, 32> data_b{};
+        BOOST_REQUIRE_EQUAL(cm_read_memory(a, 0x80000000 + 4984, data_a.data(), data_a.size(), &err_msg), 0);
+        BOOST_REQUIRE_EQUAL(cm_read_memory(b, 0x80000000 + 4984, data_b.data(), data_b.size(), &err_msg), 0);
+        BOOST_CHECK(data_a == data_b);
+        cm_hash hash_a{};
+        cm_hash hash_b{};
+        BOOST_REQUIRE_EQUAL(cm_get_root_hash(a, &hash_a, &err_msg), CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(cm_get_root_hash(b, &hash_b, &err_msg), CM_ERROR_OK);
+        BOOST_CHECK_EQUAL(0, memcmp(hash_a, hash_b, sizeof(cm_hash)));
+    };
+    check_same_state(read_machine, mapped_machine);
+
+    // Writes change the mapped RAM but not the image
+    const std::array<unsigned char, 16> data{'m', 'a', 'p', 'p', 'e', 'd'};
+    for (auto *m : {read_machine, mapped_machine}) {
+        BOOST_REQUIRE_EQUAL(cm_write_memory(m, 0x80000000 + 4992, data.data(), data.size(), &err_msg), 0);
+        BOOST_REQUIRE_EQUAL(cm_write_memory(m, 0x80000000 + 0x80000, data.data(), data.size(), &err_msg), 0);
+    }
+    check_same_state(read_machine, mapped_machine);
+    std::ifstream ifs(ram_image_path, std::ios::binary);
+    const std::vector<unsigned char> stored_image{std::istreambuf_iterator<char>(ifs), {}};
+    BOOST_CHECK(stored_image == image);
+
+    // Stored machines can be loaded with their RAM image mapped too
+    const auto dir = std::filesystem::temp_directory_path() / "test-map-ram-image-machine";
+    std::filesystem::remove_all(dir);
+    BOOST_REQUIRE_EQUAL(cm_store(mapped_machine, dir.c_str(), &err_msg), CM_ERROR_OK);
+    cm_machine *loaded_machine{};
+    error_code = cm_load_machine(dir.c_str(), &map_runtime_config, &loaded_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    check_same_state(read_machine, loaded_machine);
+
+    cm_delete_machine(loaded_machine);
+    cm_delete_machine(mapped_machine);
+    cm_delete_machine(read_machine);
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove(ram_image_path);
+}
+
 BOOST_AUTO_TEST_CASE_NOLINT(get_root_hash_null_machine_test) {
     cm_hash restored_hash;
     int error_code = cm_get_root_hash(nullptr, &restored_hash, nullptr);
@@ -729,6 +1094,106 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(get_proof_machine_hash_test, ordinary_machine_fix
     cm_delete_merkle_tree_proof(p);
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(get_multiproof_invalid_args_test, ordinary_machine_fixture) {
+    char *err_msg{};
+    cm_merkle_tree_multiproof *proof{};
+    const std::array<uint64_t, 2> addresses{0, 1};
+    int error_code = cm_get_multiproof(_machine, addresses.data(), addresses.size(), 3, &proof, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("address not aligned to log2_size"));
+    cm_delete_cstring(err_msg);
+
+    error_code = cm_get_multiproof(_machine, addresses.data(), 0, 3, &proof, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("no addresses"));
+    cm_delete_cstring(err_msg);
+
+    error_code = cm_get_multiproof(_machine, addresses.data(), 1, 65, &proof, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("invalid log2_size"));
+    cm_delete_cstring(err_msg);
+
+    error_code = cm_get_multiproof(_machine, addresses.data(), 1, 3, nullptr, nullptr);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(get_multiproof_test, ordinary_machine_fixture) {
+    char *err_msg{};
+    const uint64_t ram_start = 0x80000000;
+    const std::array<uint64_t, 4> data{0x0123456789abcdef, 0xfedcba9876543210, 0xdeadbeef, 0xcafebabe};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    int error_code = cm_write_memory(_machine, ram_start, reinterpret_cast<const unsigned char *>(data.data()),
+        sizeof(data), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    // Unsorted, with duplicates, in the same word, the same page, different pages, and pristine memory
+    const std::vector<uint64_t> addresses{ram_start + 0x10000, ram_start + 8, ram_start, 0x1000, ram_start + 8,
+        ram_start + 24, 0x50000000};
+    const std::vector<uint64_t> expected_addresses{0x1000, 0x50000000, ram_start, ram_start + 8, ram_start + 24,
+        ram_start + 0x10000};
+    cm_merkle_tree_multiproof *proof{};
+    error_code = cm_get_multiproof(_machine, addresses.data(), addresses.size(), 3, &proof, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    BOOST_CHECK_EQUAL(proof->log2_root_size, static_cast<size_t>(64));
+    BOOST_CHECK_EQUAL(proof->log2_target_size, static_cast<size_t>(3));
+    BOOST_REQUIRE_EQUAL(proof->target_hashes.count, expected_addresses.size());
+    BOOST_CHECK_EQUAL_COLLECTIONS(proof->target_addresses, proof->target_addresses + proof->target_hashes.count,
+        expected_addresses.begin(), expected_addresses.end());
+
+    // Each target matches its own proof, and shared siblings are listed only once
+    size_t proof_sibling_count = 0;
+    for (size_t i = 0; i < expected_addresses.size(); ++i) {
+        cm_merkle_tree_proof *p{};
+        error_code = cm_get_proof(_machine, expected_addresses[i], 3, &p, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_CHECK_EQUAL_COLLECTIONS(p->target_hash, p->target_hash + sizeof(cm_hash),
+            proof->target_hashes.entry[i], proof->target_hashes.entry[i] + sizeof(cm_hash));
+        BOOST_CHECK_EQUAL_COLLECTIONS(p->root_hash, p->root_hash + sizeof(cm_hash), proof->root_hash,
+            proof->root_hash + sizeof(cm_hash));
+        proof_sibling_count += p->sibling_hashes.count;
+        cm_delete_merkle_tree_proof(p);
+    }
+    BOOST_CHECK_LT(proof->sibling_hashes.count, proof_sibling_count);
+
+    bool result = false;
+    error_code = cm_verify_merkle_tree_multiproof(proof, &result, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK(result);
+
+    // Tampering with a target or a sibling hash breaks the proof
+    proof->target_hashes.entry[2][0] ^= 1;
+    error_code = cm_verify_merkle_tree_multiproof(proof, &result, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK(!result);
+    proof->target_hashes.entry[2][0] ^= 1;
+    proof->sibling_hashes.entry[proof->sibling_hashes.count - 1][0] ^= 1;
+    error_code = cm_verify_merkle_tree_multiproof(proof, &result, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK(!result);
+    proof->sibling_hashes.entry[proof->sibling_hashes.count - 1][0] ^= 1;
+    proof->sibling_hashes.count -= 1;
+    error_code = cm_verify_merkle_tree_multiproof(proof, &result, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK(!result);
+    proof->sibling_hashes.count += 1;
+
+    cm_delete_merkle_tree_multiproof(proof);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(get_proof_pristine_page_test, ordinary_machine_fixture) {
+    char *err_msg{};
+    cm_merkle_tree_proof *p{};
+    // Pristine RAM pages have no node in the Merkle tree
+    int error_code = cm_get_proof(_machine, 0x80010008, 3, &p, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(err_msg, nullptr);
+    auto verification = calculate_emulator_hash(_machine);
+    BOOST_CHECK_EQUAL_COLLECTIONS(verification.begin(), verification.end(), p->root_hash,
+        p->root_hash + sizeof(cm_hash));
+    cm_delete_merkle_tree_proof(p);
+}
+
 BOOST_AUTO_TEST_CASE_NOLINT(read_word_null_machine_test) {
     uint64_t word_value = 0;
     int error_code = cm_read_word(nullptr, 0x100, &word_value, nullptr);
@@ -1550,11 +2015,8 @@ BOOST_AUTO_TEST_CASE_NOLINT(snapshot_null_machine_test) {
 BOOST_FIXTURE_TEST_CASE_NOLINT(snapshot_basic_test, ordinary_machine_fixture) {
     char *err_msg = nullptr;
     int error_code = cm_snapshot(_machine, &err_msg);
-    std::string result = err_msg;
-    std::string origin("snapshot is not supported");
-    BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
-    BOOST_CHECK_EQUAL(origin, result);
-    cm_delete_cstring(err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(err_msg, nullptr);
 }
 
 BOOST_AUTO_TEST_CASE_NOLINT(rollback_null_machine_test) {
@@ -1566,12 +2028,111 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(rollback_basic_test, ordinary_machine_fixture) {
     char *err_msg = nullptr;
     int error_code = cm_rollback(_machine, &err_msg);
     std::string result = err_msg;
-    std::string origin("rollback is not supported");
+    std::string origin("no snapshot to roll back to");
     BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
     BOOST_CHECK_EQUAL(origin, result);
     cm_delete_cstring(err_msg);
 }
 
+BOOST_AUTO_TEST_CASE_NOLINT(commit_null_machine_test) {
+    int error_code = cm_commit(nullptr, nullptr);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(commit_basic_test, ordinary_machine_fixture) {
+    char *err_msg = nullptr;
+    int error_code = cm_commit(_machine, &err_msg);
+    std::string result = err_msg;
+    std::string origin("no snapshot to commit");
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
+    BOOST_CHECK_EQUAL(origin, result);
+    cm_delete_cstring(err_msg);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(snapshot_rollback_commit_test, incomplete_machine_fixture) {
+    // Loads and stores to 768 pages in a row, so pages keep entering and leaving the write TLB
+    // loop: auipc t0, 0x100; li t1, 768
+    // 1: ld t3, 0(t0); add a0, a0, t3; sd a0, 8(t0); lui t4, 1; add t0, t0, t4; addi t1, t1, -1; bnez t1, 1b
+    // j loop
+    const std::array<uint32_t, 10> code{0x00100297, 0x30000313, 0x0002be03, 0x01c50533, 0x00a2b423, 0x00001eb7,
+        0x01d282b3, 0xfff30313, 0xfe0314e3, 0xfddff06f};
+    const std::array<unsigned char, 16> data{'s', 'n', 'a', 'p', 's', 'h', 'o', 't'};
+    _machine_config.ram.length = 8 << 20;
+    // The microarchitecture stores to the RAM of the big machine and halts
+    const std::string uarch_ram_path = "./test-snapshot-uarch-ram.bin";
+    const std::array<uint32_t, 7> uarch_code{
+        0x07b00513,                                                                        // li a0, 123
+        0x20100293,                                                                        // li t0, 0x201
+        0x01629293,                                                                        // slli t0, t0, 22
+        0x00a2b023,                                                                        // sd a0, 0(t0)
+        ((UARCH_HALT_FLAG_SHADDOW_ADDR_DEF >> 12) << 12) | static_cast<uint32_t>(0x02b7), // li t0, halt flag
+        0x00100313,                                                                        // li t1, 1
+        0x0062b023,                                                                        // sd t1, 0(t0)
+    };
+    std::ofstream of(uarch_ram_path, std::ios::binary);
+    of.write(reinterpret_cast<const char *>(uarch_code.data()), sizeof(uarch_code));
+    of.close();
+    _set_uarch_ram_image(uarch_ram_path);
+    cm_machine *machine{};
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_write_memory(machine, 0x80000000, reinterpret_cast<const unsigned char *>(code.data()),
+                            code.size() * sizeof(uint32_t), &err_msg),
+        CM_ERROR_OK);
+    // Start with pages in the write TLB
+    BOOST_REQUIRE_EQUAL(cm_machine_run(machine, 5000, nullptr, &err_msg), CM_ERROR_OK);
+
+    cm_hash snapshot_hash{};
+    uint64_t snapshot_mcycle{};
+    BOOST_REQUIRE_EQUAL(cm_get_root_hash(machine, &snapshot_hash, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_read_mcycle(machine, &snapshot_mcycle, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_snapshot(machine, &err_msg), CM_ERROR_OK);
+
+    // Change memory, registers, and the Merkle tree in all the ways there are
+    cm_hash run_hash{};
+    BOOST_REQUIRE_EQUAL(cm_machine_run(machine, 30000, nullptr, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_get_root_hash(machine, &run_hash, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_write_memory(machine, 0x80400000, data.data(), data.size(), &err_msg), CM_ERROR_OK);
+    auto status{CM_UARCH_BREAK_REASON_REACHED_TARGET_CYCLE};
+    BOOST_REQUIRE_EQUAL(cm_machine_run_uarch(machine, 100, &status, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(status, CM_UARCH_BREAK_REASON_UARCH_HALTED);
+    BOOST_REQUIRE_EQUAL(cm_reset_uarch(machine, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_machine_run(machine, 40000, nullptr, &err_msg), CM_ERROR_OK);
+
+    // Rolling back restores the state as it was, hash included
+    BOOST_REQUIRE_EQUAL(cm_rollback(machine, &err_msg), CM_ERROR_OK);
+    cm_hash hash{};
+    uint64_t mcycle{};
+    bool consistent{};
+    BOOST_REQUIRE_EQUAL(cm_read_mcycle(machine, &mcycle, &err_msg), CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(mcycle, snapshot_mcycle);
+    BOOST_REQUIRE_EQUAL(cm_verify_dirty_page_maps(machine, &consistent, &err_msg), CM_ERROR_OK);
+    BOOST_CHECK(consistent);
+    BOOST_REQUIRE_EQUAL(cm_get_root_hash(machine, &hash, &err_msg), CM_ERROR_OK);
+    BOOST_CHECK_EQUAL_COLLECTIONS(hash, hash + sizeof(cm_hash), snapshot_hash, snapshot_hash + sizeof(cm_hash));
+    BOOST_REQUIRE_EQUAL(cm_verify_merkle_tree(machine, &consistent, &err_msg), CM_ERROR_OK);
+    BOOST_CHECK(consistent);
+
+    // ... and the machine runs exactly as it did the first time
+    BOOST_REQUIRE_EQUAL(cm_machine_run(machine, 30000, nullptr, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_get_root_hash(machine, &hash, &err_msg), CM_ERROR_OK);
+    BOOST_CHECK_EQUAL_COLLECTIONS(hash, hash + sizeof(cm_hash), run_hash, run_hash + sizeof(cm_hash));
+
+    // Committing keeps the changes
+    BOOST_REQUIRE_EQUAL(cm_snapshot(machine, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_write_memory(machine, 0x80400000, data.data(), data.size(), &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_get_root_hash(machine, &run_hash, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_commit(machine, &err_msg), CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(cm_get_root_hash(machine, &hash, &err_msg), CM_ERROR_OK);
+    BOOST_CHECK_EQUAL_COLLECTIONS(hash, hash + sizeof(cm_hash), run_hash, run_hash + sizeof(cm_hash));
+    error_code = cm_rollback(machine, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
+    cm_delete_cstring(err_msg);
+    cm_delete_machine(machine);
+    std::filesystem::remove(uarch_ram_path);
+}
+
 BOOST_AUTO_TEST_CASE_NOLINT(read_x_null_machine_test) {
     uint64_t val{};
     int error_code = cm_read_x(nullptr, 4, &val, nullptr);
@@ -2052,6 +2613,252 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(log_uarch_step_until_halt, access_log_machine_fix
     BOOST_REQUIRE_EQUAL(halt, 1);
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(log_uarch_step_page_hash_cache_test, access_log_machine_fixture) {
+    // Fewer cached pages than pages proved, so entries are also replaced
+    cm_machine_runtime_config cache_runtime_config{_runtime_config};
+    cache_runtime_config.page_hash_cache_size = 2;
+    cm_machine *cache_machine{};
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &cache_runtime_config, &cache_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    const std::array<cm_machine *, 2> machines{_machine, cache_machine};
+    std::array<cm_hash, 2> hashes{};
+    for (int step = 0; step < 4; ++step) {
+        for (size_t i = 0; i < machines.size(); ++i) {
+            cm_hash hash_before{};
+            error_code = cm_get_root_hash(machines[i], &hash_before, &err_msg);
+            BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+            error_code = cm_log_uarch_step(machines[i], _log_type, false, &_access_log, &err_msg);
+            BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+            error_code = cm_get_root_hash(machines[i], &hashes[i], &err_msg);
+            BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+            // The proofs in the log must match the root hashes before and after the step
+            error_code = cm_verify_uarch_step_state_transition(&hash_before, _access_log, &hashes[i],
+                &_runtime_config, false, &err_msg);
+            BOOST_CHECK_EQUAL(error_code, CM_ERROR_OK);
+            cm_delete_access_log(_access_log);
+        }
+        BOOST_CHECK_EQUAL_COLLECTIONS(hashes[0], hashes[0] + sizeof(cm_hash), hashes[1], hashes[1] + sizeof(cm_hash));
+    }
+
+    // Proofs of words in a page written to one word at a time, then all at once
+    const uint64_t page_address = 0x80001000;
+    std::array<unsigned char, 4096> page{};
+    for (size_t j = 0; j < 4; ++j) {
+        const uint64_t word = 0x0123456789abcdef * (j + 1);
+        for (auto *machine : machines) {
+            error_code = cm_write_memory(machine, page_address + 8 * j * j,
+                reinterpret_cast<const unsigned char *>(&word), sizeof(word), &err_msg);
+            BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        }
+        if (j == 3) {
+            page.fill(0x5a);
+            for (auto *machine : machines) {
+                error_code = cm_write_memory(machine, page_address, page.data(), page.size(), &err_msg);
+                BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+            }
+        }
+        std::array<cm_merkle_tree_proof *, 2> proofs{};
+        for (size_t i = 0; i < machines.size(); ++i) {
+            error_code = cm_get_proof(machines[i], page_address + 8 * j, 3, &proofs[i], &err_msg);
+            BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        }
+        BOOST_CHECK_EQUAL_COLLECTIONS(proofs[0]->root_hash, proofs[0]->root_hash + sizeof(cm_hash),
+            proofs[1]->root_hash, proofs[1]->root_hash + sizeof(cm_hash));
+        BOOST_CHECK_EQUAL_COLLECTIONS(proofs[0]->target_hash, proofs[0]->target_hash + sizeof(cm_hash),
+            proofs[1]->target_hash, proofs[1]->target_hash + sizeof(cm_hash));
+        BOOST_REQUIRE_EQUAL(proofs[0]->sibling_hashes.count, proofs[1]->sibling_hashes.count);
+        for (size_t k = 0; k < proofs[0]->sibling_hashes.count; ++k) {
+            BOOST_CHECK_EQUAL_COLLECTIONS(proofs[0]->sibling_hashes.entry[k],
+                proofs[0]->sibling_hashes.entry[k] + sizeof(cm_hash), proofs[1]->sibling_hashes.entry[k],
+                proofs[1]->sibling_hashes.entry[k] + sizeof(cm_hash));
+        }
+        cm_delete_merkle_tree_proof(proofs[0]);
+        cm_delete_merkle_tree_proof(proofs[1]);
+    }
+
+    cm_delete_machine(cache_machine);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(access_log_binary_test, access_log_machine_fixture) {
+    cm_hash hash_before{};
+    cm_hash hash_after{};
+    char *err_msg{};
+    int error_code = cm_get_root_hash(_machine, &hash_before, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_log_uarch_step(_machine, _log_type, false, &_access_log, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_get_root_hash(_machine, &hash_after, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    unsigned char *data{};
+    size_t length{};
+    error_code = cm_encode_access_log_binary(_access_log, &data, &length, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    // Sibling hashes shared across accesses are encoded only once
+    size_t sibling_hashes_count = 0;
+    for (size_t i = 0; i < _access_log->accesses.count; ++i) {
+        sibling_hashes_count += _access_log->accesses.entry[i].sibling_hashes->count;
+    }
+    BOOST_CHECK_LT(length, sibling_hashes_count * sizeof(cm_hash));
+
+    cm_access_log *decoded_log{};
+    error_code = cm_decode_access_log_binary(data, length, &decoded_log, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_verify_uarch_step_state_transition(&hash_before, decoded_log, &hash_after, &_runtime_config,
+        false, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(decoded_log->accesses.count, _access_log->accesses.count);
+    BOOST_REQUIRE_EQUAL(decoded_log->notes.count, _access_log->notes.count);
+    for (size_t i = 0; i < decoded_log->notes.count; ++i) {
+        BOOST_CHECK_EQUAL(std::string(decoded_log->notes.entry[i]), std::string(_access_log->notes.entry[i]));
+    }
+    BOOST_REQUIRE_EQUAL(decoded_log->brackets.count, _access_log->brackets.count);
+    for (size_t i = 0; i < decoded_log->brackets.count; ++i) {
+        BOOST_CHECK_EQUAL(decoded_log->brackets.entry[i].where, _access_log->brackets.entry[i].where);
+        BOOST_CHECK_EQUAL(std::string(decoded_log->brackets.entry[i].text),
+            std::string(_access_log->brackets.entry[i].text));
+    }
+
+    // Encoding the decoded log gives the same bytes
+    unsigned char *reencoded_data{};
+    size_t reencoded_length{};
+    error_code = cm_encode_access_log_binary(decoded_log, &reencoded_data, &reencoded_length, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL_COLLECTIONS(data, data + length, reencoded_data, reencoded_data + reencoded_length);
+    cm_delete_access_log_binary(reencoded_data);
+    cm_delete_access_log(decoded_log);
+
+    // Truncated, extended and corrupt logs are rejected
+    error_code = cm_decode_access_log_binary(data, length - 1, &decoded_log, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("truncated binary access log"));
+    cm_delete_cstring(err_msg);
+    std::vector<unsigned char> extended(data, data + length);
+    extended.push_back(0);
+    error_code = cm_decode_access_log_binary(extended.data(), extended.size(), &decoded_log, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("trailing data after binary access log"));
+    cm_delete_cstring(err_msg);
+    data[4] = cartesi::ACCESS_LOG_BINARY_VERSION + 1;
+    error_code = cm_decode_access_log_binary(data, length, &decoded_log, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("unsupported binary access log version 2"));
+    cm_delete_cstring(err_msg);
+    data[0] = 0;
+    error_code = cm_decode_access_log_binary(data, length, &decoded_log, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("not a binary access log"));
+    cm_delete_cstring(err_msg);
+    cm_delete_access_log_binary(data);
+
+    error_code = cm_encode_access_log_binary(_access_log, nullptr, &length, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("invalid data output"));
+    cm_delete_cstring(err_msg);
+    error_code = cm_decode_access_log_binary(nullptr, 0, &decoded_log, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("invalid data"));
+    cm_delete_cstring(err_msg);
+    cm_delete_access_log(_access_log);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(verify_uarch_step_state_transitions_test, access_log_machine_fixture) {
+    constexpr size_t count = 3;
+    std::array<cm_hash, count> hashes_before{};
+    std::array<cm_hash, count> hashes_after{};
+    std::array<cm_access_log *, count> logs{};
+    char *err_msg{};
+    for (size_t i = 0; i < count; ++i) {
+        int error_code = cm_get_root_hash(_machine, &hashes_before[i], &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        error_code = cm_log_uarch_step(_machine, _log_type, false, &logs[i], &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        error_code = cm_get_root_hash(_machine, &hashes_after[i], &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    }
+    // Break the middle transition
+    hashes_after[1][0] ^= 1;
+
+    std::array<char *, count> log_err_msgs{};
+    int error_code = cm_verify_uarch_step_state_transitions(hashes_before.data(), logs.data(), hashes_after.data(),
+        count, &_runtime_config, false, log_err_msgs.data(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK(log_err_msgs[0] == nullptr);
+    BOOST_CHECK(log_err_msgs[1] != nullptr);
+    BOOST_CHECK(log_err_msgs[2] == nullptr);
+    for (auto *msg : log_err_msgs) {
+        cm_delete_cstring(msg);
+    }
+
+    error_code = cm_verify_uarch_step_state_transitions(hashes_before.data(), logs.data(), hashes_after.data(), count,
+        &_runtime_config, false, nullptr, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("invalid log error messages output"));
+    cm_delete_cstring(err_msg);
+
+    for (auto *log : logs) {
+        cm_delete_access_log(log);
+    }
+    cm_delete_access_log(_access_log);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(log_uarch_steps_test, access_log_machine_fixture) {
+    // Log each step on its own first, then roll back and log them all at once
+    constexpr size_t count = 4;
+    std::array<cm_hash, count + 1> hashes{};
+    char *err_msg{};
+    int error_code = cm_snapshot(_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_get_root_hash(_machine, &hashes[0], &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    for (size_t i = 0; i < count; ++i) {
+        error_code = cm_log_uarch_step(_machine, _log_type, false, &_access_log, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        cm_delete_access_log(_access_log);
+        error_code = cm_get_root_hash(_machine, &hashes[i + 1], &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    }
+    error_code = cm_rollback(_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    // The microarchitecture halts after the last step, so no more logs come back than steps were taken
+    cm_access_log_array *logs{};
+    error_code = cm_log_uarch_steps(_machine, count + 10, _log_type, false, &logs, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(logs->count, count);
+    std::array<char *, count> log_err_msgs{};
+    error_code = cm_verify_uarch_step_state_transitions(hashes.data(), logs->entry, hashes.data() + 1, count,
+        &_runtime_config, false, log_err_msgs.data(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    for (auto *msg : log_err_msgs) {
+        BOOST_CHECK(msg == nullptr);
+        cm_delete_cstring(msg);
+    }
+    cm_delete_access_log_array(logs);
+    cm_hash hash_after{};
+    error_code = cm_get_root_hash(_machine, &hash_after, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL_COLLECTIONS(hash_after, hash_after + sizeof(cm_hash), hashes[count],
+        hashes[count] + sizeof(cm_hash));
+
+    // A halted microarchitecture still takes one step
+    error_code = cm_log_uarch_steps(_machine, count, _log_type, false, &logs, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(logs->count, 1);
+    cm_delete_access_log_array(logs);
+    error_code = cm_log_uarch_steps(_machine, 0, _log_type, false, &logs, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(logs->count, 0);
+    cm_delete_access_log_array(logs);
+
+    error_code = cm_log_uarch_steps(_machine, count, _log_type, false, nullptr, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("invalid access logs output"));
+    cm_delete_cstring(err_msg);
+}
+
 BOOST_FIXTURE_TEST_CASE_NOLINT(step_complex_test, access_log_machine_fixture) {
     char *err_msg{};
     cm_hash hash0;
@@ -2179,6 +2986,211 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(machine_run_long_cycle_test, ordinary_machine_fix
     BOOST_CHECK_EQUAL_COLLECTIONS(verification.begin(), verification.end(), hash_end, hash_end + sizeof(cm_hash));
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(machine_run_with_checkpoints_test, ordinary_machine_fixture) {
+    // Run to each checkpoint on its own first, then roll back and run with checkpoints
+    constexpr uint64_t period = 1000;
+    constexpr size_t count = 5;
+    std::array<cm_hash, count + 1> hashes{};
+    char *err_msg{};
+    int error_code = cm_snapshot(_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_get_root_hash(_machine, &hashes[0], &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    for (size_t i = 0; i < count; ++i) {
+        error_code = cm_machine_run(_machine, (i + 1) * period, nullptr, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        error_code = cm_get_root_hash(_machine, &hashes[i + 1], &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    }
+    error_code = cm_rollback(_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    cm_checkpoint_array *checkpoints{};
+    error_code = cm_machine_run_with_checkpoints(_machine, count * period, period, &checkpoints, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(checkpoints->count, count + 1);
+    for (size_t i = 0; i <= count; ++i) {
+        BOOST_CHECK_EQUAL(checkpoints->entry[i].mcycle, i * period);
+        BOOST_CHECK_EQUAL_COLLECTIONS(checkpoints->entry[i].root_hash,
+            checkpoints->entry[i].root_hash + sizeof(cm_hash), hashes[i], hashes[i] + sizeof(cm_hash));
+    }
+    cm_delete_checkpoint_array(checkpoints);
+    cm_hash hash_after{};
+    error_code = cm_get_root_hash(_machine, &hash_after, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL_COLLECTIONS(hash_after, hash_after + sizeof(cm_hash), hashes[count],
+        hashes[count] + sizeof(cm_hash));
+
+    error_code = cm_machine_run_with_checkpoints(_machine, count * period, 0, &checkpoints, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("checkpoint period cannot be zero"));
+    cm_delete_cstring(err_msg);
+
+    error_code = cm_machine_run_with_checkpoints(_machine, count * period, period, nullptr, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(std::string(err_msg), std::string("invalid checkpoints output"));
+    cm_delete_cstring(err_msg);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(transaction_test, ordinary_machine_fixture) {
+    const uint64_t address = 0x80000000;
+    const std::string data = "hello, transaction";
+    const nlohmann::json operations = {
+        {{"method", "write_memory"}, {"params", {address, cartesi::encode_base64(data)}}},
+        {{"method", "read_csr"}, {"params", {"mcycle"}}},
+        {{"method", "run"}, {"params", {1000}}},
+        {{"method", "write_csr"}, {"params", {"mscratch", {{"$result", 1}}}}},
+        {{"method", "read_csr"}, {"params", {"mscratch"}}},
+        {{"method", "read_memory"}, {"params", {address, data.size()}}},
+        {{"method", "get_root_hash"}},
+        {{"method", "read_csr"}, {"params", {{"csr", "mscratch"}}}},
+    };
+    char *err_msg{};
+    char *results{};
+    int error_code = cm_transaction(_machine, operations.dump().c_str(), &results, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    const auto jresults = nlohmann::json::parse(results);
+    cm_delete_cstring(results);
+    BOOST_REQUIRE_EQUAL(jresults.size(), operations.size());
+    BOOST_CHECK_EQUAL(jresults[2].get<std::string>(), "reached_target_mcycle");
+    BOOST_CHECK_EQUAL(jresults[4].get<uint64_t>(), jresults[1].get<uint64_t>());
+    BOOST_CHECK_EQUAL(cartesi::decode_base64(jresults[5].get<std::string>()), data);
+    // Arguments can also be given by name
+    BOOST_CHECK_EQUAL(jresults[7].get<uint64_t>(), jresults[1].get<uint64_t>());
+
+    cm_hash hash{};
+    error_code = cm_get_root_hash(_machine, &hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    const auto hash_str = cartesi::decode_base64(jresults[6].get<std::string>());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    BOOST_CHECK_EQUAL(hash_str, std::string(reinterpret_cast<const char *>(hash), sizeof(cm_hash)));
+
+    // Operations run until the first failure
+    const nlohmann::json failing = {
+        {{"method", "write_csr"}, {"params", {"mscratch", 7}}},
+        {{"method", "read_csr"}, {"params", {"mscratch", {{"$result", 5}}}}},
+        {{"method", "write_csr"}, {"params", {"mscratch", 8}}},
+    };
+    error_code = cm_transaction(_machine, failing.dump().c_str(), &results, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    BOOST_CHECK_EQUAL(results, nullptr);
+    BOOST_REQUIRE_NE(err_msg, nullptr);
+    cm_delete_cstring(err_msg);
+    err_msg = nullptr;
+    uint64_t mscratch{};
+    error_code = cm_read_mscratch(_machine, &mscratch, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(mscratch, 7);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(machine_run_self_modifying_code_test, ordinary_machine_fixture) {
+    // loop: addi a0, a0, 1; j loop
+    std::array<uint32_t, 2> code{0x00150513, 0xffdff06f};
+    char *err_msg{};
+    int error_code = cm_write_memory(_machine, 0x80000000, reinterpret_cast<const unsigned char *>(code.data()),
+        code.size() * sizeof(uint32_t), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    error_code = cm_machine_run(_machine, 100, nullptr, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    uint64_t a0{};
+    error_code = cm_read_x(_machine, 10, &a0, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    BOOST_CHECK_EQUAL(a0, static_cast<uint64_t>(50));
+
+    // Replace the loop body with ori a0, a0, 0x100 after it has already been executed. It needs a different
+    // handler, so a stale decoded instruction would keep adding one instead
+    code[0] = 0x10056513;
+    error_code = cm_write_memory(_machine, 0x80000000, reinterpret_cast<const unsigned char *>(code.data()),
+        sizeof(uint32_t), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    error_code = cm_machine_run(_machine, 200, nullptr, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    error_code = cm_read_x(_machine, 10, &a0, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    BOOST_CHECK_EQUAL(a0, static_cast<uint64_t>(0x100 | 50));
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(machine_run_host_tlb_test, incomplete_machine_fixture) {
+    // Maps 1024 pages with Sv39, with the accessed and dirty bits clear, and switches to S-mode. Then, repeatedly:
+    // loads and stores to 768 of the pages in a row, so the shadow TLB keeps evicting its own entries;
+    // clears the accessed and dirty bits of one page table entry and swaps the pages of two others,
+    // issuing SFENCE.VMA only every 4th time
+    const std::array<uint32_t, 82> code{
+        0x008012b7, 0x00829293, 0x20040337, 0x4013031b, 0x0062b423, 0x20000337, 0x0cf3031b, 0x0062b823, 0x000803b7,
+        0x1013839b, 0x00c39393, 0x20041337, 0x8013031b, 0x0063b023, 0x20041337, 0xc013031b, 0x0063b423, 0x400813b7,
+        0x00139393, 0x20080337, 0x0073031b, 0x40000e13, 0x40000e93, 0x0063b023, 0x01d30333, 0x00838393, 0xfffe0e13,
+        0xfe0e18e3, 0xfff00313, 0x02c31313, 0x00130313, 0x01331313, 0x10030313, 0x18031073, 0x00002337, 0x8003031b,
+        0x30033073, 0x00001337, 0x8003031b, 0x30032073, 0x00000317, 0x01030313, 0x34131073, 0x30200073, 0x400004b7,
+        0x40081937, 0x00191913, 0x00000413, 0x00048293, 0x30000313, 0x0082be03, 0x01c50533, 0x00150513, 0x00a2b423,
+        0x00001eb7, 0x01d282b3, 0xfff30313, 0xfe0312e3, 0x02500f13, 0x03e40fb3, 0x30000f13, 0x03efffb3, 0x003f9f93,
+        0x01f90fb3, 0x000fbf03, 0xf3ff7f13, 0x01efb023, 0x00b00f13, 0x03e40fb3, 0x2ff00f13, 0x03efffb3, 0x003f9f93,
+        0x01f90fb3, 0x000fb383, 0x008fbe03, 0x01cfb023, 0x007fb423, 0x00347f13, 0x000f1463, 0x12000073, 0x00140413,
+        0xf7dff06f};
+    _machine_config.ram.length = 8 << 20;
+
+    cm_machine_runtime_config host_tlb_runtime_config{};
+    host_tlb_runtime_config.host_tlb.size = 1024;
+    host_tlb_runtime_config.host_tlb.ways = 4;
+    cm_machine_runtime_config small_host_tlb_runtime_config{};
+    small_host_tlb_runtime_config.host_tlb.size = 16;
+    small_host_tlb_runtime_config.host_tlb.ways = 1;
+
+    std::array<cm_hash, 3> hashes{};
+    std::array<uint64_t, 3> a0{};
+    std::array<const cm_machine_runtime_config *, 3> runtime_configs{&_runtime_config, &host_tlb_runtime_config,
+        &small_host_tlb_runtime_config};
+    for (size_t i = 0; i < runtime_configs.size(); ++i) {
+        cm_machine *machine{};
+        char *err_msg{};
+        int error_code = cm_create_machine(&_machine_config, runtime_configs[i], &machine, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        error_code = cm_write_memory(machine, 0x80000000, reinterpret_cast<const unsigned char *>(code.data()),
+            code.size() * sizeof(uint32_t), &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        // Break the run in a different number of segments for each machine
+        for (size_t j = 0; j <= i; ++j) {
+            error_code = cm_machine_run(machine, 500000 * (j + 1) / (i + 1), nullptr, &err_msg);
+            BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        }
+        error_code = cm_read_x(machine, 10, &a0[i], &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        error_code = cm_get_root_hash(machine, &hashes[i], &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        cm_delete_machine(machine);
+    }
+
+    // The host TLB must not change the machine state, shadow TLB and page tables included
+    for (size_t i = 1; i < runtime_configs.size(); ++i) {
+        BOOST_CHECK_EQUAL(a0[0], a0[i]);
+        BOOST_CHECK_EQUAL_COLLECTIONS(hashes[0], hashes[0] + sizeof(cm_hash), hashes[i],
+            hashes[i] + sizeof(cm_hash));
+    }
+
+    // Sets must have 1, 2, or 4 ways
+    host_tlb_runtime_config.host_tlb.ways = 3;
+    cm_machine *machine{};
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &host_tlb_runtime_config, &machine, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    std::string result = err_msg;
+    std::string origin("host TLB ways must be 1, 2, or 4");
+    BOOST_CHECK_EQUAL(origin, result);
+    cm_delete_cstring(err_msg);
+}
+
 BOOST_AUTO_TEST_CASE_NOLINT(machine_run_uarch_null_machine_test) {
     auto status{CM_UARCH_BREAK_REASON_REACHED_TARGET_CYCLE};
     int error_code = cm_machine_run_uarch(nullptr, 1000, &status, nullptr);
@@ -2379,6 +3391,146 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(machine_verify_merkle_tree_root_updates_test, ord
     BOOST_CHECK_EQUAL_COLLECTIONS(verification.begin(), verification.end(), end_hash, end_hash + sizeof(cm_hash));
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(machine_verify_merkle_tree_scattered_updates_test, ordinary_machine_fixture) {
+    char *err_msg{};
+
+    cm_hash start_hash;
+    int error_code = cm_get_root_hash(_machine, &start_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    // dirty pages at both ends of words of the dirty page map, and the very last page of ram
+    const uint64_t ram_pages = _machine_config.ram.length / 4096;
+    for (uint64_t page : {UINT64_C(0), UINT64_C(63), UINT64_C(64), UINT64_C(200), ram_pages - 1}) {
+        std::array<uint8_t, 8> data{};
+        data.fill(static_cast<uint8_t>(page + 1));
+        error_code = cm_write_memory(_machine, 0x80000000 + page * 4096 + 8, data.data(), data.size(), &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    }
+
+    cm_hash end_hash;
+    error_code = cm_get_root_hash(_machine, &end_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    auto verification = calculate_emulator_hash(_machine);
+    BOOST_CHECK_EQUAL_COLLECTIONS(verification.begin(), verification.end(), end_hash, end_hash + sizeof(cm_hash));
+    BOOST_CHECK(!std::equal(start_hash, start_hash + sizeof(cm_hash), end_hash));
+
+    bool result{};
+    error_code = cm_verify_dirty_page_maps(_machine, &result, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(err_msg, nullptr);
+    BOOST_CHECK(result);
+}
+
+static void write_every_page(cm_machine *machine, uint64_t length, uint8_t value) {
+    char *err_msg{};
+    std::array<uint8_t, 8> data{};
+    data.fill(value);
+    for (uint64_t offset = 0; offset < length; offset += 4096) {
+        int error_code = cm_write_memory(machine, 0x80000000 + offset, data.data(), data.size(), &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(machine_parallel_merkle_tree_update_after_fork_test, ordinary_machine_fixture) {
+    char *err_msg{};
+    cm_machine_runtime_config runtime_config{};
+    runtime_config.concurrency.update_merkle_tree = 4;
+    cm_machine *machine{};
+    int error_code = cm_create_machine(&_machine_config, &runtime_config, &machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    // update the tree with multiple threads before forking
+    write_every_page(machine, _machine_config.ram.length, 1);
+    cm_hash hash;
+    error_code = cm_get_root_hash(machine, &hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    auto verification = calculate_emulator_hash(machine);
+    BOOST_CHECK_EQUAL_COLLECTIONS(verification.begin(), verification.end(), hash, hash + sizeof(cm_hash));
+
+    // both parent and child must be able to update the tree with multiple threads after the fork
+    write_every_page(machine, _machine_config.ram.length, 2);
+    const pid_t pid = fork();
+    BOOST_REQUIRE(pid >= 0);
+    if (pid == 0) {
+        cm_hash child_hash;
+        if (cm_get_root_hash(machine, &child_hash, nullptr) != CM_ERROR_OK) {
+            _exit(1);
+        }
+        auto child_verification = calculate_emulator_hash(machine);
+        _exit(std::equal(child_verification.begin(), child_verification.end(), child_hash) ? 0 : 1);
+    }
+    error_code = cm_get_root_hash(machine, &hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    verification = calculate_emulator_hash(machine);
+    BOOST_CHECK_EQUAL_COLLECTIONS(verification.begin(), verification.end(), hash, hash + sizeof(cm_hash));
+    int status = 0;
+    BOOST_REQUIRE_EQUAL(waitpid(pid, &status, 0), pid);
+    BOOST_CHECK(WIFEXITED(status));
+    BOOST_CHECK_EQUAL(WEXITSTATUS(status), 0);
+
+    cm_delete_machine(machine);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(machine_pristine_page_tracking_test, ordinary_machine_fixture) {
+    char *err_msg{};
+    cm_hash pristine_hash;
+    int error_code = cm_get_root_hash(_machine, &pristine_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    // writing to a page known to be pristine must change the hash
+    const uint64_t address = 0x80000000 + 5 * 4096 + 64;
+    std::array<uint8_t, 8> data{};
+    data.fill(0xaa);
+    error_code = cm_write_memory(_machine, address, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    cm_hash written_hash;
+    error_code = cm_get_root_hash(_machine, &written_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    auto verification = calculate_emulator_hash(_machine);
+    BOOST_CHECK_EQUAL_COLLECTIONS(verification.begin(), verification.end(), written_hash,
+        written_hash + sizeof(cm_hash));
+    BOOST_CHECK(!std::equal(pristine_hash, pristine_hash + sizeof(cm_hash), written_hash));
+
+    // zeroing the page again must bring back the pristine hash
+    std::array<uint8_t, 8> zeros{};
+    error_code = cm_write_memory(_machine, address, zeros.data(), zeros.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    cm_hash zeroed_hash;
+    error_code = cm_get_root_hash(_machine, &zeroed_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    BOOST_CHECK_EQUAL_COLLECTIONS(pristine_hash, pristine_hash + sizeof(cm_hash), zeroed_hash,
+        zeroed_hash + sizeof(cm_hash));
+
+    // and writing to it once more must not be missed
+    error_code = cm_write_memory(_machine, address, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    cm_hash rewritten_hash;
+    error_code = cm_get_root_hash(_machine, &rewritten_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    BOOST_CHECK_EQUAL_COLLECTIONS(written_hash, written_hash + sizeof(cm_hash), rewritten_hash,
+        rewritten_hash + sizeof(cm_hash));
+
+    bool result{};
+    error_code = cm_verify_merkle_tree(_machine, &result, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(err_msg, nullptr);
+    BOOST_CHECK(result);
+}
+
 BOOST_FIXTURE_TEST_CASE_NOLINT(machine_verify_merkle_tree_proof_updates_test, ordinary_machine_fixture) {
     char *err_msg{};
 
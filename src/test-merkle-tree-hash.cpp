@@ -23,6 +23,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <optional>
+#include <utility>
+#include <vector>
 
 #include "back-merkle-tree.h"
 #include "complete-merkle-tree.h"
@@ -157,6 +159,29 @@ static hash_type get_leaf_hash(int log2_word_size, const unsigned char *leaf_dat
     return get_leaf_hash(h, log2_word_size, leaf_data, log2_leaf_size);
 }
 
+/// \brief Computes the Merkle hash of a leaf of data using batch hashing
+/// \param h Hasher object
+/// \param log2_word_size Log<sub>2</sub> of word size
+/// \param leaf_data Pointer to buffer containing leaf data with
+/// at least 2^log2_leaf_size bytes
+/// \param log2_leaf_size Log<sub>2</sub> of leaf size
+/// \returns Merkle hash of leaf data
+/// \details Hashes all words in one batch, then each level of the tree in one batch.
+static hash_type get_leaf_hash_batch(hasher_type &h, int log2_word_size, const unsigned char *leaf_data,
+    int log2_leaf_size) {
+    assert(log2_leaf_size >= log2_word_size);
+    size_t count = static_cast<size_t>(1) << (log2_leaf_size - log2_word_size);
+    std::vector<hash_type> level(count);
+    h.hash_batch(leaf_data, static_cast<size_t>(1) << log2_word_size, count, level.data());
+    while (count > 1) {
+        count /= 2;
+        std::vector<hash_type> parent(count);
+        h.hash_batch(level.front().data(), 2 * hasher_type::hash_size, count, parent.data());
+        level = std::move(parent);
+    }
+    return level.front();
+}
+
 /// \brief Prints help message
 static void help(const char *name) {
     (void) fprintf(stderr,
@@ -256,6 +281,11 @@ int main(int argc, char *argv[]) try {
         memset(leaf_buf.get() + got, 0, leaf_size - got);
         // Compute leaf hash
         auto leaf_hash = get_leaf_hash(log2_word_size, leaf_buf.get(), log2_leaf_size);
+        // Compare with leaf hash computed in batches
+        if (get_leaf_hash_batch(h, log2_word_size, leaf_buf.get(), log2_leaf_size) != leaf_hash) {
+            error("mismatch in leaf hash for sequential and batch hashing\n");
+            return 1;
+        }
         // Add to array of leaf hashes
         leaf_hashes.push_back(leaf_hash);
         // Print leaf hash
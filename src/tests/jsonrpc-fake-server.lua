@@ -0,0 +1,180 @@
+#!/usr/bin/env lua5.4
+
+-- Copyright Cartesi and individual authors (see AUTHORS)
+-- SPDX-License-Identifier: LGPL-3.0-or-later
+--
+-- This program is free software: you can redistribute it and/or modify it under
+-- the terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+-- PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+--
+-- You should have received a copy of the GNU Lesser General Public License along
+-- with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+--
+
+-- Fake JSONRPC server that misbehaves in the ways the JSONRPC client must cope with.
+-- It prints the address it listens on, then one line per request it receives:
+--
+--   <connection> <method> <binary|json> <number of params> <length of last param>
+--
+-- The last param length is the number of raw bytes that follow a binary request, or the length
+-- of the last param of a JSON request when it is a string. The server exits after answering the
+-- "shutdown" method, or after a while without requests.
+
+local socket = require("socket")
+local json = require("dkjson")
+
+local IDLE_TIMEOUT = 30
+
+local scenario_name = assert(arg[1], "missing scenario")
+
+local function http_reply(conn, content_type, body)
+    return conn:send(
+        string.format("HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %d\r\n\r\n", content_type, #body)
+            .. body
+    )
+end
+
+-- Reads answer zero, everything else answers true
+local function jsonrpc_reply(conn, request)
+    local result = true
+    if request.method:match("^machine%.read_") then result = 0 end
+    return http_reply(conn, "application/json", json.encode({ jsonrpc = "2.0", id = request.id, result = result }))
+end
+
+local function jsonrpc_parse_error(conn)
+    return http_reply(
+        conn,
+        "application/json",
+        [[{"jsonrpc":"2.0","id":null,"error":{"code":-32700,"message":"Parse error"}}]]
+    )
+end
+
+-- Each scenario answers a request, or not, and returns false to close the connection
+local scenarios = {
+    -- Well-behaved server, which keeps connections alive unless asked to close them
+    ["keep-alive"] = function(conn, request)
+        return jsonrpc_reply(conn, request) and (request.headers["connection"] or ""):lower() ~= "close"
+    end,
+    -- Server that closes connections right after answering, without telling the client
+    ["drop-idle"] = function(conn, request)
+        jsonrpc_reply(conn, request)
+        return false
+    end,
+    -- Server that closes connections kept alive just as the client sends another request on them
+    ["drop-reused"] = function(conn, request)
+        if request.reused then return false end
+        return jsonrpc_reply(conn, request)
+    end,
+    -- Server from before binary requests, which does not understand raw bytes after the JSON request
+    ["old-server"] = function(conn, request)
+        if request.binary then return jsonrpc_parse_error(conn) end
+        return jsonrpc_reply(conn, request)
+    end,
+    -- Server that answers reads with one byte too few or too many
+    ["bad-length"] = function(conn, request)
+        if request.method == "machine.read_memory" then
+            return http_reply(conn, "application/octet-stream", string.rep("\0", request.params[2] - 1))
+        elseif request.method == "machine.read_virtual_memory" then
+            return http_reply(conn, "application/octet-stream", string.rep("\0", request.params[2] + 1))
+        end
+        return jsonrpc_reply(conn, request)
+    end,
+}
+
+local scenario = assert(scenarios[scenario_name], "unknown scenario " .. scenario_name)
+
+-- Reads a request from the connection, returning nil if the client closed it
+local function read_request(conn)
+    local line = conn:receive("*l")
+    if not line then return nil end
+    local headers = {}
+    while true do
+        line = assert(conn:receive("*l"))
+        if line == "" then break end
+        local name, value = line:match("^([^:]+):%s*(.-)%s*$")
+        headers[name:lower()] = value
+    end
+    local length = tonumber(headers["content-length"] or 0)
+    local body = length > 0 and assert(conn:receive(length)) or ""
+    local request = { headers = headers }
+    request.binary = (headers["content-type"] or ""):lower():match("^application/octet%-stream") ~= nil
+    local text, bytes = body, nil
+    if request.binary then
+        local separator = body:find("\0", 1, true)
+        if separator then
+            text, bytes = body:sub(1, separator - 1), body:sub(separator + 1)
+        end
+    end
+    local decoded = assert(json.decode(text), "invalid request")
+    request.id, request.method, request.params = decoded.id, decoded.method, decoded.params or {}
+    if bytes then
+        request.last_param_length = #bytes
+    elseif type(request.params[#request.params]) == "string" then
+        request.last_param_length = #request.params[#request.params]
+    else
+        request.last_param_length = 0
+    end
+    return request
+end
+
+io.stdout:setvbuf("line")
+local server = assert(socket.bind("127.0.0.1", 0))
+local ip, port = server:getsockname()
+print(string.format("%s:%d", ip, port))
+
+local connections = { server }
+local connection_ids = {}
+local connection_count = 0
+local served = {}
+
+local function close_connection(conn)
+    conn:close()
+    for i, c in ipairs(connections) do
+        if c == conn then table.remove(connections, i) end
+    end
+    connection_ids[conn] = nil
+    served[conn] = nil
+end
+
+local done = false
+while not done do
+    local readable = socket.select(connections, nil, IDLE_TIMEOUT)
+    if #readable == 0 then error("no requests for " .. IDLE_TIMEOUT .. " seconds") end
+    for _, conn in ipairs(readable) do
+        if conn == server then
+            local client = assert(server:accept())
+            connection_count = connection_count + 1
+            connection_ids[client] = connection_count
+            connections[#connections + 1] = client
+        else
+            local request = read_request(conn)
+            if not request then
+                close_connection(conn)
+            else
+                request.reused = served[conn]
+                served[conn] = true
+                print(
+                    string.format(
+                        "%d %s %s %d %d",
+                        connection_ids[conn],
+                        request.method,
+                        request.binary and "binary" or "json",
+                        #request.params,
+                        request.last_param_length
+                    )
+                )
+                if request.method == "shutdown" then
+                    jsonrpc_reply(conn, request)
+                    done = true
+                elseif not scenario(conn, request) then
+                    close_connection(conn)
+                end
+            end
+        end
+    end
+end
@@ -673,6 +673,47 @@ do_test("written and read values should match", function(machine)
     assert(memory_read == "mydataol12345678")
 end)
 
+print("\n\n check transactions")
+do_test("transaction results should match individual operations", function(machine)
+    local results = machine:transaction([=[[
+        {"method": "write_memory", "params": [2147483903, "bXlkYXRhb2wxMjM0NTY3OA=="]},
+        {"method": "write_csr", "params": ["mscratch", 1234]},
+        {"method": "read_csr", "params": ["mscratch"]},
+        {"method": "write_csr", "params": ["sscratch", {"$result": 2}]}
+    ]]=])
+    assert(results == "[true,true,1234,true]", "unexpected transaction results " .. results)
+    assert(machine:read_sscratch() == 1234)
+    assert(machine:read_memory(0x800000FF, 0x10) == "mydataol12345678")
+end)
+
+print("\n\n check snapshot and rollback")
+do_test("rollback should restore the state at snapshot", function(machine)
+    local initial_mcycle = machine:read_mcycle()
+    local initial_hash = machine:get_root_hash()
+    machine:snapshot()
+    machine:write_memory(0x800000FF, "mydataol12345678", 0x10)
+    machine:run(initial_mcycle + 1000)
+    assert(machine:get_root_hash() ~= initial_hash)
+    machine:rollback()
+    assert(machine:read_mcycle() == initial_mcycle)
+    assert(machine:get_root_hash() == initial_hash)
+end)
+
+print("\n\n check run with checkpoints")
+do_test("checkpoints should match the state where the machine stopped", function(machine)
+    local initial_mcycle = machine:read_mcycle()
+    local initial_hash = machine:get_root_hash()
+    local checkpoints = machine:run_with_checkpoints(initial_mcycle + 3000, 1000)
+    assert(#checkpoints >= 1 and #checkpoints <= 4)
+    assert(checkpoints[1].mcycle == initial_mcycle)
+    assert(checkpoints[1].root_hash == initial_hash)
+    for i = 2, #checkpoints do
+        assert(checkpoints[i].mcycle > checkpoints[i - 1].mcycle)
+    end
+    assert(checkpoints[#checkpoints].mcycle == machine:read_mcycle())
+    assert(checkpoints[#checkpoints].root_hash == machine:get_root_hash())
+end)
+
 print("\n\n dump step log  to console")
 do_test("dumped step log content should match", function()
     -- Dump log and check values
@@ -733,6 +774,21 @@ do_test("machine step should pass verifications", function(machine)
     module.machine.verify_uarch_step_log(log, {})
 end)
 
+do_test("machine steps should pass verifications", function(machine)
+    local module = cartesi
+    if machine_type ~= "local" then
+        if not remote then remote = connect() end
+        module = remote
+    end
+    local initial_cycle = machine:read_uarch_cycle()
+    local logs = machine:log_uarch_steps(2, { proofs = true, annotations = true })
+    assert(#logs == 2)
+    assert(machine:read_uarch_cycle() == initial_cycle + 2)
+    for _, log in ipairs(logs) do
+        module.machine.verify_uarch_step_log(log, {})
+    end
+end)
+
 print("\n\ntesting step and verification")
 do_test("Step log must contain conssitent data hashes", function(machine)
     local wrong_hash = string.rep("\0", 32)
@@ -0,0 +1,216 @@
+#!/usr/bin/env lua5.4
+
+-- Copyright Cartesi and individual authors (see AUTHORS)
+-- SPDX-License-Identifier: LGPL-3.0-or-later
+--
+-- This program is free software: you can redistribute it and/or modify it under
+-- the terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+-- PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+--
+-- You should have received a copy of the GNU Lesser General Public License along
+-- with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+--
+
+local jsonrpc = require("cartesi.jsonrpc")
+local test_util = require("tests.util")
+
+local remote_address = nil
+
+-- Print help and exit
+local function help()
+    io.stderr:write(string.format(
+        [=[
+Usage:
+
+  %s --remote-address=<host>:<port>
+
+where remote-address gives the address of a running
+jsonrpc remote Cartesi machine server.
+
+]=],
+        arg[0]
+    ))
+    os.exit()
+end
+
+local options = {
+    {
+        "^%-%-h$",
+        function(all)
+            if not all then return false end
+            help()
+        end,
+    },
+    {
+        "^%-%-help$",
+        function(all)
+            if not all then return false end
+            help()
+        end,
+    },
+    {
+        "^%-%-remote%-address%=(.*)$",
+        function(o)
+            if not o or #o < 1 then return false end
+            remote_address = o
+            return true
+        end,
+    },
+    { ".*", function(all) error("unrecognized option " .. all) end },
+}
+
+-- Process command line options
+for _, argument in ipairs({ ... }) do
+    if argument:sub(1, 1) == "-" then
+        for _, option in ipairs(options) do
+            if option[2](argument:match(option[1])) then break end
+        end
+    else
+        error("unrecognized argument " .. argument)
+    end
+end
+
+assert(remote_address, "remote cartesi machine address is missing")
+
+-- Memory contents move as raw bytes in HTTP bodies, rather than in base64 inside JSON.
+-- These tests check the contents survive the trip, and that everything else still comes back in JSON.
+
+local RAM_START = 0x80000000
+local PAGE_SIZE = 4096
+
+-- Every byte value, including NUL, spread over a few pages
+local function make_data(length, seed)
+    local bytes = {}
+    for i = 1, length do
+        bytes[i] = string.char((i * 7 + seed) % 256)
+    end
+    return table.concat(bytes)
+end
+
+local function expect_error(f, pattern)
+    local ok, err = pcall(f)
+    assert(not ok, "expected an error")
+    assert(tostring(err):find(pattern), "unexpected error: " .. tostring(err))
+end
+
+local function do_test(description, f)
+    io.write("  " .. description .. "...\n")
+    f()
+    print("<<<<<<<<<<<<<<<< passed >>>>>>>>>>>>>>>")
+end
+
+local stub = assert(jsonrpc.stub(remote_address))
+
+print("Testing binary memory transfers with server at " .. remote_address)
+
+do_test("errors should come back in JSON", function()
+    -- The server has no machine yet, so every method fails
+    local no_machine = stub.get_machine()
+    local data = make_data(PAGE_SIZE, 0)
+    expect_error(function() no_machine:read_memory(RAM_START, PAGE_SIZE) end, "no machine")
+    expect_error(function() no_machine:write_memory(RAM_START, data) end, "no machine")
+    expect_error(function() no_machine:read_virtual_memory(RAM_START, PAGE_SIZE) end, "no machine")
+    expect_error(function() no_machine:write_virtual_memory(RAM_START, data) end, "no machine")
+    local conn = test_util.http_connect(remote_address)
+    local code, headers, body = test_util.http_post(conn, {
+        ["Content-Type"] = "application/json",
+        ["Accept"] = "application/octet-stream",
+    }, string.format('{"jsonrpc":"2.0","id":0,"method":"machine.read_memory","params":[%d,%d]}', RAM_START, 16))
+    conn:close()
+    assert(code == 200, "unexpected status code")
+    assert(headers["content-type"] == "application/json", "error did not come back in JSON")
+    assert(body:find('"error"'), "missing error in " .. body)
+end)
+
+local config = stub.machine.get_default_config()
+config.ram.length = 1 << 20
+local machine = stub.machine(config)
+
+do_test("multi-page buffers should round trip", function()
+    local data = make_data(3 * PAGE_SIZE + 17, 0)
+    machine:write_memory(RAM_START + 5, data)
+    assert(machine:read_memory(RAM_START + 5, #data) == data, "read_memory mismatch")
+    assert(machine:read_virtual_memory(RAM_START + 5, #data) == data, "read_virtual_memory mismatch")
+    data = make_data(2 * PAGE_SIZE + 3, 1)
+    machine:write_virtual_memory(RAM_START + PAGE_SIZE - 1, data)
+    assert(machine:read_memory(RAM_START + PAGE_SIZE - 1, #data) == data, "read_memory mismatch")
+    assert(machine:read_virtual_memory(RAM_START + PAGE_SIZE - 1, #data) == data, "read_virtual_memory mismatch")
+end)
+
+do_test("zero-length buffers should round trip", function()
+    local before = machine:read_memory(RAM_START, PAGE_SIZE)
+    machine:write_memory(RAM_START, "")
+    machine:write_virtual_memory(RAM_START, "")
+    assert(machine:read_memory(RAM_START, 0) == "", "read_memory returned data")
+    assert(machine:read_virtual_memory(RAM_START, 0) == "", "read_virtual_memory returned data")
+    assert(machine:read_memory(RAM_START, PAGE_SIZE) == before, "zero-length write changed memory")
+end)
+
+do_test("writes outside memory should fail", function()
+    -- There is no memory at address 0x1000000000
+    local data = make_data(PAGE_SIZE, 0)
+    expect_error(function() machine:write_memory(0x1000000000, data) end, "address range not entirely in memory")
+end)
+
+do_test("media type parameters should be ignored", function()
+    local data = make_data(PAGE_SIZE, 2)
+    local conn = test_util.http_connect(remote_address)
+    local code, headers, body = test_util.http_post(
+        conn,
+        { ["Content-Type"] = "application/octet-stream; charset=binary" },
+        string.format('{"jsonrpc":"2.0","id":0,"method":"machine.write_memory","params":[%d]}', RAM_START)
+            .. "\0"
+            .. data
+    )
+    assert(code == 200 and headers["content-type"] == "application/json", "unexpected response")
+    assert(body:find('"result"'), "write failed: " .. body)
+    assert(machine:read_memory(RAM_START, #data) == data, "write_memory mismatch")
+    code, headers, body = test_util.http_post(conn, {
+        ["Content-Type"] = "application/json",
+        ["Accept"] = "application/json, Application/Octet-Stream;q=0.9",
+    }, string.format('{"jsonrpc":"2.0","id":0,"method":"machine.read_memory","params":[%d,%d]}', RAM_START, #data))
+    conn:close()
+    assert(code == 200 and headers["content-type"] == "application/octet-stream", "reply is not binary")
+    assert(body == data, "read_memory mismatch")
+end)
+
+do_test("reads with the wrong length should fail", function()
+    local address, wait = test_util.start_jsonrpc_fake_server("bad-length")
+    local fake_stub = assert(jsonrpc.stub(address))
+    local fake_machine = fake_stub.get_machine()
+    expect_error(function() fake_machine:read_memory(RAM_START, PAGE_SIZE) end, "invalid binary data length")
+    expect_error(function() fake_machine:read_virtual_memory(RAM_START, PAGE_SIZE) end, "invalid binary data length")
+    fake_stub.shutdown()
+    local requests = wait()
+    assert(#requests == 3, "unexpected number of requests")
+    assert(requests[1]:find(" machine.read_memory json 2 0$"), requests[1])
+    assert(requests[2]:find(" machine.read_virtual_memory json 2 0$"), requests[2])
+end)
+
+do_test("writes should fall back to base64 on servers that cannot parse binary requests", function()
+    local address, wait = test_util.start_jsonrpc_fake_server("old-server")
+    local fake_stub = assert(jsonrpc.stub(address))
+    local fake_machine = fake_stub.get_machine()
+    local data = make_data(PAGE_SIZE + 1, 3)
+    local base64_length = 4 * ((#data + 2) // 3)
+    fake_machine:write_memory(RAM_START, data)
+    fake_machine:write_virtual_memory(RAM_START, data)
+    fake_stub.shutdown()
+    local requests = wait()
+    for i, request in ipairs(requests) do
+        print(i, request)
+    end
+    assert(#requests == 4, "unexpected number of requests")
+    -- The first write gets a parse error and is sent again in base64, and later writes go in base64 right away
+    assert(requests[1]:find(" machine.write_memory binary 1 " .. #data .. "$"), requests[1])
+    assert(requests[2]:find(" machine.write_memory json 2 " .. base64_length .. "$"), requests[2])
+    assert(requests[3]:find(" machine.write_virtual_memory json 2 " .. base64_length .. "$"), requests[3])
+    assert(requests[4]:find(" shutdown json 0 0$"), requests[4])
+end)
+
+stub.shutdown()
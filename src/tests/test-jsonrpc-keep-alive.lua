@@ -0,0 +1,239 @@
+#!/usr/bin/env lua5.4
+
+-- Copyright Cartesi and individual authors (see AUTHORS)
+-- SPDX-License-Identifier: LGPL-3.0-or-later
+--
+-- This program is free software: you can redistribute it and/or modify it under
+-- the terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+-- PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+--
+-- You should have received a copy of the GNU Lesser General Public License along
+-- with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+--
+
+local jsonrpc = require("cartesi.jsonrpc")
+local test_util = require("tests.util")
+
+local remote_address = nil
+
+-- Print help and exit
+local function help()
+    io.stderr:write(string.format(
+        [=[
+Usage:
+
+  %s --remote-address=<host>:<port>
+
+where remote-address gives the address of a running
+jsonrpc remote Cartesi machine server.
+
+]=],
+        arg[0]
+    ))
+    os.exit()
+end
+
+local options = {
+    {
+        "^%-%-h$",
+        function(all)
+            if not all then return false end
+            help()
+        end,
+    },
+    {
+        "^%-%-help$",
+        function(all)
+            if not all then return false end
+            help()
+        end,
+    },
+    {
+        "^%-%-remote%-address%=(.*)$",
+        function(o)
+            if not o or #o < 1 then return false end
+            remote_address = o
+            return true
+        end,
+    },
+    { ".*", function(all) error("unrecognized option " .. all) end },
+}
+
+-- Process command line options
+for _, argument in ipairs({ ... }) do
+    if argument:sub(1, 1) == "-" then
+        for _, option in ipairs(options) do
+            if option[2](argument:match(option[1])) then break end
+        end
+    else
+        error("unrecognized argument " .. argument)
+    end
+end
+
+assert(remote_address, "remote cartesi machine address is missing")
+
+-- Connections to the server are kept alive across requests, unless the client turns that off.
+-- These tests check requests still get through when the server closes connections the client kept,
+-- and that only requests that can safely be processed twice are sent again.
+
+local socket = require("socket")
+
+local function expect_error(f, pattern)
+    local ok, err = pcall(f)
+    assert(not ok, "expected an error")
+    assert(tostring(err):find(pattern), "unexpected error: " .. tostring(err))
+end
+
+local function do_test(description, f)
+    io.write("  " .. description .. "...\n")
+    f()
+    print("<<<<<<<<<<<<<<<< passed >>>>>>>>>>>>>>>")
+end
+
+-- Splits the lines logged by the fake server into connections and methods
+local function parse_requests(requests)
+    local connections, methods = {}, {}
+    for i, request in ipairs(requests) do
+        print(i, request)
+        local connection, method = request:match("^(%d+) (%S+) ")
+        connections[i], methods[i] = tonumber(connection), method
+    end
+    return connections, methods
+end
+
+local function count(list, value)
+    local n = 0
+    for _, v in ipairs(list) do
+        if v == value then n = n + 1 end
+    end
+    return n
+end
+
+local stub = assert(jsonrpc.stub(remote_address))
+local config = stub.machine.get_default_config()
+config.ram.length = 1 << 20
+local machine = stub.machine(config)
+
+print("Testing keep-alive connections with server at " .. remote_address)
+
+do_test("calls should succeed with keep-alive on and off", function()
+    for _, keep_alive in ipairs({ true, false, true }) do
+        stub.set_keep_alive(keep_alive)
+        for i = 1, 31 do
+            machine:write_x(i, i * 3 + (keep_alive and 1 or 0))
+        end
+        for i = 1, 31 do
+            assert(machine:read_x(i) == i * 3 + (keep_alive and 1 or 0), "mismatch in x[" .. i .. "]")
+        end
+    end
+end)
+
+do_test("requests should share a connection only with keep-alive on", function()
+    local address, wait = test_util.start_jsonrpc_fake_server("keep-alive")
+    local fake_stub = assert(jsonrpc.stub(address))
+    local fake_machine = fake_stub.get_machine()
+    fake_stub.set_keep_alive(true)
+    for i = 1, 3 do
+        fake_machine:read_x(i)
+    end
+    fake_stub.set_keep_alive(false)
+    for i = 1, 3 do
+        fake_machine:read_x(i)
+    end
+    fake_stub.shutdown()
+    local connections = parse_requests(wait())
+    assert(#connections == 7, "unexpected number of requests")
+    assert(connections[1] == 1 and connections[2] == 1 and connections[3] == 1, "connection was not kept alive")
+    for i = 4, 7 do
+        assert(connections[i] == i - 2, "connection was kept alive")
+    end
+end)
+
+do_test("calls should succeed after the server drops idle connections", function()
+    local address, wait = test_util.start_jsonrpc_fake_server("drop-idle")
+    local fake_stub = assert(jsonrpc.stub(address))
+    local fake_machine = fake_stub.get_machine()
+    fake_stub.set_keep_alive(true)
+    for i = 1, 3 do
+        fake_machine:read_x(i)
+        -- Give the server time to drop the connection
+        socket.sleep(0.1)
+        fake_machine:write_x(i, i)
+        socket.sleep(0.1)
+    end
+    fake_stub.shutdown()
+    local connections, methods = parse_requests(wait())
+    -- Stale connections were noticed before sending, so nothing was sent twice
+    assert(#connections == 7, "unexpected number of requests")
+    for i = 1, 7 do
+        assert(connections[i] == i, "request sent on a stale connection")
+    end
+    assert(count(methods, "machine.read_x") == 3 and count(methods, "machine.write_x") == 3, "unexpected requests")
+end)
+
+do_test("only idempotent requests should be sent again when a reused connection closes", function()
+    local address, wait = test_util.start_jsonrpc_fake_server("drop-reused")
+    local fake_stub = assert(jsonrpc.stub(address))
+    local fake_machine = fake_stub.get_machine()
+    fake_stub.set_keep_alive(true)
+    fake_machine:read_x(1)
+    -- The server closes the connection on this request, so it is sent again on a new connection
+    fake_machine:read_x(2)
+    -- This one is not sent again, because the server might have processed it
+    expect_error(function() fake_machine:write_x(3, 3) end, "connection closed")
+    fake_machine:read_x(4)
+    fake_stub.shutdown()
+    local connections, methods = parse_requests(wait())
+    assert(#connections == 6, "unexpected number of requests")
+    assert(count(methods, "machine.read_x") == 4, "read_x was not sent again")
+    assert(count(methods, "machine.write_x") == 1, "write_x was sent again")
+    assert(connections[2] == 1 and connections[3] == 2, "read_x was not sent again on a new connection")
+    assert(connections[5] == 3, "closed connection was reused")
+end)
+
+do_test("fork and rollback should work while the client holds idle connections", function()
+    stub.set_keep_alive(true)
+    machine:write_x(1, 10)
+    assert(machine:read_x(1) == 10)
+    local child_address = stub.fork()
+    local child_stub = assert(jsonrpc.stub(child_address))
+    child_stub.set_keep_alive(true)
+    local child_machine = child_stub.get_machine()
+    assert(child_machine:read_x(1) == 10, "child did not inherit machine")
+    child_machine:write_x(1, 20)
+    -- The child inherited the parent's connections, so make sure the parent's still work
+    assert(machine:read_x(1) == 10, "parent machine changed")
+    machine:write_x(1, 30)
+    assert(child_machine:read_x(1) == 20, "child machine changed")
+    child_stub.shutdown()
+    assert(machine:read_x(1) == 30, "parent machine changed")
+    -- Snapshots fork the server behind the scenes
+    machine:snapshot()
+    machine:write_x(1, 40)
+    assert(machine:read_x(1) == 40)
+    machine:rollback()
+    assert(machine:read_x(1) == 30, "rollback did not restore machine")
+end)
+
+do_test("Connection: close should make the server close the connection", function()
+    local request = '{"jsonrpc":"2.0","id":0,"method":"machine.read_x","params":[1]}'
+    local conn = test_util.http_connect(remote_address)
+    -- Connections are kept alive by default
+    local code, _, body = test_util.http_post(conn, { ["Content-Type"] = "application/json" }, request)
+    assert(code == 200 and body:find('"result"'), "first request failed")
+    code, _, body = test_util.http_post(conn, { ["Content-Type"] = "application/json" }, request)
+    assert(code == 200 and body:find('"result"'), "second request failed")
+    code, _, body =
+        test_util.http_post(conn, { ["Content-Type"] = "application/json", ["Connection"] = "close" }, request)
+    assert(code == 200 and body:find('"result"'), "last request failed")
+    local line, err = conn:receive("*l")
+    assert(line == nil and err == "closed", "server did not close the connection")
+    conn:close()
+end)
+
+stub.shutdown()
@@ -31,6 +31,8 @@ tests=(
     "$cartesi_machine_tests --remote-address=$server_address --remote-protocol="jsonrpc" --test-path=\"$test_path\" --test='.*' run"
     "$lua $script_dir/machine-bind.lua jsonrpc --remote-address=$server_address"
     "$lua $script_dir/machine-test.lua jsonrpc --remote-address=$server_address"
+    "$lua $script_dir/test-jsonrpc-binary.lua --remote-address=$server_address"
+    "$lua $script_dir/test-jsonrpc-keep-alive.lua --remote-address=$server_address"
     "$cartesi_machine --remote-address=$server_address --remote-protocol="jsonrpc" --remote-shutdown"
     "$lua $script_dir/test-jsonrpc-fork.lua --remote-address=$server_address"
 )
@@ -237,6 +237,57 @@ end
 
 test_util.merkle_hash = merkle_hash
 
+-- Open a raw connection to a JSONRPC server, to check what goes on the wire
+function test_util.http_connect(address)
+    local socket = require("socket")
+    local host, port = address:match("^(.*):(%d+)$")
+    local conn = assert(socket.connect(host, tonumber(port)))
+    conn:settimeout(10)
+    return conn
+end
+
+-- Send a POST request on a raw connection and read the response
+-- Returns the status code, the response headers (with lowercase names), and the response body
+function test_util.http_post(conn, headers, body)
+    local request = { "POST / HTTP/1.1\r\n", "Host: localhost\r\n", string.format("Content-Length: %d\r\n", #body) }
+    for name, value in pairs(headers) do
+        request[#request + 1] = name .. ": " .. value .. "\r\n"
+    end
+    request[#request + 1] = "\r\n"
+    request[#request + 1] = body
+    assert(conn:send(table.concat(request)))
+    local status = assert(conn:receive("*l"))
+    local code = tonumber(status:match("^HTTP/1%.%d (%d+)"))
+    local response_headers = {}
+    while true do
+        local line = assert(conn:receive("*l"))
+        if line == "" then break end
+        local name, value = line:match("^([^:]+):%s*(.-)%s*$")
+        response_headers[name:lower()] = value
+    end
+    local length = tonumber(response_headers["content-length"] or 0)
+    local response_body = length > 0 and assert(conn:receive(length)) or ""
+    return code, response_headers, response_body
+end
+
+-- Start tests/jsonrpc-fake-server.lua with a scenario
+-- Returns its address, and a function that waits for it to exit and returns the requests it logged
+function test_util.start_jsonrpc_fake_server(scenario)
+    local lua = arg[-1] or "lua5.4"
+    local script = arg[0]:gsub("[^/]*$", "") .. "jsonrpc-fake-server.lua"
+    local server = assert(io.popen(string.format("%s %s %s", lua, script, scenario)))
+    local address = assert(server:read("l"), "fake server did not start")
+    return address,
+        function()
+            local requests = {}
+            for line in server:lines() do
+                requests[#requests + 1] = line
+            end
+            assert(server:close(), "fake server failed")
+            return requests
+        end
+end
+
 -- Take data from dumped memory files
 -- and calculate root hash of the machine
 function test_util.calculate_emulator_hash(machine)
@@ -43,10 +43,26 @@
 #ifndef TRANSLATE_VIRTUAL_ADDRESS_H
 #define TRANSLATE_VIRTUAL_ADDRESS_H
 
+#include <array>
+#include <cstdint>
+
 #include "compiler-defines.h"
+#include "riscv-constants.h"
 
 namespace cartesi {
 
+/// \brief Maximum number of page table levels (Sv57)
+constexpr int PAGE_TABLE_LEVELS_MAX = 5;
+
+/// \brief Page table entries read by a successful page table walk.
+/// \details Walking again under the same satp, privilege, and mstatus, while all these entries still hold the
+/// same values, gives the same translation without modifying any of them.
+struct page_table_walk {
+    int levels{0};                                          ///< Number of entries read, 0 when no walk was needed
+    std::array<uint64_t, PAGE_TABLE_LEVELS_MAX> pte_addr{}; ///< Physical address of each entry, from the root down
+    std::array<uint64_t, PAGE_TABLE_LEVELS_MAX> pte{};      ///< Value of each entry when the walk finished
+};
+
 /// \brief Write an aligned word to memory.
 /// \tparam STATE_ACCESS Class of machine state accessor object.
 /// \param a Machine state accessor object.
@@ -62,10 +78,10 @@ static inline bool write_ram_uint64(STATE_ACCESS &a, uint64_t paddr, uint64_t va
     const uint64_t paddr_page = paddr & ~PAGE_OFFSET_MASK;
     unsigned char *hpage = a.get_host_memory(pma) + (paddr_page - pma.get_start());
     const uint64_t hoffset = paddr - paddr_page;
-    // log writes to memory
-    a.write_memory_word(paddr, hpage, hoffset, val);
     // mark page as dirty so we know to update the Merkle tree
     pma.mark_dirty_page(paddr - pma.get_start());
+    // log writes to memory
+    a.write_memory_word(paddr, hpage, hoffset, val);
     return true;
 }
 
@@ -96,10 +112,12 @@ static inline bool read_ram_uint64(STATE_ACCESS &a, uint64_t paddr, uint64_t *pv
 /// \param ppaddr Pointer to physical address.
 /// \param xwr_shift Encodes the access mode by the shift to the XWR triad (PTE_XWR_R_SHIFT,
 ///  PTE_XWR_R_SHIFT, or PTE_XWR_R_SHIFT)
+/// \param walk Receives the page table entries read by the walk, when not nullptr.
 /// \details This function is outlined to minimize host CPU code cache pressure.
 /// \returns True if succeeded, false otherwise.
 template <typename STATE_ACCESS, bool UPDATE_PTE = true>
-static NO_INLINE bool translate_virtual_address(STATE_ACCESS &a, uint64_t *ppaddr, uint64_t vaddr, int xwr_shift) {
+static NO_INLINE bool translate_virtual_address(STATE_ACCESS &a, uint64_t *ppaddr, uint64_t vaddr, int xwr_shift,
+    page_table_walk *walk = nullptr) {
     auto priv = a.read_iflags_PRV();
     const uint64_t mstatus = a.read_mstatus();
 
@@ -164,6 +182,11 @@ static NO_INLINE bool translate_virtual_address(STATE_ACCESS &a, uint64_t *ppadd
         if (unlikely(!read_ram_uint64(a, pte_addr, &pte))) {
             return false;
         }
+        if (walk != nullptr) {
+            walk->pte_addr[i] = pte_addr;
+            walk->pte[i] = pte;
+            walk->levels = i + 1;
+        }
         // The OS can mark page table entries as invalid,
         // but these entries shouldn't be reached during page lookups
         if (unlikely(!(pte & PTE_V_MASK))) {
@@ -230,6 +253,9 @@ static NO_INLINE bool translate_virtual_address(STATE_ACCESS &a, uint64_t *ppadd
                 }
                 if (pte != update_pte) {
                     write_ram_uint64(a, pte_addr, update_pte); // Can't fail since read succeeded earlier
+                    if (walk != nullptr) {
+                        walk->pte[i] = update_pte;
+                    }
                 }
             }
             // Add page offset in vaddr to ppn to form physical address
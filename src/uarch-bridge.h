@@ -629,12 +629,16 @@ private:
                 case offsetof(tlb_cold_entry, paddr_page): {
                     tlbce.paddr_page = val;
                     // Update vh_offset
-                    const pma_entry &pma = find_pma_entry<uint64_t>(s, tlbce.paddr_page);
+                    pma_entry &pma = s.pmas[s.pma_lookup.find(tlbce.paddr_page, sizeof(uint64_t))];
                     assert(pma.get_istart_M()); // TLB only works for memory mapped PMAs
                     const unsigned char *hpage =
                         pma.get_memory().get_host_memory() + (tlbce.paddr_page - pma.get_start());
                     tlb_hot_entry &tlbhe = s.tlb.hot[etype][eidx];
                     tlbhe.vh_offset = cast_ptr_to_addr<uint64_t>(hpage) - tlbhe.vaddr_page;
+                    // Pages in the write TLB are written to without being marked dirty, so mark them beforehand
+                    if (etype == TLB_WRITE && tlbhe.vaddr_page != TLB_INVALID_PAGE) {
+                        pma.mark_dirty_page(tlbce.paddr_page - pma.get_start());
+                    }
                     return true;
                 }
                 case offsetof(tlb_cold_entry, pma_index):
@@ -696,17 +700,7 @@ private:
     /// for an empty range.
     template <typename T>
     static const pma_entry &find_pma_entry(machine_state &s, uint64_t paddr) {
-        for (const auto &pma : s.pmas) {
-            // Stop at first empty PMA
-            if (pma.get_length() == 0) {
-                return pma;
-            }
-            if (pma.contains(paddr, sizeof(T))) {
-                return pma;
-            }
-        }
-        // Last PMA is always the empty range
-        return s.pmas.back();
+        return s.pmas[s.pma_lookup.find(paddr, sizeof(T))];
     }
 
     /// \brief Writes a character to the console
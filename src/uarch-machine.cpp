@@ -57,7 +57,7 @@ uarch_machine::uarch_machine(uarch_config c) : m_s{}, m_c{c} {
         if (uarch_pristine_ram_len > m_s.ram.get_length()) {
             throw std::runtime_error("embedded uarch ram image does not fit in uarch ram pma");
         }
-        memcpy(m_s.ram.get_memory().get_host_memory(), uarch_pristine_ram, uarch_pristine_ram_len);
+        m_s.ram.write_memory(m_s.ram.get_start(), uarch_pristine_ram, uarch_pristine_ram_len);
     }
 }
 
@@ -354,18 +354,13 @@ private:
         auto old_data = aliased_aligned_read<uint64_t>(hdata);
         // Log the write access
         log_before_write(paddr, old_data, data, "memory");
+        // Mark the page dirty before modifying it, so an active snapshot can save its contents
+        const uint64_t paddr_page = paddr & ~PAGE_OFFSET_MASK;
+        pma.mark_dirty_page(paddr_page - pma.get_start());
         // Actually modify the state
         aliased_aligned_write<uint64_t>(hdata, data);
-
-        // Finally, update Merkle tree or mark the page dirty, depending on whether proofs are being requested or not
-        if (m_log->get_log_type().has_proofs()) {
-            // When proofs are requested, we always want to update the Merkle tree
-            update_after_write(paddr);
-        } else {
-            // Marking the page dirty is only needed for pages of memory PMAs, when proofs are not requested
-            const uint64_t paddr_page = paddr & ~PAGE_OFFSET_MASK;
-            pma.mark_dirty_page(paddr_page - pma.get_start());
-        }
+        // Finally, when proofs are requested, we always want to update the Merkle tree
+        update_after_write(paddr);
     }
 
     /// \brief Writes a uint64 machine state register mapped to a memory address
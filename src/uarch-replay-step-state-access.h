@@ -27,6 +27,7 @@
 #include <sstream>
 #include <string>
 
+#include "concat-hash-cache.h"
 #include "i-uarch-step-state-access.h"
 #include "shadow-state.h"
 #include "uarch-bridge.h"
@@ -38,6 +39,7 @@ class uarch_replay_step_state_access : public i_uarch_step_state_access<uarch_re
     using hash_type = tree_type::hash_type;
     using hasher_type = tree_type::hasher_type;
     using proof_type = tree_type::proof_type;
+    using hash_cache_type = concat_hash_cache<hasher_type>;
 
     ///< Access log generated by step
     const std::vector<access> &m_accesses;
@@ -52,6 +54,8 @@ class uarch_replay_step_state_access : public i_uarch_step_state_access<uarch_re
     hash_type m_root_hash;
     ///< Hasher needed to verify proofs
     hasher_type m_hasher;
+    ///< Memo of node hashes shared with other replays, or nullptr
+    hash_cache_type *m_hash_cache;
 
 public:
     /// \brief Constructor from log of word accesses.
@@ -59,14 +63,16 @@ public:
     /// \param verify_proofs Whether to verify proofs in access log
     /// \param initial_hash  Initial root hash
     /// \param one_based Whether to add one to indices reported in errors
+    /// \param hash_cache Memo of node hashes to use when verifying proofs, or nullptr
     explicit uarch_replay_step_state_access(const access_log &log, bool verify_proofs, const hash_type &initial_hash,
-        bool one_based) :
+        bool one_based, hash_cache_type *hash_cache = nullptr) :
         m_accesses(log.get_accesses()),
         m_verify_proofs(verify_proofs),
         m_next_access{0},
         m_one_based{one_based},
         m_root_hash{initial_hash},
-        m_hasher{} {
+        m_hasher{},
+        m_hash_cache{hash_cache} {
         if (m_accesses.empty()) {
             throw std::invalid_argument{"the access log has no accesses"};
         }
@@ -107,6 +113,20 @@ private:
         get_merkle_tree_hash(hasher, data.data(), data.size(), sizeof(uint64_t), hash);
     }
 
+    bool verify_proof(const proof_type &proof) {
+        if (m_hash_cache) {
+            return m_hash_cache->verify(m_hasher, proof);
+        }
+        return proof.verify(m_hasher);
+    }
+
+    hash_type bubble_up(const proof_type &proof, const hash_type &new_target_hash) {
+        if (m_hash_cache) {
+            return m_hash_cache->bubble_up(m_hasher, proof, new_target_hash);
+        }
+        return proof.bubble_up(m_hasher, new_target_hash);
+    }
+
     /// \brief Checks a logged word read and advances log.
     /// \param paligned Physical address in the machine state,
     /// aligned to 64-bits.
@@ -164,7 +184,7 @@ private:
         }
         if (m_verify_proofs) {
             auto proof = access.make_proof(m_root_hash);
-            if (!proof.verify(m_hasher)) {
+            if (!verify_proof(proof)) {
                 throw std::invalid_argument{"Mismatch in root hash of access " + std::to_string(access_to_report())};
             }
         }
@@ -255,11 +275,11 @@ private:
         }
         if (m_verify_proofs) {
             auto proof = access.make_proof(m_root_hash);
-            if (!proof.verify(m_hasher)) {
+            if (!verify_proof(proof)) {
                 throw std::invalid_argument{"Mismatch in root hash of access " + std::to_string(access_to_report())};
             }
             // Update root hash to reflect the data written by this access
-            m_root_hash = proof.bubble_up(m_hasher, written_hash);
+            m_root_hash = bubble_up(proof, written_hash);
         }
         m_next_access++;
     }
@@ -15,6 +15,7 @@
 //
 
 #include "virtual-machine.h"
+#include "machine-transaction.h"
 
 namespace cartesi {
 
@@ -32,18 +33,41 @@ void virtual_machine::do_store(const std::string &dir) {
     m_machine->store(dir);
 }
 
+void virtual_machine::do_store_delta(const std::string &dir, const std::string &base_dir) {
+    m_machine->store_delta(dir, base_dir);
+}
+
 interpreter_break_reason virtual_machine::do_run(uint64_t mcycle_end) {
     return m_machine->run(mcycle_end);
 }
 
+std::vector<std::pair<uint64_t, virtual_machine::hash_type>> virtual_machine::do_run_with_checkpoints(
+    uint64_t mcycle_end, uint64_t period) {
+    return m_machine->run_with_checkpoints(mcycle_end, period);
+}
+
+std::string virtual_machine::do_transaction(const std::string &operations) {
+    return run_transaction(*m_machine, nlohmann::json::parse(operations)).dump();
+}
+
 access_log virtual_machine::do_log_uarch_step(const access_log::type &log_type, bool one_based) {
     return m_machine->log_uarch_step(log_type, one_based);
 }
 
+std::vector<access_log> virtual_machine::do_log_uarch_steps(uint64_t count, const access_log::type &log_type,
+    bool one_based) {
+    return m_machine->log_uarch_steps(count, log_type, one_based);
+}
+
 machine_merkle_tree::proof_type virtual_machine::do_get_proof(uint64_t address, int log2_size) const {
     return m_machine->get_proof(address, log2_size);
 }
 
+machine_merkle_tree::multiproof_type virtual_machine::do_get_multiproof(const std::vector<uint64_t> &addresses,
+    int log2_size) const {
+    return m_machine->get_multiproof(addresses, log2_size);
+}
+
 void virtual_machine::do_get_root_hash(hash_type &hash) const {
     m_machine->get_root_hash(hash);
 }
@@ -437,11 +461,15 @@ void virtual_machine::do_destroy() {
 }
 
 void virtual_machine::do_snapshot(void) {
-    throw std::runtime_error("snapshot is not supported");
+    m_machine->snapshot();
 }
 
 void virtual_machine::do_rollback(void) {
-    throw std::runtime_error("rollback is not supported");
+    m_machine->rollback();
+}
+
+void virtual_machine::do_commit(void) {
+    m_machine->commit();
 }
 
 uint64_t virtual_machine::do_read_uarch_x(int i) const {
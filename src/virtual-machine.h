@@ -41,9 +41,17 @@ public:
 
 private:
     void do_store(const std::string &dir) override;
+    void do_store_delta(const std::string &dir, const std::string &base_dir) override;
     interpreter_break_reason do_run(uint64_t mcycle_end) override;
+    std::vector<std::pair<uint64_t, hash_type>> do_run_with_checkpoints(uint64_t mcycle_end,
+        uint64_t period) override;
+    std::string do_transaction(const std::string &operations) override;
     access_log do_log_uarch_step(const access_log::type &log_type, bool one_based = false) override;
+    std::vector<access_log> do_log_uarch_steps(uint64_t count, const access_log::type &log_type,
+        bool one_based = false) override;
     machine_merkle_tree::proof_type do_get_proof(uint64_t address, int log2_size) const override;
+    machine_merkle_tree::multiproof_type do_get_multiproof(const std::vector<uint64_t> &addresses,
+        int log2_size) const override;
     void do_get_root_hash(hash_type &hash) const override;
     bool do_verify_merkle_tree(void) const override;
     uint64_t do_read_csr(csr r) const override;
@@ -144,6 +152,7 @@ private:
     void do_snapshot() override;
     void do_destroy() override;
     void do_rollback() override;
+    void do_commit() override;
     uint64_t do_read_uarch_x(int i) const override;
     void do_write_uarch_x(int i, uint64_t val) override;
     uint64_t do_read_uarch_pc(void) const override;
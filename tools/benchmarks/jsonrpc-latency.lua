@@ -0,0 +1,94 @@
+#!/usr/bin/env lua5.4
+
+-- Copyright Cartesi and individual authors (see AUTHORS)
+-- SPDX-License-Identifier: LGPL-3.0-or-later
+--
+-- This program is free software: you can redistribute it and/or modify it under
+-- the terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+-- PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+--
+-- You should have received a copy of the GNU Lesser General Public License along
+-- with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+--
+
+-- Measures the latency of small JSON-RPC requests to a remote machine server,
+-- with and without connections kept alive across requests.
+--
+-- Usage: jsonrpc-latency.lua --remote-address=<host>:<port> [--requests=<number>]
+--
+-- The server must already be running, e.g. jsonrpc-remote-cartesi-machine --server-address=<host>:<port>
+
+local socket = require("socket")
+local jsonrpc = require("cartesi.jsonrpc")
+
+-- Number of times each mode is measured
+local N_RUNS = 5
+
+local remote_address
+local n_requests = 10000
+
+for _, argument in ipairs({ ... }) do
+    local value = argument:match("^%-%-remote%-address%=(.+)$")
+    if value then
+        remote_address = value
+    else
+        value = argument:match("^%-%-requests%=(%d+)$")
+        if not value then error("unrecognized argument " .. argument) end
+        n_requests = assert(tonumber(value))
+    end
+end
+assert(remote_address, "missing --remote-address")
+
+local stub = assert(jsonrpc.stub(remote_address))
+local config = stub.machine.get_default_config()
+config.ram.length = 1 << 20
+local machine = stub.machine(config)
+
+local function measure(keep_alive)
+    stub.set_keep_alive(keep_alive)
+    local results = {}
+    for _ = 1, N_RUNS do
+        local start = socket.gettime()
+        for _ = 1, n_requests do
+            machine:read_mcycle()
+        end
+        table.insert(results, (socket.gettime() - start) / n_requests)
+    end
+    return results
+end
+
+local function average(arr)
+    local avg = 0.0
+    for _, value in ipairs(arr) do
+        avg = avg + value
+    end
+    return avg / #arr
+end
+
+local function stddev(arr)
+    local std2 = 0.0
+    local avg = average(arr)
+    for _, value in ipairs(arr) do
+        std2 = std2 + (value - avg) ^ 2
+    end
+    return math.sqrt(std2 / #arr)
+end
+
+local modes = {
+    { name = "connection per request", keep_alive = false },
+    { name = "keep-alive", keep_alive = true },
+}
+local averages = {}
+for _, mode in ipairs(modes) do
+    local results = measure(mode.keep_alive)
+    averages[#averages + 1] = average(results)
+    io.write(string.format("|%-24s|%9.1f us +-%.1f|\n", mode.name, average(results) * 1e6, stddev(results) * 1e6))
+end
+io.write(string.format("keep-alive speedup: %.2fx\n", averages[1] / averages[2]))
+
+machine:destroy()